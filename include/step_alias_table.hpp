@@ -0,0 +1,515 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_alias_table.hpp
+ *
+ * @brief Provides alias tables for weighted random tile selection.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_ALIAS_TABLE_HEADER
+#define STEP_ALIAS_TABLE_HEADER
+
+#include <algorithm>  // min
+#include <cstddef>    // size_t
+#include <cstdint>    // uint32_t, uint64_t
+#include <limits>     // numeric_limits
+#include <vector>     // vector
+
+#include "step_api.hpp"
+#include "step_exception.hpp"
+#include "step_tileset.hpp"
+#include "step_types.hpp"
+#include "step_utils.hpp"
+#include "step_wang_set.hpp"
+
+namespace step {
+namespace detail {
+
+/**
+ * @class split_mix
+ *
+ * @brief A small and fast SplitMix64 random number generator.
+ *
+ * @details The generator satisfies the requirements of
+ * _UniformRandomBitGenerator_, and is cheap enough to seed that a separate
+ * stream can be used for every block of a batch.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_alias_table.hpp
+ */
+class split_mix final {
+ public:
+  using result_type = std::uint64_t;
+
+  constexpr explicit split_mix(std::uint64_t seed) noexcept : m_state{seed}
+  {}
+
+  /**
+   * @brief Returns a generator for one of the streams derived from a seed.
+   *
+   * @param seed the seed of the batch.
+   * @param stream the index of the stream.
+   *
+   * @return a generator that is independent of the other streams.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] static constexpr auto stream(std::uint64_t seed,
+                                             std::uint64_t stream) noexcept
+      -> split_mix
+  {
+    split_mix mixer{seed ^ (stream * 0xD1B54A32D192ED03ull)};
+    return split_mix{mixer()};
+  }
+
+  [[nodiscard]] static constexpr auto min() noexcept -> result_type
+  {
+    return 0;
+  }
+
+  [[nodiscard]] static constexpr auto max() noexcept -> result_type
+  {
+    return std::numeric_limits<result_type>::max();
+  }
+
+  constexpr auto operator()() noexcept -> result_type
+  {
+    auto z = (m_state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30u)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27u)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31u);
+  }
+
+ private:
+  std::uint64_t m_state{};
+};
+
+/**
+ * @brief Converts 64 random bits to a uniform value in [0, 1).
+ *
+ * @param bits the random bits.
+ *
+ * @return a value in the range [0, 1).
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] constexpr auto to_unit(std::uint64_t bits) noexcept -> double
+{
+  return static_cast<double>(bits >> 11u) * 0x1.0p-53;
+}
+
+}  // namespace detail
+
+/**
+ * @class alias_table
+ *
+ * @brief An alias table, which draws weighted random indices in constant time.
+ *
+ * @details The table is built with Vose's method in linear time. Every draw
+ * uses a single uniform value, whose integral part selects a column and whose
+ * fractional part selects either the column or its alias.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_alias_table.hpp
+ */
+class alias_table final {
+ public:
+  alias_table() = default;
+
+  /**
+   * @brief Creates an alias table from some weights.
+   *
+   * @param weights the relative weights of the indices, which must not be
+   * negative.
+   *
+   * @throws step_exception if there are no weights, if a weight is negative or
+   * if the sum of the weights isn't positive.
+   *
+   * @since 0.3.0
+   */
+  explicit alias_table(const std::vector<double>& weights)
+  {
+    double sum = 0;
+    for (const auto weight : weights) {
+      if (weight < 0) {
+        throw step_exception{"alias_table > Weights can't be negative!"};
+      }
+      sum += weight;
+    }
+
+    if (weights.empty() || !(sum > 0)) {
+      throw step_exception{"alias_table > The sum of weights must be > 0!"};
+    }
+
+    const auto count = weights.size();
+    m_probability.resize(count);
+    m_alias.resize(count);
+
+    std::vector<double> scaled(count);
+    std::vector<std::uint32_t> small;
+    std::vector<std::uint32_t> large;
+
+    for (std::size_t i = 0; i < count; ++i) {
+      scaled[i] = weights[i] * static_cast<double>(count) / sum;
+      m_alias[i] = static_cast<std::uint32_t>(i);
+      auto& list = scaled[i] < 1.0 ? small : large;
+      list.push_back(static_cast<std::uint32_t>(i));
+    }
+
+    while (!small.empty() && !large.empty()) {
+      const auto less = small.back();
+      small.pop_back();
+      const auto more = large.back();
+
+      m_probability[less] = scaled[less];
+      m_alias[less] = more;
+
+      scaled[more] = (scaled[more] + scaled[less]) - 1.0;
+      if (scaled[more] < 1.0) {
+        large.pop_back();
+        small.push_back(more);
+      }
+    }
+
+    // Whatever is left only differs from one due to rounding errors
+    for (const auto i : large) {
+      m_probability[i] = 1.0;
+    }
+    for (const auto i : small) {
+      m_probability[i] = 1.0;
+    }
+  }
+
+  /**
+   * @brief Returns the index selected by a uniform value.
+   *
+   * @param uniform a value in the range [0, 1).
+   *
+   * @return an index in the range [0, `size()`).
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto pick(double uniform) const noexcept -> std::size_t
+  {
+    const auto scaled = uniform * static_cast<double>(m_probability.size());
+    const auto column = std::min(static_cast<std::size_t>(scaled),
+                                 m_probability.size() - 1);
+    const auto fraction = scaled - static_cast<double>(column);
+    return fraction < m_probability[column] ? column : m_alias[column];
+  }
+
+  /**
+   * @brief Returns a weighted random index.
+   *
+   * @tparam Rng the type of the random number generator, which must produce
+   * 64 random bits per invocation.
+   *
+   * @param rng the random number generator that will be used.
+   *
+   * @return an index in the range [0, `size()`).
+   *
+   * @since 0.3.0
+   */
+  template <typename Rng>
+  [[nodiscard]] auto pick(Rng& rng) const -> std::size_t
+  {
+    return pick(detail::to_unit(static_cast<std::uint64_t>(rng())));
+  }
+
+  /**
+   * @brief Returns the amount of indices in the table.
+   *
+   * @return the amount of indices in the table.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto size() const noexcept -> std::size_t
+  {
+    return m_probability.size();
+  }
+
+  /**
+   * @brief Indicates whether or not the table is empty.
+   *
+   * @return `true` if the table has no indices; `false` otherwise.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto empty() const noexcept -> bool
+  {
+    return m_probability.empty();
+  }
+
+ private:
+  std::vector<double> m_probability;
+  std::vector<std::uint32_t> m_alias;
+};
+
+/**
+ * @class weighted_tiles
+ *
+ * @brief Picks weighted random tiles from a tileset or a Wang set.
+ *
+ * @details Tiles without an explicit probability have the probability 1, as
+ * in Tiled. The probability of a Wang tile is the probability of the tile
+ * multiplied with the probabilities of the colors of its corners and edges.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_alias_table.hpp
+ */
+class weighted_tiles final {
+ public:
+  /**
+   * @brief Creates a selection of all tiles in a tileset.
+   *
+   * @param tileset the tileset that provides the tiles.
+   *
+   * @throws step_exception if the tileset has no tiles with a positive
+   * probability.
+   *
+   * @since 0.3.0
+   */
+  explicit weighted_tiles(const tileset& tileset)
+  {
+    const auto count = static_cast<std::size_t>(tileset.tile_count());
+    std::vector<double> weights(count, 1.0);
+    for (const auto& tile : tileset.tiles()) {
+      const auto id = static_cast<std::size_t>(tile.id().get());
+      if (id < count) {
+        weights[id] = tile.probability().value_or(1.0);
+      }
+    }
+
+    m_gids.reserve(count);
+    for (std::size_t id = 0; id < count; ++id) {
+      m_gids.push_back(tileset.first_gid().get() + static_cast<unsigned>(id));
+    }
+
+    m_table = alias_table{weights};
+  }
+
+  /**
+   * @brief Creates a selection of the tiles in a Wang set.
+   *
+   * @details Flipped Wang tiles are picked with their flip bits set.
+   *
+   * @param tileset the tileset that contains the Wang set.
+   * @param set the Wang set that provides the tiles.
+   *
+   * @throws step_exception if the Wang set has no tiles with a positive
+   * probability.
+   *
+   * @since 0.3.0
+   */
+  weighted_tiles(const tileset& tileset, const wang_set& set)
+  {
+    std::vector<double> tileWeights(
+        static_cast<std::size_t>(tileset.tile_count()), 1.0);
+    for (const auto& tile : tileset.tiles()) {
+      const auto id = static_cast<std::size_t>(tile.id().get());
+      if (id < tileWeights.size()) {
+        tileWeights[id] = tile.probability().value_or(1.0);
+      }
+    }
+
+    const auto color_probability = [](const std::vector<wang_color>& colors,
+                                      int index) {
+      // Wang color indices are one-based, zero means no color
+      const auto i = static_cast<std::size_t>(index - 1);
+      return index > 0 && i < colors.size() ? colors[i].probability() : 1.0;
+    };
+
+    std::vector<double> weights;
+    for (const auto& wangTile : set.wang_tiles()) {
+      const auto id = static_cast<std::size_t>(wangTile.tile_id().get());
+      auto weight = id < tileWeights.size() ? tileWeights[id] : 1.0;
+
+      // Even indices are edges and odd indices are corners
+      const auto& indices = wangTile.wang_color_indices();
+      for (std::size_t i = 0; i < indices.size(); ++i) {
+        weight *= color_probability(
+            i % 2 == 0 ? set.edge_colors() : set.corner_colors(), indices[i]);
+      }
+
+      auto gid = tileset.first_gid().get() + static_cast<unsigned>(id);
+      if (wangTile.flipped_horizontally()) {
+        gid |= detail::flipped_horizontally_bit;
+      }
+      if (wangTile.flipped_vertically()) {
+        gid |= detail::flipped_vertically_bit;
+      }
+      if (wangTile.flipped_diagonally()) {
+        gid |= detail::flipped_diagonally_bit;
+      }
+
+      m_gids.push_back(gid);
+      weights.push_back(weight);
+    }
+
+    m_table = alias_table{weights};
+  }
+
+  /**
+   * @brief Returns the tile selected by a uniform value.
+   *
+   * @param uniform a value in the range [0, 1).
+   *
+   * @return the GID of the selected tile.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto pick(double uniform) const noexcept -> global_id
+  {
+    return global_id{m_gids[m_table.pick(uniform)]};
+  }
+
+  /**
+   * @brief Returns a weighted random tile.
+   *
+   * @tparam Rng the type of the random number generator, which must produce
+   * 64 random bits per invocation.
+   *
+   * @param rng the random number generator that will be used.
+   *
+   * @return the GID of the selected tile.
+   *
+   * @since 0.3.0
+   */
+  template <typename Rng>
+  [[nodiscard]] auto pick(Rng& rng) const -> global_id
+  {
+    return global_id{m_gids[m_table.pick(rng)]};
+  }
+
+  /**
+   * @brief Fills a range of GIDs with weighted random tiles.
+   *
+   * @details The range is split into blocks of a fixed size, that each use
+   * their own random stream derived from the seed. The result therefore only
+   * depends on the seed, and not on the amount of threads.
+   *
+   * @param gids the first GID that will be written.
+   * @param count the amount of GIDs that will be written.
+   * @param seed the seed of the random streams.
+   * @param threads the maximum amount of threads, zero means the amount of
+   * hardware threads.
+   *
+   * @since 0.3.0
+   */
+  void fill(unsigned* gids,
+            std::size_t count,
+            std::uint64_t seed,
+            int threads = 0) const
+  {
+    const auto blocks = static_cast<int>((count + block_size - 1) / block_size);
+    detail::parallel_for(0, blocks, threads, [&](int block) {
+      auto rng = detail::split_mix::stream(seed, static_cast<unsigned>(block));
+      const auto first = static_cast<std::size_t>(block) * block_size;
+      const auto last = std::min(first + block_size, count);
+      for (auto i = first; i < last; ++i) {
+        gids[i] = m_gids[m_table.pick(rng)];
+      }
+    });
+  }
+
+  /**
+   * @brief Fills a rectangular region of a row-major grid with weighted random
+   * tiles.
+   *
+   * @details Every row uses its own random stream, derived from the seed and
+   * the row index, so filling the same region twice with the same seed
+   * produces the same tiles.
+   *
+   * @param gids the GIDs of the grid, in row-major order.
+   * @param stride the amount of columns in the grid.
+   * @param col the first column of the region.
+   * @param row the first row of the region.
+   * @param width the amount of columns in the region.
+   * @param height the amount of rows in the region.
+   * @param seed the seed of the random streams.
+   * @param threads the maximum amount of threads, zero means the amount of
+   * hardware threads.
+   *
+   * @throws step_exception if the region is outside of the grid.
+   *
+   * @since 0.3.0
+   */
+  void fill(std::vector<unsigned>& gids,
+            int stride,
+            int col,
+            int row,
+            int width,
+            int height,
+            std::uint64_t seed,
+            int threads = 0) const
+  {
+    if (col < 0 || row < 0 || width < 0 || height < 0 ||
+        col + width > stride ||
+        static_cast<std::size_t>(row + height) *
+                static_cast<std::size_t>(stride) >
+            gids.size()) {
+      throw step_exception{"weighted_tiles > Region is out of bounds!"};
+    }
+
+    detail::parallel_for(row, row + height, threads, [&](int r) {
+      auto rng = detail::split_mix::stream(seed, static_cast<unsigned>(r));
+      auto* first = gids.data() + static_cast<std::size_t>(r) * stride + col;
+      for (auto i = 0; i < width; ++i) {
+        first[i] = m_gids[m_table.pick(rng)];
+      }
+    });
+  }
+
+  /**
+   * @brief Returns the GIDs of the tiles that can be picked.
+   *
+   * @return the GIDs of the tiles that can be picked, including flip bits.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto gids() const noexcept -> const std::vector<unsigned>&
+  {
+    return m_gids;
+  }
+
+ private:
+  static constexpr std::size_t block_size = 256;
+
+  std::vector<unsigned> m_gids;
+  alias_table m_table;
+};
+
+}  // namespace step
+
+#endif  // STEP_ALIAS_TABLE_HEADER
@@ -0,0 +1,484 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_atlas.hpp
+ *
+ * @brief Provides the `texture_atlas` class.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_ATLAS_HEADER
+#define STEP_ATLAS_HEADER
+
+#include <algorithm>      // max, min, find, sort, remove_if
+#include <cstddef>        // size_t
+#include <limits>         // numeric_limits
+#include <string>         // string
+#include <unordered_map>  // unordered_map
+#include <utility>        // move
+#include <vector>         // vector
+
+#include "step_api.hpp"
+#include "step_exception.hpp"
+#include "step_gid_table.hpp"
+#include "step_map.hpp"
+#include "step_rect.hpp"
+#include "step_tile_mask.hpp"
+#include "step_tileset.hpp"
+#include "step_types.hpp"
+
+namespace step {
+
+/**
+ * @struct atlas_region
+ *
+ * @brief The location of a tile in a texture atlas.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_atlas.hpp
+ */
+struct atlas_region final {
+  int page{-1};  ///< The atlas page, -1 if the tile isn't in the atlas.
+  rect bounds;   ///< The area of the page that holds the tile, in pixels.
+};
+
+/**
+ * @struct atlas_image
+ *
+ * @brief The placement of a source image in a texture atlas.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_atlas.hpp
+ */
+struct atlas_image final {
+  std::string image;  ///< The path to the image, as stored in the map.
+  int page{};         ///< The atlas page that holds the image.
+  rect bounds;        ///< The area of the page that holds the image.
+};
+
+/**
+ * @class texture_atlas
+ *
+ * @brief Computes a layout that packs the images of tilesets into atlas pages.
+ *
+ * @details The whole image of an ordinary tileset is packed as a single
+ * rectangle, whereas every tile of an image collection tileset is packed as a
+ * rectangle of its own. Images that are used by several tiles are only packed
+ * once. The images are placed with the MaxRects algorithm, using the best
+ * short side fit heuristic, and new pages are added when the images don't fit
+ * in the existing pages.
+ *
+ * Only the layout is computed, no images are loaded. The atlas rectangle of
+ * every tile is stored in a dense array that is indexed by GID.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_atlas.hpp
+ */
+class texture_atlas final {
+ public:
+  /**
+   * @brief Computes an atlas layout for the tilesets of a map.
+   *
+   * @param map the map that provides the tilesets.
+   * @param pageWidth the width of the atlas pages, in pixels.
+   * @param pageHeight the height of the atlas pages, in pixels.
+   * @param padding the amount of empty pixels between images.
+   * @param tilesets the names of the tilesets that will be packed, all
+   * tilesets are packed if the vector is empty.
+   *
+   * @throws step_exception if the page size isn't positive, or if an image
+   * doesn't fit in a page.
+   *
+   * @since 0.3.0
+   */
+  texture_atlas(const map& map,
+                int pageWidth,
+                int pageHeight,
+                int padding = 0,
+                const std::vector<std::string>& tilesets = {})
+      : m_regions{detail::gid_count(map), atlas_region{}},
+        m_pageWidth{pageWidth},
+        m_pageHeight{pageHeight},
+        m_padding{std::max(padding, 0)}
+  {
+    if (pageWidth <= 0 || pageHeight <= 0) {
+      throw step_exception{"texture_atlas > Page size must be positive!"};
+    }
+
+    std::vector<int> sizes;  // Pairs of image widths and heights
+    std::vector<tile_ref> refs;
+    for (const auto& tileset : map.tilesets()) {
+      if (!tilesets.empty() &&
+          std::find(tilesets.begin(), tilesets.end(), tileset->name()) ==
+              tilesets.end()) {
+        continue;
+      }
+      collect(*tileset, sizes, refs);
+    }
+
+    pack(sizes);
+
+    for (const auto& ref : refs) {
+      const auto& image = m_images[ref.image];
+      m_regions.set(global_id{ref.gid},
+                    atlas_region{image.page,
+                                 rect{image.bounds.x + ref.x,
+                                      image.bounds.y + ref.y,
+                                      ref.width,
+                                      ref.height}});
+    }
+  }
+
+  /**
+   * @brief Returns the atlas region of a tile.
+   *
+   * @param gid the GID of the tile, flip flags are ignored.
+   *
+   * @return the region of the tile; the page is -1 if the tile isn't in the
+   * atlas.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto region(global_id gid) const noexcept
+      -> const atlas_region&
+  {
+    return m_regions[gid];
+  }
+
+  /**
+   * @brief Returns the atlas regions of all tiles, indexed by GID.
+   *
+   * @return the atlas regions of all tiles.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto regions() const noexcept -> const gid_array<atlas_region>&
+  {
+    return m_regions;
+  }
+
+  /**
+   * @brief Returns the placements of the packed images.
+   *
+   * @return the packed images, in the order in which they were encountered.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto images() const noexcept
+      -> const std::vector<atlas_image>&
+  {
+    return m_images;
+  }
+
+  /**
+   * @brief Returns the amount of atlas pages.
+   *
+   * @return the amount of atlas pages.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto page_count() const noexcept -> int
+  {
+    return static_cast<int>(m_pages.size());
+  }
+
+  /**
+   * @brief Returns the width of the atlas pages.
+   *
+   * @return the width of the atlas pages, in pixels.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto page_width() const noexcept -> int
+  {
+    return m_pageWidth;
+  }
+
+  /**
+   * @brief Returns the height of the atlas pages.
+   *
+   * @return the height of the atlas pages, in pixels.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto page_height() const noexcept -> int
+  {
+    return m_pageHeight;
+  }
+
+ private:
+  struct area final {
+    int x{};
+    int y{};
+    int width{};
+    int height{};
+  };
+
+  struct tile_ref final {
+    unsigned gid{};
+    std::size_t image{};
+    double x{};
+    double y{};
+    double width{};
+    double height{};
+  };
+
+  gid_array<atlas_region> m_regions;
+  std::vector<atlas_image> m_images;
+  std::vector<std::vector<area>> m_pages;  // The free areas of each page
+  std::unordered_map<std::string, std::size_t> m_imageIndices;
+  int m_pageWidth{};
+  int m_pageHeight{};
+  int m_padding{};
+
+  auto add_image(const std::string& image,
+                 int width,
+                 int height,
+                 std::vector<int>& sizes) -> std::size_t
+  {
+    if (const auto it = m_imageIndices.find(image);
+        it != m_imageIndices.end()) {
+      return it->second;
+    }
+
+    const auto index = m_images.size();
+    m_imageIndices.emplace(image, index);
+    m_images.push_back(atlas_image{image, -1, rect{}});
+    sizes.push_back(width);
+    sizes.push_back(height);
+    return index;
+  }
+
+  void collect(const tileset& tileset,
+               std::vector<int>& sizes,
+               std::vector<tile_ref>& refs)
+  {
+    const auto first = tileset.first_gid().get();
+
+    if (!tileset.image().empty()) {
+      const auto image = add_image(std::string{tileset.image()},
+                                   tileset.image_width(),
+                                   tileset.image_height(),
+                                   sizes);
+
+      const auto columns = std::max(tileset.columns(), 1);
+      const auto tw = tileset.tile_width();
+      const auto th = tileset.tile_height();
+      const auto margin = tileset.margin();
+      const auto spacing = tileset.spacing();
+      for (auto id = 0; id < tileset.tile_count(); ++id) {
+        const auto x = margin + (id % columns) * (tw + spacing);
+        const auto y = margin + (id / columns) * (th + spacing);
+        refs.push_back(tile_ref{first + static_cast<unsigned>(id),
+                                image,
+                                static_cast<double>(x),
+                                static_cast<double>(y),
+                                static_cast<double>(tw),
+                                static_cast<double>(th)});
+      }
+      return;
+    }
+
+    for (const auto& tile : tileset.tiles()) {
+      const auto& path = tile.image();
+      const auto width = tile.image_width();
+      const auto height = tile.image_height();
+      if (!path || !width || !height) {
+        continue;
+      }
+
+      const auto image = add_image(*path, *width, *height, sizes);
+      refs.push_back(tile_ref{first + static_cast<unsigned>(tile.id().get()),
+                              image,
+                              0,
+                              0,
+                              static_cast<double>(*width),
+                              static_cast<double>(*height)});
+    }
+  }
+
+  void pack(const std::vector<int>& sizes)
+  {
+    // Large images first, since they are the hardest ones to fit
+    std::vector<std::size_t> order(m_images.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+      order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+      const auto wa = sizes[a * 2];
+      const auto ha = sizes[a * 2 + 1];
+      const auto wb = sizes[b * 2];
+      const auto hb = sizes[b * 2 + 1];
+      if (std::max(wa, ha) != std::max(wb, hb)) {
+        return std::max(wa, ha) > std::max(wb, hb);
+      } else if (wa * ha != wb * hb) {
+        return wa * ha > wb * hb;
+      } else {
+        return a < b;
+      }
+    });
+
+    for (const auto index : order) {
+      const auto width = sizes[index * 2];
+      const auto height = sizes[index * 2 + 1];
+      auto& image = m_images[index];
+
+      // Every image is padded on its right and bottom sides, and the pages
+      // are enlarged by the padding so that the last row and column fit
+      const auto paddedWidth = width + m_padding;
+      const auto paddedHeight = height + m_padding;
+      if (width > m_pageWidth || height > m_pageHeight) {
+        throw step_exception{"texture_atlas > Image doesn't fit in a page!"};
+      }
+
+      auto placed = false;
+      for (std::size_t page = 0; page < m_pages.size() && !placed; ++page) {
+        placed = place(page, paddedWidth, paddedHeight, image);
+      }
+
+      if (!placed) {
+        m_pages.push_back({area{0,
+                                0,
+                                m_pageWidth + m_padding,
+                                m_pageHeight + m_padding}});
+        place(m_pages.size() - 1, paddedWidth, paddedHeight, image);
+      }
+
+      image.bounds.width = width;
+      image.bounds.height = height;
+    }
+  }
+
+  auto place(std::size_t page, int width, int height, atlas_image& image)
+      -> bool
+  {
+    auto& free = m_pages[page];
+
+    // Best short side fit, ties are broken by the long side
+    auto bestShort = std::numeric_limits<int>::max();
+    auto bestLong = std::numeric_limits<int>::max();
+    area node;
+    for (const auto& candidate : free) {
+      if (candidate.width < width || candidate.height < height) {
+        continue;
+      }
+
+      const auto dx = candidate.width - width;
+      const auto dy = candidate.height - height;
+      const auto shortSide = std::min(dx, dy);
+      const auto longSide = std::max(dx, dy);
+      if (shortSide < bestShort ||
+          (shortSide == bestShort && longSide < bestLong)) {
+        bestShort = shortSide;
+        bestLong = longSide;
+        node = area{candidate.x, candidate.y, width, height};
+      }
+    }
+
+    if (bestShort == std::numeric_limits<int>::max()) {
+      return false;
+    }
+
+    split(free, node);
+
+    image.page = static_cast<int>(page);
+    image.bounds.x = node.x;
+    image.bounds.y = node.y;
+    return true;
+  }
+
+  // Replaces the free areas that overlap the node with the parts around it
+  static void split(std::vector<area>& free, const area& node)
+  {
+    const auto right = node.x + node.width;
+    const auto bottom = node.y + node.height;
+
+    std::vector<area> added;
+    const auto overlaps = [&](const area& other) {
+      const auto otherRight = other.x + other.width;
+      const auto otherBottom = other.y + other.height;
+      if (node.x >= otherRight || right <= other.x || node.y >= otherBottom ||
+          bottom <= other.y) {
+        return false;
+      }
+
+      if (node.x > other.x) {
+        added.push_back({other.x, other.y, node.x - other.x, other.height});
+      }
+      if (right < otherRight) {
+        added.push_back({right, other.y, otherRight - right, other.height});
+      }
+      if (node.y > other.y) {
+        added.push_back({other.x, other.y, other.width, node.y - other.y});
+      }
+      if (bottom < otherBottom) {
+        added.push_back({other.x, bottom, other.width, otherBottom - bottom});
+      }
+      return true;
+    };
+
+    free.erase(std::remove_if(free.begin(), free.end(), overlaps), free.end());
+    free.insert(free.end(), added.begin(), added.end());
+    prune(free);
+  }
+
+  // Removes the free areas that are contained in other free areas
+  static void prune(std::vector<area>& free)
+  {
+    const auto contains = [](const area& outer, const area& inner) {
+      return inner.x >= outer.x && inner.y >= outer.y &&
+             inner.x + inner.width <= outer.x + outer.width &&
+             inner.y + inner.height <= outer.y + outer.height;
+    };
+
+    std::vector<area> result;
+    result.reserve(free.size());
+    for (std::size_t i = 0; i < free.size(); ++i) {
+      auto redundant = false;
+      for (std::size_t j = 0; j < free.size() && !redundant; ++j) {
+        if (i != j && contains(free[j], free[i])) {
+          // Identical areas are only removed once
+          redundant = !contains(free[i], free[j]) || j < i;
+        }
+      }
+      if (!redundant) {
+        result.push_back(free[i]);
+      }
+    }
+    free = std::move(result);
+  }
+};
+
+}  // namespace step
+
+#endif  // STEP_ATLAS_HEADER
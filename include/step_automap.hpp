@@ -0,0 +1,874 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_automap.hpp
+ *
+ * @brief Provides a rule-based automapping engine for tile layers.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_AUTOMAP_HEADER
+#define STEP_AUTOMAP_HEADER
+
+#include <algorithm>      // find, min, max, sort
+#include <cstddef>        // size_t
+#include <string>         // string
+#include <string_view>    // string_view
+#include <unordered_map>  // unordered_map
+#include <utility>        // move, pair
+#include <vector>         // vector
+
+#include "step_api.hpp"
+#include "step_exception.hpp"
+#include "step_layer.hpp"
+#include "step_map.hpp"
+#include "step_tile_layer.hpp"
+#include "step_types.hpp"
+#include "step_utils.hpp"
+
+namespace step {
+namespace detail {
+
+/**
+ * @struct automap_cell
+ *
+ * @brief A cell of an automapping rule, relative to the rule region.
+ *
+ * @details Input cells list the alternative GIDs from all input layers with
+ * the same name, output cells have exactly one GID.
+ *
+ * @since 0.3.0
+ */
+struct automap_cell final {
+  int dx{};
+  int dy{};
+  std::vector<unsigned> gids;
+};
+
+/**
+ * @struct automap_condition
+ *
+ * @brief The cells that a rule requires, or forbids, in a single layer.
+ *
+ * @since 0.3.0
+ */
+struct automap_condition final {
+  std::size_t layer{};
+  bool negated{};
+  std::vector<automap_cell> cells;
+};
+
+/**
+ * @struct automap_rule
+ *
+ * @brief An automapping rule, i.e. the contents of one rule region.
+ *
+ * @since 0.3.0
+ */
+struct automap_rule final {
+  std::vector<automap_condition> conditions;
+  std::vector<automap_condition> outputs;
+  int width{};
+  int height{};
+};
+
+/**
+ * @struct automap_anchor
+ *
+ * @brief Associates a rule with one of its required cells.
+ *
+ * @since 0.3.0
+ */
+struct automap_anchor final {
+  std::size_t rule{};
+  int dx{};
+  int dy{};
+};
+
+/**
+ * @struct automap_match
+ *
+ * @brief The position of the region of a rule that matched.
+ *
+ * @since 0.3.0
+ */
+struct automap_match final {
+  std::size_t rule{};
+  int col{};
+  int row{};
+};
+
+[[nodiscard]] inline auto starts_with(std::string_view str,
+                                      std::string_view prefix) noexcept -> bool
+{
+  return str.substr(0, prefix.size()) == prefix;
+}
+
+}  // namespace detail
+
+/**
+ * @class automap_rules
+ *
+ * @brief A set of automapping rules, parsed from a rule map.
+ *
+ * @details Rule maps follow the conventions of Tiled. Tile layers named
+ * `input_<name>` and `inputnot_<name>` describe the cells that must, or must
+ * not, be present in the layer `<name>`, and layers named `output_<name>`
+ * describe the tiles that are placed in the layer `<name>`. Several input
+ * layers with the same name list alternatives for the same cells.
+ *
+ * Every 4-connected region of non-empty cells in a layer called `regions`
+ * is a rule. Without such a layer, the regions are formed by the cells of the
+ * input and output layers instead. Empty input cells match any tile.
+ *
+ * Every rule is anchored on one of its required cells, so that only positions
+ * where the anchor tile is present have to be considered.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_automap.hpp
+ */
+class automap_rules final {
+ public:
+  /**
+   * @brief Parses the rules in a rule map.
+   *
+   * @param rules the rule map.
+   *
+   * @throws step_exception if the rule map has no input layers.
+   *
+   * @since 0.3.0
+   */
+  explicit automap_rules(const map& rules)
+      : m_width{rules.width()},
+        m_height{rules.height()}
+  {
+    const auto size = static_cast<std::size_t>(m_width * m_height);
+
+    std::vector<unsigned char> regions(size, 0);
+    auto hasRegions = false;
+    std::vector<std::pair<std::string, std::vector<unsigned>>> layers;
+
+    for (const auto& layer : rules.layers()) {
+      detail::each_tile_layer(layer, [&](const step::layer& info,
+                                         const tile_layer& tiles) {
+        const auto name = info.name();
+        const auto isRegions = name == "regions";
+        if (!isRegions && !detail::starts_with(name, "input_") &&
+            !detail::starts_with(name, "inputnot_") &&
+            !detail::starts_with(name, "output_")) {
+          return;
+        }
+
+        std::vector<unsigned> gids(size, 0);
+        tiles.each([&](int col, int row, global_id gid) {
+          if (col >= 0 && row >= 0 && col < m_width && row < m_height) {
+            gids[static_cast<std::size_t>(row * m_width + col)] = gid.get();
+          }
+        });
+
+        if (isRegions) {
+          hasRegions = true;
+          for (std::size_t i = 0; i < size; ++i) {
+            regions[i] = gids[i] != 0;
+          }
+        } else {
+          layers.emplace_back(name, std::move(gids));
+        }
+      });
+    }
+
+    if (std::none_of(layers.begin(), layers.end(), [](const auto& layer) {
+          return detail::starts_with(layer.first, "input");
+        })) {
+      throw step_exception{"automap_rules > Rule map has no input layers!"};
+    }
+
+    if (!hasRegions) {
+      for (const auto& [name, gids] : layers) {
+        for (std::size_t i = 0; i < size; ++i) {
+          regions[i] |= gids[i] != 0;
+        }
+      }
+    }
+
+    parse_regions(regions, layers);
+  }
+
+  /**
+   * @brief Returns the names of the layers that the rules read or write.
+   *
+   * @return the names of the layers, indexed by the layer indices of the rules.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto layer_names() const noexcept
+      -> const std::vector<std::string>&
+  {
+    return m_layerNames;
+  }
+
+  /**
+   * @brief Returns the rules, in the order they appear in the rule map.
+   *
+   * @return the rules.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto rules() const noexcept
+      -> const std::vector<detail::automap_rule>&
+  {
+    return m_rules;
+  }
+
+  /**
+   * @brief Returns the anchors of the rules that require a GID in a layer.
+   *
+   * @param layer the index of the layer.
+   * @param gid the required GID, including flip bits.
+   *
+   * @return the anchors for the GID; null if there are none.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto anchors(std::size_t layer, unsigned gid) const
+      -> const std::vector<detail::automap_anchor>*
+  {
+    const auto& index = m_anchors.at(layer);
+    if (const auto it = index.find(gid); it != index.end()) {
+      return &it->second;
+    } else {
+      return nullptr;
+    }
+  }
+
+  /**
+   * @brief Indicates whether or not any rules are anchored in a layer.
+   *
+   * @param layer the index of the layer.
+   *
+   * @return `true` if rules are anchored in the layer; `false` otherwise.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto has_anchors(std::size_t layer) const -> bool
+  {
+    return !m_anchors.at(layer).empty();
+  }
+
+  /**
+   * @brief Returns the indices of the rules that only forbid tiles.
+   *
+   * @details These rules have no anchor, and are tried at every position.
+   *
+   * @return the indices of the unanchored rules.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto unanchored() const noexcept
+      -> const std::vector<std::size_t>&
+  {
+    return m_unanchored;
+  }
+
+  /**
+   * @brief Returns the maximum width of the rule regions.
+   *
+   * @return the maximum width of the rule regions.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto max_width() const noexcept -> int
+  {
+    return m_maxWidth;
+  }
+
+  /**
+   * @brief Returns the maximum height of the rule regions.
+   *
+   * @return the maximum height of the rule regions.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto max_height() const noexcept -> int
+  {
+    return m_maxHeight;
+  }
+
+ private:
+  using anchor_index =
+      std::unordered_map<unsigned, std::vector<detail::automap_anchor>>;
+
+  int m_width{};
+  int m_height{};
+  int m_maxWidth{};
+  int m_maxHeight{};
+  std::vector<std::string> m_layerNames;
+  std::vector<detail::automap_rule> m_rules;
+  std::vector<anchor_index> m_anchors;
+  std::vector<std::size_t> m_unanchored;
+
+  [[nodiscard]] auto layer_index(std::string_view name) -> std::size_t
+  {
+    const auto it = std::find(m_layerNames.begin(), m_layerNames.end(), name);
+    if (it != m_layerNames.end()) {
+      return static_cast<std::size_t>(it - m_layerNames.begin());
+    }
+
+    m_layerNames.emplace_back(name);
+    m_anchors.emplace_back();
+    return m_layerNames.size() - 1;
+  }
+
+  void parse_regions(
+      std::vector<unsigned char>& regions,
+      const std::vector<std::pair<std::string, std::vector<unsigned>>>& layers)
+  {
+    std::vector<int> component;
+    for (auto start = 0; start < m_width * m_height; ++start) {
+      if (!regions[static_cast<std::size_t>(start)]) {
+        continue;
+      }
+
+      // Collects the 4-connected region with a flood fill
+      component.clear();
+      component.push_back(start);
+      regions[static_cast<std::size_t>(start)] = 0;
+      for (std::size_t i = 0; i < component.size(); ++i) {
+        const auto col = component[i] % m_width;
+        const auto row = component[i] / m_width;
+        const auto visit = [&](int c, int r) {
+          const auto index = r * m_width + c;
+          if (c >= 0 && r >= 0 && c < m_width && r < m_height &&
+              regions[static_cast<std::size_t>(index)]) {
+            regions[static_cast<std::size_t>(index)] = 0;
+            component.push_back(index);
+          }
+        };
+        visit(col - 1, row);
+        visit(col + 1, row);
+        visit(col, row - 1);
+        visit(col, row + 1);
+      }
+
+      add_rule(component, layers);
+    }
+  }
+
+  void add_rule(
+      std::vector<int>& component,
+      const std::vector<std::pair<std::string, std::vector<unsigned>>>& layers)
+  {
+    std::sort(component.begin(), component.end());
+
+    auto minCol = m_width;
+    auto minRow = m_height;
+    auto maxCol = 0;
+    auto maxRow = 0;
+    for (const auto index : component) {
+      minCol = std::min(minCol, index % m_width);
+      minRow = std::min(minRow, index / m_width);
+      maxCol = std::max(maxCol, index % m_width);
+      maxRow = std::max(maxRow, index / m_width);
+    }
+
+    detail::automap_rule rule;
+    rule.width = maxCol - minCol + 1;
+    rule.height = maxRow - minRow + 1;
+
+    for (const auto& [name, gids] : layers) {
+      const auto output = detail::starts_with(name, "output_");
+      const auto negated = detail::starts_with(name, "inputnot_");
+      const auto target = name.substr(name.find('_') + 1);
+
+      auto& conditions = output ? rule.outputs : rule.conditions;
+      const auto layer = layer_index(target);
+
+      auto it = std::find_if(
+          conditions.begin(), conditions.end(), [&](const auto& condition) {
+            return condition.layer == layer && condition.negated == negated;
+          });
+      if (output || it == conditions.end()) {
+        auto& condition = conditions.emplace_back();
+        condition.layer = layer;
+        condition.negated = negated;
+        it = conditions.end() - 1;
+      }
+
+      for (const auto index : component) {
+        const auto gid = gids[static_cast<std::size_t>(index)];
+        if (gid == 0) {
+          continue;
+        }
+
+        const auto dx = index % m_width - minCol;
+        const auto dy = index / m_width - minRow;
+        auto cell = std::find_if(
+            it->cells.begin(), it->cells.end(), [&](const auto& cell) {
+              return cell.dx == dx && cell.dy == dy;
+            });
+        if (output || cell == it->cells.end()) {
+          it->cells.push_back({dx, dy, {}});
+          cell = it->cells.end() - 1;
+        }
+        cell->gids.push_back(gid);
+      }
+    }
+
+    // Drops empty conditions, and rules that can't match anything
+    const auto is_empty = [](const auto& condition) {
+      return condition.cells.empty();
+    };
+    auto& conditions = rule.conditions;
+    conditions.erase(
+        std::remove_if(conditions.begin(), conditions.end(), is_empty),
+        conditions.end());
+    rule.outputs.erase(
+        std::remove_if(rule.outputs.begin(), rule.outputs.end(), is_empty),
+        rule.outputs.end());
+    if (conditions.empty()) {
+      return;
+    }
+
+    const auto index = m_rules.size();
+    m_maxWidth = std::max(m_maxWidth, rule.width);
+    m_maxHeight = std::max(m_maxHeight, rule.height);
+
+    // The required cell with the fewest alternatives becomes the anchor
+    const detail::automap_condition* anchorCondition{};
+    const detail::automap_cell* anchorCell{};
+    for (const auto& condition : conditions) {
+      for (const auto& cell : condition.cells) {
+        if (!condition.negated &&
+            (!anchorCell || cell.gids.size() < anchorCell->gids.size())) {
+          anchorCondition = &condition;
+          anchorCell = &cell;
+        }
+      }
+    }
+
+    if (anchorCell) {
+      auto& anchors = m_anchors.at(anchorCondition->layer);
+      for (const auto gid : anchorCell->gids) {
+        anchors[gid].push_back({index, anchorCell->dx, anchorCell->dy});
+      }
+    } else {
+      m_unanchored.push_back(index);
+    }
+
+    m_rules.push_back(std::move(rule));
+  }
+};
+
+/**
+ * @class automapper
+ *
+ * @brief Applies automapping rules to a copy of the tile layers of a map.
+ *
+ * @details All rules are matched against the state of the layers before a
+ * pass, and the outputs of the matches are then written in rule order, with
+ * matches of the same rule written in row-major order. Since matching doesn't
+ * modify anything, the map is split into bands of rows that are matched in
+ * parallel.
+ *
+ * Cells that are changed with `set()` are remembered, so that `update()` only
+ * has to reconsider the rule positions that overlap the changed cells.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_automap.hpp
+ */
+class automapper final {
+ public:
+  /**
+   * @brief Creates an automapper for a map.
+   *
+   * @details The tile layers that the rules refer to are copied from the map,
+   * layers that don't exist in the map start out empty. Only the cells inside
+   * of the map bounds are considered.
+   *
+   * @param target the map that provides the initial tiles.
+   * @param rules the rules that will be applied, must outlive the automapper.
+   *
+   * @since 0.3.0
+   */
+  automapper(const map& target, const automap_rules& rules)
+      : m_rules{&rules},
+        m_width{target.width()},
+        m_height{target.height()}
+  {
+    const auto size = static_cast<std::size_t>(m_width * m_height);
+    const auto& names = rules.layer_names();
+    m_layers.assign(names.size(), std::vector<unsigned>(size, 0));
+
+    for (const auto& layer : target.layers()) {
+      detail::each_tile_layer(layer, [&](const step::layer& info,
+                                         const tile_layer& tiles) {
+        const auto name = info.name();
+        const auto it = std::find(names.begin(), names.end(), name);
+        if (it == names.end()) {
+          return;
+        }
+
+        auto& gids = m_layers[static_cast<std::size_t>(it - names.begin())];
+        tiles.each([&](int col, int row, global_id gid) {
+          if (in_bounds(col, row)) {
+            gids[index_of(col, row)] = gid.get();
+          }
+        });
+      });
+    }
+  }
+
+  /**
+   * @brief Applies the rules to the entire map.
+   *
+   * @param threads the maximum amount of threads, zero means the amount of
+   * hardware threads.
+   *
+   * @return the amount of cells that were changed.
+   *
+   * @since 0.3.0
+   */
+  auto apply(int threads = 0) -> std::size_t
+  {
+    m_dirty.clear();
+    m_positions.clear();
+    return run(0, 0, m_width, m_height, threads);
+  }
+
+  /**
+   * @brief Reapplies the rules around the cells changed since the last pass.
+   *
+   * @param threads the maximum amount of threads, zero means the amount of
+   * hardware threads.
+   *
+   * @return the amount of cells that were changed.
+   *
+   * @since 0.3.0
+   */
+  auto update(int threads = 0) -> std::size_t
+  {
+    if (m_dirty.empty()) {
+      return 0;
+    }
+
+    // Marks the rule positions whose regions may overlap a changed cell
+    m_positions.assign(static_cast<std::size_t>(m_width * m_height), 0);
+    const auto reachX = m_rules->max_width() - 1;
+    const auto reachY = m_rules->max_height() - 1;
+
+    auto minCol = m_width;
+    auto minRow = m_height;
+    auto maxCol = 0;
+    auto maxRow = 0;
+    for (const auto& [col, row] : m_dirty) {
+      const auto firstCol = std::max(0, col - reachX);
+      const auto firstRow = std::max(0, row - reachY);
+      for (auto r = firstRow; r <= row; ++r) {
+        for (auto c = firstCol; c <= col; ++c) {
+          m_positions[index_of(c, r)] = 1;
+        }
+      }
+
+      minCol = std::min(minCol, firstCol);
+      minRow = std::min(minRow, firstRow);
+      maxCol = std::max(maxCol, col);
+      maxRow = std::max(maxRow, row);
+    }
+    m_dirty.clear();
+
+    // Anchors may be anywhere within the regions of the marked positions
+    const auto lastCol = std::min(m_width, maxCol + reachX + 1);
+    const auto lastRow = std::min(m_height, maxRow + reachY + 1);
+    const auto changed =
+        run(minCol, minRow, lastCol - minCol, lastRow - minRow, threads);
+
+    m_positions.clear();
+    return changed;
+  }
+
+  /**
+   * @brief Changes a cell, which is reconsidered by the next `update()`.
+   *
+   * @param layer the name of the layer.
+   * @param col the column of the cell.
+   * @param row the row of the cell.
+   * @param gid the new GID of the cell, including flip bits.
+   *
+   * @throws step_exception if the layer isn't used by the rules, or if the
+   * cell is outside of the map.
+   *
+   * @since 0.3.0
+   */
+  void set(std::string_view layer, int col, int row, global_id gid)
+  {
+    if (!in_bounds(col, row)) {
+      throw step_exception{"automapper > Cell is outside of the map!"};
+    }
+
+    m_layers.at(layer_of(layer))[index_of(col, row)] = gid.get();
+    m_dirty.emplace_back(col, row);
+  }
+
+  /**
+   * @brief Returns the GID of a cell.
+   *
+   * @param layer the name of the layer.
+   * @param col the column of the cell.
+   * @param row the row of the cell.
+   *
+   * @return the GID of the cell, including flip bits; zero if the cell is
+   * outside of the map.
+   *
+   * @throws step_exception if the layer isn't used by the rules.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto gid_at(std::string_view layer, int col, int row) const
+      -> global_id
+  {
+    const auto& gids = m_layers.at(layer_of(layer));
+    return global_id{in_bounds(col, row) ? gids[index_of(col, row)] : 0u};
+  }
+
+  /**
+   * @brief Returns the GIDs of a layer.
+   *
+   * @param layer the name of the layer.
+   *
+   * @return the GIDs of the layer in row-major order, including flip bits.
+   *
+   * @throws step_exception if the layer isn't used by the rules.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto layer(std::string_view layer) const
+      -> const std::vector<unsigned>&
+  {
+    return m_layers.at(layer_of(layer));
+  }
+
+  /**
+   * @brief Returns the amount of changed cells that haven't been updated.
+   *
+   * @return the amount of pending changed cells.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto pending() const noexcept -> std::size_t
+  {
+    return m_dirty.size();
+  }
+
+  /**
+   * @brief Returns the width of the map.
+   *
+   * @return the width of the map, in tiles.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto width() const noexcept -> int
+  {
+    return m_width;
+  }
+
+  /**
+   * @brief Returns the height of the map.
+   *
+   * @return the height of the map, in tiles.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto height() const noexcept -> int
+  {
+    return m_height;
+  }
+
+ private:
+  static constexpr int band_height = 16;
+
+  const automap_rules* m_rules{};
+  int m_width{};
+  int m_height{};
+  std::vector<std::vector<unsigned>> m_layers;
+  std::vector<std::pair<int, int>> m_dirty;
+  std::vector<unsigned char> m_positions;
+
+  [[nodiscard]] auto in_bounds(int col, int row) const noexcept -> bool
+  {
+    return col >= 0 && row >= 0 && col < m_width && row < m_height;
+  }
+
+  [[nodiscard]] auto index_of(int col, int row) const noexcept -> std::size_t
+  {
+    return static_cast<std::size_t>(row * m_width + col);
+  }
+
+  [[nodiscard]] auto layer_of(std::string_view layer) const -> std::size_t
+  {
+    const auto& names = m_rules->layer_names();
+    const auto it = std::find(names.begin(), names.end(), layer);
+    if (it == names.end()) {
+      throw step_exception{"automapper > Layer isn't used by the rules!"};
+    }
+    return static_cast<std::size_t>(it - names.begin());
+  }
+
+  [[nodiscard]] auto matches(const detail::automap_rule& rule,
+                             int col,
+                             int row) const -> bool
+  {
+    if (col < 0 || row < 0 || col + rule.width > m_width ||
+        row + rule.height > m_height) {
+      return false;
+    }
+
+    if (!m_positions.empty() && !m_positions[index_of(col, row)]) {
+      return false;
+    }
+
+    for (const auto& condition : rule.conditions) {
+      const auto& gids = m_layers[condition.layer];
+      for (const auto& cell : condition.cells) {
+        const auto gid = gids[index_of(col + cell.dx, row + cell.dy)];
+        const auto found =
+            std::find(cell.gids.begin(), cell.gids.end(), gid) !=
+            cell.gids.end();
+        if (found == condition.negated) {
+          return false;
+        }
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * @brief Matches the rules with anchors in a band of rows.
+   */
+  void match_band(int col,
+                  int width,
+                  int firstRow,
+                  int lastRow,
+                  std::vector<detail::automap_match>& result) const
+  {
+    const auto& rules = m_rules->rules();
+    for (std::size_t layer = 0; layer < m_layers.size(); ++layer) {
+      if (!m_rules->has_anchors(layer)) {
+        continue;
+      }
+
+      const auto& gids = m_layers[layer];
+      for (auto row = firstRow; row < lastRow; ++row) {
+        for (auto c = col; c < col + width; ++c) {
+          const auto gid = gids[index_of(c, row)];
+          if (gid == 0) {
+            continue;
+          }
+
+          if (const auto* anchors = m_rules->anchors(layer, gid)) {
+            for (const auto& anchor : *anchors) {
+              const auto x = c - anchor.dx;
+              const auto y = row - anchor.dy;
+              if (matches(rules[anchor.rule], x, y)) {
+                result.push_back({anchor.rule, x, y});
+              }
+            }
+          }
+        }
+      }
+    }
+
+    for (const auto index : m_rules->unanchored()) {
+      for (auto row = firstRow; row < lastRow; ++row) {
+        for (auto c = col; c < col + width; ++c) {
+          if (matches(rules[index], c, row)) {
+            result.push_back({index, c, row});
+          }
+        }
+      }
+    }
+  }
+
+  auto run(int col, int row, int width, int height, int threads)
+      -> std::size_t
+  {
+    if (width <= 0 || height <= 0) {
+      return 0;
+    }
+
+    const auto bands = (height + band_height - 1) / band_height;
+    std::vector<std::vector<detail::automap_match>> found(
+        static_cast<std::size_t>(bands));
+
+    detail::parallel_for(0, bands, threads, [&](int band) {
+      const auto first = row + band * band_height;
+      const auto last = std::min(first + band_height, row + height);
+      match_band(col, width, first, last, found[band]);
+    });
+
+    std::vector<detail::automap_match> all;
+    for (auto& band : found) {
+      all.insert(all.end(), band.begin(), band.end());
+    }
+
+    std::sort(all.begin(), all.end(), [](const auto& a, const auto& b) {
+      if (a.rule != b.rule) {
+        return a.rule < b.rule;
+      } else if (a.row != b.row) {
+        return a.row < b.row;
+      } else {
+        return a.col < b.col;
+      }
+    });
+
+    std::size_t changed = 0;
+    const auto& rules = m_rules->rules();
+    for (const auto& match : all) {
+      for (const auto& output : rules[match.rule].outputs) {
+        auto& gids = m_layers[output.layer];
+        for (const auto& cell : output.cells) {
+          auto& gid = gids[index_of(match.col + cell.dx, match.row + cell.dy)];
+          if (gid != cell.gids.front()) {
+            gid = cell.gids.front();
+            ++changed;
+          }
+        }
+      }
+    }
+
+    return changed;
+  }
+};
+
+}  // namespace step
+
+#endif  // STEP_AUTOMAP_HEADER
@@ -0,0 +1,581 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_automaton.hpp
+ *
+ * @brief Provides a double-buffered cellular automaton for tile layers.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_AUTOMATON_HEADER
+#define STEP_AUTOMATON_HEADER
+
+#include <algorithm>    // fill, min, max
+#include <array>        // array
+#include <cstddef>      // size_t
+#include <cstdint>      // uint64_t
+#include <functional>   // function
+#include <string_view>  // string_view
+#include <utility>      // move, swap
+#include <vector>       // vector
+
+#include "step_alias_table.hpp"
+#include "step_api.hpp"
+#include "step_exception.hpp"
+#include "step_layer.hpp"
+#include "step_map.hpp"
+#include "step_tile_layer.hpp"
+#include "step_tile_pos.hpp"
+#include "step_types.hpp"
+#include "step_utils.hpp"
+
+namespace step {
+
+/**
+ * @struct cell_change
+ *
+ * @brief Describes a cell that was changed by a step of a cellular automaton.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_automaton.hpp
+ */
+struct cell_change final {
+  tile_pos pos;
+  unsigned previous{};
+  unsigned current{};
+};
+
+/**
+ * @class automaton_neighbourhood
+ *
+ * @brief Provides a rule with a cell and its eight neighbours.
+ *
+ * @details Cells outside of the layer have the GID zero.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_automaton.hpp
+ */
+class automaton_neighbourhood final {
+ public:
+  automaton_neighbourhood(const std::array<unsigned, 9>& cells,
+                          tile_pos pos,
+                          std::uint64_t key) noexcept
+      : m_cells{cells},
+        m_pos{pos},
+        m_key{key}
+  {}
+
+  /**
+   * @brief Returns the GID of the cell that is updated.
+   *
+   * @return the GID of the cell, including flip bits.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto center() const noexcept -> unsigned
+  {
+    return m_cells[4];
+  }
+
+  /**
+   * @brief Returns the GID of a cell in the neighbourhood.
+   *
+   * @param dx the column offset, in the range [-1, 1].
+   * @param dy the row offset, in the range [-1, 1].
+   *
+   * @return the GID of the cell, including flip bits.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto at(int dx, int dy) const noexcept -> unsigned
+  {
+    return m_cells[static_cast<std::size_t>((dy + 1) * 3 + dx + 1)];
+  }
+
+  /**
+   * @brief Returns the amount of neighbours with a specific GID.
+   *
+   * @details The cell that is updated isn't counted.
+   *
+   * @param gid the GID to look for, flip bits are ignored.
+   *
+   * @return the amount of neighbours with the GID, in the range [0, 8].
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto count(global_id gid) const noexcept -> int
+  {
+    auto result = 0;
+    for (std::size_t i = 0; i < m_cells.size(); ++i) {
+      if (i != 4 && strip_flip_bits(global_id{m_cells[i]}) == gid) {
+        ++result;
+      }
+    }
+    return result;
+  }
+
+  /**
+   * @brief Returns the position of the cell that is updated.
+   *
+   * @return the position of the cell.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto pos() const noexcept -> tile_pos
+  {
+    return m_pos;
+  }
+
+  /**
+   * @brief Returns a random value for the cell in the current generation.
+   *
+   * @details The value only depends on the seed of the automaton, the
+   * generation and the position, so results don't depend on the order in
+   * which cells are updated.
+   *
+   * @return a value in the range [0, 1).
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto random() const noexcept -> double
+  {
+    auto rng = detail::split_mix{m_key};
+    return detail::to_unit(rng());
+  }
+
+ private:
+  std::array<unsigned, 9> m_cells{};
+  tile_pos m_pos;
+  std::uint64_t m_key{};
+};
+
+/**
+ * @class cellular_automaton
+ *
+ * @brief A double-buffered cellular automaton over the cells of a tile layer.
+ *
+ * @details Rules are keyed on the GID of the updated cell, with flip bits
+ * ignored, and compute the next GID of the cell from its neighbourhood.
+ * Cells without a rule keep their GID.
+ *
+ * The layer is split into square blocks, which are stepped in parallel. Only
+ * blocks that changed in the previous step, the blocks next to them, and the
+ * blocks that contain spontaneous cells are stepped, so that stable areas are
+ * skipped. Spontaneous rules are rules that may change a cell even though its
+ * neighbourhood didn't change, e.g. due to randomness.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_automaton.hpp
+ */
+class cellular_automaton final {
+ public:
+  using rule = std::function<global_id(const automaton_neighbourhood&)>;
+
+  /**
+   * @brief Creates an empty automaton.
+   *
+   * @param width the amount of columns.
+   * @param height the amount of rows.
+   *
+   * @since 0.3.0
+   */
+  cellular_automaton(int width, int height)
+      : m_width{std::max(width, 0)},
+        m_height{std::max(height, 0)},
+        m_blockCols{(m_width + block_size - 1) / block_size},
+        m_blockRows{(m_height + block_size - 1) / block_size}
+  {
+    const auto size = static_cast<std::size_t>(m_width * m_height);
+    m_current.assign(size, 0);
+    m_next.assign(size, 0);
+
+    const auto blocks = static_cast<std::size_t>(m_blockCols * m_blockRows);
+    m_active.assign(blocks, 1);
+    m_spontaneous.assign(blocks, 0);
+  }
+
+  /**
+   * @brief Creates an automaton from the cells of a tile layer.
+   *
+   * @param map the map that contains the layer.
+   * @param layer the name of the tile layer, which may be nested in a group.
+   *
+   * @throws step_exception if there is no tile layer with the name.
+   *
+   * @since 0.3.0
+   */
+  cellular_automaton(const map& map, std::string_view layer)
+      : cellular_automaton{map.width(), map.height()}
+  {
+    const auto* tiles = detail::find_tile_layer(map.layers(), layer);
+    if (!tiles) {
+      throw step_exception{"cellular_automaton > Tile layer doesn't exist!"};
+    }
+
+    tiles->each([&](int col, int row, global_id gid) {
+      if (in_bounds(col, row)) {
+        m_current[index_of(col, row)] = gid.get();
+      }
+    });
+
+    m_next = m_current;
+  }
+
+  /**
+   * @brief Sets the rule for cells with a specific GID.
+   *
+   * @details All blocks are stepped in the next step, since the rule may
+   * change cells anywhere.
+   *
+   * @param gid the GID of the cells that the rule updates, flip bits are
+   * ignored.
+   * @param rule the rule, which must be safe to invoke concurrently.
+   * @param spontaneous `true` if the rule may change a cell even though its
+   * neighbourhood didn't change; `false` otherwise.
+   *
+   * @since 0.3.0
+   */
+  void set_rule(global_id gid, rule rule, bool spontaneous = false)
+  {
+    const auto index = static_cast<std::size_t>(strip_flip_bits(gid).get());
+    if (index >= m_rules.size()) {
+      m_rules.resize(index + 1);
+      m_isSpontaneous.resize(index + 1, 0);
+    }
+
+    m_rules[index] = std::move(rule);
+    m_isSpontaneous[index] = spontaneous ? 1 : 0;
+
+    std::fill(m_active.begin(), m_active.end(), 1);
+    std::fill(m_spontaneous.begin(), m_spontaneous.end(), 0);
+    for (auto row = 0; row < m_height; ++row) {
+      for (auto col = 0; col < m_width; ++col) {
+        if (is_spontaneous(m_current[index_of(col, row)])) {
+          ++m_spontaneous[block_of(col, row)];
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Advances the automaton by one generation.
+   *
+   * @param threads the maximum amount of threads, zero means the amount of
+   * hardware threads.
+   *
+   * @return the cells that changed, grouped by block and in row-major order
+   * within each block.
+   *
+   * @since 0.3.0
+   */
+  auto step(int threads = 0) -> const std::vector<cell_change>&
+  {
+    std::vector<int> blocks;
+    for (auto block = 0; block < m_blockCols * m_blockRows; ++block) {
+      const auto i = static_cast<std::size_t>(block);
+      if (m_active[i] || m_spontaneous[i] > 0) {
+        blocks.push_back(block);
+      }
+    }
+
+    std::vector<std::vector<cell_change>> found(blocks.size());
+    const auto count = static_cast<int>(blocks.size());
+    detail::parallel_for(0, count, threads, [&](int i) {
+      const auto index = static_cast<std::size_t>(i);
+      step_block(blocks[index], found[index]);
+    });
+
+    std::swap(m_current, m_next);
+    std::fill(m_active.begin(), m_active.end(), 0);
+
+    m_changes.clear();
+    for (const auto& changes : found) {
+      for (const auto& change : changes) {
+        // Keeps both buffers in sync, so inactive blocks never need copying
+        m_next[index_of(change.pos.col, change.pos.row)] = change.current;
+        on_changed(
+            change.pos.col, change.pos.row, change.previous, change.current);
+        m_changes.push_back(change);
+      }
+    }
+
+    ++m_generation;
+    m_steppedBlocks = blocks.size();
+    return m_changes;
+  }
+
+  /**
+   * @brief Changes a cell, outside of the rules.
+   *
+   * @param col the column of the cell.
+   * @param row the row of the cell.
+   * @param gid the new GID of the cell, including flip bits.
+   *
+   * @throws step_exception if the cell is outside of the layer.
+   *
+   * @since 0.3.0
+   */
+  void set(int col, int row, global_id gid)
+  {
+    if (!in_bounds(col, row)) {
+      throw step_exception{"cellular_automaton > Cell is out of bounds!"};
+    }
+
+    const auto index = index_of(col, row);
+    const auto previous = m_current[index];
+    m_current[index] = gid.get();
+    m_next[index] = gid.get();
+    on_changed(col, row, previous, gid.get());
+  }
+
+  /**
+   * @brief Returns the GID of a cell.
+   *
+   * @param col the column of the cell.
+   * @param row the row of the cell.
+   *
+   * @return the GID of the cell, including flip bits; zero if the cell is
+   * outside of the layer.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto gid_at(int col, int row) const noexcept -> global_id
+  {
+    return global_id{in_bounds(col, row) ? m_current[index_of(col, row)] : 0u};
+  }
+
+  /**
+   * @brief Returns the GIDs of the current generation.
+   *
+   * @return the GIDs in row-major order, including flip bits.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto gids() const noexcept -> const std::vector<unsigned>&
+  {
+    return m_current;
+  }
+
+  /**
+   * @brief Returns the cells that were changed by the last step.
+   *
+   * @return the cells that were changed by the last step.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto changes() const noexcept
+      -> const std::vector<cell_change>&
+  {
+    return m_changes;
+  }
+
+  /**
+   * @brief Sets the seed used by the random values of the neighbourhoods.
+   *
+   * @param seed the new seed.
+   *
+   * @since 0.3.0
+   */
+  void set_seed(std::uint64_t seed) noexcept
+  {
+    m_seed = seed;
+  }
+
+  /**
+   * @brief Returns the amount of steps that have been taken.
+   *
+   * @return the current generation.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto generation() const noexcept -> std::uint64_t
+  {
+    return m_generation;
+  }
+
+  /**
+   * @brief Returns the amount of blocks that were stepped by the last step.
+   *
+   * @return the amount of blocks that were stepped by the last step.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto stepped_blocks() const noexcept -> std::size_t
+  {
+    return m_steppedBlocks;
+  }
+
+  /**
+   * @brief Returns the width of the automaton.
+   *
+   * @return the amount of columns.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto width() const noexcept -> int
+  {
+    return m_width;
+  }
+
+  /**
+   * @brief Returns the height of the automaton.
+   *
+   * @return the amount of rows.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto height() const noexcept -> int
+  {
+    return m_height;
+  }
+
+  /**
+   * @brief The width and height of the blocks, in cells.
+   *
+   * @since 0.3.0
+   */
+  static constexpr int block_size = 32;
+
+ private:
+  int m_width{};
+  int m_height{};
+  int m_blockCols{};
+  int m_blockRows{};
+  std::uint64_t m_seed{};
+  std::uint64_t m_generation{};
+  std::size_t m_steppedBlocks{};
+  std::vector<unsigned> m_current;
+  std::vector<unsigned> m_next;
+  std::vector<rule> m_rules;
+  std::vector<unsigned char> m_isSpontaneous;
+  std::vector<unsigned char> m_active;
+  std::vector<int> m_spontaneous;
+  std::vector<cell_change> m_changes;
+
+  [[nodiscard]] auto in_bounds(int col, int row) const noexcept -> bool
+  {
+    return col >= 0 && row >= 0 && col < m_width && row < m_height;
+  }
+
+  [[nodiscard]] auto index_of(int col, int row) const noexcept -> std::size_t
+  {
+    return static_cast<std::size_t>(row * m_width + col);
+  }
+
+  [[nodiscard]] auto block_of(int col, int row) const noexcept -> std::size_t
+  {
+    return static_cast<std::size_t>((row / block_size) * m_blockCols +
+                                    col / block_size);
+  }
+
+  [[nodiscard]] auto rule_of(unsigned gid) const noexcept -> const rule*
+  {
+    const auto index = static_cast<std::size_t>(
+        strip_flip_bits(global_id{gid}).get());
+    return index < m_rules.size() && m_rules[index] ? &m_rules[index]
+                                                    : nullptr;
+  }
+
+  [[nodiscard]] auto is_spontaneous(unsigned gid) const noexcept -> bool
+  {
+    const auto index = static_cast<std::size_t>(
+        strip_flip_bits(global_id{gid}).get());
+    return index < m_isSpontaneous.size() && m_isSpontaneous[index];
+  }
+
+  void on_changed(int col, int row, unsigned previous, unsigned current)
+  {
+    const auto block = block_of(col, row);
+    m_spontaneous[block] -= is_spontaneous(previous) ? 1 : 0;
+    m_spontaneous[block] += is_spontaneous(current) ? 1 : 0;
+
+    // Neighbouring blocks read this cell, so they have to be stepped as well
+    const auto blockCol = col / block_size;
+    const auto blockRow = row / block_size;
+    for (auto r = std::max(blockRow - 1, 0);
+         r <= std::min(blockRow + 1, m_blockRows - 1);
+         ++r) {
+      for (auto c = std::max(blockCol - 1, 0);
+           c <= std::min(blockCol + 1, m_blockCols - 1);
+           ++c) {
+        m_active[static_cast<std::size_t>(r * m_blockCols + c)] = 1;
+      }
+    }
+  }
+
+  void step_block(int block, std::vector<cell_change>& changes)
+  {
+    const auto firstCol = (block % m_blockCols) * block_size;
+    const auto firstRow = (block / m_blockCols) * block_size;
+    const auto lastCol = std::min(firstCol + block_size, m_width);
+    const auto lastRow = std::min(firstRow + block_size, m_height);
+
+    const auto generationKey = m_seed ^ (m_generation * 0x9E3779B97F4A7C15ull);
+
+    std::array<unsigned, 9> cells{};
+    for (auto row = firstRow; row < lastRow; ++row) {
+      for (auto col = firstCol; col < lastCol; ++col) {
+        const auto index = index_of(col, row);
+        const auto current = m_current[index];
+
+        const auto* rule = rule_of(current);
+        if (!rule) {
+          m_next[index] = current;
+          continue;
+        }
+
+        for (auto dy = -1; dy <= 1; ++dy) {
+          for (auto dx = -1; dx <= 1; ++dx) {
+            const auto c = col + dx;
+            const auto r = row + dy;
+            cells[static_cast<std::size_t>((dy + 1) * 3 + dx + 1)] =
+                in_bounds(c, r) ? m_current[index_of(c, r)] : 0u;
+          }
+        }
+
+        const auto key = detail::split_mix::stream(generationKey, index)();
+        const automaton_neighbourhood neighbourhood{cells, {col, row}, key};
+
+        const auto next = (*rule)(neighbourhood).get();
+        m_next[index] = next;
+        if (next != current) {
+          changes.push_back({{col, row}, current, next});
+        }
+      }
+    }
+  }
+};
+
+}  // namespace step
+
+#endif  // STEP_AUTOMATON_HEADER
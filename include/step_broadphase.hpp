@@ -0,0 +1,663 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_broadphase.hpp
+ *
+ * @brief Provides the `object_broadphase` class.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_BROADPHASE_HEADER
+#define STEP_BROADPHASE_HEADER
+
+#include <algorithm>  // min, max, remove_if
+#include <cmath>      // cos, sin, sqrt
+#include <cstddef>    // size_t
+#include <vector>     // vector
+
+#include "step_api.hpp"
+#include "step_exception.hpp"
+#include "step_geometry.hpp"
+#include "step_object.hpp"
+#include "step_object_group.hpp"
+#include "step_point.hpp"
+#include "step_rect.hpp"
+#include "step_types.hpp"
+
+namespace step {
+
+/**
+ * @struct object_pair
+ *
+ * @brief A simple data container for a pair of overlapping objects.
+ *
+ * @details The members are indices of objects in an `object_broadphase`,
+ * where `first` is always less than `second`.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_broadphase.hpp
+ */
+struct object_pair final {
+  std::size_t first{};   ///< The index of the first object.
+  std::size_t second{};  ///< The index of the second object.
+};
+
+/**
+ * @brief Indicates whether or not two object pairs are equal.
+ *
+ * @param lhs the left-hand side pair.
+ * @param rhs the right-hand side pair.
+ *
+ * @return `true` if the pairs are equal; `false` otherwise.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] constexpr auto operator==(const object_pair& lhs,
+                                        const object_pair& rhs) noexcept
+    -> bool
+{
+  return lhs.first == rhs.first && lhs.second == rhs.second;
+}
+
+/**
+ * @brief Indicates whether or not two object pairs aren't equal.
+ *
+ * @param lhs the left-hand side pair.
+ * @param rhs the right-hand side pair.
+ *
+ * @return `true` if the pairs aren't equal; `false` otherwise.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] constexpr auto operator!=(const object_pair& lhs,
+                                        const object_pair& rhs) noexcept
+    -> bool
+{
+  return !(lhs == rhs);
+}
+
+/**
+ * @class object_broadphase
+ *
+ * @brief Finds the pairs of overlapping objects in a set of object groups.
+ *
+ * @details The objects of the groups are numbered in order, i.e. the objects
+ * of the first group come first. Each object is enclosed in a world-space
+ * bounding box, which accounts for the rotation of the object, and the boxes
+ * are kept sorted by their left edges. Candidate pairs are found by sweeping
+ * over the sorted boxes (sort and sweep), and are confirmed with exact tests
+ * of the shapes.
+ *
+ * Rectangles, tile objects and texts are tested as rectangles, polygons and
+ * polylines as closed polygons, ellipses exactly against polygons and points,
+ * and ellipses against other ellipses by approximating one of them with a
+ * polygon. Objects whose bounding boxes only touch are never reported.
+ *
+ * Objects can be moved and rotated. The next `update()` then restores the
+ * sorted order with an insertion sort, which is fast since only a few boxes
+ * are out of order, and only looks for new pairs of the moved objects.
+ *
+ * @warning The broadphase refers to the objects of the groups, so the groups
+ * must outlive the broadphase.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_broadphase.hpp
+ */
+class object_broadphase final {
+ public:
+  /**
+   * @enum object_broadphase::pairs_of
+   *
+   * @brief Selects the pairs that are reported.
+   *
+   * @since 0.3.0
+   */
+  enum class pairs_of {
+    all,           ///< Pairs within and across groups.
+    across_groups  ///< Only pairs of objects in different groups.
+  };
+
+  /**
+   * @brief Creates a broadphase for the objects of some object groups.
+   *
+   * @details The pairs are computed by the constructor.
+   *
+   * @param groups the object groups, which must not be null.
+   * @param selection the pairs that are reported.
+   *
+   * @throws step_exception if any of the groups is null.
+   *
+   * @since 0.3.0
+   */
+  explicit object_broadphase(const std::vector<const object_group*>& groups,
+                             pairs_of selection = pairs_of::all)
+      : m_selection{selection}
+  {
+    for (std::size_t group = 0; group < groups.size(); ++group) {
+      if (!groups[group]) {
+        throw step_exception{"object_broadphase > Null object group!"};
+      }
+
+      for (const auto& object : groups[group]->objects()) {
+        proxy p;
+        p.source = &object;
+        p.group = group;
+        p.position = point{object.x(), object.y()};
+        p.rotation = object.rotation();
+        m_proxies.push_back(p);
+      }
+    }
+
+    m_shapes.resize(m_proxies.size());
+    m_order.resize(m_proxies.size());
+    m_rank.resize(m_proxies.size());
+    for (std::size_t i = 0; i < m_proxies.size(); ++i) {
+      refresh(i);
+      m_order[i] = i;
+    }
+
+    update();
+  }
+
+  /**
+   * @brief Moves an object.
+   *
+   * @details The object itself isn't modified. The pairs are updated by the
+   * next call to `update()`. This function has no effect if the index is
+   * out-of-bounds.
+   *
+   * @param index the index of the object.
+   * @param position the new position of the object, in pixels.
+   *
+   * @since 0.3.0
+   */
+  void set_position(std::size_t index, const point& position)
+  {
+    if (index < m_proxies.size()) {
+      m_proxies[index].position = position;
+      refresh(index);
+      mark_dirty(index);
+    }
+  }
+
+  /**
+   * @brief Rotates an object.
+   *
+   * @details The object itself isn't modified. The pairs are updated by the
+   * next call to `update()`. This function has no effect if the index is
+   * out-of-bounds.
+   *
+   * @param index the index of the object.
+   * @param degrees the new clockwise rotation of the object, in degrees.
+   *
+   * @since 0.3.0
+   */
+  void set_rotation(std::size_t index, double degrees)
+  {
+    if (index < m_proxies.size()) {
+      m_proxies[index].rotation = degrees;
+      refresh(index);
+      mark_dirty(index);
+    }
+  }
+
+  /**
+   * @brief Updates the pairs after objects have been moved or rotated.
+   *
+   * @details If many objects have been moved, all pairs are computed again.
+   *
+   * @since 0.3.0
+   */
+  void update()
+  {
+    sort();
+
+    if (!m_initialized || m_dirty.size() * 4 > m_proxies.size()) {
+      sweep_all();
+      m_initialized = true;
+    } else if (!m_dirty.empty()) {
+      sweep_dirty();
+    }
+
+    for (const auto index : m_dirty) {
+      m_proxies[index].dirty = false;
+    }
+    m_dirty.clear();
+  }
+
+  /**
+   * @brief Returns the pairs of overlapping objects.
+   *
+   * @details The order of the pairs is unspecified.
+   *
+   * @return the pairs of overlapping objects, as of the last update.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto pairs() const noexcept -> const std::vector<object_pair>&
+  {
+    return m_pairs;
+  }
+
+  /**
+   * @brief Indicates whether or not two objects overlap.
+   *
+   * @details This function ignores the selection of pairs.
+   *
+   * @param a the index of the first object.
+   * @param b the index of the second object.
+   *
+   * @return `true` if the objects overlap; `false` otherwise.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto overlaps(std::size_t a, std::size_t b) const -> bool
+  {
+    if (a == b || a >= m_proxies.size() || b >= m_proxies.size()) {
+      return false;
+    }
+    return boxes_overlap(m_proxies[a], m_proxies[b]) &&
+           shapes_overlap(m_shapes[a], m_shapes[b]);
+  }
+
+  /**
+   * @brief Returns an object.
+   *
+   * @param index the index of the object.
+   *
+   * @return the object, without any changes to its position or rotation.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto object_at(std::size_t index) const -> const object&
+  {
+    return *m_proxies.at(index).source;
+  }
+
+  /**
+   * @brief Returns the group that an object belongs to.
+   *
+   * @param index the index of the object.
+   *
+   * @return the index of the group of the object.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto group_of(std::size_t index) const -> std::size_t
+  {
+    return m_proxies.at(index).group;
+  }
+
+  /**
+   * @brief Returns the world-space bounding box of an object.
+   *
+   * @param index the index of the object.
+   *
+   * @return the bounding box of the object.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto bounds(std::size_t index) const -> rect
+  {
+    const auto& p = m_proxies.at(index);
+    return {p.minX, p.minY, p.maxX - p.minX, p.maxY - p.minY};
+  }
+
+  /**
+   * @brief Returns the amount of objects.
+   *
+   * @return the amount of objects in all of the groups.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto size() const noexcept -> std::size_t
+  {
+    return m_proxies.size();
+  }
+
+ private:
+  static constexpr int ellipse_segments = 64;
+
+  struct proxy final {
+    const object* source{};
+    std::size_t group{};
+    point position;
+    double rotation{};
+    double minX{};
+    double minY{};
+    double maxX{};
+    double maxY{};
+    bool dirty{};
+  };
+
+  /// The shape of an object in world space.
+  struct shape final {
+    enum class kind { point, polygon, ellipse };
+
+    kind type{kind::point};
+    std::vector<point> points;  ///< The polygon, or the approximate ellipse.
+    point origin;               ///< The rotation origin of ellipses.
+    double cos{1};
+    double sin{};
+    double rx{};
+    double ry{};
+  };
+
+  pairs_of m_selection{pairs_of::all};
+  std::vector<proxy> m_proxies;
+  std::vector<shape> m_shapes;
+  std::vector<std::size_t> m_order;  ///< Indices sorted by left edges.
+  std::vector<std::size_t> m_rank;   ///< Positions in the sorted order.
+  std::vector<std::size_t> m_dirty;
+  std::vector<object_pair> m_pairs;
+  double m_maxWidth{};
+  bool m_initialized{};
+
+  void mark_dirty(std::size_t index)
+  {
+    if (!m_proxies[index].dirty) {
+      m_proxies[index].dirty = true;
+      m_dirty.push_back(index);
+    }
+  }
+
+  /// Computes the world-space shape and bounding box of an object.
+  void refresh(std::size_t index)
+  {
+    auto& p = m_proxies[index];
+    auto& s = m_shapes[index];
+    const auto& object = *p.source;
+
+    const auto radians = p.rotation * detail::pi / 180.0;
+    s.cos = std::cos(radians);
+    s.sin = std::sin(radians);
+    s.origin = p.position;
+    s.points.clear();
+
+    const auto width = object.width();
+    const auto height = object.height();
+    const auto place = [&](const point& offset) {
+      s.points.push_back(detail::rotate(s.origin, offset, s.cos, s.sin));
+    };
+
+    if (object.is_point() || (!object.has<polygon>() &&
+                              !object.has<polyline>() && width <= 0 &&
+                              height <= 0)) {
+      s.type = shape::kind::point;
+      place({0, 0});
+    } else if (object.is_ellipse() && width > 0 && height > 0) {
+      s.type = shape::kind::ellipse;
+      s.rx = width / 2.0;
+      s.ry = height / 2.0;
+      for (auto i = 0; i < ellipse_segments; ++i) {
+        const auto angle = 2 * detail::pi * i / ellipse_segments;
+        place({s.rx + s.rx * std::cos(angle), s.ry + s.ry * std::sin(angle)});
+      }
+    } else if (const auto* poly = object.try_as<polygon>()) {
+      s.type = shape::kind::polygon;
+      for (const auto& vertex : poly->points) {
+        place(vertex);
+      }
+    } else if (const auto* line = object.try_as<polyline>()) {
+      s.type = shape::kind::polygon;
+      for (const auto& vertex : line->points) {
+        place(vertex);
+      }
+    } else {
+      // Tile objects are aligned to their bottom-left corner
+      const auto top = object.has<global_id>() ? -height : 0.0;
+      s.type = shape::kind::polygon;
+      place({0, top});
+      place({width, top});
+      place({width, top + height});
+      place({0, top + height});
+    }
+
+    if (s.type == shape::kind::ellipse) {
+      const auto center =
+          detail::rotate(s.origin, point{s.rx, s.ry}, s.cos, s.sin);
+      const auto ex = std::sqrt(s.rx * s.rx * s.cos * s.cos +
+                                s.ry * s.ry * s.sin * s.sin);
+      const auto ey = std::sqrt(s.rx * s.rx * s.sin * s.sin +
+                                s.ry * s.ry * s.cos * s.cos);
+      p.minX = center.x() - ex;
+      p.maxX = center.x() + ex;
+      p.minY = center.y() - ey;
+      p.maxY = center.y() + ey;
+    } else if (s.points.empty()) {
+      s.type = shape::kind::point;
+      p.minX = p.maxX = s.origin.x();
+      p.minY = p.maxY = s.origin.y();
+      s.points.push_back(s.origin);
+    } else {
+      p.minX = p.maxX = s.points.front().x();
+      p.minY = p.maxY = s.points.front().y();
+      for (const auto& vertex : s.points) {
+        p.minX = std::min(p.minX, vertex.x());
+        p.maxX = std::max(p.maxX, vertex.x());
+        p.minY = std::min(p.minY, vertex.y());
+        p.maxY = std::max(p.maxY, vertex.y());
+      }
+    }
+
+    m_maxWidth = std::max(m_maxWidth, p.maxX - p.minX);
+  }
+
+  /// Restores the sorted order, which is cheap if it is almost sorted.
+  void sort()
+  {
+    for (std::size_t i = 1; i < m_order.size(); ++i) {
+      const auto index = m_order[i];
+      const auto key = m_proxies[index].minX;
+
+      auto j = i;
+      while (j > 0 && m_proxies[m_order[j - 1]].minX > key) {
+        m_order[j] = m_order[j - 1];
+        m_rank[m_order[j]] = j;
+        --j;
+      }
+
+      m_order[j] = index;
+      m_rank[index] = j;
+    }
+
+    if (!m_order.empty()) {
+      m_rank[m_order.front()] = 0;
+    }
+  }
+
+  [[nodiscard]] static auto boxes_overlap(const proxy& a,
+                                          const proxy& b) noexcept -> bool
+  {
+    return a.minX < b.maxX && b.minX < a.maxX && a.minY < b.maxY &&
+           b.minY < a.maxY;
+  }
+
+  /// Tests a candidate pair and adds it if the shapes overlap.
+  void consider(std::size_t a, std::size_t b)
+  {
+    const auto& pa = m_proxies[a];
+    const auto& pb = m_proxies[b];
+    if (m_selection == pairs_of::across_groups && pa.group == pb.group) {
+      return;
+    }
+
+    if (boxes_overlap(pa, pb) && shapes_overlap(m_shapes[a], m_shapes[b])) {
+      m_pairs.push_back({std::min(a, b), std::max(a, b)});
+    }
+  }
+
+  void sweep_all()
+  {
+    m_pairs.clear();
+    m_maxWidth = 0;
+
+    std::vector<std::size_t> active;
+    for (const auto index : m_order) {
+      const auto& p = m_proxies[index];
+      m_maxWidth = std::max(m_maxWidth, p.maxX - p.minX);
+
+      active.erase(std::remove_if(active.begin(),
+                                  active.end(),
+                                  [&](std::size_t other) {
+                                    return m_proxies[other].maxX <= p.minX;
+                                  }),
+                   active.end());
+
+      for (const auto other : active) {
+        consider(other, index);
+      }
+      active.push_back(index);
+    }
+  }
+
+  void sweep_dirty()
+  {
+    m_pairs.erase(std::remove_if(m_pairs.begin(),
+                                 m_pairs.end(),
+                                 [this](const object_pair& pair) {
+                                   return m_proxies[pair.first].dirty ||
+                                          m_proxies[pair.second].dirty;
+                                 }),
+                  m_pairs.end());
+
+    for (const auto index : m_dirty) {
+      const auto& p = m_proxies[index];
+      const auto rank = m_rank[index];
+
+      // Pairs of two moved objects are found by the one with the lower index
+      const auto visit = [&](std::size_t other) {
+        if (!m_proxies[other].dirty || other > index) {
+          consider(index, other);
+        }
+      };
+
+      for (auto i = rank; i-- > 0;) {
+        const auto other = m_order[i];
+        if (m_proxies[other].minX < p.minX - m_maxWidth) {
+          break;
+        }
+        if (m_proxies[other].maxX > p.minX) {
+          visit(other);
+        }
+      }
+
+      for (auto i = rank + 1; i < m_order.size(); ++i) {
+        const auto other = m_order[i];
+        if (m_proxies[other].minX >= p.maxX) {
+          break;
+        }
+        visit(other);
+      }
+    }
+  }
+
+  /// Maps a point into the space where an ellipse is the unit circle.
+  [[nodiscard]] static auto to_unit(const shape& ellipse,
+                                    const point& p) noexcept -> point
+  {
+    const auto dx = p.x() - ellipse.origin.x();
+    const auto dy = p.y() - ellipse.origin.y();
+    const auto x = dx * ellipse.cos + dy * ellipse.sin;
+    const auto y = -dx * ellipse.sin + dy * ellipse.cos;
+    return {(x - ellipse.rx) / ellipse.rx, (y - ellipse.ry) / ellipse.ry};
+  }
+
+  [[nodiscard]] static auto ellipse_overlaps(const shape& ellipse,
+                                             const std::vector<point>& points)
+      -> bool
+  {
+    std::vector<point> unit;
+    unit.reserve(points.size());
+    for (const auto& p : points) {
+      unit.push_back(to_unit(ellipse, p));
+    }
+
+    const point center{0, 0};
+    if (unit.size() == 1) {
+      return detail::distance_squared(center, unit.front()) <= 1;
+    }
+
+    if (detail::polygon_contains(unit.data(), unit.size(), center)) {
+      return true;
+    }
+
+    for (std::size_t i = 0, j = unit.size() - 1; i < unit.size(); j = i++) {
+      const auto closest = detail::closest_on_segment(center, unit[j], unit[i]);
+      if (detail::distance_squared(center, closest) <= 1) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  [[nodiscard]] static auto polygons_overlap(const std::vector<point>& a,
+                                             const std::vector<point>& b)
+      -> bool
+  {
+    if (a.size() == 1 && b.size() == 1) {
+      return a.front().x() == b.front().x() && a.front().y() == b.front().y();
+    } else if (a.size() == 1) {
+      return detail::polygon_contains(b.data(), b.size(), a.front());
+    } else if (b.size() == 1) {
+      return detail::polygon_contains(a.data(), a.size(), b.front());
+    }
+
+    for (std::size_t i = 0, j = a.size() - 1; i < a.size(); j = i++) {
+      for (std::size_t k = 0, l = b.size() - 1; k < b.size(); l = k++) {
+        if (detail::segments_intersect(a[j], a[i], b[l], b[k])) {
+          return true;
+        }
+      }
+    }
+
+    return detail::polygon_contains(a.data(), a.size(), b.front()) ||
+           detail::polygon_contains(b.data(), b.size(), a.front());
+  }
+
+  [[nodiscard]] static auto shapes_overlap(const shape& a, const shape& b)
+      -> bool
+  {
+    if (a.type == shape::kind::ellipse) {
+      return ellipse_overlaps(a, b.points);
+    } else if (b.type == shape::kind::ellipse) {
+      return ellipse_overlaps(b, a.points);
+    } else {
+      return polygons_overlap(a.points, b.points);
+    }
+  }
+};
+
+}  // namespace step
+
+#endif  // STEP_BROADPHASE_HEADER
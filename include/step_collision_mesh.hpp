@@ -0,0 +1,561 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_collision_mesh.hpp
+ *
+ * @brief Provides the `collision_mesh` class, which merges solid tiles into
+ * rectangles.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_COLLISION_MESH_HEADER
+#define STEP_COLLISION_MESH_HEADER
+
+#include <algorithm>    // min, max
+#include <cstddef>      // size_t
+#include <string_view>  // string_view
+#include <type_traits>  // enable_if_t
+#include <utility>      // move
+#include <vector>       // vector
+
+#include "step_api.hpp"
+#include "step_exception.hpp"
+#include "step_layer.hpp"
+#include "step_map.hpp"
+#include "step_object.hpp"
+#include "step_object_group.hpp"
+#include "step_point.hpp"
+#include "step_rect.hpp"
+#include "step_tile_mask.hpp"
+#include "step_types.hpp"
+#include "step_utils.hpp"
+
+namespace step {
+
+/**
+ * @struct collision_shape
+ *
+ * @brief A simple data container for a collision object of a tile placed in a
+ * tile layer.
+ *
+ * @details The coordinates of the object are relative to the tile, so the
+ * world position of the object is `offset + (object.x(), object.y())`.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_collision_mesh.hpp
+ */
+struct collision_shape final {
+  const object* shape{};  ///< The object in the object group of the tile.
+  point offset;           ///< The world position of the top-left of the tile.
+  global_id gid{0};       ///< The GID of the tile, including any flip flags.
+};
+
+/**
+ * @class collision_mesh
+ *
+ * @brief Provides static collision geometry derived from the tile layers of a
+ * map.
+ *
+ * @details The map is divided into square chunks of tiles. The solid tiles of
+ * each chunk are merged into as few axis-aligned rectangles as possible by
+ * greedy meshing, i.e. runs of solid tiles are grown horizontally and then
+ * vertically. Rectangles never cross chunk borders, which means that changing
+ * a tile only requires the chunk that contains the tile to be rebuilt. The
+ * collision objects of tiles, i.e. the contents of `tile::object_group()`, are
+ * collected per chunk and offset into world space.
+ *
+ * @note The world positions are computed for orthogonal maps.
+ *
+ * @warning The collision shapes refer to objects owned by the map, so the
+ * mesh must not outlive the map that it was created from.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_collision_mesh.hpp
+ */
+class collision_mesh final {
+ public:
+  /**
+   * @brief Creates a collision mesh from the tile layers of a map.
+   *
+   * @tparam Predicate the type of the predicate.
+   *
+   * @param map the map that provides the tile layers.
+   * @param isSolid the predicate that takes a single `const tile&` argument
+   * and indicates whether or not the tile is solid, e.g. by checking
+   * `tile::type()`.
+   * @param chunkSize the width and height of the chunks, in tiles.
+   *
+   * @throws step_exception if any tile layer uses Base64 encoded data.
+   *
+   * @since 0.3.0
+   */
+  template <typename Predicate,
+            typename = std::enable_if_t<detail::is_tile_predicate<Predicate>>>
+  collision_mesh(const map& map, Predicate&& isSolid, int chunkSize = 16)
+      : collision_mesh{make_tile_mask(map, isSolid),
+                       map.tile_width(),
+                       map.tile_height(),
+                       chunkSize}
+  {
+    collect_shapes(map);
+  }
+
+  /**
+   * @brief Creates a collision mesh from the tile layers of a map, where solid
+   * tiles are identified by a boolean property.
+   *
+   * @param map the map that provides the tile layers.
+   * @param property the name of the boolean tile property, e.g. `"solid"`.
+   * @param chunkSize the width and height of the chunks, in tiles.
+   *
+   * @throws step_exception if any tile layer uses Base64 encoded data.
+   *
+   * @since 0.3.0
+   */
+  collision_mesh(const map& map, std::string_view property, int chunkSize = 16)
+      : collision_mesh{make_tile_mask(map, property),
+                       map.tile_width(),
+                       map.tile_height(),
+                       chunkSize}
+  {
+    collect_shapes(map);
+  }
+
+  /**
+   * @brief Creates a collision mesh from a mask of solid tiles.
+   *
+   * @param solid the mask of solid tiles.
+   * @param tileWidth the width of the tiles, in pixels.
+   * @param tileHeight the height of the tiles, in pixels.
+   * @param chunkSize the width and height of the chunks, in tiles.
+   *
+   * @since 0.3.0
+   */
+  collision_mesh(tile_mask solid,
+                 int tileWidth,
+                 int tileHeight,
+                 int chunkSize = 16)
+      : m_solid{std::move(solid)},
+        m_tileWidth{tileWidth},
+        m_tileHeight{tileHeight},
+        m_chunkSize{std::max(chunkSize, 1)},
+        m_chunkCols{(m_solid.width() + m_chunkSize - 1) / m_chunkSize},
+        m_chunkRows{(m_solid.height() + m_chunkSize - 1) / m_chunkSize},
+        m_regions(static_cast<std::size_t>(m_chunkCols) *
+                  static_cast<std::size_t>(m_chunkRows))
+  {
+    rebuild();
+  }
+
+  /**
+   * @brief Changes whether or not a tile is solid.
+   *
+   * @details The chunk that contains the tile is rebuilt by the next call to
+   * `rebuild()`. This function has no effect if the position is out-of-bounds
+   * or if the tile already has the specified state.
+   *
+   * @param col the column of the tile.
+   * @param row the row of the tile.
+   * @param solid `true` if the tile should be solid; `false` otherwise.
+   *
+   * @since 0.3.0
+   */
+  void set_solid(int col, int row, bool solid) noexcept
+  {
+    if (m_solid.contains(col, row) && m_solid.test(col, row) != solid) {
+      m_solid.set(col, row, solid);
+      region_at(col / m_chunkSize, row / m_chunkSize).dirty = true;
+      m_dirty = true;
+    }
+  }
+
+  /**
+   * @brief Rebuilds the rectangles of all chunks that have been changed.
+   *
+   * @return the amount of chunks that were rebuilt.
+   *
+   * @since 0.3.0
+   */
+  auto rebuild() -> int
+  {
+    if (!m_dirty) {
+      return 0;
+    }
+
+    int count = 0;
+    for (int chunkRow = 0; chunkRow < m_chunkRows; ++chunkRow) {
+      for (int chunkCol = 0; chunkCol < m_chunkCols; ++chunkCol) {
+        auto& region = region_at(chunkCol, chunkRow);
+        if (region.dirty) {
+          mesh(chunkCol, chunkRow, region);
+          ++count;
+        }
+      }
+    }
+
+    m_dirty = false;
+    return count;
+  }
+
+  /**
+   * @brief Iterates over all rectangles that intersect an area.
+   *
+   * @details Only the chunks that overlap the area are visited.
+   *
+   * @tparam Lambda the type of the lambda object.
+   *
+   * @param area the area to look for rectangles in, in pixels.
+   * @param lambda the lambda that takes a single `const rect&` argument.
+   *
+   * @since 0.3.0
+   */
+  template <typename Lambda>
+  void query(const rect& area, Lambda&& lambda) const
+  {
+    each_overlapping_region(area, [&](const region& region) {
+      for (const auto& rect : region.rects) {
+        if (intersects(rect, area)) {
+          lambda(rect);
+        }
+      }
+    });
+  }
+
+  /**
+   * @brief Iterates over all tile collision objects in the chunks that overlap
+   * an area.
+   *
+   * @details The shapes themselves aren't tested against the area.
+   *
+   * @tparam Lambda the type of the lambda object.
+   *
+   * @param area the area to look for shapes in, in pixels.
+   * @param lambda the lambda that takes a single `const collision_shape&`
+   * argument.
+   *
+   * @since 0.3.0
+   */
+  template <typename Lambda>
+  void query_shapes(const rect& area, Lambda&& lambda) const
+  {
+    each_overlapping_region(area, [&](const region& region) {
+      for (const auto& shape : region.shapes) {
+        lambda(shape);
+      }
+    });
+  }
+
+  /**
+   * @brief Returns the rectangles of a chunk.
+   *
+   * @param chunkCol the column of the chunk.
+   * @param chunkRow the row of the chunk.
+   *
+   * @return the merged rectangles of the solid tiles in the chunk, in pixels.
+   *
+   * @throws step_exception if the chunk position is out-of-bounds.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto chunk_rects(int chunkCol, int chunkRow) const
+      -> const std::vector<rect>&
+  {
+    return checked_region_at(chunkCol, chunkRow).rects;
+  }
+
+  /**
+   * @brief Returns the tile collision objects of a chunk.
+   *
+   * @param chunkCol the column of the chunk.
+   * @param chunkRow the row of the chunk.
+   *
+   * @return the collision objects of the tiles in the chunk.
+   *
+   * @throws step_exception if the chunk position is out-of-bounds.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto chunk_shapes(int chunkCol, int chunkRow) const
+      -> const std::vector<collision_shape>&
+  {
+    return checked_region_at(chunkCol, chunkRow).shapes;
+  }
+
+  /**
+   * @brief Returns all of the rectangles in the mesh.
+   *
+   * @return the merged rectangles of all chunks, in pixels.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto rects() const -> std::vector<rect>
+  {
+    std::vector<rect> result;
+    result.reserve(static_cast<std::size_t>(rect_count()));
+    for (const auto& region : m_regions) {
+      result.insert(result.end(), region.rects.begin(), region.rects.end());
+    }
+    return result;
+  }
+
+  /**
+   * @brief Returns the total amount of rectangles in the mesh.
+   *
+   * @return the amount of rectangles in the mesh.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto rect_count() const noexcept -> int
+  {
+    std::size_t count = 0;
+    for (const auto& region : m_regions) {
+      count += region.rects.size();
+    }
+    return static_cast<int>(count);
+  }
+
+  /**
+   * @brief Returns the mask of solid tiles used by the mesh.
+   *
+   * @return the mask of solid tiles.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto solid() const noexcept -> const tile_mask&
+  {
+    return m_solid;
+  }
+
+  /**
+   * @brief Returns the width and height of the chunks, in tiles.
+   *
+   * @return the size of the chunks, in tiles.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto chunk_size() const noexcept -> int
+  {
+    return m_chunkSize;
+  }
+
+  /**
+   * @brief Returns the amount of chunk columns.
+   *
+   * @return the amount of chunk columns.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto chunk_cols() const noexcept -> int
+  {
+    return m_chunkCols;
+  }
+
+  /**
+   * @brief Returns the amount of chunk rows.
+   *
+   * @return the amount of chunk rows.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto chunk_rows() const noexcept -> int
+  {
+    return m_chunkRows;
+  }
+
+ private:
+  struct region final {
+    std::vector<rect> rects;
+    std::vector<collision_shape> shapes;
+    bool dirty{true};
+  };
+
+  tile_mask m_solid;
+  int m_tileWidth{};
+  int m_tileHeight{};
+  int m_chunkSize{};
+  int m_chunkCols{};
+  int m_chunkRows{};
+  std::vector<region> m_regions;
+  bool m_dirty{true};
+
+  [[nodiscard]] auto region_at(int chunkCol, int chunkRow) -> region&
+  {
+    return m_regions[static_cast<std::size_t>(chunkRow) * m_chunkCols +
+                     static_cast<std::size_t>(chunkCol)];
+  }
+
+  [[nodiscard]] auto checked_region_at(int chunkCol, int chunkRow) const
+      -> const region&
+  {
+    if (chunkCol < 0 || chunkRow < 0 || chunkCol >= m_chunkCols ||
+        chunkRow >= m_chunkRows) {
+      throw step_exception{"collision_mesh > Chunk position out-of-bounds!"};
+    }
+    return m_regions[static_cast<std::size_t>(chunkRow) * m_chunkCols +
+                     static_cast<std::size_t>(chunkCol)];
+  }
+
+  template <typename Lambda>
+  void each_overlapping_region(const rect& area, Lambda&& lambda) const
+  {
+    const auto chunkWidth = static_cast<double>(m_chunkSize) * m_tileWidth;
+    const auto chunkHeight = static_cast<double>(m_chunkSize) * m_tileHeight;
+    if (chunkWidth <= 0 || chunkHeight <= 0) {
+      return;
+    }
+
+    using detail::floor_to_int;
+    const auto col0 = std::max(floor_to_int(area.x / chunkWidth), 0);
+    const auto row0 = std::max(floor_to_int(area.y / chunkHeight), 0);
+    const auto col1 = std::min(floor_to_int((area.x + area.width) / chunkWidth),
+                               m_chunkCols - 1);
+    const auto row1 = std::min(
+        floor_to_int((area.y + area.height) / chunkHeight), m_chunkRows - 1);
+
+    for (auto row = row0; row <= row1; ++row) {
+      for (auto col = col0; col <= col1; ++col) {
+        lambda(m_regions[static_cast<std::size_t>(row) * m_chunkCols +
+                         static_cast<std::size_t>(col)]);
+      }
+    }
+  }
+
+  void mesh(int chunkCol, int chunkRow, region& region)
+  {
+    region.rects.clear();
+    region.dirty = false;
+
+    const auto col0 = chunkCol * m_chunkSize;
+    const auto row0 = chunkRow * m_chunkSize;
+    const auto cols = std::min(m_chunkSize, m_solid.width() - col0);
+    const auto rows = std::min(m_chunkSize, m_solid.height() - row0);
+
+    std::vector<unsigned char> used(static_cast<std::size_t>(cols) *
+                                    static_cast<std::size_t>(rows));
+    const auto available = [&](int col, int row) {
+      return !used[static_cast<std::size_t>(row) * cols + col] &&
+             m_solid.test(col0 + col, row0 + row);
+    };
+
+    for (int row = 0; row < rows; ++row) {
+      for (int col = 0; col < cols; ++col) {
+        if (!available(col, row)) {
+          continue;
+        }
+
+        // Grow the rectangle horizontally, then vertically
+        int width = 1;
+        while (col + width < cols && available(col + width, row)) {
+          ++width;
+        }
+
+        int height = 1;
+        for (; row + height < rows; ++height) {
+          bool full = true;
+          for (int i = 0; i < width && full; ++i) {
+            full = available(col + i, row + height);
+          }
+          if (!full) {
+            break;
+          }
+        }
+
+        for (int r = row; r < row + height; ++r) {
+          for (int c = col; c < col + width; ++c) {
+            used[static_cast<std::size_t>(r) * cols + c] = 1;
+          }
+        }
+
+        region.rects.push_back(
+            {static_cast<double>(col0 + col) * m_tileWidth,
+             static_cast<double>(row0 + row) * m_tileHeight,
+             static_cast<double>(width) * m_tileWidth,
+             static_cast<double>(height) * m_tileHeight});
+      }
+    }
+  }
+
+  void collect_shapes(const map& map)
+  {
+    struct tile_shapes final {
+      const object_group* group{};
+      int tileHeight{};
+      point tileOffset;
+    };
+
+    const auto table = detail::make_gid_table<tile_shapes>(
+        map, [](const tileset& tileset, const tile& tile) -> tile_shapes {
+          const auto* layer = tile.object_group();
+          if (!layer || !layer->is<object_group>()) {
+            return {};
+          }
+
+          point offset;
+          if (const auto& tileOffset = tileset.get_tile_offset()) {
+            offset = point{static_cast<double>(tileOffset->x()),
+                           static_cast<double>(tileOffset->y())};
+          }
+
+          return {&layer->as<object_group>(), tileset.tile_height(), offset};
+        });
+
+    for (const auto& layer : map.layers()) {
+      detail::each_tile_layer(
+          layer, [&](const step::layer&, const tile_layer& tiles) {
+            tiles.each([&](int col, int row, global_id gid) {
+              const auto index =
+                  static_cast<std::size_t>(strip_flip_bits(gid).get());
+              if (index >= table.size() || !table[index].group ||
+                  !m_solid.contains(col, row)) {
+                return;
+              }
+
+              // Tile images are aligned to the bottom-left corner of cells
+              const auto& entry = table[index];
+              const point offset{
+                  static_cast<double>(col) * m_tileWidth + entry.tileOffset.x(),
+                  static_cast<double>(row + 1) * m_tileHeight -
+                      entry.tileHeight + entry.tileOffset.y()};
+
+              auto& region = region_at(col / m_chunkSize, row / m_chunkSize);
+              for (const auto& object : entry.group->objects()) {
+                region.shapes.push_back({&object, offset, gid});
+              }
+            });
+          });
+    }
+  }
+};
+
+}  // namespace step
+
+#endif  // STEP_COLLISION_MESH_HEADER
@@ -0,0 +1,390 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_field_of_view.hpp
+ *
+ * @brief Provides the `field_of_view` class, which computes the tiles that are
+ * visible from a tile.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_FIELD_OF_VIEW_HEADER
+#define STEP_FIELD_OF_VIEW_HEADER
+
+#include <algorithm>  // max
+#include <array>      // array
+#include <cstddef>    // size_t
+#include <vector>     // vector
+
+#include "step_api.hpp"
+#include "step_tile_mask.hpp"
+#include "step_tile_pos.hpp"
+#include "step_utils.hpp"
+
+namespace step {
+
+/**
+ * @struct fov_viewer
+ *
+ * @brief A simple data container for the position and sight radius of a
+ * viewer.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_field_of_view.hpp
+ */
+struct fov_viewer final {
+  tile_pos origin;  ///< The position of the viewer.
+  int radius{0};    ///< The sight radius of the viewer, in tiles.
+};
+
+/**
+ * @class field_of_view
+ *
+ * @brief Represents the tiles that are visible from a tile.
+ *
+ * @details The visible tiles are computed with symmetric shadowcasting, i.e.
+ * each quadrant around the origin is scanned row by row, while keeping track
+ * of the slopes of the shadows cast by opaque tiles. Slopes are represented as
+ * exact fractions. A transparent tile is visible if its center is in an
+ * unshadowed sector, which makes visibility symmetric: if a transparent tile
+ * `a` can see a transparent tile `b`, then `b` can also see `a`. Opaque tiles
+ * are visible if any part of them is lit, so that walls are displayed.
+ *
+ * The visible tiles are stored as a bit mask that covers the square of tiles
+ * within the radius around the origin, rather than the whole map. The object
+ * can be reused for another computation without reallocating the mask.
+ *
+ * @note Tiles outside of the opacity mask are considered to be opaque.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_field_of_view.hpp
+ */
+class field_of_view final {
+ public:
+  field_of_view() noexcept = default;
+
+  /**
+   * @brief Computes the tiles that are visible from a tile.
+   *
+   * @param opaque the mask of the tiles that block sight, e.g. created from a
+   * boolean tile property with `make_tile_mask()`.
+   * @param origin the position of the viewer.
+   * @param radius the sight radius, in tiles. Tiles are within the radius if
+   * the Euclidean distance between the tile centers is at most the radius.
+   *
+   * @since 0.3.0
+   */
+  field_of_view(const tile_mask& opaque, tile_pos origin, int radius)
+  {
+    compute(opaque, origin, radius);
+  }
+
+  /**
+   * @brief Recomputes the tiles that are visible from a tile.
+   *
+   * @param opaque the mask of the tiles that block sight.
+   * @param origin the position of the viewer.
+   * @param radius the sight radius, in tiles.
+   *
+   * @since 0.3.0
+   */
+  void compute(const tile_mask& opaque, tile_pos origin, int radius)
+  {
+    m_origin = origin;
+    m_radius = std::max(radius, 0);
+
+    const auto size = 2 * m_radius + 1;
+    if (m_visible.width() != size) {
+      m_visible = tile_mask{size, size};
+    } else {
+      m_visible.clear();
+    }
+
+    if (!opaque.contains(origin.col, origin.row)) {
+      return;
+    }
+
+    reveal({origin.col, origin.row});
+    for (const auto quadrant : {north, east, south, west}) {
+      scan(opaque, quadrant);
+    }
+  }
+
+  /**
+   * @brief Indicates whether or not a tile is visible.
+   *
+   * @param pos the position of the tile.
+   *
+   * @return `true` if the tile is visible; `false` otherwise.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto is_visible(tile_pos pos) const noexcept -> bool
+  {
+    return m_visible.test(pos.col - m_origin.col + m_radius,
+                          pos.row - m_origin.row + m_radius);
+  }
+
+  /**
+   * @brief Returns the amount of visible tiles.
+   *
+   * @return the amount of visible tiles.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto count() const noexcept -> int
+  {
+    return m_visible.count();
+  }
+
+  /**
+   * @brief Returns the mask of visible tiles.
+   *
+   * @details The mask covers the tiles within the radius of the origin, i.e.
+   * the bit at (0, 0) represents the tile at `origin - (radius, radius)`.
+   *
+   * @return the mask of visible tiles.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto visible() const noexcept -> const tile_mask&
+  {
+    return m_visible;
+  }
+
+  /**
+   * @brief Returns the position of the viewer.
+   *
+   * @return the position of the viewer.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto origin() const noexcept -> tile_pos
+  {
+    return m_origin;
+  }
+
+  /**
+   * @brief Returns the sight radius.
+   *
+   * @return the sight radius, in tiles.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto radius() const noexcept -> int
+  {
+    return m_radius;
+  }
+
+ private:
+  /**
+   * @brief Maps (depth, column) in a quadrant to offsets from the origin.
+   */
+  struct quadrant final {
+    int depthCol;
+    int depthRow;
+    int colCol;
+    int colRow;
+  };
+
+  static constexpr quadrant north{0, -1, 1, 0};
+  static constexpr quadrant east{1, 0, 0, 1};
+  static constexpr quadrant south{0, 1, 1, 0};
+  static constexpr quadrant west{-1, 0, 0, 1};
+
+  /**
+   * @brief A row of a quadrant, with the sector that is still lit given by
+   * the slopes `startNum / startDen` and `endNum / endDen`.
+   */
+  struct row final {
+    int depth;
+    int startNum;
+    int startDen;
+    int endNum;
+    int endDen;
+  };
+
+  tile_mask m_visible;
+  tile_pos m_origin;
+  int m_radius{0};
+  std::vector<row> m_rows;
+
+  [[nodiscard]] static auto floor_div(int num, int den) noexcept -> int
+  {
+    const auto quotient = num / den;
+    return (num % den != 0 && num < 0) ? quotient - 1 : quotient;
+  }
+
+  [[nodiscard]] static auto ceil_div(int num, int den) noexcept -> int
+  {
+    const auto quotient = num / den;
+    return (num % den != 0 && num > 0) ? quotient + 1 : quotient;
+  }
+
+  void reveal(tile_pos pos) noexcept
+  {
+    m_visible.set(pos.col - m_origin.col + m_radius,
+                  pos.row - m_origin.row + m_radius);
+  }
+
+  void scan(const tile_mask& opaque, const quadrant& q)
+  {
+    const auto radiusSquared = m_radius * m_radius;
+    const auto to_pos = [&](int depth, int col) noexcept {
+      return tile_pos{m_origin.col + depth * q.depthCol + col * q.colCol,
+                      m_origin.row + depth * q.depthRow + col * q.colRow};
+    };
+    const auto is_opaque = [&](tile_pos pos) {
+      return !opaque.contains(pos.col, pos.row) || opaque.test(pos);
+    };
+
+    m_rows.clear();
+    m_rows.push_back({1, -1, 1, 1, 1});
+
+    while (!m_rows.empty()) {
+      auto current = m_rows.back();
+      m_rows.pop_back();
+
+      if (current.depth > m_radius) {
+        continue;
+      }
+
+      const auto depth = current.depth;
+
+      // Columns whose centers are within the sector, rounding ties outwards
+      const auto minCol = floor_div(2 * depth * current.startNum +
+                                        current.startDen,
+                                    2 * current.startDen);
+      const auto maxCol = ceil_div(2 * depth * current.endNum - current.endDen,
+                                   2 * current.endDen);
+
+      int prev = -1;  // -1 for none, 0 for transparent and 1 for opaque
+      for (auto col = minCol; col <= maxCol; ++col) {
+        const auto pos = to_pos(depth, col);
+        const auto wall = is_opaque(pos);
+
+        // A tile is symmetric if its center is within the sector
+        const auto symmetric =
+            col * current.startDen >= depth * current.startNum &&
+            col * current.endDen <= depth * current.endNum;
+
+        if ((wall || symmetric) && col * col + depth * depth <= radiusSquared &&
+            opaque.contains(pos.col, pos.row)) {
+          reveal(pos);
+        }
+
+        // The slope of the left edge of the tile
+        const auto slopeNum = 2 * col - 1;
+        const auto slopeDen = 2 * depth;
+
+        if (prev == 1 && !wall) {
+          current.startNum = slopeNum;
+          current.startDen = slopeDen;
+        }
+
+        if (prev == 0 && wall) {
+          m_rows.push_back({depth + 1,
+                            current.startNum,
+                            current.startDen,
+                            slopeNum,
+                            slopeDen});
+        }
+
+        prev = wall ? 1 : 0;
+      }
+
+      if (prev == 0) {
+        current.depth = depth + 1;
+        m_rows.push_back(current);
+      }
+    }
+  }
+};
+
+/**
+ * @brief Computes the fields of view of several viewers in parallel.
+ *
+ * @details The results are stored in an output vector, which is resized to
+ * the amount of viewers. Reusing the same output vector between calls avoids
+ * reallocating the visibility masks.
+ *
+ * @param opaque the mask of the tiles that block sight, shared by all viewers.
+ * @param viewers the viewers.
+ * @param results the vector that the fields of view are written to, in the
+ * same order as the viewers.
+ * @param threads the maximum amount of threads, zero means the amount of
+ * hardware threads.
+ *
+ * @since 0.3.0
+ */
+inline void compute_fields_of_view(const tile_mask& opaque,
+                                   const std::vector<fov_viewer>& viewers,
+                                   std::vector<field_of_view>& results,
+                                   int threads = 0)
+{
+  results.resize(viewers.size());
+  detail::parallel_for(0,
+                       static_cast<int>(viewers.size()),
+                       threads,
+                       [&](int i) {
+                         const auto index = static_cast<std::size_t>(i);
+                         const auto& viewer = viewers[index];
+                         results[index].compute(
+                             opaque, viewer.origin, viewer.radius);
+                       });
+}
+
+/**
+ * @brief Computes the fields of view of several viewers in parallel.
+ *
+ * @param opaque the mask of the tiles that block sight, shared by all viewers.
+ * @param viewers the viewers.
+ * @param threads the maximum amount of threads, zero means the amount of
+ * hardware threads.
+ *
+ * @return the fields of view, in the same order as the viewers.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] inline auto compute_fields_of_view(
+    const tile_mask& opaque,
+    const std::vector<fov_viewer>& viewers,
+    int threads = 0) -> std::vector<field_of_view>
+{
+  std::vector<field_of_view> results;
+  compute_fields_of_view(opaque, viewers, results, threads);
+  return results;
+}
+
+}  // namespace step
+
+#endif  // STEP_FIELD_OF_VIEW_HEADER
@@ -0,0 +1,547 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_flow_field.hpp
+ *
+ * @brief Provides the `flow_field` class, which provides distances and
+ * directions to the nearest of a set of goals.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_FLOW_FIELD_HEADER
+#define STEP_FLOW_FIELD_HEADER
+
+#include <algorithm>  // find, sort, min, max
+#include <cstddef>    // size_t
+#include <cstdint>    // int32_t
+#include <limits>     // numeric_limits
+#include <optional>   // optional
+#include <vector>     // vector
+
+#include "step_api.hpp"
+#include "step_tile_pos.hpp"
+#include "step_utils.hpp"
+#include "step_walkability.hpp"
+
+namespace step {
+
+/**
+ * @class flow_field
+ *
+ * @brief Provides the distance from every tile in a walkability grid to the
+ * nearest of a set of goals, along with the direction to move in.
+ *
+ * @details A flow field replaces one path search per agent with a single
+ * computation per set of goals, agents simply follow `next()` from their
+ * current tile. The distances are computed by expanding a wavefront from all
+ * goals at once, using a bucket queue (Dial's algorithm), since all move costs
+ * are small integers. Edge moves have the length 5 and diagonal moves have the
+ * length 7, i.e. a 5-7 chamfer approximation of the Euclidean distance, and
+ * the distances are reported in units of edge moves.
+ *
+ * The directions are derived from the distances tile by tile, which is
+ * distributed over several threads.
+ *
+ * @par Incremental updates
+ * Adding a goal only affects the tiles that end up closer to the new goal.
+ * Removing a goal only affects the tiles whose nearest goal was the removed
+ * goal, which are recomputed from the surrounding tiles. In both cases, only
+ * the directions of the affected area are recomputed.
+ *
+ * @warning The flow field refers to the grid, so the grid must outlive the
+ * flow field. Call `rebuild()` after changing the costs of the grid.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_flow_field.hpp
+ */
+class flow_field final {
+ public:
+  /**
+   * @enum flow_field::metric
+   *
+   * @brief Provides values for the different ways of measuring distances.
+   *
+   * @var weighted
+   * The cost of each move is the length of the move multiplied by the cost of
+   * the entered tile.
+   * @var chamfer
+   * The cost of each move is the length of the move, i.e. the costs of the
+   * tiles are only used to determine whether or not they are walkable.
+   *
+   * @since 0.3.0
+   */
+  enum class metric { weighted, chamfer };
+
+  /**
+   * @brief Creates a flow field without any goals.
+   *
+   * @param grid the grid that the field is computed for.
+   * @param distanceMetric the way distances are measured.
+   * @param threads the maximum amount of threads used to compute directions,
+   * zero means the amount of hardware threads.
+   *
+   * @since 0.3.0
+   */
+  explicit flow_field(const walkability_grid& grid,
+                      metric distanceMetric = metric::weighted,
+                      int threads = 0)
+      : m_grid{&grid},
+        m_metric{distanceMetric},
+        m_threads{threads},
+        m_distance(cell_count(), unreachable),
+        m_source(cell_count(), -1),
+        m_next(cell_count(), -1),
+        m_buckets(static_cast<std::size_t>(max_move_cost() + 1))
+  {}
+
+  /**
+   * @brief Replaces all goals and recomputes the whole field.
+   *
+   * @details Goals that are blocked or out-of-bounds are ignored.
+   *
+   * @param goals the positions of the goals.
+   *
+   * @since 0.3.0
+   */
+  void set_goals(const std::vector<tile_pos>& goals)
+  {
+    m_goals.clear();
+    for (const auto goal : goals) {
+      if (m_grid->is_walkable(goal) &&
+          std::find(m_goals.begin(), m_goals.end(), goal) == m_goals.end()) {
+        m_goals.push_back(goal);
+      }
+    }
+    rebuild();
+  }
+
+  /**
+   * @brief Recomputes the whole field from the current goals.
+   *
+   * @since 0.3.0
+   */
+  void rebuild()
+  {
+    std::fill(m_distance.begin(), m_distance.end(), unreachable);
+    std::fill(m_source.begin(), m_source.end(), -1);
+
+    std::vector<int> seeds;
+    for (const auto goal : m_goals) {
+      const auto cell = to_cell(goal);
+      m_distance[static_cast<std::size_t>(cell)] = 0;
+      m_source[static_cast<std::size_t>(cell)] = cell;
+      seeds.push_back(cell);
+    }
+
+    propagate(seeds);
+    update_directions(0, 0, m_grid->width() - 1, m_grid->height() - 1);
+  }
+
+  /**
+   * @brief Adds a goal to the field.
+   *
+   * @details This function has no effect if the position is blocked,
+   * out-of-bounds or already a goal.
+   *
+   * @param goal the position of the new goal.
+   *
+   * @since 0.3.0
+   */
+  void add_goal(tile_pos goal)
+  {
+    if (!m_grid->is_walkable(goal) || is_goal(goal)) {
+      return;
+    }
+
+    m_goals.push_back(goal);
+    reset_changes();
+
+    const auto cell = to_cell(goal);
+    m_distance[static_cast<std::size_t>(cell)] = 0;
+    m_source[static_cast<std::size_t>(cell)] = cell;
+    mark_changed(goal);
+
+    std::vector<int> seeds{cell};
+    propagate(seeds);
+    update_changed_directions();
+  }
+
+  /**
+   * @brief Removes a goal from the field.
+   *
+   * @details This function has no effect if the position isn't a goal.
+   *
+   * @param goal the position of the goal that will be removed.
+   *
+   * @since 0.3.0
+   */
+  void remove_goal(tile_pos goal)
+  {
+    const auto it = std::find(m_goals.begin(), m_goals.end(), goal);
+    if (it == m_goals.end()) {
+      return;
+    }
+
+    m_goals.erase(it);
+    reset_changes();
+
+    // Forget the area that the goal was the nearest goal of, which is
+    // connected since every tile got its distance from a neighbour
+    const auto source = to_cell(goal);
+    std::vector<int> area{source};
+    m_distance[static_cast<std::size_t>(source)] = unreachable;
+    m_source[static_cast<std::size_t>(source)] = -1;
+
+    for (std::size_t i = 0; i < area.size(); ++i) {
+      const auto pos = to_pos(area[i]);
+      mark_changed(pos);
+      m_grid->each_neighbour(pos, [&](tile_pos next, double) {
+        const auto cell = static_cast<std::size_t>(to_cell(next));
+        if (m_source[cell] == source) {
+          m_distance[cell] = unreachable;
+          m_source[cell] = -1;
+          area.push_back(to_cell(next));
+        }
+      });
+    }
+
+    // Refill the area from the tiles that surround it
+    std::vector<int> seeds;
+    for (const auto cell : area) {
+      m_grid->each_neighbour(to_pos(cell), [&](tile_pos next, double) {
+        const auto index = to_cell(next);
+        if (m_distance[static_cast<std::size_t>(index)] != unreachable) {
+          seeds.push_back(index);
+        }
+      });
+    }
+
+    propagate(seeds);
+    update_changed_directions();
+  }
+
+  /**
+   * @brief Moves a goal to another position.
+   *
+   * @param from the current position of the goal.
+   * @param to the new position of the goal.
+   *
+   * @since 0.3.0
+   */
+  void move_goal(tile_pos from, tile_pos to)
+  {
+    remove_goal(from);
+    add_goal(to);
+  }
+
+  /**
+   * @brief Returns the distance from a tile to the nearest goal.
+   *
+   * @param pos the position of the tile.
+   *
+   * @return the distance to the nearest goal, in units of edge moves; an
+   * empty optional if no goal can be reached from the tile.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto distance(tile_pos pos) const noexcept
+      -> std::optional<double>
+  {
+    if (!m_grid->contains(pos.col, pos.row)) {
+      return std::nullopt;
+    }
+
+    const auto value = m_distance[static_cast<std::size_t>(to_cell(pos))];
+    if (value == unreachable) {
+      return std::nullopt;
+    } else {
+      return static_cast<double>(value) / edge_length;
+    }
+  }
+
+  /**
+   * @brief Returns the tile that should be entered next when moving from a
+   * tile towards the nearest goal.
+   *
+   * @param pos the position of the current tile.
+   *
+   * @return the position of the next tile; the current position if the tile
+   * is a goal, or if no goal can be reached from the tile.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto next(tile_pos pos) const noexcept -> tile_pos
+  {
+    if (!m_grid->contains(pos.col, pos.row)) {
+      return pos;
+    }
+
+    const auto next = m_next[static_cast<std::size_t>(to_cell(pos))];
+    return next == -1 ? pos : to_pos(next);
+  }
+
+  /**
+   * @brief Returns the goal that is nearest to a tile.
+   *
+   * @param pos the position of the tile.
+   *
+   * @return the position of the nearest goal; an empty optional if no goal
+   * can be reached from the tile.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto nearest_goal(tile_pos pos) const noexcept
+      -> std::optional<tile_pos>
+  {
+    if (!m_grid->contains(pos.col, pos.row)) {
+      return std::nullopt;
+    }
+
+    const auto source = m_source[static_cast<std::size_t>(to_cell(pos))];
+    if (source == -1) {
+      return std::nullopt;
+    } else {
+      return to_pos(source);
+    }
+  }
+
+  /**
+   * @brief Indicates whether or not a position is a goal.
+   *
+   * @param pos the position that will be checked.
+   *
+   * @return `true` if the position is a goal; `false` otherwise.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto is_goal(tile_pos pos) const -> bool
+  {
+    return std::find(m_goals.begin(), m_goals.end(), pos) != m_goals.end();
+  }
+
+  /**
+   * @brief Returns the goals of the field.
+   *
+   * @return the positions of the goals.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto goals() const noexcept -> const std::vector<tile_pos>&
+  {
+    return m_goals;
+  }
+
+ private:
+  using distance_type = std::int32_t;
+
+  static constexpr distance_type unreachable =
+      std::numeric_limits<distance_type>::max();
+  static constexpr distance_type edge_length = 5;
+  static constexpr distance_type diagonal_length = 7;
+
+  const walkability_grid* m_grid{};
+  metric m_metric{metric::weighted};
+  int m_threads{0};
+  std::vector<tile_pos> m_goals;
+  std::vector<distance_type> m_distance;
+  std::vector<int> m_source;  ///< The cell of the nearest goal, or -1.
+  std::vector<int> m_next;    ///< The cell to move to, or -1.
+  std::vector<std::vector<int>> m_buckets;
+  int m_minCol{0};
+  int m_minRow{0};
+  int m_maxCol{-1};
+  int m_maxRow{-1};
+
+  [[nodiscard]] auto cell_count() const noexcept -> std::size_t
+  {
+    return static_cast<std::size_t>(m_grid->width()) *
+           static_cast<std::size_t>(m_grid->height());
+  }
+
+  [[nodiscard]] auto to_cell(tile_pos pos) const noexcept -> int
+  {
+    return pos.row * m_grid->width() + pos.col;
+  }
+
+  [[nodiscard]] auto to_pos(int cell) const noexcept -> tile_pos
+  {
+    return {cell % m_grid->width(), cell / m_grid->width()};
+  }
+
+  [[nodiscard]] auto max_move_cost() const noexcept -> distance_type
+  {
+    return m_metric == metric::weighted ? diagonal_length * 255
+                                        : diagonal_length;
+  }
+
+  /**
+   * @brief Returns the cost of moving from a neighbour into a tile.
+   */
+  [[nodiscard]] auto move_cost(tile_pos to, double length) const noexcept
+      -> distance_type
+  {
+    const auto base = length > 1 ? diagonal_length : edge_length;
+    if (m_metric == metric::weighted) {
+      return base * static_cast<distance_type>(m_grid->cost(to));
+    } else {
+      return base;
+    }
+  }
+
+  void reset_changes() noexcept
+  {
+    m_minCol = m_grid->width();
+    m_minRow = m_grid->height();
+    m_maxCol = -1;
+    m_maxRow = -1;
+  }
+
+  void mark_changed(tile_pos pos) noexcept
+  {
+    m_minCol = std::min(m_minCol, pos.col);
+    m_minRow = std::min(m_minRow, pos.row);
+    m_maxCol = std::max(m_maxCol, pos.col);
+    m_maxRow = std::max(m_maxRow, pos.row);
+  }
+
+  /**
+   * @brief Expands the wavefront from tiles with known distances, lowering
+   * the distances of the tiles that can be reached more cheaply.
+   */
+  void propagate(std::vector<int>& seeds)
+  {
+    std::sort(seeds.begin(), seeds.end(), [this](int lhs, int rhs) {
+      return m_distance[static_cast<std::size_t>(lhs)] <
+             m_distance[static_cast<std::size_t>(rhs)];
+    });
+
+    const auto bucketCount = static_cast<distance_type>(m_buckets.size());
+    const auto bucket_of = [bucketCount](distance_type distance) {
+      return static_cast<std::size_t>(distance % bucketCount);
+    };
+
+    std::size_t nextSeed = 0;
+    std::size_t pending = 0;
+    distance_type current = 0;
+    std::vector<int> cells;
+
+    while (pending != 0 || nextSeed < seeds.size()) {
+      if (pending == 0) {
+        const auto seed = static_cast<std::size_t>(seeds[nextSeed]);
+        current = m_distance[seed];
+      }
+
+      // Seeds are only queued when the wavefront reaches them, so that the
+      // queued distances never span more than the amount of buckets
+      while (nextSeed < seeds.size()) {
+        const auto seed = seeds[nextSeed];
+        if (m_distance[static_cast<std::size_t>(seed)] != current) {
+          break;
+        }
+        m_buckets[bucket_of(current)].push_back(seed);
+        ++pending;
+        ++nextSeed;
+      }
+
+      cells.clear();
+      cells.swap(m_buckets[bucket_of(current)]);
+      pending -= cells.size();
+
+      for (const auto cell : cells) {
+        if (m_distance[static_cast<std::size_t>(cell)] != current) {
+          continue;  // Outdated entry
+        }
+
+        const auto pos = to_pos(cell);
+        const auto source = m_source[static_cast<std::size_t>(cell)];
+        m_grid->each_neighbour(pos, [&](tile_pos next, double length) {
+          // Agents move in the opposite direction of the wavefront
+          const auto distance = current + move_cost(pos, length);
+          const auto index = static_cast<std::size_t>(to_cell(next));
+          if (distance < m_distance[index]) {
+            m_distance[index] = distance;
+            m_source[index] = source;
+            m_buckets[bucket_of(distance)].push_back(to_cell(next));
+            ++pending;
+            mark_changed(next);
+          }
+        });
+      }
+
+      ++current;
+    }
+  }
+
+  void update_changed_directions()
+  {
+    if (m_maxCol >= m_minCol) {
+      update_directions(m_minCol - 1, m_minRow - 1, m_maxCol + 1, m_maxRow + 1);
+    }
+  }
+
+  void update_directions(int minCol, int minRow, int maxCol, int maxRow)
+  {
+    minCol = std::max(minCol, 0);
+    minRow = std::max(minRow, 0);
+    maxCol = std::min(maxCol, m_grid->width() - 1);
+    maxRow = std::min(maxRow, m_grid->height() - 1);
+
+    detail::parallel_for(minRow, maxRow + 1, m_threads, [&](int row) {
+      for (auto col = minCol; col <= maxCol; ++col) {
+        const tile_pos pos{col, row};
+        const auto cell = static_cast<std::size_t>(to_cell(pos));
+
+        auto best = m_distance[cell];
+        auto next = -1;
+        if (best != 0 && best != unreachable) {
+          m_grid->each_neighbour(pos, [&](tile_pos other, double length) {
+            const auto index = static_cast<std::size_t>(to_cell(other));
+            if (m_distance[index] == unreachable) {
+              return;
+            }
+
+            const auto distance = m_distance[index] + move_cost(other, length);
+            if (distance < best || (distance == best && next == -1)) {
+              best = distance;
+              next = to_cell(other);
+            }
+          });
+        }
+
+        m_next[cell] = next;
+      }
+    });
+  }
+};
+
+}  // namespace step
+
+#endif  // STEP_FLOW_FIELD_HEADER
@@ -0,0 +1,189 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_geometry.hpp
+ *
+ * @brief Provides geometric utilities used by the shape queries.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_GEOMETRY_HEADER
+#define STEP_GEOMETRY_HEADER
+
+#include <algorithm>  // min, max
+#include <cmath>      // cos, sin
+#include <cstddef>    // size_t
+
+#include "step_api.hpp"
+#include "step_point.hpp"
+
+namespace step::detail {
+
+inline constexpr double pi = 3.14159265358979323846;
+
+/**
+ * @brief Returns the cross product of the vectors `a - o` and `b - o`.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] inline auto cross(const point& o,
+                                const point& a,
+                                const point& b) noexcept -> double
+{
+  return (a.x() - o.x()) * (b.y() - o.y()) - (a.y() - o.y()) * (b.x() - o.x());
+}
+
+/**
+ * @brief Returns the squared distance between two points.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] inline auto distance_squared(const point& a,
+                                           const point& b) noexcept -> double
+{
+  const auto dx = b.x() - a.x();
+  const auto dy = b.y() - a.y();
+  return dx * dx + dy * dy;
+}
+
+/**
+ * @brief Returns the point on a line segment that is closest to a point.
+ *
+ * @param p the point.
+ * @param a the first point of the segment.
+ * @param b the second point of the segment.
+ *
+ * @return the closest point on the segment.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] inline auto closest_on_segment(const point& p,
+                                             const point& a,
+                                             const point& b) noexcept -> point
+{
+  const auto ex = b.x() - a.x();
+  const auto ey = b.y() - a.y();
+  const auto lengthSq = ex * ex + ey * ey;
+  if (lengthSq == 0) {
+    return a;
+  }
+
+  auto t = ((p.x() - a.x()) * ex + (p.y() - a.y()) * ey) / lengthSq;
+  t = std::min(std::max(t, 0.0), 1.0);
+  return {a.x() + t * ex, a.y() + t * ey};
+}
+
+/**
+ * @brief Indicates whether or not two line segments intersect.
+ *
+ * @details Segments that only touch, or that are collinear and overlap,
+ * intersect.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] inline auto segments_intersect(const point& a,
+                                             const point& b,
+                                             const point& c,
+                                             const point& d) noexcept -> bool
+{
+  const auto d1 = cross(c, d, a);
+  const auto d2 = cross(c, d, b);
+  const auto d3 = cross(a, b, c);
+  const auto d4 = cross(a, b, d);
+
+  if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) &&
+      ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))) {
+    return true;
+  }
+
+  const auto onSegment = [](const point& p, const point& q, const point& r) {
+    return std::min(p.x(), q.x()) <= r.x() && r.x() <= std::max(p.x(), q.x()) &&
+           std::min(p.y(), q.y()) <= r.y() && r.y() <= std::max(p.y(), q.y());
+  };
+
+  return (d1 == 0 && onSegment(c, d, a)) || (d2 == 0 && onSegment(c, d, b)) ||
+         (d3 == 0 && onSegment(a, b, c)) || (d4 == 0 && onSegment(a, b, d));
+}
+
+/**
+ * @brief Indicates whether or not a point is inside of a polygon.
+ *
+ * @details The even-odd rule is used, so the polygon may be concave. Points
+ * on the boundary may be classified either way.
+ *
+ * @param points the points of the polygon.
+ * @param count the amount of points in the polygon.
+ * @param p the point that will be tested.
+ *
+ * @return `true` if the point is inside of the polygon; `false` otherwise.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] inline auto polygon_contains(const point* points,
+                                           std::size_t count,
+                                           const point& p) noexcept -> bool
+{
+  auto inside = false;
+  for (std::size_t i = 0, j = count - 1; i < count; j = i++) {
+    const auto& a = points[i];
+    const auto& b = points[j];
+    if ((a.y() > p.y()) != (b.y() > p.y()) &&
+        p.x() < (b.x() - a.x()) * (p.y() - a.y()) / (b.y() - a.y()) + a.x()) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+/**
+ * @brief Rotates a point clockwise around an origin, in a y-down coordinate
+ * system, like Tiled rotates objects.
+ *
+ * @param origin the point that the point is rotated around.
+ * @param offset the position of the point relative to the origin.
+ * @param cos the cosine of the rotation.
+ * @param sin the sine of the rotation.
+ *
+ * @return the rotated point.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] inline auto rotate(const point& origin,
+                                 const point& offset,
+                                 double cos,
+                                 double sin) noexcept -> point
+{
+  return {origin.x() + offset.x() * cos - offset.y() * sin,
+          origin.y() + offset.x() * sin + offset.y() * cos};
+}
+
+}  // namespace step::detail
+
+#endif  // STEP_GEOMETRY_HEADER
@@ -0,0 +1,397 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_gid_remap.hpp
+ *
+ * @brief Provides the `gid_remap` class.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_GID_REMAP_HEADER
+#define STEP_GID_REMAP_HEADER
+
+#include <algorithm>      // max, min
+#include <cstddef>        // size_t
+#include <string>         // string
+#include <string_view>    // string_view
+#include <utility>        // move
+#include <unordered_map>  // unordered_map
+#include <vector>         // vector
+
+#include "step_api.hpp"
+#include "step_map.hpp"
+#include "step_tile_mask.hpp"
+#include "step_tile_usage.hpp"
+#include "step_tileset.hpp"
+#include "step_types.hpp"
+#include "step_utils.hpp"
+
+namespace step {
+
+/**
+ * @class gid_remap
+ *
+ * @brief Maps the GIDs of one or several maps to a shared, compact GID space.
+ *
+ * @details Tilesets are identified by their source file, or by their name if
+ * they are embedded. Every distinct tileset is assigned one contiguous range of
+ * GIDs, in the order in which the tilesets are first encountered. Optionally,
+ * tiles that aren't used by any of the maps are left out of the ranges, see
+ * `local_tiles()` for the tiles that each range consists of.
+ *
+ * Remapping is a table lookup per GID that preserves the flip flags. GIDs that
+ * don't belong to a tileset, or that belong to a removed tile, are mapped to
+ * zero, i.e. an empty cell.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_gid_remap.hpp
+ */
+class gid_remap final {
+ public:
+  /**
+   * @brief Computes the remapping of the GIDs of several maps.
+   *
+   * @param maps the maps that will share the GID space, may not contain null
+   * pointers.
+   * @param compact `true` if tiles that aren't used by any of the maps should
+   * be removed; `false` otherwise.
+   * @param threads the maximum amount of threads used to analyze the maps,
+   * zero means the amount of hardware threads.
+   *
+   * @throws step_exception if `compact` is `true` and a map has Base64
+   * encoded tile data.
+   *
+   * @since 0.3.0
+   */
+  explicit gid_remap(const std::vector<const map*>& maps,
+                     bool compact = false,
+                     int threads = 0)
+  {
+    std::vector<std::vector<std::size_t>> tilesets(maps.size());
+    for (std::size_t index = 0; index < maps.size(); ++index) {
+      for (const auto& tileset : maps[index]->tilesets()) {
+        tilesets[index].push_back(add_tileset(*tileset));
+      }
+    }
+
+    std::vector<std::vector<unsigned char>> used(m_localTiles.size());
+    for (std::size_t ts = 0; ts < used.size(); ++ts) {
+      used[ts].assign(m_localTiles[ts].size(), !compact);
+    }
+
+    if (compact) {
+      std::vector<std::vector<int>> usedTiles(maps.size());
+      detail::parallel_for(
+          0, static_cast<int>(maps.size()), threads, [&](int index) {
+            const auto i = static_cast<std::size_t>(index);
+            const tile_histogram histogram{*maps[i], 1};
+            auto& result = usedTiles[i];
+            for (std::size_t j = 0; j < tilesets[i].size(); ++j) {
+              for (const auto id : histogram.used_tiles(j)) {
+                result.push_back(static_cast<int>(j));
+                result.push_back(id);
+              }
+            }
+          });
+
+      for (std::size_t i = 0; i < maps.size(); ++i) {
+        const auto& pairs = usedTiles[i];
+        for (std::size_t j = 0; j < pairs.size(); j += 2) {
+          const auto ts = tilesets[i][static_cast<std::size_t>(pairs[j])];
+          used[ts][static_cast<std::size_t>(pairs[j + 1])] = 1;
+        }
+      }
+    }
+
+    // Assigns the new GIDs, with the new local IDs of the tiles
+    std::vector<std::vector<int>> newLocal(m_localTiles.size());
+    unsigned next = 1;
+    for (std::size_t ts = 0; ts < m_localTiles.size(); ++ts) {
+      auto& tiles = m_localTiles[ts];
+      newLocal[ts].assign(tiles.size(), -1);
+      tiles.clear();
+
+      m_firstGids.push_back(global_id{next});
+      for (std::size_t id = 0; id < used[ts].size(); ++id) {
+        if (used[ts][id]) {
+          newLocal[ts][id] = static_cast<int>(tiles.size());
+          tiles.push_back(static_cast<int>(id));
+        }
+      }
+      next += static_cast<unsigned>(tiles.size());
+    }
+    m_gidCount = next;
+
+    m_tables.reserve(maps.size());
+    for (std::size_t index = 0; index < maps.size(); ++index) {
+      const auto& map = *maps[index];
+
+      // The last entry is a sentinel for GIDs outside of all tilesets
+      auto& table = m_tables.emplace_back(detail::gid_count(map) + 1, 0u);
+      for (std::size_t j = 0; j < tilesets[index].size(); ++j) {
+        const auto& tileset = *map.tilesets().at(j);
+        const auto ts = tilesets[index][j];
+        const auto first = tileset.first_gid().get();
+        const auto firstNew = m_firstGids[ts].get();
+
+        const auto& ids = newLocal[ts];
+        const auto count = std::min(static_cast<std::size_t>(
+                                        std::max(tileset.tile_count(), 0)),
+                                    ids.size());
+        for (std::size_t id = 0; id < count; ++id) {
+          const auto gid = first + static_cast<unsigned>(id);
+          if (ids[id] != -1 && gid < table.size() - 1) {
+            table[gid] = firstNew + static_cast<unsigned>(ids[id]);
+          }
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Computes the remapping of the GIDs of a single map.
+   *
+   * @param map the map that will be remapped.
+   * @param compact `true` if unused tiles should be removed; `false`
+   * otherwise.
+   *
+   * @throws step_exception if `compact` is `true` and the map has Base64
+   * encoded tile data.
+   *
+   * @since 0.3.0
+   */
+  explicit gid_remap(const map& map, bool compact = false)
+      : gid_remap{std::vector<const step::map*>{&map}, compact, 1}
+  {}
+
+  /**
+   * @brief Returns the new GID of a tile.
+   *
+   * @param map the index of the map that the GID belongs to.
+   * @param gid the GID that will be remapped, may have flip flags set.
+   *
+   * @return the new GID, with the same flip flags as the supplied GID.
+   *
+   * @throws std::out_of_range if the map index is invalid.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto remap(std::size_t map, global_id gid) const -> global_id
+  {
+    const auto& table = m_tables.at(map);
+    return global_id{lookup(table.data(), table.size() - 1, gid.get())};
+  }
+
+  /**
+   * @brief Remaps a range of GIDs.
+   *
+   * @details The input and output ranges may be the same range. The lookup
+   * is branch-free so that the loop can be vectorized by the compiler.
+   *
+   * @param map the index of the map that the GIDs belong to.
+   * @param in the GIDs that will be remapped.
+   * @param out the range that the new GIDs will be written to.
+   * @param count the amount of GIDs.
+   * @param threads the maximum amount of threads, zero means the amount of
+   * hardware threads.
+   *
+   * @throws std::out_of_range if the map index is invalid.
+   *
+   * @since 0.3.0
+   */
+  void remap(std::size_t map,
+             const global_id* in,
+             global_id* out,
+             std::size_t count,
+             int threads = 1) const
+  {
+    const auto& table = m_tables.at(map);
+    const auto* data = table.data();
+    const auto last = table.size() - 1;
+
+    const auto blocks = static_cast<int>((count + block_size - 1) / block_size);
+    detail::parallel_for(0, blocks, threads, [&](int block) {
+      const auto begin = static_cast<std::size_t>(block) * block_size;
+      const auto end = std::min(begin + block_size, count);
+      for (auto i = begin; i < end; ++i) {
+        out[i] = global_id{lookup(data, last, in[i].get())};
+      }
+    });
+  }
+
+  /**
+   * @brief Returns a remapped copy of tile data.
+   *
+   * @param map the index of the map that the GIDs belong to.
+   * @param gids the GIDs that will be remapped.
+   * @param threads the maximum amount of threads, zero means the amount of
+   * hardware threads.
+   *
+   * @return the new GIDs.
+   *
+   * @throws std::out_of_range if the map index is invalid.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto remap(std::size_t map,
+                           const std::vector<global_id>& gids,
+                           int threads = 1) const -> std::vector<global_id>
+  {
+    std::vector<global_id> result(gids.size(), global_id{0});
+    remap(map, gids.data(), result.data(), gids.size(), threads);
+    return result;
+  }
+
+  /**
+   * @brief Returns the lookup table of a map.
+   *
+   * @param map the index of the map.
+   *
+   * @return the new GIDs, indexed by the old GIDs without flip flags. The
+   * last entry is zero and used for all GIDs outside of the table.
+   *
+   * @throws std::out_of_range if the map index is invalid.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto table(std::size_t map) const
+      -> const std::vector<unsigned>&
+  {
+    return m_tables.at(map);
+  }
+
+  /**
+   * @brief Returns the identifiers of the distinct tilesets.
+   *
+   * @return the source files or names of the tilesets, in the order of their
+   * GID ranges.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto tilesets() const noexcept
+      -> const std::vector<std::string>&
+  {
+    return m_keys;
+  }
+
+  /**
+   * @brief Returns the first new GID of a tileset.
+   *
+   * @param tileset the index of the tileset, see `tilesets()`.
+   *
+   * @return the first GID of the range of the tileset.
+   *
+   * @throws std::out_of_range if the tileset index is invalid.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto first_gid(std::size_t tileset) const -> global_id
+  {
+    return m_firstGids.at(tileset);
+  }
+
+  /**
+   * @brief Returns the tiles that make up the GID range of a tileset.
+   *
+   * @param tileset the index of the tileset, see `tilesets()`.
+   *
+   * @return the original local IDs of the tiles, where the tile at index `i`
+   * has the new GID `first_gid(tileset) + i`.
+   *
+   * @throws std::out_of_range if the tileset index is invalid.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto local_tiles(std::size_t tileset) const
+      -> const std::vector<int>&
+  {
+    return m_localTiles.at(tileset);
+  }
+
+  /**
+   * @brief Returns the amount of GIDs in the new GID space.
+   *
+   * @return one more than the largest new GID.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto gid_count() const noexcept -> std::size_t
+  {
+    return m_gidCount;
+  }
+
+ private:
+  static constexpr std::size_t block_size = 4'096;
+
+  std::vector<std::vector<unsigned>> m_tables;
+  std::vector<std::string> m_keys;
+  std::vector<global_id> m_firstGids;
+  std::vector<std::vector<int>> m_localTiles;
+  std::unordered_map<std::string, std::size_t> m_indices;
+  std::size_t m_gidCount{1};
+
+  [[nodiscard]] static auto lookup(const unsigned* table,
+                                   std::size_t last,
+                                   unsigned gid) noexcept -> unsigned
+  {
+    const auto flags = gid & detail::gid_flags_mask;
+    const auto index =
+        std::min(static_cast<std::size_t>(gid & ~detail::gid_flags_mask), last);
+    const auto result = table[index];
+    return result | (result != 0 ? flags : 0u);
+  }
+
+  auto add_tileset(const tileset& tileset) -> std::size_t
+  {
+    const auto source = tileset.source();
+    std::string key{source.empty() ? tileset.name() : source};
+
+    const auto count =
+        static_cast<std::size_t>(std::max(tileset.tile_count(), 0));
+    if (const auto it = m_indices.find(key); it != m_indices.end()) {
+      auto& tiles = m_localTiles[it->second];
+      if (tiles.size() < count) {
+        tiles.resize(count);
+      }
+      return it->second;
+    }
+
+    const auto index = m_keys.size();
+    m_indices.emplace(key, index);
+    m_keys.push_back(std::move(key));
+    m_localTiles.emplace_back(count);
+    return index;
+  }
+};
+
+}  // namespace step
+
+#endif  // STEP_GID_REMAP_HEADER
@@ -0,0 +1,498 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_gid_table.hpp
+ *
+ * @brief Provides lookup tables of tile data that are indexed by GIDs.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_GID_TABLE_HEADER
+#define STEP_GID_TABLE_HEADER
+
+#include <cstddef>      // size_t
+#include <cstdint>      // uint64_t
+#include <functional>   // less
+#include <map>          // map
+#include <string>       // string
+#include <string_view>  // string_view
+#include <type_traits>  // enable_if_t, is_arithmetic_v
+#include <utility>      // move, forward
+#include <vector>       // vector
+
+#include "step_api.hpp"
+#include "step_map.hpp"
+#include "step_property.hpp"
+#include "step_tile.hpp"
+#include "step_tile_mask.hpp"
+#include "step_types.hpp"
+
+namespace step {
+
+/**
+ * @class gid_bitset
+ *
+ * @brief A packed set of bits, with one bit per GID of a map.
+ *
+ * @details Bitsets are used to answer questions such as "is this tile solid"
+ * with a single load, instead of looking up the tile and its properties. The
+ * flip flags of GIDs are ignored, and GIDs outside of the set are never set.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_gid_table.hpp
+ */
+class gid_bitset final {
+ public:
+  gid_bitset() noexcept = default;
+
+  /**
+   * @brief Creates a bitset with all bits cleared.
+   *
+   * @param size the amount of GIDs, i.e. one more than the largest GID.
+   *
+   * @since 0.3.0
+   */
+  explicit gid_bitset(std::size_t size)
+      : m_size{size},
+        m_words((size + word_bits - 1) / word_bits)
+  {}
+
+  /**
+   * @brief Creates a bitset from the tiles of a map.
+   *
+   * @tparam Predicate the type of the predicate.
+   *
+   * @param map the map that provides the tilesets.
+   * @param predicate the predicate that takes a single `const tile&` argument
+   * and returns the bit of the tile. Tiles without custom data aren't set.
+   *
+   * @since 0.3.0
+   */
+  template <typename Predicate,
+            typename = std::enable_if_t<detail::is_tile_predicate<Predicate>>>
+  gid_bitset(const map& map, Predicate&& predicate)
+      : gid_bitset{detail::gid_count(map)}
+  {
+    for (const auto& tileset : map.tilesets()) {
+      const auto first = tileset->first_gid().get();
+      for (const auto& tile : tileset->tiles()) {
+        if (predicate(tile)) {
+          set(global_id{first + tile.id().get()});
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Creates a bitset of the tiles that have a boolean property set to
+   * `true`.
+   *
+   * @param map the map that provides the tilesets.
+   * @param property the name of the boolean tile property, e.g. `"solid"`.
+   *
+   * @since 0.3.0
+   */
+  gid_bitset(const map& map, std::string_view property)
+      : gid_bitset{map, [property](const tile& tile) {
+                     const auto* props = tile.get_properties();
+                     return props && props->is(property, true);
+                   }}
+  {}
+
+  /**
+   * @brief Sets the bit associated with a GID.
+   *
+   * @details This function has no effect if the GID is outside of the set.
+   *
+   * @param gid the GID, flip flags are ignored.
+   * @param value the new value of the bit.
+   *
+   * @since 0.3.0
+   */
+  void set(global_id gid, bool value = true) noexcept
+  {
+    const auto index = static_cast<std::size_t>(strip_flip_bits(gid).get());
+    if (index < m_size) {
+      auto& word = m_words[index / word_bits];
+      const auto bit = word_type{1} << (index % word_bits);
+      if (value) {
+        word |= bit;
+      } else {
+        word &= ~bit;
+      }
+    }
+  }
+
+  /**
+   * @brief Indicates whether or not the bit associated with a GID is set.
+   *
+   * @param gid the GID, flip flags are ignored.
+   *
+   * @return `true` if the bit is set; `false` otherwise.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto test(global_id gid) const noexcept -> bool
+  {
+    const auto index = static_cast<std::size_t>(strip_flip_bits(gid).get());
+    return index < m_size &&
+           ((m_words[index / word_bits] >> (index % word_bits)) & 1u);
+  }
+
+  /**
+   * @copydoc test()
+   */
+  [[nodiscard]] auto operator[](global_id gid) const noexcept -> bool
+  {
+    return test(gid);
+  }
+
+  /**
+   * @brief Returns the amount of GIDs in the set.
+   *
+   * @return one more than the largest GID in the set.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto size() const noexcept -> std::size_t
+  {
+    return m_size;
+  }
+
+ private:
+  using word_type = std::uint64_t;
+  static constexpr std::size_t word_bits = 64;
+
+  std::size_t m_size{};
+  std::vector<word_type> m_words;
+};
+
+/**
+ * @class gid_array
+ *
+ * @brief A dense array of values, with one value per GID of a map.
+ *
+ * @details Arrays are used to look up numeric tile data, e.g. movement costs
+ * or damage values, with a single load. The flip flags of GIDs are ignored,
+ * and GIDs outside of the array are mapped to the fallback value.
+ *
+ * @tparam T the type of the values.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_gid_table.hpp
+ */
+template <typename T>
+class gid_array final {
+ public:
+  gid_array() = default;
+
+  /**
+   * @brief Creates an array where every GID has the fallback value.
+   *
+   * @param size the amount of GIDs, i.e. one more than the largest GID.
+   * @param fallback the value used for GIDs without a value.
+   *
+   * @since 0.3.0
+   */
+  gid_array(std::size_t size, T fallback)
+      : m_fallback{fallback},
+        m_values(size, fallback)
+  {}
+
+  /**
+   * @brief Creates an array from the tiles of a map.
+   *
+   * @tparam Lambda the type of the lambda object.
+   *
+   * @param map the map that provides the tilesets.
+   * @param lambda the lambda that takes two arguments, `const tileset&` and
+   * `const tile&`, and returns the value of the tile.
+   * @param fallback the value used for tiles without custom data.
+   *
+   * @since 0.3.0
+   */
+  template <typename Lambda,
+            typename = std::enable_if_t<
+                std::is_invocable_r_v<T, Lambda, const tileset&, const tile&>>>
+  gid_array(const map& map, Lambda&& lambda, T fallback = {})
+      : m_fallback{fallback},
+        m_values{detail::make_gid_table<T>(map, lambda, fallback)}
+  {}
+
+  /**
+   * @brief Creates an array from a numeric tile property.
+   *
+   * @details Both `int` and `float` properties are converted to the value
+   * type. Tiles without the property, or with a property of another type, are
+   * mapped to the fallback value.
+   *
+   * @param map the map that provides the tilesets.
+   * @param property the name of the tile property, e.g. `"damage"`.
+   * @param fallback the value used for tiles without the property.
+   *
+   * @since 0.3.0
+   */
+  template <typename U = T,
+            typename = std::enable_if_t<std::is_arithmetic_v<U>>>
+  gid_array(const map& map, std::string_view property, T fallback = {})
+      : gid_array{map,
+                  [property, fallback](const tileset&, const tile& tile) -> T {
+                    const auto* props = tile.get_properties();
+                    if (!props || !props->has(property)) {
+                      return fallback;
+                    }
+
+                    const auto& value = props->get(property);
+                    if (value.is<int>()) {
+                      return static_cast<T>(value.get<int>());
+                    } else if (value.is<float>()) {
+                      return static_cast<T>(value.get<float>());
+                    } else {
+                      return fallback;
+                    }
+                  },
+                  fallback}
+  {}
+
+  /**
+   * @brief Sets the value associated with a GID.
+   *
+   * @details This function has no effect if the GID is outside of the array.
+   *
+   * @param gid the GID, flip flags are ignored.
+   * @param value the new value.
+   *
+   * @since 0.3.0
+   */
+  void set(global_id gid, T value)
+  {
+    const auto index = static_cast<std::size_t>(strip_flip_bits(gid).get());
+    if (index < m_values.size()) {
+      m_values[index] = std::move(value);
+    }
+  }
+
+  /**
+   * @brief Returns the value associated with a GID.
+   *
+   * @param gid the GID, flip flags are ignored.
+   *
+   * @return the value of the GID; the fallback value if the GID is outside of
+   * the array.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto get(global_id gid) const noexcept -> const T&
+  {
+    const auto index = static_cast<std::size_t>(strip_flip_bits(gid).get());
+    return index < m_values.size() ? m_values[index] : m_fallback;
+  }
+
+  /**
+   * @copydoc get()
+   */
+  [[nodiscard]] auto operator[](global_id gid) const noexcept -> const T&
+  {
+    return get(gid);
+  }
+
+  /**
+   * @brief Returns the value used for GIDs without a value.
+   *
+   * @return the fallback value.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto fallback() const noexcept -> const T&
+  {
+    return m_fallback;
+  }
+
+  /**
+   * @brief Returns the amount of GIDs in the array.
+   *
+   * @return one more than the largest GID in the array.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto size() const noexcept -> std::size_t
+  {
+    return m_values.size();
+  }
+
+ private:
+  T m_fallback{};
+  std::vector<T> m_values;
+};
+
+/**
+ * @class tile_property_tables
+ *
+ * @brief Compiles the tile properties of a map into GID-indexed tables.
+ *
+ * @details Every boolean tile property is compiled into a `gid_bitset` and
+ * every `int` and `float` tile property into a `gid_array`, in a single pass
+ * over the tiles of all tilesets. Look up the table of a property once, by
+ * name, and then use it for all per-tile checks. Tiles without a property
+ * are unset in bitsets and zero in arrays.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_gid_table.hpp
+ */
+class tile_property_tables final {
+ public:
+  /**
+   * @brief Compiles the tile properties of a map.
+   *
+   * @param map the map that provides the tilesets.
+   *
+   * @since 0.3.0
+   */
+  explicit tile_property_tables(const map& map)
+  {
+    const auto size = detail::gid_count(map);
+    for (const auto& tileset : map.tilesets()) {
+      const auto first = tileset->first_gid().get();
+      for (const auto& tile : tileset->tiles()) {
+        const auto* props = tile.get_properties();
+        if (!props) {
+          continue;
+        }
+
+        const global_id gid{first + tile.id().get()};
+        props->each([&](const auto& pair) {
+          const auto& [name, value] = pair;
+          switch (value.get_type()) {
+            case property::type::boolean:
+              find_or_add(m_flags, name, size)
+                  .set(gid, value.template get<bool>());
+              break;
+
+            case property::type::integer:
+              find_or_add(m_integers, name, size, 0)
+                  .set(gid, value.template get<int>());
+              break;
+
+            case property::type::floating:
+              find_or_add(m_floats, name, size, 0.0f)
+                  .set(gid, value.template get<float>());
+              break;
+
+            default:
+              break;
+          }
+        });
+      }
+    }
+  }
+
+  /**
+   * @brief Returns the bitset of a boolean tile property.
+   *
+   * @param name the name of the property.
+   *
+   * @return the bitset of the property; a null pointer if no tile has a
+   * boolean property with the specified name.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto flags(std::string_view name) const -> const gid_bitset*
+  {
+    return find(m_flags, name);
+  }
+
+  /**
+   * @brief Returns the array of an `int` tile property.
+   *
+   * @param name the name of the property.
+   *
+   * @return the array of the property; a null pointer if no tile has an `int`
+   * property with the specified name.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto integers(std::string_view name) const
+      -> const gid_array<int>*
+  {
+    return find(m_integers, name);
+  }
+
+  /**
+   * @brief Returns the array of a `float` tile property.
+   *
+   * @param name the name of the property.
+   *
+   * @return the array of the property; a null pointer if no tile has a
+   * `float` property with the specified name.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto floats(std::string_view name) const
+      -> const gid_array<float>*
+  {
+    return find(m_floats, name);
+  }
+
+ private:
+  template <typename T>
+  using table_map = std::map<std::string, T, std::less<>>;
+
+  table_map<gid_bitset> m_flags;
+  table_map<gid_array<int>> m_integers;
+  table_map<gid_array<float>> m_floats;
+
+  template <typename T, typename... Args>
+  static auto find_or_add(table_map<T>& tables,
+                          const std::string& name,
+                          Args&&... args) -> T&
+  {
+    if (const auto it = tables.find(name); it != tables.end()) {
+      return it->second;
+    } else {
+      return tables.emplace(name, T{std::forward<Args>(args)...})
+          .first->second;
+    }
+  }
+
+  template <typename T>
+  [[nodiscard]] static auto find(const table_map<T>& tables,
+                                 std::string_view name) -> const T*
+  {
+    const auto it = tables.find(name);
+    return it != tables.end() ? &it->second : nullptr;
+  }
+};
+
+}  // namespace step
+
+#endif  // STEP_GID_TABLE_HEADER
@@ -27,6 +27,7 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
@@ -397,6 +398,83 @@ class layer final {
   }
 };
 
+namespace detail {
+
+/**
+ * @brief Invokes a lambda for a layer if it is a tile layer, or for each of
+ * the tile layers nested in it if it is a group.
+ *
+ * @tparam Lambda the type of the lambda object.
+ *
+ * @param layer the layer that will be visited.
+ * @param lambda the lambda that takes two arguments, `const layer&` and
+ * `const tile_layer&`.
+ *
+ * @since 0.3.0
+ */
+template <typename Lambda>
+void each_tile_layer(const layer& layer, Lambda&& lambda)
+{
+  if (const auto* tileLayer = layer.try_as<tile_layer>()) {
+    lambda(layer, *tileLayer);
+  } else if (const auto* group = layer.try_as<step::group>()) {
+    group->each([&](const step::layer& child) {
+      each_tile_layer(child, lambda);
+    });
+  }
+}
+
+/**
+ * @brief Returns the first tile layer with a specific name.
+ *
+ * @param layers the layers that will be searched, including nested groups.
+ * @param name the name of the tile layer.
+ *
+ * @return the tile layer; null if there is no tile layer with the name.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] inline auto find_tile_layer(const std::vector<layer>& layers,
+                                          std::string_view name)
+    -> const tile_layer*
+{
+  const tile_layer* result{};
+  for (const auto& root : layers) {
+    each_tile_layer(root, [&](const layer& info, const tile_layer& tiles) {
+      if (!result && info.name() == name) {
+        result = &tiles;
+      }
+    });
+  }
+  return result;
+}
+
+/**
+ * @brief Invokes a lambda for a layer if it is an object group, or for each of
+ * the object groups nested in it if it is a group.
+ *
+ * @tparam Lambda the type of the lambda object.
+ *
+ * @param layer the layer that will be visited.
+ * @param lambda the lambda that takes two arguments, `const layer&` and
+ * `const object_group&`.
+ *
+ * @since 0.3.0
+ */
+template <typename Lambda>
+void each_object_group(const layer& layer, Lambda&& lambda)
+{
+  if (const auto* objects = layer.try_as<object_group>()) {
+    lambda(layer, *objects);
+  } else if (const auto* group = layer.try_as<step::group>()) {
+    group->each([&](const step::layer& child) {
+      each_object_group(child, lambda);
+    });
+  }
+}
+
+}  // namespace detail
+
 NLOHMANN_JSON_SERIALIZE_ENUM(layer::type,
                              {{layer::type::tile_layer, "tilelayer"},
                               {layer::type::image_layer, "imagelayer"},
@@ -0,0 +1,278 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_layer_states.hpp
+ *
+ * @brief Provides the `layer_states` class.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_LAYER_STATES_HEADER
+#define STEP_LAYER_STATES_HEADER
+
+#include <cstddef>        // size_t
+#include <unordered_map>  // unordered_map
+#include <vector>         // vector
+
+#include "step_api.hpp"
+#include "step_exception.hpp"
+#include "step_layer.hpp"
+#include "step_map.hpp"
+
+namespace step {
+
+/**
+ * @struct layer_state
+ *
+ * @brief The accumulated state of a layer, including all of its groups.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_layer_states.hpp
+ */
+struct layer_state final {
+  const layer* source{};  ///< The layer, owned by the map.
+  int parent{-1};         ///< The index of the parent group, -1 for none.
+  std::size_t end{};      ///< The index after the last descendant.
+  double offset_x{};      ///< The sum of the horizontal offsets.
+  double offset_y{};      ///< The sum of the vertical offsets.
+  double opacity{1};      ///< The product of the opacities.
+  bool visible{true};     ///< Whether the layer and its groups are visible.
+};
+
+/**
+ * @class layer_states
+ *
+ * @brief A flat array of the effective offsets, opacities and visibility of
+ * all layers in a map.
+ *
+ * @details The layers are stored in depth-first order, i.e. the order in
+ * which they are drawn, where every group is directly followed by its
+ * descendants. The state of a layer is obtained by combining its own values
+ * with the state of its parent group.
+ *
+ * The own values of a layer can be overridden, e.g. to toggle a group at
+ * runtime, which only recomputes the states of the layer and its
+ * descendants.
+ *
+ * @note The map must outlive the states.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_layer_states.hpp
+ */
+class layer_states final {
+ public:
+  /**
+   * @brief Computes the states of all layers in a map.
+   *
+   * @param map the map that provides the layers.
+   *
+   * @since 0.3.0
+   */
+  explicit layer_states(const map& map)
+  {
+    for (const auto& layer : map.layers()) {
+      add(layer, -1);
+    }
+    refresh(0, m_states.size());
+  }
+
+  /**
+   * @brief Sets whether or not a layer is visible.
+   *
+   * @param id the ID of the layer.
+   * @param visible `true` if the layer should be visible; `false` otherwise.
+   *
+   * @throws step_exception if there is no layer with the ID.
+   *
+   * @since 0.3.0
+   */
+  void set_visible(int id, bool visible)
+  {
+    const auto index = index_of(id);
+    m_own[index].visible = visible;
+    refresh(index, m_states[index].end);
+  }
+
+  /**
+   * @brief Sets the opacity of a layer.
+   *
+   * @param id the ID of the layer.
+   * @param opacity the opacity of the layer, in the range [0, 1].
+   *
+   * @throws step_exception if there is no layer with the ID.
+   *
+   * @since 0.3.0
+   */
+  void set_opacity(int id, double opacity)
+  {
+    const auto index = index_of(id);
+    m_own[index].opacity = opacity;
+    refresh(index, m_states[index].end);
+  }
+
+  /**
+   * @brief Sets the offset of a layer.
+   *
+   * @param id the ID of the layer.
+   * @param x the horizontal offset of the layer, in pixels.
+   * @param y the vertical offset of the layer, in pixels.
+   *
+   * @throws step_exception if there is no layer with the ID.
+   *
+   * @since 0.3.0
+   */
+  void set_offset(int id, double x, double y)
+  {
+    const auto index = index_of(id);
+    m_own[index].offset_x = x;
+    m_own[index].offset_y = y;
+    refresh(index, m_states[index].end);
+  }
+
+  /**
+   * @brief Returns the state of a layer.
+   *
+   * @param id the ID of the layer.
+   *
+   * @return the accumulated state of the layer.
+   *
+   * @throws step_exception if there is no layer with the ID.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto get(int id) const -> const layer_state&
+  {
+    return m_states[index_of(id)];
+  }
+
+  /**
+   * @brief Returns the index of a layer in the flat array.
+   *
+   * @param id the ID of the layer.
+   *
+   * @return the index of the layer.
+   *
+   * @throws step_exception if there is no layer with the ID.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto index_of(int id) const -> std::size_t
+  {
+    const auto it = m_indices.find(id);
+    if (it == m_indices.end()) {
+      throw step_exception{"layer_states > Unknown layer ID!"};
+    }
+    return it->second;
+  }
+
+  /**
+   * @brief Returns the states of all layers.
+   *
+   * @return the states of all layers, in depth-first order.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto states() const noexcept
+      -> const std::vector<layer_state>&
+  {
+    return m_states;
+  }
+
+  /**
+   * @brief Returns the amount of layers.
+   *
+   * @return the amount of layers, including nested layers.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto size() const noexcept -> std::size_t
+  {
+    return m_states.size();
+  }
+
+ private:
+  struct own_state final {
+    double offset_x{};
+    double offset_y{};
+    double opacity{1};
+    bool visible{true};
+  };
+
+  std::vector<layer_state> m_states;
+  std::vector<own_state> m_own;
+  std::unordered_map<int, std::size_t> m_indices;
+
+  void add(const layer& layer, int parent)
+  {
+    const auto index = m_states.size();
+    m_indices.emplace(layer.id(), index);
+
+    layer_state state;
+    state.source = &layer;
+    state.parent = parent;
+    m_states.push_back(state);
+    m_own.push_back(own_state{
+        layer.offset_x(), layer.offset_y(), layer.opacity(), layer.visible()});
+
+    if (const auto* group = layer.try_as<step::group>()) {
+      group->each([&](const step::layer& child) {
+        add(child, static_cast<int>(index));
+      });
+    }
+    m_states[index].end = m_states.size();
+  }
+
+  // Parents precede their children, so one pass over the range suffices
+  void refresh(std::size_t begin, std::size_t end) noexcept
+  {
+    for (auto index = begin; index < end; ++index) {
+      auto& state = m_states[index];
+      const auto& own = m_own[index];
+      if (state.parent == -1) {
+        state.offset_x = own.offset_x;
+        state.offset_y = own.offset_y;
+        state.opacity = own.opacity;
+        state.visible = own.visible;
+      } else {
+        const auto& parent = m_states[static_cast<std::size_t>(state.parent)];
+        state.offset_x = parent.offset_x + own.offset_x;
+        state.offset_y = parent.offset_y + own.offset_y;
+        state.opacity = parent.opacity * own.opacity;
+        state.visible = parent.visible && own.visible;
+      }
+    }
+  }
+};
+
+}  // namespace step
+
+#endif  // STEP_LAYER_STATES_HEADER
@@ -0,0 +1,461 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_lod.hpp
+ *
+ * @brief Provides level of detail pyramids for tile layers.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_LOD_HEADER
+#define STEP_LOD_HEADER
+
+#include <algorithm>    // max, min
+#include <cmath>        // log2, floor
+#include <cstddef>      // size_t
+#include <stdexcept>    // out_of_range
+#include <string_view>  // string_view
+#include <utility>      // move
+#include <vector>       // vector
+
+#include "step_api.hpp"
+#include "step_exception.hpp"
+#include "step_gid_table.hpp"
+#include "step_layer.hpp"
+#include "step_map.hpp"
+#include "step_types.hpp"
+#include "step_utils.hpp"
+
+namespace step {
+
+/**
+ * @class lod_pyramid
+ *
+ * @brief A pyramid of progressively smaller versions of a tile layer.
+ *
+ * @details Level zero is the layer itself, and every cell of a higher level
+ * summarizes a 2x2 block of the level below with a representative GID. The
+ * representative is the non-empty GID with the largest total weight in the
+ * block, where each tile has a weight of one by default, i.e. the mode of the
+ * block. Ties go to the GID that appears first, in row-major order.
+ *
+ * Each level also keeps the amount of non-empty cells per chunk of 16x16
+ * cells, so that empty parts of far zoom levels can be skipped.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_lod.hpp
+ */
+class lod_pyramid final {
+ public:
+  /**
+   * @brief The width and height of the chunks, in cells.
+   *
+   * @since 0.3.0
+   */
+  static constexpr int chunk_size = 16;
+
+  /**
+   * @brief Builds a pyramid where the representative GID of a block is its
+   * most common GID.
+   *
+   * @param map the map that contains the layer.
+   * @param layer the name of the tile layer, which may be nested in a group.
+   * @param threads the maximum amount of threads, zero means the amount of
+   * hardware threads.
+   *
+   * @throws step_exception if there is no tile layer with the name.
+   *
+   * @since 0.3.0
+   */
+  lod_pyramid(const map& map, std::string_view layer, int threads = 0)
+      : lod_pyramid{map, layer, gid_array<double>{0, 1.0}, threads}
+  {}
+
+  /**
+   * @brief Builds a pyramid where GIDs are weighted, e.g. by a tile property.
+   *
+   * @param map the map that contains the layer.
+   * @param layer the name of the tile layer, which may be nested in a group.
+   * @param weights the weights of the GIDs, GIDs with weights that aren't
+   * positive are only picked if nothing else is present.
+   * @param threads the maximum amount of threads, zero means the amount of
+   * hardware threads.
+   *
+   * @throws step_exception if there is no tile layer with the name.
+   *
+   * @since 0.3.0
+   */
+  lod_pyramid(const map& map,
+              std::string_view layer,
+              gid_array<double> weights,
+              int threads = 0)
+      : m_weights{std::move(weights)}
+  {
+    const auto* tiles = detail::find_tile_layer(map.layers(), layer);
+    if (!tiles) {
+      throw step_exception{"lod_pyramid > Tile layer doesn't exist!"};
+    }
+
+    auto width = std::max(map.width(), 1);
+    auto height = std::max(map.height(), 1);
+
+    auto& base = m_levels.emplace_back();
+    base.width = width;
+    base.height = height;
+    base.gids.assign(static_cast<std::size_t>(width * height), 0);
+    tiles->each([&](int col, int row, global_id gid) {
+      if (col >= 0 && row >= 0 && col < width && row < height) {
+        base.gids[static_cast<std::size_t>(row * width + col)] = gid.get();
+      }
+    });
+
+    while (width > 1 || height > 1) {
+      width = (width + 1) / 2;
+      height = (height + 1) / 2;
+
+      auto& level = m_levels.emplace_back();
+      level.width = width;
+      level.height = height;
+      level.gids.assign(static_cast<std::size_t>(width * height), 0);
+    }
+
+    for (std::size_t index = 1; index < m_levels.size(); ++index) {
+      auto& level = m_levels[index];
+      detail::parallel_for(0, level.height, threads, [&](int row) {
+        for (auto col = 0; col < level.width; ++col) {
+          level.gids[static_cast<std::size_t>(row * level.width + col)] =
+              summarize(index, col, row);
+        }
+      });
+    }
+
+    for (auto& level : m_levels) {
+      count_chunks(level);
+    }
+  }
+
+  /**
+   * @brief Changes a tile of the layer, and updates the levels above it.
+   *
+   * @details Only the cells that cover the tile are recomputed, and the update
+   * stops at the first level where the representative GID didn't change.
+   *
+   * @param col the column of the tile.
+   * @param row the row of the tile.
+   * @param gid the new GID of the tile, including flip bits.
+   *
+   * @throws step_exception if the tile is outside of the layer.
+   *
+   * @since 0.3.0
+   */
+  void set(int col, int row, global_id gid)
+  {
+    if (!in_bounds(0, col, row)) {
+      throw step_exception{"lod_pyramid > Tile is out of bounds!"};
+    }
+
+    if (!assign(0, col, row, gid.get())) {
+      return;
+    }
+
+    for (std::size_t index = 1; index < m_levels.size(); ++index) {
+      col /= 2;
+      row /= 2;
+      if (!assign(index, col, row, summarize(index, col, row))) {
+        return;
+      }
+    }
+  }
+
+  /**
+   * @brief Returns the GID of a cell in a level.
+   *
+   * @param level the level, where zero is the layer itself.
+   * @param col the column of the cell in the level.
+   * @param row the row of the cell in the level.
+   *
+   * @return the GID of the cell, including flip bits; zero if the cell is
+   * outside of the level.
+   *
+   * @throws std::out_of_range if the level doesn't exist.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto gid_at(std::size_t level, int col, int row) const
+      -> global_id
+  {
+    const auto& data = m_levels.at(level);
+    return global_id{in_bounds(level, col, row)
+                         ? data.gids[static_cast<std::size_t>(
+                               row * data.width + col)]
+                         : 0u};
+  }
+
+  /**
+   * @brief Returns the GIDs of a level.
+   *
+   * @param level the level, where zero is the layer itself.
+   *
+   * @return the GIDs of the level in row-major order, including flip bits.
+   *
+   * @throws std::out_of_range if the level doesn't exist.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto level(std::size_t level) const
+      -> const std::vector<unsigned>&
+  {
+    return m_levels.at(level).gids;
+  }
+
+  /**
+   * @brief Returns the width of a level.
+   *
+   * @param level the level, where zero is the layer itself.
+   *
+   * @return the amount of columns in the level.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto width(std::size_t level) const -> int
+  {
+    return m_levels.at(level).width;
+  }
+
+  /**
+   * @brief Returns the height of a level.
+   *
+   * @param level the level, where zero is the layer itself.
+   *
+   * @return the amount of rows in the level.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto height(std::size_t level) const -> int
+  {
+    return m_levels.at(level).height;
+  }
+
+  /**
+   * @brief Returns the amount of levels, including the layer itself.
+   *
+   * @return the amount of levels.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto levels() const noexcept -> std::size_t
+  {
+    return m_levels.size();
+  }
+
+  /**
+   * @brief Returns the level that suits a zoom factor.
+   *
+   * @details The cells of level `k` cover 2^k tiles along each axis. The
+   * returned level draws its cells at more than half, and at most all, of the
+   * original tile size.
+   *
+   * @param scale the zoom factor, where one means that tiles have their
+   * original size.
+   *
+   * @return the coarsest level that doesn't lose detail at the zoom factor.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto level_for_scale(double scale) const noexcept
+      -> std::size_t
+  {
+    if (!(scale < 1.0)) {
+      return 0;
+    }
+
+    const auto level = scale > 0 ? std::floor(-std::log2(scale))
+                                 : static_cast<double>(m_levels.size());
+    return std::min(static_cast<std::size_t>(level), m_levels.size() - 1);
+  }
+
+  /**
+   * @brief Returns the amount of non-empty cells in a chunk of a level.
+   *
+   * @param level the level, where zero is the layer itself.
+   * @param chunkCol the column of the chunk.
+   * @param chunkRow the row of the chunk.
+   *
+   * @return the amount of non-empty cells in the chunk; zero if the chunk is
+   * outside of the level.
+   *
+   * @throws std::out_of_range if the level doesn't exist.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto chunk_count(std::size_t level,
+                                 int chunkCol,
+                                 int chunkRow) const -> int
+  {
+    const auto& data = m_levels.at(level);
+    if (chunkCol < 0 || chunkRow < 0 || chunkCol >= data.chunkCols ||
+        chunkRow >= chunk_rows(level)) {
+      return 0;
+    }
+    return data.chunks[static_cast<std::size_t>(chunkRow * data.chunkCols +
+                                                chunkCol)];
+  }
+
+  /**
+   * @brief Returns the amount of chunk columns in a level.
+   *
+   * @param level the level, where zero is the layer itself.
+   *
+   * @return the amount of chunk columns in the level.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto chunk_cols(std::size_t level) const -> int
+  {
+    return m_levels.at(level).chunkCols;
+  }
+
+  /**
+   * @brief Returns the amount of chunk rows in a level.
+   *
+   * @param level the level, where zero is the layer itself.
+   *
+   * @return the amount of chunk rows in the level.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto chunk_rows(std::size_t level) const -> int
+  {
+    return (m_levels.at(level).height + chunk_size - 1) / chunk_size;
+  }
+
+ private:
+  struct level_data final {
+    int width{};
+    int height{};
+    int chunkCols{};
+    std::vector<unsigned> gids;
+    std::vector<int> chunks;
+  };
+
+  gid_array<double> m_weights;
+  std::vector<level_data> m_levels;
+
+  [[nodiscard]] auto in_bounds(std::size_t level, int col, int row) const
+      noexcept -> bool
+  {
+    const auto& data = m_levels[level];
+    return col >= 0 && row >= 0 && col < data.width && row < data.height;
+  }
+
+  /**
+   * @brief Computes the representative GID of a cell from the level below.
+   */
+  [[nodiscard]] auto summarize(std::size_t level, int col, int row) const
+      -> unsigned
+  {
+    const auto& below = m_levels[level - 1];
+
+    unsigned candidates[4]{};
+    auto count = 0;
+    for (auto dy = 0; dy < 2; ++dy) {
+      for (auto dx = 0; dx < 2; ++dx) {
+        const auto c = col * 2 + dx;
+        const auto r = row * 2 + dy;
+        if (c < below.width && r < below.height) {
+          const auto gid = below.gids[static_cast<std::size_t>(
+              r * below.width + c)];
+          if (gid != 0) {
+            candidates[count++] = gid;
+          }
+        }
+      }
+    }
+
+    unsigned best = count > 0 ? candidates[0] : 0u;
+    auto bestScore = 0.0;
+    for (auto i = 0; i < count; ++i) {
+      auto score = 0.0;
+      for (auto j = 0; j < count; ++j) {
+        if (candidates[j] == candidates[i]) {
+          score += m_weights.get(global_id{candidates[j]});
+        }
+      }
+
+      if (score > bestScore) {
+        best = candidates[i];
+        bestScore = score;
+      }
+    }
+
+    return best;
+  }
+
+  /**
+   * @brief Changes a cell, and returns `true` if its GID changed.
+   */
+  auto assign(std::size_t level, int col, int row, unsigned gid) -> bool
+  {
+    auto& data = m_levels[level];
+    auto& cell = data.gids[static_cast<std::size_t>(row * data.width + col)];
+    if (cell == gid) {
+      return false;
+    }
+
+    auto& chunk = data.chunks[static_cast<std::size_t>(
+        (row / chunk_size) * data.chunkCols + col / chunk_size)];
+    chunk += (gid != 0 ? 1 : 0) - (cell != 0 ? 1 : 0);
+
+    cell = gid;
+    return true;
+  }
+
+  static void count_chunks(level_data& level)
+  {
+    level.chunkCols = (level.width + chunk_size - 1) / chunk_size;
+    const auto chunkRows = (level.height + chunk_size - 1) / chunk_size;
+    level.chunks.assign(static_cast<std::size_t>(level.chunkCols * chunkRows),
+                        0);
+
+    for (auto row = 0; row < level.height; ++row) {
+      for (auto col = 0; col < level.width; ++col) {
+        if (level.gids[static_cast<std::size_t>(row * level.width + col)]) {
+          ++level.chunks[static_cast<std::size_t>(
+              (row / chunk_size) * level.chunkCols + col / chunk_size)];
+        }
+      }
+    }
+  }
+};
+
+}  // namespace step
+
+#endif  // STEP_LOD_HEADER
@@ -34,6 +34,7 @@
 #include "step_color.hpp"
 #include "step_layer.hpp"
 #include "step_properties.hpp"
+#include "step_simplify.hpp"
 #include "step_tileset.hpp"
 #include "step_types.hpp"
 
@@ -66,6 +67,30 @@ class map final {
     parse(parent.string(), detail::parse_json(path.string()));
   }
 
+  /**
+   * @brief Loads a map and simplifies some of its polygon and polyline
+   * objects.
+   *
+   * @details The simplification is applied before the objects are parsed, so
+   * the removed points are never stored.
+   *
+   * @param path the file path of the JSON map file.
+   * @param rules the rules that select the simplified objects, the first rule
+   * that matches an object is used.
+   *
+   * @since 0.3.0
+   */
+  map(const fs::path& path, const std::vector<simplification_rule>& rules)
+  {
+    auto parent = path.parent_path();
+    parent += fs::path::preferred_separator;
+
+    auto json = detail::parse_json(path.string());
+    detail::simplify_layers(json.at("layers"), rules);
+
+    parse(parent.string(), json);
+  }
+
   /**
    * @param root the file path of the directory that contains the map.
    * @param file the name of the JSON map file, including the .json extension.
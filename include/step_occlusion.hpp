@@ -0,0 +1,350 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_occlusion.hpp
+ *
+ * @brief Provides occlusion masks for stacked tile layers.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_OCCLUSION_HEADER
+#define STEP_OCCLUSION_HEADER
+
+#include <bitset>       // bitset
+#include <cstddef>      // size_t
+#include <string_view>  // string_view
+#include <vector>       // vector
+
+#include "step_api.hpp"
+#include "step_exception.hpp"
+#include "step_gid_table.hpp"
+#include "step_layer.hpp"
+#include "step_map.hpp"
+#include "step_tile_layer.hpp"
+#include "step_types.hpp"
+#include "step_utils.hpp"
+
+namespace step {
+
+/**
+ * @class occlusion_mask
+ *
+ * @brief Marks the cells of tile layers that are hidden by opaque tiles in
+ * higher layers.
+ *
+ * @details A cell is occluded if the same cell of a higher layer holds an
+ * opaque tile, and that layer is visible, fully opaque and not offset. The
+ * visibility and opacity of enclosing groups are taken into account. The
+ * masks are stored per chunk of 16x16 cells, so that renderers can skip
+ * hidden cells, or entire chunks, when building render batches.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_occlusion.hpp
+ */
+class occlusion_mask final {
+ public:
+  /**
+   * @brief The width and height of the chunks, in cells.
+   *
+   * @since 0.3.0
+   */
+  static constexpr int chunk_size = 16;
+
+  /**
+   * @brief The bits of a chunk, in row-major order.
+   *
+   * @since 0.3.0
+   */
+  using chunk_bits = std::bitset<chunk_size * chunk_size>;
+
+  /**
+   * @brief Computes the occlusion masks of a map.
+   *
+   * @param map the map that provides the tile layers.
+   * @param opaque the set of opaque tiles.
+   * @param threads the maximum amount of threads, zero means the amount of
+   * hardware threads.
+   *
+   * @since 0.3.0
+   */
+  occlusion_mask(const map& map, const gid_bitset& opaque, int threads = 0)
+      : m_width{map.width()},
+        m_height{map.height()},
+        m_chunkCols{(m_width + chunk_size - 1) / chunk_size},
+        m_chunkRows{(m_height + chunk_size - 1) / chunk_size}
+  {
+    for (const auto& layer : map.layers()) {
+      collect(layer, true, true);
+    }
+
+    const auto chunks = m_chunkCols * m_chunkRows;
+    for (auto& layer : m_layers) {
+      layer.masks.resize(static_cast<std::size_t>(chunks));
+    }
+
+    detail::parallel_for(0, chunks, threads, [&](int chunk) {
+      compute_chunk(chunk, opaque);
+    });
+
+    for (auto& layer : m_layers) {
+      layer.gids.clear();
+      layer.gids.shrink_to_fit();
+    }
+  }
+
+  /**
+   * @brief Computes the occlusion masks of a map, where opaque tiles are
+   * marked with a boolean tile property.
+   *
+   * @param map the map that provides the tile layers and tilesets.
+   * @param property the name of the boolean tile property, e.g. `"opaque"`.
+   * @param threads the maximum amount of threads, zero means the amount of
+   * hardware threads.
+   *
+   * @since 0.3.0
+   */
+  occlusion_mask(const map& map, std::string_view property, int threads = 0)
+      : occlusion_mask{map, gid_bitset{map, property}, threads}
+  {}
+
+  /**
+   * @brief Indicates whether or not a cell of a layer is occluded.
+   *
+   * @param layer the ID of the tile layer.
+   * @param col the column of the cell.
+   * @param row the row of the cell.
+   *
+   * @return `true` if the cell holds a tile that is hidden; `false` otherwise.
+   *
+   * @throws step_exception if there is no tile layer with the ID.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto occluded(int layer, int col, int row) const -> bool
+  {
+    if (col < 0 || row < 0 || col >= m_width || row >= m_height) {
+      return false;
+    }
+
+    const auto& masks = find(layer).masks;
+    const auto chunk = (row / chunk_size) * m_chunkCols + col / chunk_size;
+    const auto bit = (row % chunk_size) * chunk_size + col % chunk_size;
+    return masks[static_cast<std::size_t>(chunk)].occluded.test(
+        static_cast<std::size_t>(bit));
+  }
+
+  /**
+   * @brief Returns the mask of the occluded cells in a chunk of a layer.
+   *
+   * @param layer the ID of the tile layer.
+   * @param chunkCol the column of the chunk.
+   * @param chunkRow the row of the chunk.
+   *
+   * @return the occluded cells of the chunk, in row-major order.
+   *
+   * @throws step_exception if there is no tile layer with the ID, or if the
+   * chunk is out of bounds.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto chunk_mask(int layer, int chunkCol, int chunkRow) const
+      -> const chunk_bits&
+  {
+    return chunk_at(layer, chunkCol, chunkRow).occluded;
+  }
+
+  /**
+   * @brief Indicates whether or not every tile in a chunk of a layer is
+   * occluded.
+   *
+   * @details Chunks without any tiles count as hidden.
+   *
+   * @param layer the ID of the tile layer.
+   * @param chunkCol the column of the chunk.
+   * @param chunkRow the row of the chunk.
+   *
+   * @return `true` if nothing in the chunk has to be drawn; `false` otherwise.
+   *
+   * @throws step_exception if there is no tile layer with the ID, or if the
+   * chunk is out of bounds.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto chunk_hidden(int layer, int chunkCol, int chunkRow) const
+      -> bool
+  {
+    const auto& chunk = chunk_at(layer, chunkCol, chunkRow);
+    return chunk.occluded == chunk.occupied;
+  }
+
+  /**
+   * @brief Returns the total amount of occluded cells, in all layers.
+   *
+   * @return the total amount of occluded cells.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto occluded_count() const noexcept -> std::size_t
+  {
+    std::size_t count = 0;
+    for (const auto& layer : m_layers) {
+      for (const auto& chunk : layer.masks) {
+        count += chunk.occluded.count();
+      }
+    }
+    return count;
+  }
+
+  /**
+   * @brief Returns the amount of chunk columns.
+   *
+   * @return the amount of chunk columns.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto chunk_cols() const noexcept -> int
+  {
+    return m_chunkCols;
+  }
+
+  /**
+   * @brief Returns the amount of chunk rows.
+   *
+   * @return the amount of chunk rows.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto chunk_rows() const noexcept -> int
+  {
+    return m_chunkRows;
+  }
+
+ private:
+  struct chunk_masks final {
+    chunk_bits occupied;
+    chunk_bits occluded;
+  };
+
+  struct layer_data final {
+    int id{};
+    bool occluder{};
+    std::vector<unsigned> gids;
+    std::vector<chunk_masks> masks;
+  };
+
+  int m_width{};
+  int m_height{};
+  int m_chunkCols{};
+  int m_chunkRows{};
+  std::vector<layer_data> m_layers;  // In draw order, i.e. bottom first
+
+  void collect(const layer& layer, bool visible, bool opaque)
+  {
+    visible = visible && layer.visible();
+    opaque = opaque && layer.opacity() >= 1.0;
+
+    if (const auto* group = layer.try_as<step::group>()) {
+      group->each([&](const step::layer& child) {
+        collect(child, visible, opaque);
+      });
+    } else if (const auto* tiles = layer.try_as<tile_layer>()) {
+      auto& data = m_layers.emplace_back();
+      data.id = layer.id();
+      data.occluder = visible && opaque && layer.offset_x() == 0 &&
+                      layer.offset_y() == 0;
+      data.gids.assign(static_cast<std::size_t>(m_width * m_height), 0);
+      tiles->each([&](int col, int row, global_id gid) {
+        if (col >= 0 && row >= 0 && col < m_width && row < m_height) {
+          data.gids[static_cast<std::size_t>(row * m_width + col)] = gid.get();
+        }
+      });
+    }
+  }
+
+  void compute_chunk(int chunk, const gid_bitset& opaque)
+  {
+    const auto firstCol = (chunk % m_chunkCols) * chunk_size;
+    const auto firstRow = (chunk / m_chunkCols) * chunk_size;
+    const auto index = static_cast<std::size_t>(chunk);
+
+    // Walks the layers from the top, accumulating the covered cells
+    chunk_bits covered;
+    for (auto it = m_layers.rbegin(); it != m_layers.rend(); ++it) {
+      auto& masks = it->masks[index];
+      chunk_bits solid;
+
+      for (auto r = 0; r < chunk_size && firstRow + r < m_height; ++r) {
+        for (auto c = 0; c < chunk_size && firstCol + c < m_width; ++c) {
+          const auto cell = static_cast<std::size_t>(
+              (firstRow + r) * m_width + firstCol + c);
+          const auto gid = it->gids[cell];
+          if (gid != 0) {
+            const auto bit = static_cast<std::size_t>(r * chunk_size + c);
+            masks.occupied.set(bit);
+            if (opaque.test(global_id{gid})) {
+              solid.set(bit);
+            }
+          }
+        }
+      }
+
+      masks.occluded = masks.occupied & covered;
+      if (it->occluder) {
+        covered |= solid;
+      }
+    }
+  }
+
+  [[nodiscard]] auto find(int id) const -> const layer_data&
+  {
+    for (const auto& layer : m_layers) {
+      if (layer.id == id) {
+        return layer;
+      }
+    }
+    throw step_exception{"occlusion_mask > No tile layer with the ID!"};
+  }
+
+  [[nodiscard]] auto chunk_at(int layer, int chunkCol, int chunkRow) const
+      -> const chunk_masks&
+  {
+    if (chunkCol < 0 || chunkRow < 0 || chunkCol >= m_chunkCols ||
+        chunkRow >= m_chunkRows) {
+      throw step_exception{"occlusion_mask > Chunk is out of bounds!"};
+    }
+    const auto chunk = chunkRow * m_chunkCols + chunkCol;
+    return find(layer).masks[static_cast<std::size_t>(chunk)];
+  }
+};
+
+}  // namespace step
+
+#endif  // STEP_OCCLUSION_HEADER
@@ -0,0 +1,866 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_pathfinding.hpp
+ *
+ * @brief Provides the `path_finder` and `hierarchical_path_finder` classes,
+ * which find paths in walkability grids.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_PATHFINDING_HEADER
+#define STEP_PATHFINDING_HEADER
+
+#include <algorithm>  // min, max, sort, unique, reverse, push_heap, pop_heap
+#include <array>      // array
+#include <cstddef>    // size_t
+#include <cstdint>    // uint32_t
+#include <limits>     // numeric_limits
+#include <utility>    // move
+#include <vector>     // vector
+
+#include "step_api.hpp"
+#include "step_tile_pos.hpp"
+#include "step_walkability.hpp"
+
+namespace step {
+namespace detail {
+
+/**
+ * @class search_state
+ *
+ * @brief Provides the bookkeeping of best-first graph searches, for graphs
+ * whose nodes are identified by indices.
+ *
+ * @details The state is reused between searches. Instead of clearing the
+ * arrays before each search, every node is stamped with the search that it was
+ * last reached by.
+ *
+ * @since 0.3.0
+ */
+class search_state final {
+ public:
+  void reset(std::size_t size)
+  {
+    m_cost.assign(size, 0);
+    m_parent.assign(size, -1);
+    m_stamp.assign(size, 0);
+    m_generation = 0;
+    m_heap.clear();
+  }
+
+  void begin()
+  {
+    ++m_generation;
+    if (m_generation == 0) {
+      std::fill(m_stamp.begin(), m_stamp.end(), 0);
+      m_generation = 1;
+    }
+    m_heap.clear();
+  }
+
+  /**
+   * @brief Records a path to a node, if it's cheaper than the best known path.
+   */
+  void open(int index, int parent, double cost, double estimate)
+  {
+    const auto i = static_cast<std::size_t>(index);
+    if (m_stamp[i] != m_generation || cost < m_cost[i]) {
+      m_stamp[i] = m_generation;
+      m_cost[i] = cost;
+      m_parent[i] = parent;
+      m_heap.push_back({estimate, cost, index});
+      std::push_heap(m_heap.begin(), m_heap.end(), compare);
+    }
+  }
+
+  /**
+   * @brief Removes the most promising node, skipping outdated entries.
+   */
+  [[nodiscard]] auto pop(int& index) -> bool
+  {
+    while (!m_heap.empty()) {
+      std::pop_heap(m_heap.begin(), m_heap.end(), compare);
+      const auto entry = m_heap.back();
+      m_heap.pop_back();
+
+      if (entry.cost <= m_cost[static_cast<std::size_t>(entry.index)]) {
+        index = entry.index;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  [[nodiscard]] auto reached(int index) const noexcept -> bool
+  {
+    return m_stamp[static_cast<std::size_t>(index)] == m_generation;
+  }
+
+  [[nodiscard]] auto cost(int index) const noexcept -> double
+  {
+    return m_cost[static_cast<std::size_t>(index)];
+  }
+
+  /**
+   * @brief Returns the indices of the nodes on the path to a reached node,
+   * starting with the source of the search.
+   */
+  [[nodiscard]] auto path_to(int index) const -> std::vector<int>
+  {
+    std::vector<int> result;
+    for (auto i = index; i != -1; i = m_parent[static_cast<std::size_t>(i)]) {
+      result.push_back(i);
+    }
+    std::reverse(result.begin(), result.end());
+    return result;
+  }
+
+ private:
+  struct entry final {
+    double estimate;
+    double cost;
+    int index;
+  };
+
+  std::vector<double> m_cost;
+  std::vector<int> m_parent;
+  std::vector<std::uint32_t> m_stamp;
+  std::uint32_t m_generation{0};
+  std::vector<entry> m_heap;
+
+  [[nodiscard]] static auto compare(const entry& lhs,
+                                    const entry& rhs) noexcept -> bool
+  {
+    // Min-heap ordered by estimate, preferring deeper nodes on ties
+    if (lhs.estimate != rhs.estimate) {
+      return lhs.estimate > rhs.estimate;
+    } else {
+      return lhs.cost < rhs.cost;
+    }
+  }
+};
+
+/**
+ * @brief Runs an A* search.
+ *
+ * @param state the state that will hold the result of the search.
+ * @param start the index of the start node.
+ * @param goal the index of the goal node, or -1 to visit all reachable nodes.
+ * @param heuristic the callable that returns a lower bound of the cost from a
+ * node to the goal.
+ * @param expand the callable that takes an index and a callable `relax`, and
+ * invokes `relax(neighbour, edgeCost)` for each neighbour of the node.
+ *
+ * @return `true` if the goal was reached; `false` otherwise.
+ *
+ * @since 0.3.0
+ */
+template <typename Heuristic, typename Expand>
+auto a_star(search_state& state,
+            int start,
+            int goal,
+            Heuristic&& heuristic,
+            Expand&& expand) -> bool
+{
+  state.begin();
+  state.open(start, -1, 0, heuristic(start));
+
+  int index{};
+  while (state.pop(index)) {
+    if (index == goal) {
+      return true;
+    }
+
+    const auto cost = state.cost(index);
+    expand(index, [&](int next, double edgeCost) {
+      const auto nextCost = cost + edgeCost;
+      state.open(next, index, nextCost, nextCost + heuristic(next));
+    });
+  }
+
+  return false;
+}
+
+}  // namespace detail
+
+/**
+ * @class path_finder
+ *
+ * @brief Finds shortest paths in a walkability grid using A*.
+ *
+ * @details The search buffers are allocated once and reused between searches,
+ * so a path finder should be kept around rather than recreated for each path.
+ * Use a separate path finder for each thread.
+ *
+ * @warning The path finder refers to the grid, so the grid must outlive the
+ * path finder.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_pathfinding.hpp
+ */
+class path_finder final {
+ public:
+  /**
+   * @brief Creates a path finder for a grid.
+   *
+   * @param grid the grid that paths will be searched in.
+   *
+   * @since 0.3.0
+   */
+  explicit path_finder(const walkability_grid& grid) : m_grid{&grid}
+  {
+    m_state.reset(static_cast<std::size_t>(grid.width()) *
+                  static_cast<std::size_t>(grid.height()));
+  }
+
+  /**
+   * @brief Finds a shortest path between two tiles.
+   *
+   * @param start the position of the first tile of the path.
+   * @param goal the position of the last tile of the path.
+   *
+   * @return the positions of the tiles on the path, including the start and
+   * goal positions; an empty vector if there is no path.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto find_path(tile_pos start, tile_pos goal)
+      -> std::vector<tile_pos>
+  {
+    const auto& grid = *m_grid;
+    if (!grid.is_walkable(start) || !grid.is_walkable(goal)) {
+      return {};
+    }
+
+    const auto width = grid.width();
+    const auto to_pos = [width](int index) noexcept {
+      return tile_pos{index % width, index / width};
+    };
+    const auto to_index = [width](tile_pos pos) noexcept {
+      return pos.row * width + pos.col;
+    };
+
+    const auto found = detail::a_star(
+        m_state,
+        to_index(start),
+        to_index(goal),
+        [&](int index) { return grid.estimate(to_pos(index), goal); },
+        [&](int index, auto&& relax) {
+          grid.each_neighbour(to_pos(index), [&](tile_pos next, double dist) {
+            relax(to_index(next), dist * grid.cost(next));
+          });
+        });
+
+    std::vector<tile_pos> path;
+    if (found) {
+      for (const auto index : m_state.path_to(to_index(goal))) {
+        path.push_back(to_pos(index));
+      }
+    }
+
+    return path;
+  }
+
+ private:
+  const walkability_grid* m_grid{};
+  detail::search_state m_state;
+};
+
+/**
+ * @class hierarchical_path_finder
+ *
+ * @brief Finds paths in a walkability grid using hierarchical path-finding A*
+ * (HPA*).
+ *
+ * @details The grid is divided into square clusters. Each opening between two
+ * neighbouring clusters, i.e. a connected run of tiles that allow moving from
+ * one cluster into the other, is represented by an entrance in the middle of
+ * the opening. The tiles of the entrances are the nodes of an abstract graph,
+ * where the costs of the paths between the nodes of each cluster are
+ * precomputed. Paths are found by searching the abstract graph, which is much
+ * smaller than the grid, and then refining each abstract edge within a single
+ * cluster.
+ *
+ * @par Incremental repair
+ * Changing the cost of a tile only invalidates the cluster that contains the
+ * tile and its neighbouring clusters, which are rebuilt by the next call to
+ * `repair()` or `find_path()`.
+ *
+ * @note The paths are near-optimal, they may be slightly longer than the
+ * shortest paths. Use `path_finder` when shortest paths are required.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_pathfinding.hpp
+ */
+class hierarchical_path_finder final {
+ public:
+  /**
+   * @brief Creates a path finder and builds the abstract graph of a grid.
+   *
+   * @param grid the grid that paths will be searched in.
+   * @param clusterSize the width and height of the clusters, in tiles.
+   *
+   * @since 0.3.0
+   */
+  explicit hierarchical_path_finder(walkability_grid grid,
+                                    int clusterSize = 16)
+      : m_grid{std::move(grid)},
+        m_clusterSize{std::max(clusterSize, 1)},
+        m_clusterCols{(m_grid.width() + m_clusterSize - 1) / m_clusterSize},
+        m_clusterRows{(m_grid.height() + m_clusterSize - 1) / m_clusterSize},
+        m_clusters(static_cast<std::size_t>(m_clusterCols) *
+                   static_cast<std::size_t>(m_clusterRows)),
+        m_slots(cell_count(), -1)
+  {
+    m_abstractState.reset(cell_count());
+    m_localState.reset(static_cast<std::size_t>(m_clusterSize) *
+                       static_cast<std::size_t>(m_clusterSize));
+    m_goalState.reset(static_cast<std::size_t>(m_clusterSize) *
+                      static_cast<std::size_t>(m_clusterSize));
+
+    for (auto& cluster : m_clusters) {
+      cluster.dirty = true;
+    }
+    m_dirty = true;
+    repair();
+  }
+
+  /**
+   * @brief Sets the cost of entering a tile.
+   *
+   * @details The clusters affected by the change are rebuilt by the next
+   * call to `repair()` or `find_path()`. This function has no effect if the
+   * position is out-of-bounds or if the tile already has the specified cost.
+   *
+   * @param col the column of the tile.
+   * @param row the row of the tile.
+   * @param cost the new cost of the tile.
+   *
+   * @since 0.3.0
+   */
+  void set_cost(int col, int row, walkability_grid::cost_type cost) noexcept
+  {
+    if (!m_grid.contains(col, row) || m_grid.cost(col, row) == cost) {
+      return;
+    }
+
+    m_grid.set_cost(col, row, cost);
+
+    const auto clusterCol = col / m_clusterSize;
+    const auto clusterRow = row / m_clusterSize;
+    for (auto r = clusterRow - 1; r <= clusterRow + 1; ++r) {
+      for (auto c = clusterCol - 1; c <= clusterCol + 1; ++c) {
+        if (c >= 0 && r >= 0 && c < m_clusterCols && r < m_clusterRows) {
+          m_clusters[cluster_index(c, r)].dirty = true;
+        }
+      }
+    }
+
+    m_dirty = true;
+  }
+
+  /**
+   * @brief Rebuilds the clusters that were invalidated by `set_cost()`.
+   *
+   * @return the amount of clusters that were rebuilt.
+   *
+   * @since 0.3.0
+   */
+  auto repair() -> int
+  {
+    if (!m_dirty) {
+      return 0;
+    }
+
+    // The entrances of a cluster must be known before the nodes of its
+    // neighbours can be determined
+    int count = 0;
+    for (std::size_t i = 0; i < m_clusters.size(); ++i) {
+      if (m_clusters[i].dirty) {
+        build_entrances(static_cast<int>(i));
+        ++count;
+      }
+    }
+
+    for (std::size_t i = 0; i < m_clusters.size(); ++i) {
+      if (m_clusters[i].dirty) {
+        build_nodes(static_cast<int>(i));
+        m_clusters[i].dirty = false;
+      }
+    }
+
+    m_dirty = false;
+    return count;
+  }
+
+  /**
+   * @brief Finds a path between two tiles.
+   *
+   * @details Any invalidated clusters are rebuilt before the search.
+   *
+   * @param start the position of the first tile of the path.
+   * @param goal the position of the last tile of the path.
+   *
+   * @return the positions of the tiles on the path, including the start and
+   * goal positions; an empty vector if there is no path.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto find_path(tile_pos start, tile_pos goal)
+      -> std::vector<tile_pos>
+  {
+    repair();
+
+    if (!m_grid.is_walkable(start) || !m_grid.is_walkable(goal)) {
+      return {};
+    }
+
+    const auto startCell = to_cell(start);
+    const auto goalCell = to_cell(goal);
+    const auto startCluster = cluster_of(start);
+    const auto goalCluster = cluster_of(goal);
+
+    // Connect the start and goal to the nodes of their clusters
+    search_cluster(m_localState, startCluster, start, -1, false);
+    search_cluster(m_goalState, goalCluster, goal, -1, true);
+
+    const auto found = detail::a_star(
+        m_abstractState,
+        startCell,
+        goalCell,
+        [&](int cell) { return m_grid.estimate(to_pos(cell), goal); },
+        [&](int cell, auto&& relax) {
+          const auto pos = to_pos(cell);
+          const auto clusterIndex = cluster_of(pos);
+          const auto& cluster = m_clusters[clusterIndex];
+
+          if (cell == startCell) {
+            for (const auto node : cluster.nodes) {
+              const auto local = local_index(clusterIndex, to_pos(node));
+              if (m_localState.reached(local)) {
+                relax(node, m_localState.cost(local));
+              }
+            }
+          }
+
+          if (clusterIndex == goalCluster) {
+            const auto local = local_index(clusterIndex, pos);
+            if (m_goalState.reached(local)) {
+              relax(goalCell, m_goalState.cost(local));
+            }
+          }
+
+          const auto slot = m_slots[static_cast<std::size_t>(cell)];
+          if (slot != -1) {
+            const auto count = cluster.nodes.size();
+            const auto* costs =
+                cluster.costs.data() + static_cast<std::size_t>(slot) * count;
+            for (std::size_t j = 0; j < count; ++j) {
+              if (costs[j] != unreachable && cluster.nodes[j] != cell) {
+                relax(cluster.nodes[j], costs[j]);
+              }
+            }
+
+            for (const auto& entrance : cluster.entrances) {
+              if (entrance.from == cell) {
+                relax(entrance.to, entrance.cost);
+              }
+            }
+          }
+        });
+
+    if (!found) {
+      return {};
+    }
+
+    return refine(m_abstractState.path_to(goalCell));
+  }
+
+  /**
+   * @brief Returns the grid that paths are searched in.
+   *
+   * @return the grid that paths are searched in.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto grid() const noexcept -> const walkability_grid&
+  {
+    return m_grid;
+  }
+
+  /**
+   * @brief Returns the amount of nodes in the abstract graph.
+   *
+   * @return the amount of entrance tiles in all clusters.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto node_count() const noexcept -> int
+  {
+    std::size_t result = 0;
+    for (const auto& cluster : m_clusters) {
+      result += cluster.nodes.size();
+    }
+    return static_cast<int>(result);
+  }
+
+  /**
+   * @brief Returns the width and height of the clusters.
+   *
+   * @return the width and height of the clusters, in tiles.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto cluster_size() const noexcept -> int
+  {
+    return m_clusterSize;
+  }
+
+  /**
+   * @brief Returns the amount of cluster columns.
+   *
+   * @return the amount of cluster columns.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto cluster_cols() const noexcept -> int
+  {
+    return m_clusterCols;
+  }
+
+  /**
+   * @brief Returns the amount of cluster rows.
+   *
+   * @return the amount of cluster rows.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto cluster_rows() const noexcept -> int
+  {
+    return m_clusterRows;
+  }
+
+ private:
+  static constexpr double unreachable = std::numeric_limits<double>::max();
+
+  struct entrance final {
+    int from;     ///< The cell in the cluster.
+    int to;       ///< The cell in the neighbouring cluster.
+    double cost;  ///< The cost of moving between the cells.
+  };
+
+  struct cluster final {
+    std::vector<int> nodes;  ///< The cells of the nodes, sorted.
+    std::vector<double> costs;  ///< The costs between the nodes, row-major.
+    std::vector<entrance> entrances;
+    bool dirty{false};
+  };
+
+  walkability_grid m_grid;
+  int m_clusterSize{};
+  int m_clusterCols{};
+  int m_clusterRows{};
+  std::vector<cluster> m_clusters;
+  std::vector<int> m_slots;  ///< The node index of each cell, or -1.
+  detail::search_state m_abstractState;
+  detail::search_state m_localState;
+  detail::search_state m_goalState;
+  bool m_dirty{false};
+
+  [[nodiscard]] auto cell_count() const noexcept -> std::size_t
+  {
+    return static_cast<std::size_t>(m_grid.width()) *
+           static_cast<std::size_t>(m_grid.height());
+  }
+
+  [[nodiscard]] auto to_cell(tile_pos pos) const noexcept -> int
+  {
+    return pos.row * m_grid.width() + pos.col;
+  }
+
+  [[nodiscard]] auto to_pos(int cell) const noexcept -> tile_pos
+  {
+    return {cell % m_grid.width(), cell / m_grid.width()};
+  }
+
+  [[nodiscard]] auto cluster_index(int clusterCol, int clusterRow) const
+      noexcept -> std::size_t
+  {
+    return static_cast<std::size_t>(clusterRow) *
+               static_cast<std::size_t>(m_clusterCols) +
+           static_cast<std::size_t>(clusterCol);
+  }
+
+  [[nodiscard]] auto cluster_of(tile_pos pos) const noexcept -> std::size_t
+  {
+    return cluster_index(pos.col / m_clusterSize, pos.row / m_clusterSize);
+  }
+
+  [[nodiscard]] auto cluster_origin(std::size_t index) const noexcept
+      -> tile_pos
+  {
+    const auto i = static_cast<int>(index);
+    return {(i % m_clusterCols) * m_clusterSize,
+            (i / m_clusterCols) * m_clusterSize};
+  }
+
+  [[nodiscard]] auto local_index(std::size_t index, tile_pos pos) const
+      noexcept -> int
+  {
+    const auto origin = cluster_origin(index);
+    return (pos.row - origin.row) * m_clusterSize + (pos.col - origin.col);
+  }
+
+  [[nodiscard]] auto is_step(tile_pos from, tile_pos to) const -> bool
+  {
+    if (from == to) {
+      return true;
+    }
+
+    bool result = false;
+    m_grid.each_neighbour(from, [&](tile_pos next, double) {
+      result = result || next == to;
+    });
+    return result;
+  }
+
+  /**
+   * @brief Runs a search that is restricted to the tiles of a cluster, using
+   * local indices.
+   *
+   * @details Reverse searches compute the costs of moving from the tiles of
+   * the cluster to the source, rather than the other way around.
+   */
+  auto search_cluster(detail::search_state& state,
+                      std::size_t index,
+                      tile_pos source,
+                      int target,
+                      bool reverse) -> bool
+  {
+    const auto origin = cluster_origin(index);
+    const auto endCol = std::min(origin.col + m_clusterSize, m_grid.width());
+    const auto endRow = std::min(origin.row + m_clusterSize, m_grid.height());
+    const auto size = m_clusterSize;
+
+    const auto to_local_pos = [origin, size](int local) noexcept {
+      return tile_pos{origin.col + local % size, origin.row + local / size};
+    };
+
+    const auto targetPos = to_local_pos(target);
+    return detail::a_star(
+        state,
+        local_index(index, source),
+        target,
+        [&](int local) {
+          return target == -1 ? 0.0
+                              : m_grid.estimate(to_local_pos(local), targetPos);
+        },
+        [&](int local, auto&& relax) {
+          const auto pos = to_local_pos(local);
+          const auto cost = m_grid.cost(pos);
+          m_grid.each_neighbour(pos, [&](tile_pos next, double dist) {
+            if (next.col >= origin.col && next.row >= origin.row &&
+                next.col < endCol && next.row < endRow) {
+              relax(local_index(index, next),
+                    dist * (reverse ? cost : m_grid.cost(next)));
+            }
+          });
+        });
+  }
+
+  void build_entrances(int index)
+  {
+    struct transition final {
+      std::size_t neighbour;
+      tile_pos from;
+      tile_pos to;
+      double cost;
+    };
+
+    const auto self = static_cast<std::size_t>(index);
+    const auto origin = cluster_origin(self);
+    const auto endCol = std::min(origin.col + m_clusterSize, m_grid.width());
+    const auto endRow = std::min(origin.row + m_clusterSize, m_grid.height());
+
+    std::vector<transition> transitions;
+    for (auto row = origin.row; row < endRow; ++row) {
+      for (auto col = origin.col; col < endCol; ++col) {
+        const tile_pos pos{col, row};
+        if (!m_grid.is_walkable(pos)) {
+          continue;
+        }
+
+        m_grid.each_neighbour(pos, [&](tile_pos next, double dist) {
+          const auto neighbour = cluster_of(next);
+          if (neighbour != self) {
+            transitions.push_back(
+                {neighbour, pos, next, dist * m_grid.cost(next)});
+          }
+        });
+      }
+    }
+
+    // Order the transitions along the borders, so that each opening is a
+    // consecutive run of transitions
+    const auto clusterRow = origin.row / m_clusterSize;
+    std::sort(transitions.begin(),
+              transitions.end(),
+              [&](const transition& lhs, const transition& rhs) {
+                if (lhs.neighbour != rhs.neighbour) {
+                  return lhs.neighbour < rhs.neighbour;
+                }
+
+                const auto sameRow =
+                    cluster_origin(lhs.neighbour).row / m_clusterSize ==
+                    clusterRow;
+                const auto key = [sameRow](const transition& t) {
+                  return sameRow ? std::array<int, 4>{t.from.row,
+                                                      t.from.col,
+                                                      t.to.row,
+                                                      t.to.col}
+                                 : std::array<int, 4>{t.from.col,
+                                                      t.from.row,
+                                                      t.to.col,
+                                                      t.to.row};
+                };
+                return key(lhs) < key(rhs);
+              });
+
+    auto& entrances = m_clusters[self].entrances;
+    entrances.clear();
+
+    // Tiles on both sides of a run are connected within their clusters, so a
+    // single transition represents the whole run
+    std::size_t first = 0;
+    for (std::size_t i = 1; i <= transitions.size(); ++i) {
+      const auto split =
+          i == transitions.size() ||
+          transitions[i].neighbour != transitions[i - 1].neighbour ||
+          !is_step(transitions[i - 1].from, transitions[i].from) ||
+          !is_step(transitions[i - 1].to, transitions[i].to);
+      if (split) {
+        const auto& middle = transitions[first + (i - first) / 2];
+        entrances.push_back(
+            {to_cell(middle.from), to_cell(middle.to), middle.cost});
+        first = i;
+      }
+    }
+  }
+
+  void build_nodes(int index)
+  {
+    const auto self = static_cast<std::size_t>(index);
+    auto& cluster = m_clusters[self];
+
+    for (const auto node : cluster.nodes) {
+      m_slots[static_cast<std::size_t>(node)] = -1;
+    }
+
+    cluster.nodes.clear();
+    for (const auto& entrance : cluster.entrances) {
+      cluster.nodes.push_back(entrance.from);
+    }
+
+    const auto clusterCol = index % m_clusterCols;
+    const auto clusterRow = index / m_clusterCols;
+    for (auto r = clusterRow - 1; r <= clusterRow + 1; ++r) {
+      for (auto c = clusterCol - 1; c <= clusterCol + 1; ++c) {
+        if (c < 0 || r < 0 || c >= m_clusterCols || r >= m_clusterRows ||
+            (c == clusterCol && r == clusterRow)) {
+          continue;
+        }
+
+        const auto& neighbour = m_clusters[cluster_index(c, r)];
+        for (const auto& entrance : neighbour.entrances) {
+          if (cluster_of(to_pos(entrance.to)) == self) {
+            cluster.nodes.push_back(entrance.to);
+          }
+        }
+      }
+    }
+
+    auto& nodes = cluster.nodes;
+    std::sort(nodes.begin(), nodes.end());
+    nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+
+    const auto count = nodes.size();
+    for (std::size_t i = 0; i < count; ++i) {
+      m_slots[static_cast<std::size_t>(nodes[i])] = static_cast<int>(i);
+    }
+
+    cluster.costs.assign(count * count, unreachable);
+    for (std::size_t i = 0; i < count; ++i) {
+      search_cluster(m_localState, self, to_pos(nodes[i]), -1, false);
+      for (std::size_t j = 0; j < count; ++j) {
+        const auto local = local_index(self, to_pos(nodes[j]));
+        if (m_localState.reached(local)) {
+          cluster.costs[i * count + j] = m_localState.cost(local);
+        }
+      }
+    }
+  }
+
+  [[nodiscard]] auto refine(const std::vector<int>& abstractPath)
+      -> std::vector<tile_pos>
+  {
+    std::vector<tile_pos> path;
+    path.push_back(to_pos(abstractPath.front()));
+
+    for (std::size_t i = 1; i < abstractPath.size(); ++i) {
+      const auto from = to_pos(abstractPath[i - 1]);
+      const auto to = to_pos(abstractPath[i]);
+      const auto index = cluster_of(from);
+
+      if (index != cluster_of(to)) {
+        path.push_back(to);
+        continue;
+      }
+
+      const auto target = local_index(index, to);
+      search_cluster(m_localState, index, from, target, false);
+
+      const auto origin = cluster_origin(index);
+      const auto segment = m_localState.path_to(target);
+      for (std::size_t j = 1; j < segment.size(); ++j) {
+        path.push_back({origin.col + segment[j] % m_clusterSize,
+                        origin.row + segment[j] / m_clusterSize});
+      }
+    }
+
+    return path;
+  }
+};
+
+}  // namespace step
+
+#endif  // STEP_PATHFINDING_HEADER
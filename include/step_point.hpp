@@ -55,6 +55,17 @@ class point final {
  public:
   point() noexcept = default;
 
+  /**
+   * @brief Creates a point from a pair of coordinates.
+   *
+   * @param x the x-coordinate of the point.
+   * @param y the y-coordinate of the point.
+   *
+   * @since 0.3.0
+   */
+  constexpr point(double x, double y) noexcept : m_x{x}, m_y{y}
+  {}
+
   /**
    * @brief Parses a point from a JSON object.
    *
@@ -0,0 +1,687 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_polygon_decomposition.hpp
+ *
+ * @brief Provides triangulations and convex decompositions of polygon
+ * objects, along with a cache for them.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_POLYGON_DECOMPOSITION_HEADER
+#define STEP_POLYGON_DECOMPOSITION_HEADER
+
+#include <algorithm>      // find, reverse, rotate
+#include <cstddef>        // size_t, ptrdiff_t
+#include <cstdint>        // uint32_t, uint64_t
+#include <cstring>        // memcpy
+#include <map>            // map
+#include <optional>       // optional
+#include <unordered_map>  // unordered_map
+#include <utility>        // move
+#include <vector>         // vector
+
+#include "step_api.hpp"
+#include "step_exception.hpp"
+#include "step_geometry.hpp"
+#include "step_layer.hpp"
+#include "step_map.hpp"
+#include "step_object.hpp"
+#include "step_point.hpp"
+#include "step_types.hpp"
+#include "step_utils.hpp"
+
+namespace step {
+
+namespace detail {
+
+/**
+ * @brief Returns a hash of the coordinates of some points.
+ *
+ * @details The hash is used to detect cached data that is out-of-date.
+ *
+ * @param points the points that will be hashed.
+ *
+ * @return the FNV-1a hash of the coordinates.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] inline auto hash_points(const std::vector<point>& points) noexcept
+    -> std::uint64_t
+{
+  std::uint64_t hash = 14695981039346656037ull;
+  const auto mix = [&hash](double value) noexcept {
+    std::uint64_t bits{};
+    std::memcpy(&bits, &value, sizeof bits);
+    for (auto i = 0; i < 8; ++i) {
+      hash ^= (bits >> (i * 8)) & 0xFFu;
+      hash *= 1099511628211ull;
+    }
+  };
+
+  for (const auto& p : points) {
+    mix(p.x());
+    mix(p.y());
+  }
+  return hash;
+}
+
+}  // namespace detail
+
+/**
+ * @class polygon_decomposition
+ *
+ * @brief The triangulation and convex decomposition of a polygon.
+ *
+ * @details The polygon is first cleaned, i.e. repeated and collinear points
+ * are removed and the points are ordered so that the polygon has a positive
+ * signed area. The cleaned polygon is triangulated by ear clipping, and the
+ * triangles are then merged into convex pieces with the Hertel-Mehlhorn
+ * algorithm, which removes diagonals of the triangulation as long as the
+ * pieces on both sides stay convex. The result has at most four times as many
+ * pieces as the optimal decomposition.
+ *
+ * The triangles and pieces are stored as indices of the cleaned points, so
+ * the triangle indices can be used as an index buffer directly. The
+ * coordinates are the same as the coordinates of the input, e.g. relative to
+ * the position of a polygon object, so the decomposition doesn't depend on
+ * where the object is.
+ *
+ * Decompositions can be converted to and from JSON, e.g. to store them in a
+ * cache of compiled maps.
+ *
+ * @note The polygon must be simple. Self-intersecting polygons still produce
+ * triangles, but they may overlap.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_polygon_decomposition.hpp
+ */
+class polygon_decomposition final {
+ public:
+  using index_type = std::uint32_t;
+
+  polygon_decomposition() = default;
+
+  /**
+   * @brief Decomposes a polygon.
+   *
+   * @param points the points of the polygon, in any winding order.
+   *
+   * @since 0.3.0
+   */
+  explicit polygon_decomposition(const std::vector<point>& points)
+      : m_hash{detail::hash_points(points)}
+  {
+    clean(points);
+    triangulate();
+    decompose();
+  }
+
+  /**
+   * @brief Parses a decomposition from a JSON object.
+   *
+   * @param json the JSON object, as created by `to_json()`.
+   *
+   * @since 0.3.0
+   */
+  explicit polygon_decomposition(const json& json)
+      : m_hash{json.at("hash").get<std::uint64_t>()},
+        m_triangles{json.at("triangles").get<std::vector<index_type>>()}
+  {
+    const auto& coordinates = json.at("points");
+    for (std::size_t i = 0; i + 1 < coordinates.size(); i += 2) {
+      m_points.emplace_back(coordinates.at(i).get<double>(),
+                            coordinates.at(i + 1).get<double>());
+    }
+
+    m_offsets.push_back(0);
+    for (const auto& piece : json.at("pieces")) {
+      for (const auto& index : piece) {
+        m_indices.push_back(index.get<index_type>());
+      }
+      m_offsets.push_back(static_cast<index_type>(m_indices.size()));
+    }
+  }
+
+  /**
+   * @brief Returns the cleaned points of the polygon.
+   *
+   * @return the points that the indices refer to.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto points() const noexcept -> const std::vector<point>&
+  {
+    return m_points;
+  }
+
+  /**
+   * @brief Returns the triangles of the polygon.
+   *
+   * @return the indices of the points of the triangles, three per triangle.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto triangles() const noexcept
+      -> const std::vector<index_type>&
+  {
+    return m_triangles;
+  }
+
+  /**
+   * @brief Returns the amount of triangles.
+   *
+   * @return the amount of triangles.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto triangle_count() const noexcept -> std::size_t
+  {
+    return m_triangles.size() / 3;
+  }
+
+  /**
+   * @brief Returns the amount of convex pieces.
+   *
+   * @return the amount of convex pieces.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto piece_count() const noexcept -> std::size_t
+  {
+    return m_offsets.empty() ? 0 : m_offsets.size() - 1;
+  }
+
+  /**
+   * @brief Returns the indices of the points of a convex piece.
+   *
+   * @param index the index of the piece.
+   *
+   * @return the indices of the points of the piece, in the same winding
+   * order as the cleaned polygon.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto piece(std::size_t index) const -> std::vector<index_type>
+  {
+    return {m_indices.begin() + m_offsets.at(index),
+            m_indices.begin() + m_offsets.at(index + 1)};
+  }
+
+  /**
+   * @brief Returns the points of a convex piece.
+   *
+   * @param index the index of the piece.
+   *
+   * @return the points of the piece.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto piece_points(std::size_t index) const
+      -> std::vector<point>
+  {
+    std::vector<point> result;
+    for (const auto i : piece(index)) {
+      result.push_back(m_points.at(i));
+    }
+    return result;
+  }
+
+  /**
+   * @brief Returns the hash of the points that were decomposed.
+   *
+   * @return a hash of the input points, used to detect outdated caches.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto source_hash() const noexcept -> std::uint64_t
+  {
+    return m_hash;
+  }
+
+  friend void to_json(json& json, const polygon_decomposition& decomposition)
+  {
+    auto coordinates = json::array();
+    for (const auto& p : decomposition.m_points) {
+      coordinates.push_back(p.x());
+      coordinates.push_back(p.y());
+    }
+
+    auto pieces = json::array();
+    for (std::size_t i = 0; i < decomposition.piece_count(); ++i) {
+      pieces.push_back(decomposition.piece(i));
+    }
+
+    json = json::object();
+    json["hash"] = decomposition.m_hash;
+    json["points"] = std::move(coordinates);
+    json["triangles"] = decomposition.m_triangles;
+    json["pieces"] = std::move(pieces);
+  }
+
+ private:
+  std::uint64_t m_hash{};
+  std::vector<point> m_points;
+  std::vector<index_type> m_triangles;
+  std::vector<index_type> m_indices;  ///< The points of all pieces.
+  std::vector<index_type> m_offsets;  ///< The first index of each piece.
+
+  [[nodiscard]] auto turn(index_type a, index_type b, index_type c) const
+      noexcept -> double
+  {
+    return detail::cross(m_points[a], m_points[b], m_points[c]);
+  }
+
+  void clean(const std::vector<point>& points)
+  {
+    const auto same = [](const point& a, const point& b) noexcept {
+      return a.x() == b.x() && a.y() == b.y();
+    };
+
+    for (const auto& p : points) {
+      if (m_points.empty() || !same(m_points.back(), p)) {
+        m_points.push_back(p);
+      }
+    }
+    while (m_points.size() > 1 && same(m_points.front(), m_points.back())) {
+      m_points.pop_back();
+    }
+
+    // Remove collinear points until every corner turns
+    auto removed = true;
+    while (removed && m_points.size() >= 3) {
+      removed = false;
+      for (std::size_t i = 0; i < m_points.size() && m_points.size() >= 3;) {
+        const auto size = m_points.size();
+        const auto& prev = m_points[(i + size - 1) % size];
+        const auto& next = m_points[(i + 1) % size];
+        if (detail::cross(prev, m_points[i], next) == 0) {
+          m_points.erase(m_points.begin() + static_cast<std::ptrdiff_t>(i));
+          removed = true;
+        } else {
+          ++i;
+        }
+      }
+    }
+
+    if (m_points.size() < 3) {
+      m_points.clear();
+      return;
+    }
+
+    double area = 0;
+    for (std::size_t i = 0, j = m_points.size() - 1; i < m_points.size();
+         j = i++) {
+      area += m_points[j].x() * m_points[i].y() -
+              m_points[i].x() * m_points[j].y();
+    }
+    if (area < 0) {
+      std::reverse(m_points.begin(), m_points.end());
+    }
+  }
+
+  [[nodiscard]] auto is_ear(const std::vector<index_type>& next,
+                            index_type prev,
+                            index_type current,
+                            index_type following) const noexcept -> bool
+  {
+    if (turn(prev, current, following) <= 0) {
+      return false;
+    }
+
+    const auto& a = m_points[prev];
+    const auto& b = m_points[current];
+    const auto& c = m_points[following];
+    for (auto v = next[following]; v != prev; v = next[v]) {
+      const auto& p = m_points[v];
+      if ((p.x() == a.x() && p.y() == a.y()) ||
+          (p.x() == b.x() && p.y() == b.y()) ||
+          (p.x() == c.x() && p.y() == c.y())) {
+        continue;
+      }
+
+      if (detail::cross(a, b, p) >= 0 && detail::cross(b, c, p) >= 0 &&
+          detail::cross(c, a, p) >= 0) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  void triangulate()
+  {
+    const auto count = static_cast<index_type>(m_points.size());
+    if (count < 3) {
+      return;
+    }
+
+    std::vector<index_type> prev(count);
+    std::vector<index_type> next(count);
+    for (index_type i = 0; i < count; ++i) {
+      prev[i] = (i + count - 1) % count;
+      next[i] = (i + 1) % count;
+    }
+
+    m_triangles.reserve((count - 2) * 3);
+
+    const auto clip = [&](index_type v) {
+      m_triangles.push_back(prev[v]);
+      m_triangles.push_back(v);
+      m_triangles.push_back(next[v]);
+      next[prev[v]] = next[v];
+      prev[next[v]] = prev[v];
+    };
+
+    auto remaining = count;
+    auto current = index_type{0};
+    index_type misses = 0;
+    while (remaining > 3) {
+      if (is_ear(next, prev[current], current, next[current])) {
+        const auto following = next[current];
+        clip(current);
+        current = following;
+        --remaining;
+        misses = 0;
+      } else if (++misses >= remaining) {
+        // No ear, the polygon isn't simple, so clip a vertex anyway
+        const auto following = next[current];
+        clip(current);
+        current = following;
+        --remaining;
+        misses = 0;
+      } else {
+        current = next[current];
+      }
+    }
+
+    clip(current);
+  }
+
+  void decompose()
+  {
+    std::vector<std::vector<index_type>> pieces;
+    pieces.reserve(m_triangles.size() / 3);
+    for (std::size_t i = 0; i < m_triangles.size(); i += 3) {
+      pieces.push_back(
+          {m_triangles[i], m_triangles[i + 1], m_triangles[i + 2]});
+    }
+
+    // The piece on the left side of each directed edge
+    std::unordered_map<std::uint64_t, std::size_t> owners;
+    const auto key = [](index_type from, index_type to) noexcept {
+      return (static_cast<std::uint64_t>(from) << 32u) | to;
+    };
+    const auto claim = [&](std::size_t piece) {
+      const auto& points = pieces[piece];
+      for (std::size_t i = 0; i < points.size(); ++i) {
+        owners[key(points[i], points[(i + 1) % points.size()])] = piece;
+      }
+    };
+
+    for (std::size_t i = 0; i < pieces.size(); ++i) {
+      claim(i);
+    }
+
+    std::vector<bool> alive(pieces.size(), true);
+    for (std::size_t i = 0; i < m_triangles.size(); i += 3) {
+      for (std::size_t k = 0; k < 3; ++k) {
+        const auto u = m_triangles[i + k];
+        const auto v = m_triangles[i + (k + 1) % 3];
+        if (u > v) {
+          continue;  // Each diagonal is visited from one side
+        }
+
+        const auto forward = owners.find(key(u, v));
+        const auto backward = owners.find(key(v, u));
+        if (forward == owners.end() || backward == owners.end()) {
+          continue;  // Not a diagonal
+        }
+
+        const auto a = forward->second;
+        const auto b = backward->second;
+        if (a == b || !alive[a] || !alive[b]) {
+          continue;
+        }
+
+        if (auto merged = merge(pieces[a], pieces[b], u, v)) {
+          alive[a] = false;
+          alive[b] = false;
+          owners.erase(forward);
+          owners.erase(key(v, u));
+
+          pieces.push_back(std::move(*merged));
+          alive.push_back(true);
+          claim(pieces.size() - 1);
+        }
+      }
+    }
+
+    m_offsets.push_back(0);
+    for (std::size_t i = 0; i < pieces.size(); ++i) {
+      if (alive[i]) {
+        m_indices.insert(m_indices.end(), pieces[i].begin(), pieces[i].end());
+        m_offsets.push_back(static_cast<index_type>(m_indices.size()));
+      }
+    }
+  }
+
+  /// Merges two pieces that share the edge (u, v) if the result is convex.
+  [[nodiscard]] auto merge(std::vector<index_type> a,
+                           std::vector<index_type> b,
+                           index_type u,
+                           index_type v) const
+      -> std::optional<std::vector<index_type>>
+  {
+    // Rotate a into [v, ..., u] and b into [u, ..., v]
+    std::rotate(a.begin(), std::find(a.begin(), a.end(), v), a.end());
+    std::rotate(b.begin(), std::find(b.begin(), b.end(), u), b.end());
+    if (a.back() != u || b.back() != v) {
+      return std::nullopt;
+    }
+
+    if (turn(a[a.size() - 2], u, b[1]) < 0 ||
+        turn(b[b.size() - 2], v, a[1]) < 0) {
+      return std::nullopt;
+    }
+
+    a.insert(a.end(), b.begin() + 1, b.end() - 1);
+    return a;
+  }
+};
+
+/**
+ * @class polygon_cache
+ *
+ * @brief Caches the decompositions of the polygon objects of maps.
+ *
+ * @details Decompositions are computed the first time that they are
+ * requested, and are identified by the IDs of the objects. A hash of the
+ * points of each object is stored along with the decomposition, so outdated
+ * entries, e.g. from a cache that was stored before the map was edited, are
+ * computed again. Use `build()` to compute the decompositions of all polygon
+ * objects of a map up front, in parallel.
+ *
+ * Caches can be converted to and from JSON, so that decompositions can be
+ * stored along with compiled maps instead of being computed on every load.
+ *
+ * @note Caches aren't safe to use from several threads at once.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_polygon_decomposition.hpp
+ */
+class polygon_cache final {
+ public:
+  polygon_cache() = default;
+
+  /**
+   * @brief Parses a cache from a JSON object.
+   *
+   * @param json the JSON object, as created by `to_json()`.
+   *
+   * @since 0.3.0
+   */
+  explicit polygon_cache(const json& json)
+  {
+    for (const auto& entry : json.at("polygons")) {
+      m_entries.emplace(entry.at("id").get<int>(),
+                        polygon_decomposition{entry.at("decomposition")});
+    }
+  }
+
+  /**
+   * @brief Returns the decomposition of a polygon object.
+   *
+   * @details The decomposition is computed if it isn't cached, or if the
+   * cached decomposition was created from other points.
+   *
+   * @param object the polygon object.
+   *
+   * @return the decomposition of the object, which stays valid until the
+   * cache is cleared or destroyed.
+   *
+   * @throws step_exception if the object isn't a polygon.
+   *
+   * @since 0.3.0
+   */
+  auto get(const object& object) -> const polygon_decomposition&
+  {
+    const auto* poly = object.try_as<polygon>();
+    if (!poly) {
+      throw step_exception{"polygon_cache > Object isn't a polygon!"};
+    }
+
+    const auto hash = detail::hash_points(poly->points);
+    auto& entry = m_entries[object.id()];
+    if (entry.source_hash() != hash || entry.points().empty()) {
+      entry = polygon_decomposition{poly->points};
+    }
+    return entry;
+  }
+
+  /**
+   * @brief Computes the decompositions of all polygon objects of a map.
+   *
+   * @details Objects with up-to-date decompositions are skipped.
+   *
+   * @param map the map that provides the object groups.
+   * @param threads the maximum amount of threads, zero means the amount of
+   * hardware threads.
+   *
+   * @since 0.3.0
+   */
+  void build(const map& map, int threads = 0)
+  {
+    std::vector<const object*> pending;
+    for (const auto& layer : map.layers()) {
+      detail::each_object_group(
+          layer, [&](const step::layer&, const object_group& group) {
+            for (const auto& object : group.objects()) {
+              if (const auto* poly = object.try_as<polygon>()) {
+                const auto* cached = find(object.id());
+                if (!cached || cached->points().empty() ||
+                    cached->source_hash() !=
+                        detail::hash_points(poly->points)) {
+                  pending.push_back(&object);
+                }
+              }
+            }
+          });
+    }
+
+    std::vector<polygon_decomposition> results(pending.size());
+    detail::parallel_for(
+        0, static_cast<int>(pending.size()), threads, [&](int i) {
+          const auto index = static_cast<std::size_t>(i);
+          results[index] = polygon_decomposition{
+              pending[index]->as<polygon>().points};
+        });
+
+    for (std::size_t i = 0; i < pending.size(); ++i) {
+      m_entries[pending[i]->id()] = std::move(results[i]);
+    }
+  }
+
+  /**
+   * @brief Returns the cached decomposition of an object, if there is one.
+   *
+   * @param id the ID of the object.
+   *
+   * @return the cached decomposition; a null pointer if there is none.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto find(int id) const -> const polygon_decomposition*
+  {
+    const auto it = m_entries.find(id);
+    return it != m_entries.end() ? &it->second : nullptr;
+  }
+
+  /**
+   * @brief Removes all cached decompositions.
+   *
+   * @since 0.3.0
+   */
+  void clear() noexcept
+  {
+    m_entries.clear();
+  }
+
+  /**
+   * @brief Returns the amount of cached decompositions.
+   *
+   * @return the amount of cached decompositions.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto size() const noexcept -> std::size_t
+  {
+    return m_entries.size();
+  }
+
+  friend void to_json(json& json, const polygon_cache& cache)
+  {
+    auto polygons = json::array();
+    for (const auto& [id, decomposition] : cache.m_entries) {
+      polygons.push_back({{"id", id}, {"decomposition", decomposition}});
+    }
+    json = json::object();
+    json["polygons"] = std::move(polygons);
+  }
+
+ private:
+  std::map<int, polygon_decomposition> m_entries;
+};
+
+}  // namespace step
+
+#endif  // STEP_POLYGON_DECOMPOSITION_HEADER
@@ -0,0 +1,514 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_polygon_shape.hpp
+ *
+ * @brief Provides the `polygon_shape` class.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_POLYGON_SHAPE_HEADER
+#define STEP_POLYGON_SHAPE_HEADER
+
+#include <algorithm>  // min, max
+#include <cmath>      // cos, sin, sqrt
+#include <cstddef>    // size_t
+#include <limits>     // numeric_limits
+#include <utility>    // move
+#include <vector>     // vector
+
+#include "step_api.hpp"
+#include "step_exception.hpp"
+#include "step_geometry.hpp"
+#include "step_object.hpp"
+#include "step_point.hpp"
+#include "step_rect.hpp"
+#include "step_utils.hpp"
+
+namespace step {
+
+/**
+ * @struct nearest_point
+ *
+ * @brief A simple data container for the point on the outline of a shape that
+ * is closest to another point.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_polygon_shape.hpp
+ */
+struct nearest_point final {
+  point position;      ///< The closest point on the outline.
+  double distance{};   ///< The distance to the closest point.
+  std::size_t edge{};  ///< The index of the edge that the point is on.
+};
+
+/**
+ * @class polygon_shape
+ *
+ * @brief The cached world-space geometry of a polygon or polyline, for
+ * point and segment queries.
+ *
+ * @details The points are placed in world space once, using the position and
+ * rotation of the object, along with the bounding box of the shape. The edges
+ * are stored as separate arrays of start points, directions and derived
+ * values, so that the queries are simple loops over contiguous arrays without
+ * branches, which compilers vectorize. Queries outside of the bounding box
+ * return early.
+ *
+ * Polygons are closed, i.e. there is an edge from the last point to the
+ * first, and have an inside, which is determined with the even-odd rule so
+ * that concave polygons are supported. Polylines are open and have no inside.
+ *
+ * The batch queries test many points against the same shape, divided into
+ * blocks that may be processed in parallel.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_polygon_shape.hpp
+ */
+class polygon_shape final {
+ public:
+  /**
+   * @brief Creates a shape from a polygon or polyline object.
+   *
+   * @param object the object that provides the points, position and rotation.
+   *
+   * @throws step_exception if the object isn't a polygon or polyline.
+   *
+   * @since 0.3.0
+   */
+  explicit polygon_shape(const object& object)
+  {
+    const std::vector<point>* points = nullptr;
+    if (const auto* poly = object.try_as<polygon>()) {
+      points = &poly->points;
+      m_closed = true;
+    } else if (const auto* line = object.try_as<polyline>()) {
+      points = &line->points;
+    } else {
+      throw step_exception{"polygon_shape > Object isn't a polygon/polyline!"};
+    }
+
+    // Objects are rotated clockwise around their position
+    const point origin{object.x(), object.y()};
+    const auto radians = object.rotation() * detail::pi / 180.0;
+    const auto cos = std::cos(radians);
+    const auto sin = std::sin(radians);
+
+    m_points.reserve(points->size());
+    for (const auto& p : *points) {
+      m_points.push_back(detail::rotate(origin, p, cos, sin));
+    }
+
+    prepare();
+  }
+
+  /**
+   * @brief Creates a shape from world-space points.
+   *
+   * @param points the points of the shape.
+   * @param closed `true` if the shape is a polygon; `false` if it's a
+   * polyline.
+   *
+   * @since 0.3.0
+   */
+  polygon_shape(std::vector<point> points, bool closed)
+      : m_points{std::move(points)},
+        m_closed{closed}
+  {
+    prepare();
+  }
+
+  /**
+   * @brief Indicates whether or not a point is inside of the shape.
+   *
+   * @param p the point that will be tested.
+   *
+   * @return `true` if the point is inside of the polygon; `false` if it isn't
+   * or if the shape is a polyline.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto contains(const point& p) const noexcept -> bool
+  {
+    if (!m_closed || !in_bounds(p)) {
+      return false;
+    }
+
+    const auto px = p.x();
+    const auto py = p.y();
+    const auto count = m_x.size();
+    const auto* x0 = m_x.data();
+    const auto* y0 = m_y.data();
+    const auto* y1 = m_endY.data();
+    const auto* slope = m_slope.data();
+
+    // Count the edges that a horizontal ray towards +x crosses
+    unsigned crossings = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+      const auto spans = (y0[i] > py) != (y1[i] > py);
+      const auto x = x0[i] + (py - y0[i]) * slope[i];
+      crossings += static_cast<unsigned>(spans & (px < x));
+    }
+
+    return (crossings & 1u) != 0;
+  }
+
+  /**
+   * @brief Indicates whether or not a line segment crosses the outline of the
+   * shape.
+   *
+   * @details Segments that only touch the outline intersect it. Note that
+   * segments that are completely inside of a polygon don't intersect its
+   * outline, use `contains()` to detect them.
+   *
+   * @param a the first point of the segment.
+   * @param b the second point of the segment.
+   *
+   * @return `true` if the segment intersects any edge; `false` otherwise.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto intersects(const point& a, const point& b) const noexcept
+      -> bool
+  {
+    if (std::max(a.x(), b.x()) < m_bounds.x ||
+        std::min(a.x(), b.x()) > m_bounds.x + m_bounds.width ||
+        std::max(a.y(), b.y()) < m_bounds.y ||
+        std::min(a.y(), b.y()) > m_bounds.y + m_bounds.height) {
+      return false;
+    }
+
+    const auto ex = b.x() - a.x();
+    const auto ey = b.y() - a.y();
+    const auto count = m_x.size();
+    for (std::size_t i = 0; i < count; ++i) {
+      // Solve a + s * e = p + t * d for the parameters of both segments
+      const auto denominator = ex * m_dy[i] - ey * m_dx[i];
+      const auto wx = m_x[i] - a.x();
+      const auto wy = m_y[i] - a.y();
+      if (denominator != 0) {
+        const auto s = (wx * m_dy[i] - wy * m_dx[i]) / denominator;
+        const auto t = (wx * ey - wy * ex) / denominator;
+        if (s >= 0 && s <= 1 && t >= 0 && t <= 1) {
+          return true;
+        }
+      } else if (detail::segments_intersect(a, b, edge_start(i), edge_end(i))) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /**
+   * @brief Returns the point on the outline of the shape that is closest to a
+   * point.
+   *
+   * @details The outline of a polygon includes the closing edge. For points
+   * inside of a polygon, this is the closest point on its boundary.
+   *
+   * @param p the point that the closest point is found for.
+   *
+   * @return the closest point; a distance of infinity if the shape has no
+   * points.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto nearest(const point& p) const noexcept -> nearest_point
+  {
+    nearest_point result;
+    result.distance = std::numeric_limits<double>::infinity();
+    if (m_points.size() == 1) {
+      result.position = m_points.front();
+      result.distance = std::sqrt(detail::distance_squared(p, result.position));
+      return result;
+    }
+
+    const auto px = p.x();
+    const auto py = p.y();
+    const auto count = m_x.size();
+    const auto* x0 = m_x.data();
+    const auto* y0 = m_y.data();
+    const auto* dx = m_dx.data();
+    const auto* dy = m_dy.data();
+    const auto* inverse = m_inverseLengthSq.data();
+
+    auto best = std::numeric_limits<double>::infinity();
+    auto bestEdge = count;
+    auto bestT = 0.0;
+    for (std::size_t i = 0; i < count; ++i) {
+      auto t = ((px - x0[i]) * dx[i] + (py - y0[i]) * dy[i]) * inverse[i];
+      t = std::min(std::max(t, 0.0), 1.0);
+
+      const auto cx = x0[i] + t * dx[i] - px;
+      const auto cy = y0[i] + t * dy[i] - py;
+      const auto distance = cx * cx + cy * cy;
+      if (distance < best) {
+        best = distance;
+        bestEdge = i;
+        bestT = t;
+      }
+    }
+
+    if (bestEdge != count) {
+      result.position = point{x0[bestEdge] + bestT * dx[bestEdge],
+                              y0[bestEdge] + bestT * dy[bestEdge]};
+      result.distance = std::sqrt(best);
+      result.edge = bestEdge;
+    }
+
+    return result;
+  }
+
+  /**
+   * @brief Returns the distance from a point to the shape.
+   *
+   * @param p the point.
+   *
+   * @return zero if the point is inside of a polygon; the distance to the
+   * outline otherwise.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto distance(const point& p) const noexcept -> double
+  {
+    return contains(p) ? 0.0 : nearest(p).distance;
+  }
+
+  /**
+   * @brief Tests several points against the shape.
+   *
+   * @details The result vector is resized to the amount of points, reuse it
+   * between calls to avoid allocations.
+   *
+   * @param points the points that will be tested.
+   * @param inside the vector that the results are written to, as 1 if the
+   * point is inside of the shape and 0 otherwise.
+   * @param threads the maximum amount of threads, zero means the amount of
+   * hardware threads.
+   *
+   * @since 0.3.0
+   */
+  void contains(const std::vector<point>& points,
+                std::vector<unsigned char>& inside,
+                int threads = 1) const
+  {
+    inside.resize(points.size());
+    for_each_block(points.size(), threads, [&](std::size_t i) {
+      inside[i] = contains(points[i]) ? 1 : 0;
+    });
+  }
+
+  /**
+   * @brief Finds the closest points on the outline for several points.
+   *
+   * @details The result vector is resized to the amount of points, reuse it
+   * between calls to avoid allocations.
+   *
+   * @param points the points that the closest points are found for.
+   * @param result the vector that the results are written to, in the same
+   * order as the points.
+   * @param threads the maximum amount of threads, zero means the amount of
+   * hardware threads.
+   *
+   * @since 0.3.0
+   */
+  void nearest(const std::vector<point>& points,
+               std::vector<nearest_point>& result,
+               int threads = 1) const
+  {
+    result.resize(points.size());
+    for_each_block(points.size(), threads, [&](std::size_t i) {
+      result[i] = nearest(points[i]);
+    });
+  }
+
+  /**
+   * @brief Returns the start point of an edge.
+   *
+   * @param index the index of the edge.
+   *
+   * @return the start point of the edge.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto edge_start(std::size_t index) const -> point
+  {
+    return {m_x.at(index), m_y.at(index)};
+  }
+
+  /**
+   * @brief Returns the end point of an edge.
+   *
+   * @param index the index of the edge.
+   *
+   * @return the end point of the edge.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto edge_end(std::size_t index) const -> point
+  {
+    return m_points.at((index + 1) % m_points.size());
+  }
+
+  /**
+   * @brief Returns the amount of edges.
+   *
+   * @return the amount of edges, which is the amount of points for polygons
+   * and one less for polylines.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto edge_count() const noexcept -> std::size_t
+  {
+    return m_x.size();
+  }
+
+  /**
+   * @brief Returns the points of the shape.
+   *
+   * @return the world-space points.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto points() const noexcept -> const std::vector<point>&
+  {
+    return m_points;
+  }
+
+  /**
+   * @brief Returns the bounding box of the shape.
+   *
+   * @return the world-space bounding box.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto bounds() const noexcept -> const rect&
+  {
+    return m_bounds;
+  }
+
+  /**
+   * @brief Indicates whether or not the shape is a polygon.
+   *
+   * @return `true` if the shape is closed; `false` if it's a polyline.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto closed() const noexcept -> bool
+  {
+    return m_closed;
+  }
+
+ private:
+  static constexpr std::size_t block_size = 256;
+
+  std::vector<point> m_points;
+  rect m_bounds;
+  bool m_closed{};
+
+  // Edges, as separate arrays
+  std::vector<double> m_x;
+  std::vector<double> m_y;
+  std::vector<double> m_dx;
+  std::vector<double> m_dy;
+  std::vector<double> m_endY;
+  std::vector<double> m_slope;            ///< dx / dy, zero if horizontal.
+  std::vector<double> m_inverseLengthSq;  ///< Zero for degenerate edges.
+
+  void prepare()
+  {
+    if (m_points.empty()) {
+      return;
+    }
+
+    auto minX = m_points.front().x();
+    auto minY = m_points.front().y();
+    auto maxX = minX;
+    auto maxY = minY;
+    for (const auto& p : m_points) {
+      minX = std::min(minX, p.x());
+      minY = std::min(minY, p.y());
+      maxX = std::max(maxX, p.x());
+      maxY = std::max(maxY, p.y());
+    }
+    m_bounds = rect{minX, minY, maxX - minX, maxY - minY};
+
+    const auto count = m_closed ? m_points.size() : m_points.size() - 1;
+    m_x.reserve(count);
+    m_y.reserve(count);
+    m_dx.reserve(count);
+    m_dy.reserve(count);
+    m_endY.reserve(count);
+    m_slope.reserve(count);
+    m_inverseLengthSq.reserve(count);
+
+    for (std::size_t i = 0; i < count; ++i) {
+      const auto& a = m_points[i];
+      const auto& b = m_points[(i + 1) % m_points.size()];
+      const auto dx = b.x() - a.x();
+      const auto dy = b.y() - a.y();
+      const auto lengthSq = dx * dx + dy * dy;
+
+      m_x.push_back(a.x());
+      m_y.push_back(a.y());
+      m_dx.push_back(dx);
+      m_dy.push_back(dy);
+      m_endY.push_back(b.y());
+      m_slope.push_back(dy != 0 ? dx / dy : 0.0);
+      m_inverseLengthSq.push_back(lengthSq > 0 ? 1.0 / lengthSq : 0.0);
+    }
+  }
+
+  [[nodiscard]] auto in_bounds(const point& p) const noexcept -> bool
+  {
+    return p.x() >= m_bounds.x && p.x() <= m_bounds.x + m_bounds.width &&
+           p.y() >= m_bounds.y && p.y() <= m_bounds.y + m_bounds.height;
+  }
+
+  template <typename Lambda>
+  static void for_each_block(std::size_t count, int threads, Lambda&& lambda)
+  {
+    const auto blocks = static_cast<int>((count + block_size - 1) / block_size);
+    detail::parallel_for(0, blocks, threads, [&](int block) {
+      const auto first = static_cast<std::size_t>(block) * block_size;
+      const auto last = std::min(first + block_size, count);
+      for (auto i = first; i < last; ++i) {
+        lambda(i);
+      }
+    });
+  }
+};
+
+}  // namespace step
+
+#endif  // STEP_POLYGON_SHAPE_HEADER
@@ -0,0 +1,921 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_projection.hpp
+ *
+ * @brief Provides the `projection` class template, which converts between
+ * tile and pixel coordinates.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_PROJECTION_HEADER
+#define STEP_PROJECTION_HEADER
+
+#include <algorithm>  // min, max
+#include <array>      // array
+#include <cmath>      // floor, ceil
+#include <cstddef>    // size_t, ptrdiff_t
+#include <iterator>   // input_iterator_tag
+#include <limits>     // numeric_limits
+#include <utility>    // pair
+
+#include "step_api.hpp"
+#include "step_map.hpp"
+#include "step_point.hpp"
+#include "step_tile_pos.hpp"
+#include "step_utils.hpp"
+
+namespace step {
+namespace detail {
+
+/**
+ * @brief Returns the inclusive range of indices `k` for which the span
+ * `[k * step + offset, k * step + offset + size)` intersects `[lo, hi)`.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] inline auto index_span(double lo,
+                                     double hi,
+                                     double offset,
+                                     double step,
+                                     double size) noexcept
+    -> std::pair<int, int>
+{
+  const auto first =
+      static_cast<int>(std::floor((lo - offset - size) / step)) + 1;
+  const auto last = static_cast<int>(std::ceil((hi - offset) / step)) - 1;
+  return {first, last};
+}
+
+}  // namespace detail
+
+/**
+ * @class projection
+ *
+ * @brief Converts between tile coordinates and map pixel coordinates for a
+ * specific map orientation.
+ *
+ * @details The conversions mirror the renderers of the Tiled editor, so a
+ * tile is placed at the same pixel position as it is in the editor. All pixel
+ * coordinates refer to the bounding box of a tile, i.e. a rectangle of the
+ * size of the map tiles. The orientation is a template parameter, so the
+ * conversions are resolved at compile-time and the batched conversions are
+ * plain loops over arrays that compilers can vectorize. Use
+ * `visit_projection()` to obtain the projection that matches a map at runtime.
+ *
+ * @note Staggered and hexagonal maps use tile sizes rounded down to even
+ * values, just like the Tiled editor does.
+ *
+ * @tparam Orientation the orientation of the maps handled by the projection.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_projection.hpp
+ */
+template <map::orientation Orientation>
+class projection final {
+  static constexpr bool isStaggered =
+      Orientation == map::orientation::staggered ||
+      Orientation == map::orientation::hexagonal;
+
+ public:
+  /**
+   * @brief The amount of neighbours that each tile has.
+   *
+   * @details Hexagonal tiles have six neighbours, all other tiles have eight.
+   *
+   * @since 0.3.0
+   */
+  static constexpr std::size_t neighbour_count =
+      (Orientation == map::orientation::hexagonal) ? 6 : 8;
+
+  using neighbours = std::array<tile_pos, neighbour_count>;
+
+  class visible_range;
+
+  /**
+   * @brief Creates a projection for the specified map.
+   *
+   * @param map the map that the projection will be based on, the orientation
+   * of the map should match the `Orientation` template parameter.
+   *
+   * @since 0.3.0
+   */
+  explicit projection(const map& map) noexcept
+      : m_mapWidth{map.width()},
+        m_mapHeight{map.height()},
+        m_renderOrder{map.get_render_order()}
+  {
+    if constexpr (isStaggered) {
+      m_tileWidth = map.tile_width() & ~1;
+      m_tileHeight = map.tile_height() & ~1;
+      m_staggerX = map.get_stagger_axis() == map::stagger_axis::x;
+      m_staggerEven = map.get_stagger_index() == map::stagger_index::even;
+
+      if constexpr (Orientation == map::orientation::hexagonal) {
+        const auto sideLength = map.hex_side_length();
+        m_sideLengthX = m_staggerX ? sideLength : 0;
+        m_sideLengthY = m_staggerX ? 0 : sideLength;
+      }
+
+      m_sideOffsetX = (m_tileWidth - m_sideLengthX) / 2;
+      m_sideOffsetY = (m_tileHeight - m_sideLengthY) / 2;
+      m_columnWidth = m_sideOffsetX + m_sideLengthX;
+      m_rowHeight = m_sideOffsetY + m_sideLengthY;
+    } else {
+      m_tileWidth = map.tile_width();
+      m_tileHeight = map.tile_height();
+    }
+
+    init_neighbour_offsets();
+  }
+
+  /**
+   * @brief Returns the top-left corner of the bounding box of a tile.
+   *
+   * @param pos the position of the tile.
+   *
+   * @return the pixel position of the top-left corner of the tile.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto tile_to_pixel(tile_pos pos) const noexcept -> point
+  {
+    if constexpr (Orientation == map::orientation::orthogonal) {
+      return {static_cast<double>(pos.col) * m_tileWidth,
+              static_cast<double>(pos.row) * m_tileHeight};
+
+    } else if constexpr (Orientation == map::orientation::isometric) {
+      // The first column of the top row is centered at mapHeight * width / 2
+      const auto halfWidth = m_tileWidth / 2.0;
+      const auto halfHeight = m_tileHeight / 2.0;
+      return {(pos.col - pos.row + m_mapHeight - 1) * halfWidth,
+              (pos.col + pos.row) * halfHeight};
+
+    } else {
+      if (m_staggerX) {
+        const auto offset = is_shifted(pos) ? m_rowHeight : 0;
+        return {static_cast<double>(pos.col) * m_columnWidth,
+                static_cast<double>(pos.row) * (m_tileHeight + m_sideLengthY) +
+                    offset};
+      } else {
+        const auto offset = is_shifted(pos) ? m_columnWidth : 0;
+        return {static_cast<double>(pos.col) * (m_tileWidth + m_sideLengthX) +
+                    offset,
+                static_cast<double>(pos.row) * m_rowHeight};
+      }
+    }
+  }
+
+  /**
+   * @brief Returns the center point of a tile.
+   *
+   * @param pos the position of the tile.
+   *
+   * @return the pixel position of the center of the tile.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto tile_center(tile_pos pos) const noexcept -> point
+  {
+    const auto topLeft = tile_to_pixel(pos);
+    return {topLeft.x() + m_tileWidth / 2.0, topLeft.y() + m_tileHeight / 2.0};
+  }
+
+  /**
+   * @brief Returns the tile that contains the specified pixel.
+   *
+   * @details The returned position isn't clamped to the bounds of the map.
+   *
+   * @param x the x-coordinate of the pixel.
+   * @param y the y-coordinate of the pixel.
+   *
+   * @return the position of the tile that contains the pixel.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto pixel_to_tile(double x, double y) const noexcept
+      -> tile_pos
+  {
+    if constexpr (Orientation == map::orientation::orthogonal) {
+      return {detail::floor_to_int(x / m_tileWidth),
+              detail::floor_to_int(y / m_tileHeight)};
+
+    } else if constexpr (Orientation == map::orientation::isometric) {
+      const auto tx = (x - m_mapHeight * (m_tileWidth / 2.0)) / m_tileWidth;
+      const auto ty = y / m_tileHeight;
+      return {detail::floor_to_int(ty + tx), detail::floor_to_int(ty - tx)};
+
+    } else if constexpr (Orientation == map::orientation::staggered) {
+      return staggered_pixel_to_tile(x, y);
+
+    } else {
+      return hexagonal_pixel_to_tile(x, y);
+    }
+  }
+
+  /**
+   * @copydoc pixel_to_tile(double, double)
+   *
+   * @param pixel the pixel position.
+   */
+  [[nodiscard]] auto pixel_to_tile(const point& pixel) const noexcept
+      -> tile_pos
+  {
+    return pixel_to_tile(pixel.x(), pixel.y());
+  }
+
+  /**
+   * @brief Converts a batch of tile positions to pixel positions.
+   *
+   * @details The output is the top-left corner of the bounding box of each
+   * tile, see `tile_to_pixel()`. The input and output arrays must hold at least
+   * `count` elements.
+   *
+   * @param cols the columns of the tiles.
+   * @param rows the rows of the tiles.
+   * @param count the amount of tiles to convert.
+   * @param xs the array that the x-coordinates will be written to.
+   * @param ys the array that the y-coordinates will be written to.
+   *
+   * @since 0.3.0
+   */
+  void tile_to_pixel(const int* cols,
+                     const int* rows,
+                     std::size_t count,
+                     double* xs,
+                     double* ys) const noexcept
+  {
+    for (std::size_t i = 0; i < count; ++i) {
+      const auto pixel = tile_to_pixel(tile_pos{cols[i], rows[i]});
+      xs[i] = pixel.x();
+      ys[i] = pixel.y();
+    }
+  }
+
+  /**
+   * @brief Converts a batch of pixel positions to tile positions.
+   *
+   * @details The input and output arrays must hold at least `count` elements.
+   *
+   * @param xs the x-coordinates of the pixels.
+   * @param ys the y-coordinates of the pixels.
+   * @param count the amount of pixels to convert.
+   * @param cols the array that the tile columns will be written to.
+   * @param rows the array that the tile rows will be written to.
+   *
+   * @since 0.3.0
+   */
+  void pixel_to_tile(const double* xs,
+                     const double* ys,
+                     std::size_t count,
+                     int* cols,
+                     int* rows) const noexcept
+  {
+    for (std::size_t i = 0; i < count; ++i) {
+      const auto pos = pixel_to_tile(xs[i], ys[i]);
+      cols[i] = pos.col;
+      rows[i] = pos.row;
+    }
+  }
+
+  /**
+   * @brief Returns the offsets from a tile to its neighbours.
+   *
+   * @details The offsets are listed in clockwise order. For orthogonal and
+   * isometric maps, the first four offsets are the tiles that share an edge
+   * with the tile, followed by the diagonal tiles. For staggered maps, the
+   * first four offsets are the diamonds that share an edge with the tile,
+   * followed by the diamonds that only share a corner. Staggered and hexagonal
+   * maps use different tables for shifted and unshifted rows (or columns),
+   * which is why the position of the tile is required.
+   *
+   * @param pos the position of the tile.
+   *
+   * @return the neighbour offsets of the tile.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto neighbour_offsets(tile_pos pos) const noexcept
+      -> const neighbours&
+  {
+    if constexpr (isStaggered) {
+      return m_offsets[is_shifted(pos) ? 1 : 0];
+    } else {
+      return m_offsets[0];
+    }
+  }
+
+  /**
+   * @brief Returns the neighbours of a tile.
+   *
+   * @details The neighbours are in the same order as the offsets returned by
+   * `neighbour_offsets()`. The returned positions aren't clamped to the bounds
+   * of the map.
+   *
+   * @param pos the position of the tile.
+   *
+   * @return the positions of the neighbours of the tile.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto neighbours_of(tile_pos pos) const noexcept -> neighbours
+  {
+    const auto& offsets = neighbour_offsets(pos);
+
+    neighbours result;
+    for (std::size_t i = 0; i < neighbour_count; ++i) {
+      result[i] = {pos.col + offsets[i].col, pos.row + offsets[i].row};
+    }
+
+    return result;
+  }
+
+  /**
+   * @brief Returns the tiles that intersect a rectangle, in draw order.
+   *
+   * @details A tile intersects the rectangle if its bounding box does, so
+   * tiles with images that are larger than the map tiles require a margin
+   * around the rectangle. Only tiles within the bounds of the map are
+   * included and empty rectangles don't intersect any tiles. Orthogonal maps
+   * respect the render order of the map.
+   *
+   * @param x the x-coordinate of the rectangle.
+   * @param y the y-coordinate of the rectangle.
+   * @param width the width of the rectangle.
+   * @param height the height of the rectangle.
+   *
+   * @return a range of the tiles that intersect the rectangle.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto visible_tiles(double x,
+                                   double y,
+                                   double width,
+                                   double height) const noexcept
+      -> visible_range
+  {
+    return visible_range{*this, x, y, x + width, y + height};
+  }
+
+  /**
+   * @brief Returns the width of the tiles used by the projection.
+   *
+   * @return the width of the tiles used by the projection.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto tile_width() const noexcept -> int
+  {
+    return m_tileWidth;
+  }
+
+  /**
+   * @brief Returns the height of the tiles used by the projection.
+   *
+   * @return the height of the tiles used by the projection.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto tile_height() const noexcept -> int
+  {
+    return m_tileHeight;
+  }
+
+ private:
+  struct line final {
+    tile_pos start;
+    int count{};
+  };
+
+  int m_mapWidth{};
+  int m_mapHeight{};
+  int m_tileWidth{};
+  int m_tileHeight{};
+  int m_sideLengthX{};
+  int m_sideLengthY{};
+  int m_sideOffsetX{};
+  int m_sideOffsetY{};
+  int m_columnWidth{};
+  int m_rowHeight{};
+  map::render_order m_renderOrder{map::render_order::right_down};
+  bool m_staggerX{};
+  bool m_staggerEven{};
+  std::array<neighbours, 2> m_offsets{};
+
+  /**
+   * @brief Indicates whether or not the row (or column) of a tile is shifted
+   * by half a tile, in a staggered or hexagonal map.
+   */
+  [[nodiscard]] auto is_shifted(tile_pos pos) const noexcept -> bool
+  {
+    const auto index = m_staggerX ? pos.col : pos.row;
+    return ((index & 1) != 0) != m_staggerEven;
+  }
+
+  [[nodiscard]] auto top_left(tile_pos pos) const noexcept -> tile_pos
+  {
+    const auto shifted = is_shifted(pos);
+    if (m_staggerX) {
+      return {pos.col - 1, shifted ? pos.row : pos.row - 1};
+    } else {
+      return {shifted ? pos.col : pos.col - 1, pos.row - 1};
+    }
+  }
+
+  [[nodiscard]] auto top_right(tile_pos pos) const noexcept -> tile_pos
+  {
+    const auto shifted = is_shifted(pos);
+    if (m_staggerX) {
+      return {pos.col + 1, shifted ? pos.row : pos.row - 1};
+    } else {
+      return {shifted ? pos.col + 1 : pos.col, pos.row - 1};
+    }
+  }
+
+  [[nodiscard]] auto bottom_left(tile_pos pos) const noexcept -> tile_pos
+  {
+    const auto shifted = is_shifted(pos);
+    if (m_staggerX) {
+      return {pos.col - 1, shifted ? pos.row + 1 : pos.row};
+    } else {
+      return {shifted ? pos.col : pos.col - 1, pos.row + 1};
+    }
+  }
+
+  [[nodiscard]] auto bottom_right(tile_pos pos) const noexcept -> tile_pos
+  {
+    const auto shifted = is_shifted(pos);
+    if (m_staggerX) {
+      return {pos.col + 1, shifted ? pos.row + 1 : pos.row};
+    } else {
+      return {shifted ? pos.col + 1 : pos.col, pos.row + 1};
+    }
+  }
+
+  void init_neighbour_offsets() noexcept
+  {
+    if constexpr (isStaggered) {
+      // Shifted and unshifted reference tiles, the parity of the other axis
+      // doesn't matter
+      const auto unshifted = m_staggerEven ? tile_pos{1, 1} : tile_pos{0, 0};
+      const auto shifted = m_staggerEven ? tile_pos{0, 0} : tile_pos{1, 1};
+
+      const auto make = [this](tile_pos origin) {
+        const auto offset = [origin](tile_pos pos) {
+          return tile_pos{pos.col - origin.col, pos.row - origin.row};
+        };
+
+        neighbours result;
+        if constexpr (Orientation == map::orientation::hexagonal) {
+          if (m_staggerX) {
+            result = {tile_pos{0, -1},
+                      offset(top_right(origin)),
+                      offset(bottom_right(origin)),
+                      tile_pos{0, 1},
+                      offset(bottom_left(origin)),
+                      offset(top_left(origin))};
+          } else {
+            result = {offset(top_right(origin)),
+                      tile_pos{1, 0},
+                      offset(bottom_right(origin)),
+                      offset(bottom_left(origin)),
+                      tile_pos{-1, 0},
+                      offset(top_left(origin))};
+          }
+        } else {
+          const auto top = m_staggerX ? tile_pos{0, -1} : tile_pos{0, -2};
+          const auto right = m_staggerX ? tile_pos{2, 0} : tile_pos{1, 0};
+          result = {offset(top_right(origin)),
+                    offset(bottom_right(origin)),
+                    offset(bottom_left(origin)),
+                    offset(top_left(origin)),
+                    top,
+                    right,
+                    tile_pos{-top.col, -top.row},
+                    tile_pos{-right.col, -right.row}};
+        }
+        return result;
+      };
+
+      m_offsets[0] = make(unshifted);
+      m_offsets[1] = make(shifted);
+    } else {
+      m_offsets[0] = {tile_pos{0, -1},
+                      tile_pos{1, 0},
+                      tile_pos{0, 1},
+                      tile_pos{-1, 0},
+                      tile_pos{1, -1},
+                      tile_pos{1, 1},
+                      tile_pos{-1, 1},
+                      tile_pos{-1, -1}};
+      m_offsets[1] = m_offsets[0];
+    }
+  }
+
+  [[nodiscard]] auto staggered_pixel_to_tile(double x, double y) const noexcept
+      -> tile_pos
+  {
+    if (m_staggerX) {
+      x -= m_staggerEven ? m_sideOffsetX : 0;
+    } else {
+      y -= m_staggerEven ? m_sideOffsetY : 0;
+    }
+
+    // Start with the coordinates of a grid-aligned tile
+    tile_pos ref{detail::floor_to_int(x / m_tileWidth),
+                 detail::floor_to_int(y / m_tileHeight)};
+
+    // Relative position on the base square of the grid-aligned tile
+    const auto relX = x - static_cast<double>(ref.col) * m_tileWidth;
+    const auto relY = y - static_cast<double>(ref.row) * m_tileHeight;
+
+    auto& staggerIndex = m_staggerX ? ref.col : ref.row;
+    staggerIndex *= 2;
+    if (m_staggerEven) {
+      ++staggerIndex;
+    }
+
+    // Check whether the pixel is in any of the corners (neighbouring tiles)
+    const auto yPos = relX * (static_cast<double>(m_tileHeight) / m_tileWidth);
+    if (m_sideOffsetY - yPos > relY) {
+      return top_left(ref);
+    } else if (-m_sideOffsetY + yPos > relY) {
+      return top_right(ref);
+    } else if (m_sideOffsetY + yPos < relY) {
+      return bottom_left(ref);
+    } else if (m_sideOffsetY * 3 - yPos < relY) {
+      return bottom_right(ref);
+    } else {
+      return ref;
+    }
+  }
+
+  [[nodiscard]] auto hexagonal_pixel_to_tile(double x, double y) const noexcept
+      -> tile_pos
+  {
+    if (m_staggerX) {
+      x -= m_staggerEven ? m_tileWidth : m_sideOffsetX;
+    } else {
+      y -= m_staggerEven ? m_tileHeight : m_sideOffsetY;
+    }
+
+    // Start with the coordinates of a grid-aligned tile
+    tile_pos ref{detail::floor_to_int(x / (m_columnWidth * 2.0)),
+                 detail::floor_to_int(y / (m_rowHeight * 2.0))};
+
+    // Relative position on the base square of the grid-aligned tile
+    const auto relX = x - ref.col * (m_columnWidth * 2.0);
+    const auto relY = y - ref.row * (m_rowHeight * 2.0);
+
+    auto& staggerIndex = m_staggerX ? ref.col : ref.row;
+    staggerIndex *= 2;
+    if (m_staggerEven) {
+      ++staggerIndex;
+    }
+
+    // Determine the nearest hexagon tile by the distance to the center
+    std::array<point, 4> centers;
+    if (m_staggerX) {
+      const auto left = m_sideLengthX / 2.0;
+      const auto centerX = left + m_columnWidth;
+      const auto centerY = m_tileHeight / 2.0;
+      centers = {point{left, centerY},
+                 point{centerX, centerY - m_rowHeight},
+                 point{centerX, centerY + m_rowHeight},
+                 point{centerX + m_columnWidth, centerY}};
+    } else {
+      const auto top = m_sideLengthY / 2.0;
+      const auto centerX = m_tileWidth / 2.0;
+      const auto centerY = top + m_rowHeight;
+      centers = {point{centerX, top},
+                 point{centerX - m_columnWidth, centerY},
+                 point{centerX + m_columnWidth, centerY},
+                 point{centerX, centerY + m_rowHeight}};
+    }
+
+    std::size_t nearest = 0;
+    auto minDistance = std::numeric_limits<double>::max();
+    for (std::size_t i = 0; i < centers.size(); ++i) {
+      const auto dx = centers[i].x() - relX;
+      const auto dy = centers[i].y() - relY;
+      const auto distance = dx * dx + dy * dy;
+      if (distance < minDistance) {
+        minDistance = distance;
+        nearest = i;
+      }
+    }
+
+    constexpr std::array<tile_pos, 4> offsetsStaggerX{
+        tile_pos{0, 0}, tile_pos{1, -1}, tile_pos{1, 0}, tile_pos{2, 0}};
+    constexpr std::array<tile_pos, 4> offsetsStaggerY{
+        tile_pos{0, 0}, tile_pos{-1, 1}, tile_pos{0, 1}, tile_pos{0, 2}};
+
+    const auto& offset =
+        m_staggerX ? offsetsStaggerX[nearest] : offsetsStaggerY[nearest];
+    return {ref.col + offset.col, ref.row + offset.row};
+  }
+};
+
+/**
+ * @class projection::visible_range
+ *
+ * @brief A lazily evaluated range of the tiles that intersect a rectangle.
+ *
+ * @details The range is divided into "lines" of tiles that are evenly spaced,
+ * i.e. rows for orthogonal maps, diagonals for isometric maps and (half) rows
+ * for staggered and hexagonal maps. The lines are visited in draw order.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_projection.hpp
+ */
+template <map::orientation Orientation>
+class projection<Orientation>::visible_range final {
+ public:
+  class iterator final {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = tile_pos;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const tile_pos*;
+    using reference = tile_pos;
+
+    iterator(const visible_range* range, int lineIndex) noexcept
+        : m_range{range},
+          m_lineIndex{lineIndex}
+    {
+      skip_empty_lines();
+    }
+
+    [[nodiscard]] auto operator*() const noexcept -> tile_pos
+    {
+      return {m_line.start.col + m_index * m_range->m_step.col,
+              m_line.start.row + m_index * m_range->m_step.row};
+    }
+
+    auto operator++() noexcept -> iterator&
+    {
+      if (++m_index == m_line.count) {
+        m_index = 0;
+        ++m_lineIndex;
+        skip_empty_lines();
+      }
+      return *this;
+    }
+
+    [[nodiscard]] auto operator==(const iterator& other) const noexcept -> bool
+    {
+      return m_lineIndex == other.m_lineIndex && m_index == other.m_index;
+    }
+
+    [[nodiscard]] auto operator!=(const iterator& other) const noexcept -> bool
+    {
+      return !(*this == other);
+    }
+
+   private:
+    const visible_range* m_range{};
+    line m_line;
+    int m_lineIndex{};
+    int m_index{};
+
+    void skip_empty_lines() noexcept
+    {
+      for (; m_lineIndex < m_range->m_lineCount; ++m_lineIndex) {
+        m_line = m_range->line_at(m_lineIndex);
+        if (m_line.count > 0) {
+          return;
+        }
+      }
+    }
+  };
+
+  visible_range(const projection& projection,
+                double x0,
+                double y0,
+                double x1,
+                double y1) noexcept
+      : m_projection{projection},
+        m_x0{x0},
+        m_y0{y0},
+        m_x1{x1},
+        m_y1{y1}
+  {
+    if (x1 <= x0 || y1 <= y0 || m_projection.m_mapWidth <= 0 ||
+        m_projection.m_mapHeight <= 0) {
+      return;
+    }
+
+    const auto& p = m_projection;
+    if constexpr (Orientation == map::orientation::orthogonal) {
+      const auto [r0, r1] =
+          detail::index_span(y0, y1, 0, p.m_tileHeight, p.m_tileHeight);
+      const auto [c0, c1] =
+          detail::index_span(x0, x1, 0, p.m_tileWidth, p.m_tileWidth);
+      m_first = {std::max(c0, 0), std::max(r0, 0)};
+      m_last = {std::min(c1, p.m_mapWidth - 1),
+                std::min(r1, p.m_mapHeight - 1)};
+      m_lineCount = std::max(m_last.row - m_first.row + 1, 0);
+
+      const auto order = p.m_renderOrder;
+      m_step.col = (order == map::render_order::right_down ||
+                    order == map::render_order::right_up)
+                       ? 1
+                       : -1;
+      m_step.row = 0;
+
+    } else if constexpr (Orientation == map::orientation::isometric) {
+      // Lines are the diagonals d = col + row, which share the same y-position
+      const auto halfWidth = p.m_tileWidth / 2.0;
+      const auto halfHeight = p.m_tileHeight / 2.0;
+      const auto [d0, d1] =
+          detail::index_span(y0, y1, 0, halfHeight, p.m_tileHeight);
+
+      // Within a diagonal, e = col - row determines the x-position
+      const auto originX = (p.m_mapHeight - 1) * halfWidth;
+      const auto [e0, e1] =
+          detail::index_span(x0, x1, originX, halfWidth, p.m_tileWidth);
+
+      m_first = {e0, std::max(d0, 0)};
+      m_last = {e1, std::min(d1, p.m_mapWidth + p.m_mapHeight - 2)};
+      m_lineCount = std::max(m_last.row - m_first.row + 1, 0);
+      m_step = {1, -1};
+
+    } else {
+      if (p.m_staggerX) {
+        const auto [c0, c1] = detail::index_span(
+            x0, x1, 0, p.m_columnWidth, p.m_tileWidth);
+        const auto rowStep = p.m_tileHeight + p.m_sideLengthY;
+        const auto [r0, r1] =
+            detail::index_span(y0, y1, 0, rowStep, p.m_tileHeight);
+        const auto [s0, s1] =
+            detail::index_span(y0, y1, p.m_rowHeight, rowStep, p.m_tileHeight);
+
+        m_first = {std::max(c0, 0), std::max(std::min(r0, s0), 0)};
+        m_last = {std::min(c1, p.m_mapWidth - 1),
+                  std::min(std::max(r1, s1), p.m_mapHeight - 1)};
+        m_rows = {r0, r1};
+        m_shiftedRows = {s0, s1};
+
+        // Each row is split into the unshifted and shifted columns
+        m_lineCount = std::max(m_last.row - m_first.row + 1, 0) * 2;
+        m_step = {2, 0};
+      } else {
+        const auto [r0, r1] =
+            detail::index_span(y0, y1, 0, p.m_rowHeight, p.m_tileHeight);
+        m_first = {0, std::max(r0, 0)};
+        m_last = {p.m_mapWidth - 1, std::min(r1, p.m_mapHeight - 1)};
+        m_lineCount = std::max(m_last.row - m_first.row + 1, 0);
+        m_step = {1, 0};
+      }
+    }
+  }
+
+  [[nodiscard]] auto begin() const noexcept -> iterator
+  {
+    return iterator{this, 0};
+  }
+
+  [[nodiscard]] auto end() const noexcept -> iterator
+  {
+    return iterator{this, m_lineCount};
+  }
+
+ private:
+  projection m_projection;
+  double m_x0{};
+  double m_y0{};
+  double m_x1{};
+  double m_y1{};
+  tile_pos m_first;
+  tile_pos m_last;
+  tile_pos m_step;
+  std::pair<int, int> m_rows;
+  std::pair<int, int> m_shiftedRows;
+  int m_lineCount{};
+
+  [[nodiscard]] auto line_at(int index) const noexcept -> line
+  {
+    const auto& p = m_projection;
+    if constexpr (Orientation == map::orientation::orthogonal) {
+      const auto order = p.m_renderOrder;
+      const auto down = order == map::render_order::right_down ||
+                        order == map::render_order::left_down;
+      const auto row = down ? m_first.row + index : m_last.row - index;
+      const auto col = (m_step.col > 0) ? m_first.col : m_last.col;
+      return {{col, row}, m_last.col - m_first.col + 1};
+
+    } else if constexpr (Orientation == map::orientation::isometric) {
+      const auto d = m_first.row + index;
+
+      // Align the range of e = col - row to the parity of d = col + row
+      auto e0 = m_first.col;
+      auto e1 = m_last.col;
+      if (((e0 - d) & 1) != 0) {
+        ++e0;
+      }
+      if (((e1 - d) & 1) != 0) {
+        --e1;
+      }
+
+      const auto col0 =
+          std::max((d + e0) / 2, std::max(0, d - (p.m_mapHeight - 1)));
+      const auto col1 = std::min((d + e1) / 2, std::min(p.m_mapWidth - 1, d));
+      return {{col0, d - col0}, col1 - col0 + 1};
+
+    } else {
+      if (p.m_staggerX) {
+        const auto row = m_first.row + index / 2;
+        const auto shifted = (index % 2) != 0;
+
+        const auto& rows = shifted ? m_shiftedRows : m_rows;
+        if (row < rows.first || row > rows.second) {
+          return {};
+        }
+
+        auto col = m_first.col;
+        if (p.is_shifted(tile_pos{col, row}) != shifted) {
+          ++col;
+        }
+
+        const auto count = (col <= m_last.col) ? (m_last.col - col) / 2 + 1 : 0;
+        return {{col, row}, count};
+      } else {
+        const auto row = m_first.row + index;
+        const auto offset =
+            p.is_shifted(tile_pos{0, row}) ? p.m_columnWidth : 0;
+        const auto step = p.m_tileWidth + p.m_sideLengthX;
+        const auto [c0, c1] =
+            detail::index_span(m_x0, m_x1, offset, step, p.m_tileWidth);
+        const auto col0 = std::max(c0, 0);
+        const auto col1 = std::min(c1, p.m_mapWidth - 1);
+        return {{col0, row}, col1 - col0 + 1};
+      }
+    }
+  }
+};
+
+/**
+ * @brief Invokes a callable with the projection that matches the orientation
+ * of a map.
+ *
+ * @tparam Lambda the type of the callable.
+ *
+ * @param map the map that the projection will be based on.
+ * @param lambda the callable, that takes a single `const projection<O>&`
+ * parameter. A generic lambda is suitable.
+ *
+ * @return the value returned by the callable.
+ *
+ * @since 0.3.0
+ */
+template <typename Lambda>
+decltype(auto) visit_projection(const map& map, Lambda&& lambda)
+{
+  switch (map.get_orientation()) {
+    case map::orientation::isometric:
+      return lambda(projection<map::orientation::isometric>{map});
+
+    case map::orientation::staggered:
+      return lambda(projection<map::orientation::staggered>{map});
+
+    case map::orientation::hexagonal:
+      return lambda(projection<map::orientation::hexagonal>{map});
+
+    case map::orientation::orthogonal:
+    default:
+      return lambda(projection<map::orientation::orthogonal>{map});
+  }
+}
+
+}  // namespace step
+
+#endif  // STEP_PROJECTION_HEADER
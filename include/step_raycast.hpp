@@ -0,0 +1,296 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_raycast.hpp
+ *
+ * @brief Provides the `raycaster` class, which traces rays through the solid
+ * tiles of a tile mask.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_RAYCAST_HEADER
+#define STEP_RAYCAST_HEADER
+
+#include <algorithm>  // min
+#include <cmath>      // abs
+#include <cstddef>    // size_t
+#include <limits>     // numeric_limits
+#include <optional>   // optional, nullopt
+#include <vector>     // vector
+
+#include "step_api.hpp"
+#include "step_map.hpp"
+#include "step_point.hpp"
+#include "step_tile_mask.hpp"
+#include "step_tile_pos.hpp"
+#include "step_utils.hpp"
+
+namespace step {
+
+/**
+ * @struct ray
+ *
+ * @brief A simple data container for a ray, i.e. a line segment.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_raycast.hpp
+ */
+struct ray final {
+  point from;  ///< The start point of the ray.
+  point to;    ///< The end point of the ray.
+};
+
+/**
+ * @struct ray_hit
+ *
+ * @brief A simple data container for the result of a ray that hit a solid
+ * tile.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_raycast.hpp
+ */
+struct ray_hit final {
+  tile_pos tile;    ///< The position of the solid tile that was hit.
+  point position;   ///< The point where the ray entered the tile.
+  point normal;     ///< The normal of the entered face, (0, 0) if the ray
+                    ///< started inside the tile.
+  double fraction;  ///< The fraction of the ray before the hit, in [0, 1].
+};
+
+/**
+ * @class raycaster
+ *
+ * @brief Traces rays through a grid of solid tiles.
+ *
+ * @details Rays are traced with the grid traversal algorithm by Amanatides and
+ * Woo, which visits exactly the tiles that the ray passes through, in order.
+ * Each step only requires a comparison and an addition, and the solid tiles
+ * are looked up in a packed bit mask. Coordinates are in pixels, where the
+ * tile at (col, row) covers the area starting at (col * tileWidth, row *
+ * tileHeight), i.e. orthogonal maps. Tiles outside of the mask aren't solid.
+ *
+ * @warning The raycaster refers to the mask, so the mask must outlive the
+ * raycaster.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_raycast.hpp
+ */
+class raycaster final {
+ public:
+  /**
+   * @brief Creates a raycaster.
+   *
+   * @param solid the mask of solid tiles.
+   * @param tileWidth the width of the tiles, in pixels.
+   * @param tileHeight the height of the tiles, in pixels.
+   *
+   * @since 0.3.0
+   */
+  explicit raycaster(const tile_mask& solid,
+                     double tileWidth = 1,
+                     double tileHeight = 1) noexcept
+      : m_solid{&solid},
+        m_tileWidth{tileWidth},
+        m_tileHeight{tileHeight}
+  {}
+
+  /**
+   * @brief Creates a raycaster that uses the tile size of a map.
+   *
+   * @param solid the mask of solid tiles, e.g. created from a boolean tile
+   * property with `make_tile_mask()`.
+   * @param map the map that provides the tile size.
+   *
+   * @since 0.3.0
+   */
+  raycaster(const tile_mask& solid, const map& map) noexcept
+      : raycaster{solid,
+                  static_cast<double>(map.tile_width()),
+                  static_cast<double>(map.tile_height())}
+  {}
+
+  /**
+   * @brief Traces a ray and returns the first solid tile that it hits.
+   *
+   * @param r the ray that will be traced.
+   *
+   * @return the first hit; an empty optional if the ray doesn't hit any solid
+   * tile.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto cast(const ray& r) const noexcept
+      -> std::optional<ray_hit>
+  {
+    const auto& solid = *m_solid;
+
+    // Work in tile units
+    const auto x = r.from.x() / m_tileWidth;
+    const auto y = r.from.y() / m_tileHeight;
+    const auto dx = r.to.x() / m_tileWidth - x;
+    const auto dy = r.to.y() / m_tileHeight - y;
+
+    tile_pos pos{detail::floor_to_int(x), detail::floor_to_int(y)};
+    if (solid.test(pos)) {
+      return ray_hit{pos, r.from, point{0, 0}, 0};
+    }
+
+    constexpr auto infinity = std::numeric_limits<double>::infinity();
+    const auto stepCol = dx > 0 ? 1 : -1;
+    const auto stepRow = dy > 0 ? 1 : -1;
+
+    // The fraction of the ray needed to cross a whole tile along each axis
+    const auto deltaX = dx != 0 ? std::abs(1 / dx) : infinity;
+    const auto deltaY = dy != 0 ? std::abs(1 / dy) : infinity;
+
+    // The fraction of the ray at the next vertical and horizontal tile edges
+    auto nextX = dx > 0 ? (pos.col + 1 - x) * deltaX
+                        : dx < 0 ? (x - pos.col) * deltaX : infinity;
+    auto nextY = dy > 0 ? (pos.row + 1 - y) * deltaY
+                        : dy < 0 ? (y - pos.row) * deltaY : infinity;
+
+    while (true) {
+      double fraction{};
+      point normal;
+      if (nextX < nextY) {
+        fraction = nextX;
+        pos.col += stepCol;
+        nextX += deltaX;
+        normal = point{static_cast<double>(-stepCol), 0};
+      } else {
+        fraction = nextY;
+        pos.row += stepRow;
+        nextY += deltaY;
+        normal = point{0, static_cast<double>(-stepRow)};
+      }
+
+      if (fraction > 1) {
+        return std::nullopt;
+      }
+
+      if (solid.test(pos)) {
+        const point position{r.from.x() + (r.to.x() - r.from.x()) * fraction,
+                             r.from.y() + (r.to.y() - r.from.y()) * fraction};
+        return ray_hit{pos, position, normal, fraction};
+      }
+    }
+  }
+
+  /**
+   * @brief Indicates whether or not there is a clear line of sight between
+   * two points.
+   *
+   * @param from the first point.
+   * @param to the second point.
+   *
+   * @return `true` if the line segment between the points doesn't pass
+   * through any solid tile; `false` otherwise.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto line_of_sight(const point& from, const point& to) const
+      noexcept -> bool
+  {
+    return !cast(ray{from, to});
+  }
+
+  /**
+   * @brief Traces several rays.
+   *
+   * @details The rays are divided into blocks that are traced in parallel.
+   * The result vector is resized to the amount of rays, reuse it between calls
+   * to avoid reallocations.
+   *
+   * @param rays the rays that will be traced.
+   * @param hits the vector that the results are written to, in the same order
+   * as the rays.
+   * @param threads the maximum amount of threads, zero means the amount of
+   * hardware threads.
+   *
+   * @since 0.3.0
+   */
+  void cast(const std::vector<ray>& rays,
+            std::vector<std::optional<ray_hit>>& hits,
+            int threads = 1) const
+  {
+    hits.resize(rays.size());
+    for_each_block(rays.size(), threads, [&](std::size_t i) {
+      hits[i] = cast(rays[i]);
+    });
+  }
+
+  /**
+   * @brief Checks the lines of sight of several pairs of points.
+   *
+   * @param rays the line segments that will be checked.
+   * @param visible the vector that the results are written to, as 1 if the
+   * line of sight is clear and 0 otherwise.
+   * @param threads the maximum amount of threads, zero means the amount of
+   * hardware threads.
+   *
+   * @since 0.3.0
+   */
+  void line_of_sight(const std::vector<ray>& rays,
+                     std::vector<unsigned char>& visible,
+                     int threads = 1) const
+  {
+    visible.resize(rays.size());
+    for_each_block(rays.size(), threads, [&](std::size_t i) {
+      visible[i] = line_of_sight(rays[i].from, rays[i].to) ? 1 : 0;
+    });
+  }
+
+ private:
+  static constexpr std::size_t block_size = 256;
+
+  const tile_mask* m_solid{};
+  double m_tileWidth{1};
+  double m_tileHeight{1};
+
+  template <typename Lambda>
+  static void for_each_block(std::size_t count, int threads, Lambda&& lambda)
+  {
+    const auto blocks = static_cast<int>((count + block_size - 1) / block_size);
+    detail::parallel_for(0, blocks, threads, [&](int block) {
+      const auto first = static_cast<std::size_t>(block) * block_size;
+      const auto last = std::min(first + block_size, count);
+      for (auto i = first; i < last; ++i) {
+        lambda(i);
+      }
+    });
+  }
+};
+
+}  // namespace step
+
+#endif  // STEP_RAYCAST_HEADER
@@ -0,0 +1,114 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_rect.hpp
+ *
+ * @brief Provides the `rect` struct.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_RECT_HEADER
+#define STEP_RECT_HEADER
+
+#include "step_api.hpp"
+
+namespace step {
+
+/**
+ * @struct rect
+ *
+ * @brief A simple data container for axis-aligned rectangles.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_rect.hpp
+ */
+struct rect final {
+  double x{};
+  double y{};
+  double width{};
+  double height{};
+};
+
+/**
+ * @brief Indicates whether or not two rectangles are equal.
+ *
+ * @param lhs the left-hand side rectangle.
+ * @param rhs the right-hand side rectangle.
+ *
+ * @return `true` if the rectangles are equal; `false` otherwise.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] constexpr auto operator==(const rect& lhs,
+                                        const rect& rhs) noexcept -> bool
+{
+  return lhs.x == rhs.x && lhs.y == rhs.y && lhs.width == rhs.width &&
+         lhs.height == rhs.height;
+}
+
+/**
+ * @brief Indicates whether or not two rectangles aren't equal.
+ *
+ * @param lhs the left-hand side rectangle.
+ * @param rhs the right-hand side rectangle.
+ *
+ * @return `true` if the rectangles aren't equal; `false` otherwise.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] constexpr auto operator!=(const rect& lhs,
+                                        const rect& rhs) noexcept -> bool
+{
+  return !(lhs == rhs);
+}
+
+/**
+ * @brief Indicates whether or not two rectangles overlap.
+ *
+ * @details Rectangles that only share an edge don't overlap.
+ *
+ * @param lhs the first rectangle.
+ * @param rhs the second rectangle.
+ *
+ * @return `true` if the rectangles overlap; `false` otherwise.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] constexpr auto intersects(const rect& lhs,
+                                        const rect& rhs) noexcept -> bool
+{
+  return lhs.x < rhs.x + rhs.width && rhs.x < lhs.x + lhs.width &&
+         lhs.y < rhs.y + rhs.height && rhs.y < lhs.y + lhs.height;
+}
+
+}  // namespace step
+
+#endif  // STEP_RECT_HEADER
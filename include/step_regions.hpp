@@ -0,0 +1,680 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_regions.hpp
+ *
+ * @brief Provides the `region_map` class, which labels the connected regions
+ * of a tile mask.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_REGIONS_HEADER
+#define STEP_REGIONS_HEADER
+
+#include <algorithm>  // min, max, sort, stable_sort, unique
+#include <array>      // array
+#include <cstddef>    // size_t
+#include <thread>     // thread
+#include <vector>     // vector
+
+#include "step_api.hpp"
+#include "step_exception.hpp"
+#include "step_map.hpp"
+#include "step_projection.hpp"
+#include "step_tile_mask.hpp"
+#include "step_tile_pos.hpp"
+#include "step_utils.hpp"
+
+namespace step {
+
+/**
+ * @class connectivity
+ *
+ * @brief Describes which tiles are considered to be connected to each other.
+ *
+ * @details Orthogonal tiles are either 4-connected (tiles that share an edge)
+ * or 8-connected (tiles that share an edge or a corner). Use `of()` to obtain
+ * the tiles that share an edge in a map of any orientation, e.g. six tiles for
+ * hexagonal maps.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_regions.hpp
+ */
+class connectivity final {
+ public:
+  /**
+   * @brief The maximum amount of neighbours of a tile.
+   *
+   * @since 0.3.0
+   */
+  static constexpr std::size_t max_neighbours = 8;
+
+  /**
+   * @brief Returns the connectivity where orthogonal tiles that share an edge
+   * are connected.
+   *
+   * @return 4-connectivity.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] static auto four() noexcept -> connectivity
+  {
+    connectivity result;
+    result.m_count = 4;
+    result.m_offsets.fill(
+        {tile_pos{0, -1}, tile_pos{1, 0}, tile_pos{0, 1}, tile_pos{-1, 0}});
+    return result;
+  }
+
+  /**
+   * @brief Returns the connectivity where orthogonal tiles that share an edge
+   * or a corner are connected.
+   *
+   * @return 8-connectivity.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] static auto eight() noexcept -> connectivity
+  {
+    auto result = four();
+    result.m_count = 8;
+    for (auto& offsets : result.m_offsets) {
+      offsets[4] = {1, -1};
+      offsets[5] = {1, 1};
+      offsets[6] = {-1, 1};
+      offsets[7] = {-1, -1};
+    }
+    return result;
+  }
+
+  /**
+   * @brief Returns the connectivity where tiles that share an edge in a map
+   * are connected.
+   *
+   * @details Orthogonal and isometric tiles have four such neighbours,
+   * staggered tiles have four and hexagonal tiles have six.
+   *
+   * @param map the map that provides the orientation.
+   *
+   * @return the connectivity of tiles that share an edge in the map.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] static auto of(const map& map) -> connectivity
+  {
+    connectivity result;
+    result.m_count =
+        map.get_orientation() == map::orientation::hexagonal ? 6 : 4;
+
+    visit_projection(map, [&](const auto& projection) {
+      for (std::size_t i = 0; i < result.m_offsets.size(); ++i) {
+        const tile_pos pos{static_cast<int>(i & 1u),
+                           static_cast<int>(i >> 1u)};
+        const auto& offsets = projection.neighbour_offsets(pos);
+        for (std::size_t j = 0; j < result.m_count; ++j) {
+          result.m_offsets[i][j] = offsets[j];
+        }
+      }
+    });
+
+    return result;
+  }
+
+  /**
+   * @brief Invokes a callable for each position that is connected to a
+   * position.
+   *
+   * @details The positions aren't clamped to any bounds.
+   *
+   * @tparam Lambda the type of the callable.
+   *
+   * @param pos the position of the tile.
+   * @param lambda the callable that takes a single `tile_pos` argument.
+   *
+   * @since 0.3.0
+   */
+  template <typename Lambda>
+  void each(tile_pos pos, Lambda&& lambda) const
+  {
+    const auto& offsets = offsets_of(pos);
+    for (std::size_t i = 0; i < m_count; ++i) {
+      lambda(tile_pos{pos.col + offsets[i].col, pos.row + offsets[i].row});
+    }
+  }
+
+  /**
+   * @brief Returns the amount of neighbours of each tile.
+   *
+   * @return the amount of neighbours of each tile.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto count() const noexcept -> std::size_t
+  {
+    return m_count;
+  }
+
+ private:
+  using offset_table = std::array<tile_pos, max_neighbours>;
+
+  std::array<offset_table, 4> m_offsets{};  // Indexed by column/row parity
+  std::size_t m_count{0};
+
+  connectivity() noexcept = default;
+
+  [[nodiscard]] auto offsets_of(tile_pos pos) const noexcept
+      -> const offset_table&
+  {
+    return m_offsets[static_cast<std::size_t>((pos.col & 1) |
+                                              ((pos.row & 1) << 1))];
+  }
+};
+
+/**
+ * @struct region
+ *
+ * @brief A simple data container for the statistics of a connected region.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_regions.hpp
+ */
+struct region final {
+  int area{0};  ///< The amount of tiles in the region.
+  tile_pos min;  ///< The top-left corner of the bounding box, inclusive.
+  tile_pos max;  ///< The bottom-right corner of the bounding box, inclusive.
+};
+
+/**
+ * @struct region_link
+ *
+ * @brief A simple data container for an edge in a region adjacency graph.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_regions.hpp
+ */
+struct region_link final {
+  int from{0};  ///< The smaller label of the two regions.
+  int to{0};    ///< The larger label of the two regions.
+  tile_pos door;  ///< A door tile that connects the regions.
+};
+
+/**
+ * @class region_map
+ *
+ * @brief Labels the connected regions of a tile mask.
+ *
+ * @details Every set tile of the mask gets the label of the region that it
+ * belongs to, where regions are numbered in the order of their first tile in
+ * row-major order. The labeling uses a union-find structure. The rows are
+ * split into blocks that are labeled in parallel, after which the labels on
+ * either side of each block border are merged. The result doesn't depend on
+ * the amount of threads.
+ *
+ * Optionally, a mask of door tiles can be supplied. The door tiles form
+ * connected doors, and two regions are adjacent if they are both connected to
+ * the same door, which produces the region adjacency graph.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_regions.hpp
+ */
+class region_map final {
+ public:
+  /**
+   * @brief The label of tiles that don't belong to any region.
+   *
+   * @since 0.3.0
+   */
+  static constexpr int none = -1;
+
+  /**
+   * @brief Labels the connected regions of a mask.
+   *
+   * @param mask the mask of the tiles that belong to regions, e.g. the
+   * walkable tiles of a map.
+   * @param connections the connectivity of the tiles.
+   * @param threads the maximum amount of threads, zero means the amount of
+   * hardware threads.
+   *
+   * @since 0.3.0
+   */
+  region_map(const tile_mask& mask,
+             const connectivity& connections,
+             int threads = 0)
+      : m_width{mask.width()},
+        m_height{mask.height()},
+        m_labels(cell_count(), none)
+  {
+    label(mask, connections, threads);
+  }
+
+  /**
+   * @brief Labels the connected regions of a mask and finds the regions that
+   * are connected by doors.
+   *
+   * @details Door tiles shouldn't be part of the region mask, since they
+   * would merge the regions on either side of them.
+   *
+   * @param mask the mask of the tiles that belong to regions.
+   * @param doors the mask of the door tiles, e.g. created from a boolean
+   * `"door"` tile property. Must have the same size as the region mask.
+   * @param connections the connectivity of the tiles.
+   * @param threads the maximum amount of threads, zero means the amount of
+   * hardware threads.
+   *
+   * @throws step_exception if the masks have different sizes.
+   *
+   * @since 0.3.0
+   */
+  region_map(const tile_mask& mask,
+             const tile_mask& doors,
+             const connectivity& connections,
+             int threads = 0)
+      : region_map{mask, connections, threads}
+  {
+    if (doors.width() != m_width || doors.height() != m_height) {
+      throw step_exception{"region_map > Mask sizes don't match!"};
+    }
+
+    link(doors, region_map{doors, connections, threads}, connections);
+  }
+
+  /**
+   * @brief Returns the label of a tile.
+   *
+   * @param pos the position of the tile.
+   *
+   * @return the label of the region that the tile belongs to; `none` if the
+   * tile doesn't belong to a region or if the position is out-of-bounds.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto label(tile_pos pos) const noexcept -> int
+  {
+    if (pos.col >= 0 && pos.row >= 0 && pos.col < m_width &&
+        pos.row < m_height) {
+      return m_labels[cell_index(pos)];
+    } else {
+      return none;
+    }
+  }
+
+  /**
+   * @brief Indicates whether or not two tiles belong to the same region.
+   *
+   * @param a the position of the first tile.
+   * @param b the position of the second tile.
+   *
+   * @return `true` if both tiles belong to the same region; `false`
+   * otherwise.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto connected(tile_pos a, tile_pos b) const noexcept -> bool
+  {
+    const auto label = this->label(a);
+    return label != none && label == this->label(b);
+  }
+
+  /**
+   * @brief Returns the regions, indexed by label.
+   *
+   * @return the statistics of the regions.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto regions() const noexcept -> const std::vector<region>&
+  {
+    return m_regions;
+  }
+
+  /**
+   * @brief Returns the edges of the region adjacency graph.
+   *
+   * @details Each pair of regions occurs at most once, sorted by the labels
+   * of the regions. This is always empty if no doors were supplied.
+   *
+   * @return the edges of the region adjacency graph.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto links() const noexcept
+      -> const std::vector<region_link>&
+  {
+    return m_links;
+  }
+
+  /**
+   * @brief Returns the labels of the regions that are adjacent to a region.
+   *
+   * @param label the label of the region.
+   *
+   * @return the sorted labels of the adjacent regions.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto neighbours(int label) const -> std::vector<int>
+  {
+    std::vector<int> result;
+    for (const auto& link : m_links) {
+      if (link.from == label) {
+        result.push_back(link.to);
+      } else if (link.to == label) {
+        result.push_back(link.from);
+      }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+
+  /**
+   * @brief Returns the labels of all tiles, in row-major order.
+   *
+   * @return the labels of all tiles.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto labels() const noexcept -> const std::vector<int>&
+  {
+    return m_labels;
+  }
+
+  /**
+   * @brief Returns the amount of columns in the label grid.
+   *
+   * @return the amount of columns in the label grid.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto width() const noexcept -> int
+  {
+    return m_width;
+  }
+
+  /**
+   * @brief Returns the amount of rows in the label grid.
+   *
+   * @return the amount of rows in the label grid.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto height() const noexcept -> int
+  {
+    return m_height;
+  }
+
+ private:
+  static constexpr int min_block_rows = 32;
+
+  int m_width{0};
+  int m_height{0};
+  std::vector<int> m_labels;
+  std::vector<region> m_regions;
+  std::vector<region_link> m_links;
+
+  [[nodiscard]] auto cell_count() const noexcept -> std::size_t
+  {
+    return static_cast<std::size_t>(m_width) *
+           static_cast<std::size_t>(m_height);
+  }
+
+  [[nodiscard]] auto cell_index(tile_pos pos) const noexcept -> std::size_t
+  {
+    return static_cast<std::size_t>(pos.row) *
+               static_cast<std::size_t>(m_width) +
+           static_cast<std::size_t>(pos.col);
+  }
+
+  [[nodiscard]] static auto find(std::vector<int>& parent, int index) noexcept
+      -> int
+  {
+    while (parent[static_cast<std::size_t>(index)] != index) {
+      auto& next = parent[static_cast<std::size_t>(index)];
+      next = parent[static_cast<std::size_t>(next)];  // Path halving
+      index = next;
+    }
+    return index;
+  }
+
+  static void unite(std::vector<int>& parent, int a, int b) noexcept
+  {
+    a = find(parent, a);
+    b = find(parent, b);
+
+    // The root is always the first tile of the region in row-major order
+    if (a < b) {
+      parent[static_cast<std::size_t>(b)] = a;
+    } else if (b < a) {
+      parent[static_cast<std::size_t>(a)] = b;
+    }
+  }
+
+  void label(const tile_mask& mask,
+             const connectivity& connections,
+             int threads)
+  {
+    if (threads <= 0) {
+      threads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+
+    const auto blockCount =
+        std::max(1, std::min(threads, m_height / min_block_rows));
+    const auto block_begin = [&](int block) {
+      return static_cast<int>(static_cast<long long>(m_height) * block /
+                              blockCount);
+    };
+
+    std::vector<int> parent(cell_count());
+    for (std::size_t i = 0; i < parent.size(); ++i) {
+      parent[i] = static_cast<int>(i);
+    }
+
+    // Connects a tile to its set neighbours that precede it in row-major
+    // order, and that are on a row in the range [minRow, maxRow)
+    const auto connect = [&](tile_pos pos, int minRow, int maxRow) {
+      connections.each(pos, [&](tile_pos other) {
+        const auto precedes = other.row < pos.row ||
+                              (other.row == pos.row && other.col < pos.col);
+        if (precedes && other.row >= minRow && other.row < maxRow &&
+            mask.test(other)) {
+          unite(parent,
+                static_cast<int>(cell_index(pos)),
+                static_cast<int>(cell_index(other)));
+        }
+      });
+    };
+
+    // Label each block independently, every block only writes to its tiles
+    detail::parallel_for(0, blockCount, blockCount, [&](int block) {
+      const auto begin = block_begin(block);
+      const auto end = block_begin(block + 1);
+      for (auto row = begin; row < end; ++row) {
+        for (auto col = 0; col < m_width; ++col) {
+          if (mask.test(col, row)) {
+            connect({col, row}, begin, end);
+          }
+        }
+      }
+    });
+
+    // Merge the labels across the block borders
+    for (auto block = 1; block < blockCount; ++block) {
+      const auto border = block_begin(block);
+      const auto end = std::min(border + 2, m_height);
+      for (auto row = border; row < end; ++row) {
+        for (auto col = 0; col < m_width; ++col) {
+          if (mask.test(col, row)) {
+            connect({col, row}, 0, border);
+          }
+        }
+      }
+    }
+
+    // Number the roots in row-major order, which is independent of the blocks
+    std::vector<int> rootCount(static_cast<std::size_t>(blockCount) + 1, 0);
+    detail::parallel_for(0, blockCount, blockCount, [&](int block) {
+      auto count = 0;
+      const auto first = block_begin(block) * m_width;
+      const auto last = block_begin(block + 1) * m_width;
+      for (auto i = first; i < last; ++i) {
+        if (parent[static_cast<std::size_t>(i)] == i &&
+            mask.test(i % m_width, i / m_width)) {
+          ++count;
+        }
+      }
+      rootCount[static_cast<std::size_t>(block) + 1] = count;
+    });
+
+    for (std::size_t i = 1; i < rootCount.size(); ++i) {
+      rootCount[i] += rootCount[i - 1];
+    }
+
+    detail::parallel_for(0, blockCount, blockCount, [&](int block) {
+      auto next = rootCount[static_cast<std::size_t>(block)];
+      const auto first = block_begin(block) * m_width;
+      const auto last = block_begin(block + 1) * m_width;
+      for (auto i = first; i < last; ++i) {
+        if (parent[static_cast<std::size_t>(i)] == i &&
+            mask.test(i % m_width, i / m_width)) {
+          m_labels[static_cast<std::size_t>(i)] = next++;
+        }
+      }
+    });
+
+    // The roots are labeled, so the remaining tiles only read their roots
+    detail::parallel_for(0, blockCount, blockCount, [&](int block) {
+      const auto first = block_begin(block) * m_width;
+      const auto last = block_begin(block + 1) * m_width;
+      for (auto i = first; i < last; ++i) {
+        auto root = i;
+        while (parent[static_cast<std::size_t>(root)] != root) {
+          root = parent[static_cast<std::size_t>(root)];
+        }
+        if (root != i) {
+          m_labels[static_cast<std::size_t>(i)] =
+              m_labels[static_cast<std::size_t>(root)];
+        }
+      }
+    });
+
+    m_regions.assign(static_cast<std::size_t>(rootCount.back()), region{});
+    for (auto row = 0; row < m_height; ++row) {
+      for (auto col = 0; col < m_width; ++col) {
+        const auto label = m_labels[cell_index({col, row})];
+        if (label == none) {
+          continue;
+        }
+
+        auto& region = m_regions[static_cast<std::size_t>(label)];
+        if (region.area == 0) {
+          region.min = {col, row};
+          region.max = {col, row};
+        } else {
+          region.min.col = std::min(region.min.col, col);
+          region.max.col = std::max(region.max.col, col);
+          region.max.row = row;
+        }
+        ++region.area;
+      }
+    }
+  }
+
+  void link(const tile_mask& doors,
+            const region_map& doorRegions,
+            const connectivity& connections)
+  {
+    // The regions that touch each door, as (door, region) pairs
+    std::vector<std::array<int, 2>> touches;
+    for (auto row = 0; row < m_height; ++row) {
+      for (auto col = 0; col < m_width; ++col) {
+        if (!doors.test(col, row)) {
+          continue;
+        }
+
+        const auto door = doorRegions.label({col, row});
+        connections.each({col, row}, [&](tile_pos other) {
+          const auto label = this->label(other);
+          if (label != none) {
+            touches.push_back({door, label});
+          }
+        });
+      }
+    }
+
+    std::sort(touches.begin(), touches.end());
+    touches.erase(std::unique(touches.begin(), touches.end()), touches.end());
+
+    // Every pair of regions that touch the same door are adjacent
+    for (std::size_t first = 0; first < touches.size();) {
+      const auto door = touches[first][0];
+      const auto& doorRegion =
+          doorRegions.regions()[static_cast<std::size_t>(door)];
+
+      // The first tile of a region is on the top row of its bounding box
+      tile_pos doorTile = doorRegion.min;
+      while (doorRegions.label(doorTile) != door) {
+        ++doorTile.col;
+      }
+
+      auto last = first;
+      while (last < touches.size() && touches[last][0] == door) {
+        ++last;
+      }
+
+      for (auto i = first; i < last; ++i) {
+        for (auto j = i + 1; j < last; ++j) {
+          m_links.push_back({touches[i][1], touches[j][1], doorTile});
+        }
+      }
+
+      first = last;
+    }
+
+    std::stable_sort(m_links.begin(),
+                     m_links.end(),
+                     [](const region_link& lhs, const region_link& rhs) {
+                       return lhs.from < rhs.from ||
+                              (lhs.from == rhs.from && lhs.to < rhs.to);
+                     });
+
+    const auto same = [](const region_link& lhs, const region_link& rhs) {
+      return lhs.from == rhs.from && lhs.to == rhs.to;
+    };
+    m_links.erase(std::unique(m_links.begin(), m_links.end(), same),
+                  m_links.end());
+  }
+};
+
+}  // namespace step
+
+#endif  // STEP_REGIONS_HEADER
@@ -0,0 +1,337 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_render_list.hpp
+ *
+ * @brief Provides the `render_list` class.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_RENDER_LIST_HEADER
+#define STEP_RENDER_LIST_HEADER
+
+#include <algorithm>      // sort, unique
+#include <cstddef>        // size_t
+#include <unordered_map>  // unordered_map
+#include <vector>         // vector
+
+#include "step_api.hpp"
+#include "step_exception.hpp"
+#include "step_layer.hpp"
+#include "step_map.hpp"
+#include "step_object.hpp"
+#include "step_object_group.hpp"
+#include "step_tile_layer.hpp"
+#include "step_types.hpp"
+
+namespace step {
+
+/**
+ * @struct render_item
+ *
+ * @brief An entry in a depth sorted render list.
+ *
+ * @details An item is either a tile object, or a line of tiles of a tile
+ * layer. Lines are rows in orthogonal maps and diagonals, i.e. the tiles
+ * where `col + row` is constant, in isometric maps.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_render_list.hpp
+ */
+struct render_item final {
+  /**
+   * @enum render_item::kind
+   *
+   * @brief Provides values for the different kinds of render items.
+   *
+   * @since 0.3.0
+   */
+  enum class kind { object, tiles };
+
+  kind type{kind::object};  ///< The kind of the item.
+  int layer{};              ///< The ID of the layer that contains the item.
+  int index{};              ///< The object ID, or the row or diagonal.
+  double depth{};           ///< The sort key, larger values are drawn later.
+};
+
+/**
+ * @class render_list
+ *
+ * @brief A draw list of tile objects and tile lines, sorted by depth.
+ *
+ * @details The list merges the tile objects of all object groups with the
+ * `top_down` draw order and the non-empty lines of all tile layers, so that
+ * sprites are drawn in front of the tiles above them and behind the tiles
+ * below them. The depth of a tile object is its y-coordinate in orthogonal
+ * maps, and the sum of its coordinates in isometric maps, which are both
+ * the bottom of the object on the screen. Lines use the bottom edge of their
+ * tiles in the same unit. Items with equal depths are drawn in layer order.
+ *
+ * Moving objects only updates their precomputed depths, the list is sorted
+ * by `update()`. Since few items change order between frames, the list is
+ * sorted with insertion sort, unless many objects have moved.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_render_list.hpp
+ */
+class render_list final {
+ public:
+  /**
+   * @brief Creates a sorted render list for a map.
+   *
+   * @param map the map that provides the layers.
+   *
+   * @throws step_exception if the map isn't orthogonal or isometric, or if
+   * a tile layer has Base64 encoded data.
+   *
+   * @since 0.3.0
+   */
+  explicit render_list(const map& map)
+      : m_isometric{map.get_orientation() == map::orientation::isometric},
+        m_tileHeight{map.tile_height()}
+  {
+    if (!m_isometric &&
+        map.get_orientation() != map::orientation::orthogonal) {
+      throw step_exception{"render_list > Unsupported map orientation!"};
+    }
+
+    for (const auto& layer : map.layers()) {
+      add_layer(layer);
+    }
+
+    m_order.resize(m_items.size());
+    for (std::size_t i = 0; i < m_order.size(); ++i) {
+      m_order[i] = i;
+    }
+    full_sort();
+  }
+
+  /**
+   * @brief Moves a tile object.
+   *
+   * @details The order of the list isn't updated until `update()` is called.
+   *
+   * @param id the ID of the object.
+   * @param x the new x-coordinate of the object.
+   * @param y the new y-coordinate of the object.
+   *
+   * @throws step_exception if there is no tile object with the ID in the list.
+   *
+   * @since 0.3.0
+   */
+  void move(int id, double x, double y)
+  {
+    const auto it = m_objects.find(id);
+    if (it == m_objects.end()) {
+      throw step_exception{"render_list > Unknown object ID!"};
+    }
+
+    auto& item = m_items[it->second];
+    const auto depth = object_depth(x, y);
+    if (depth != item.depth) {
+      item.depth = depth;
+      ++m_moved;
+    }
+  }
+
+  /**
+   * @brief Restores the depth order of the list.
+   *
+   * @since 0.3.0
+   */
+  void update()
+  {
+    if (m_moved == 0) {
+      return;
+    }
+
+    if (m_moved * full_sort_ratio > m_order.size()) {
+      full_sort();
+    } else {
+      insertion_sort();
+    }
+    m_moved = 0;
+  }
+
+  /**
+   * @brief Invokes a callable for each item in the list, in draw order.
+   *
+   * @tparam Lambda the type of the lambda object.
+   *
+   * @param lambda the lambda that takes one argument, `const render_item&`.
+   *
+   * @since 0.3.0
+   */
+  template <typename Lambda>
+  void each(Lambda&& lambda) const
+  {
+    for (const auto index : m_order) {
+      lambda(m_items[index]);
+    }
+  }
+
+  /**
+   * @brief Returns the item at a position in the draw order.
+   *
+   * @param index the position of the item in the draw order.
+   *
+   * @return the item that is drawn at the position.
+   *
+   * @throws std::out_of_range if the index is out of bounds.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto at(std::size_t index) const -> const render_item&
+  {
+    return m_items[m_order.at(index)];
+  }
+
+  /**
+   * @brief Returns the amount of items in the list.
+   *
+   * @return the amount of items in the list.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto size() const noexcept -> std::size_t
+  {
+    return m_items.size();
+  }
+
+  /**
+   * @brief Returns the amount of objects moved since the last update.
+   *
+   * @return the amount of objects that have changed depths.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto pending() const noexcept -> std::size_t
+  {
+    return m_moved;
+  }
+
+ private:
+  // Above one moved object in eight, a full sort is cheaper than insertion
+  static constexpr std::size_t full_sort_ratio = 8;
+
+  std::vector<render_item> m_items;  // In layer order
+  std::vector<std::size_t> m_order;  // Indices of items, in draw order
+  std::unordered_map<int, std::size_t> m_objects;
+  std::size_t m_moved{};
+  bool m_isometric{};
+  int m_tileHeight{};
+
+  [[nodiscard]] auto object_depth(double x, double y) const noexcept -> double
+  {
+    return m_isometric ? x + y : y;
+  }
+
+  [[nodiscard]] auto before(std::size_t a, std::size_t b) const noexcept
+      -> bool
+  {
+    const auto& lhs = m_items[a];
+    const auto& rhs = m_items[b];
+    return lhs.depth < rhs.depth || (lhs.depth == rhs.depth && a < b);
+  }
+
+  void full_sort()
+  {
+    std::sort(m_order.begin(), m_order.end(), [this](auto a, auto b) {
+      return before(a, b);
+    });
+  }
+
+  void insertion_sort()
+  {
+    for (std::size_t i = 1; i < m_order.size(); ++i) {
+      const auto index = m_order[i];
+      auto j = i;
+      for (; j > 0 && before(index, m_order[j - 1]); --j) {
+        m_order[j] = m_order[j - 1];
+      }
+      m_order[j] = index;
+    }
+  }
+
+  void add_layer(const layer& layer)
+  {
+    if (const auto* tiles = layer.try_as<tile_layer>()) {
+      add_tiles(layer.id(), *tiles);
+    } else if (const auto* objects = layer.try_as<object_group>()) {
+      if (objects->get_draw_order() == object_group::draw_order::top_down) {
+        add_objects(layer.id(), *objects);
+      }
+    } else if (const auto* group = layer.try_as<step::group>()) {
+      group->each([this](const step::layer& child) { add_layer(child); });
+    }
+  }
+
+  void add_tiles(int id, const tile_layer& tiles)
+  {
+    std::vector<int> lines;
+    tiles.each([&](int col, int row, global_id gid) {
+      if (gid.get() != 0) {
+        lines.push_back(m_isometric ? col + row : row);
+      }
+    });
+
+    std::sort(lines.begin(), lines.end());
+    lines.erase(std::unique(lines.begin(), lines.end()), lines.end());
+
+    // The bottom of a row, or the bottom corner of a diagonal
+    const auto offset = m_isometric ? 2 : 1;
+    for (const auto line : lines) {
+      m_items.push_back(render_item{render_item::kind::tiles,
+                                    id,
+                                    line,
+                                    static_cast<double>(line + offset) *
+                                        m_tileHeight});
+    }
+  }
+
+  void add_objects(int id, const object_group& objects)
+  {
+    for (const auto& object : objects.objects()) {
+      if (object.try_as<global_id>()) {
+        m_objects.emplace(object.id(), m_items.size());
+        m_items.push_back(render_item{render_item::kind::object,
+                                      id,
+                                      object.id(),
+                                      object_depth(object.x(), object.y())});
+      }
+    }
+  }
+};
+
+}  // namespace step
+
+#endif  // STEP_RENDER_LIST_HEADER
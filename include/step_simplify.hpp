@@ -0,0 +1,398 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_simplify.hpp
+ *
+ * @brief Provides polyline and polygon simplification.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_SIMPLIFY_HEADER
+#define STEP_SIMPLIFY_HEADER
+
+#include <algorithm>   // max
+#include <cmath>       // abs
+#include <cstddef>     // size_t
+#include <functional>  // greater
+#include <queue>       // priority_queue
+#include <string>      // string
+#include <utility>     // pair
+#include <vector>      // vector
+
+#include "step_api.hpp"
+#include "step_geometry.hpp"
+#include "step_point.hpp"
+#include "step_types.hpp"
+
+namespace step {
+
+/**
+ * @enum simplification_method
+ *
+ * @brief Provides values for the supported line simplification algorithms.
+ *
+ * @var simplification_method::douglas_peucker
+ * Ramer-Douglas-Peucker, the tolerance is the maximum distance between the
+ * simplified line and the removed points.
+ *
+ * @var simplification_method::visvalingam_whyatt
+ * Visvalingam-Whyatt, points are removed while the smallest triangle formed
+ * by a point and its neighbours has an area less than the squared tolerance.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_simplify.hpp
+ */
+enum class simplification_method { douglas_peucker, visvalingam_whyatt };
+
+/**
+ * @struct simplification_rule
+ *
+ * @brief Describes which polygon and polyline objects to simplify when a map
+ * is loaded, and how.
+ *
+ * @details Empty group names and object types match anything. The first rule
+ * that matches an object is used.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_simplify.hpp
+ */
+struct simplification_rule final {
+  std::string group;
+  std::string type;
+  double tolerance{};
+  simplification_method method{simplification_method::douglas_peucker};
+};
+
+namespace detail {
+
+[[nodiscard]] inline auto segment_distance_squared(const point& p,
+                                                   const point& a,
+                                                   const point& b) noexcept
+    -> double
+{
+  return distance_squared(p, closest_on_segment(p, a, b));
+}
+
+/**
+ * @brief Marks the points of a line that are kept by the Douglas-Peucker
+ * algorithm.
+ *
+ * @details An explicit stack is used, since very long lines would otherwise
+ * recurse too deep.
+ *
+ * @param points the points of the line.
+ * @param first the index of the first point of the range.
+ * @param last the index of the last point of the range.
+ * @param toleranceSq the squared tolerance.
+ * @param keep the flags that are set for the kept points.
+ *
+ * @since 0.3.0
+ */
+inline void douglas_peucker(const std::vector<point>& points,
+                            std::size_t first,
+                            std::size_t last,
+                            double toleranceSq,
+                            std::vector<bool>& keep)
+{
+  keep[first] = true;
+  keep[last] = true;
+
+  std::vector<std::pair<std::size_t, std::size_t>> ranges;
+  ranges.emplace_back(first, last);
+
+  while (!ranges.empty()) {
+    const auto [begin, end] = ranges.back();
+    ranges.pop_back();
+
+    auto farthest = begin;
+    auto farthestSq = toleranceSq;
+    for (auto i = begin + 1; i < end; ++i) {
+      const auto distanceSq =
+          segment_distance_squared(points[i], points[begin], points[end]);
+      if (distanceSq > farthestSq) {
+        farthest = i;
+        farthestSq = distanceSq;
+      }
+    }
+
+    if (farthest != begin) {
+      keep[farthest] = true;
+      ranges.emplace_back(begin, farthest);
+      ranges.emplace_back(farthest, end);
+    }
+  }
+}
+
+[[nodiscard]] inline auto simplify_douglas_peucker(
+    const std::vector<point>& points,
+    bool closed,
+    double tolerance) -> std::vector<point>
+{
+  const auto toleranceSq = tolerance * tolerance;
+  const auto count = points.size();
+
+  std::vector<bool> keep(count + 1, false);
+  if (closed) {
+    // The ring is split at the point farthest away from the first point
+    auto ring = points;
+    ring.push_back(points.front());
+
+    std::size_t split = 1;
+    for (std::size_t i = 2; i < count; ++i) {
+      if (distance_squared(ring[0], ring[i]) >
+          distance_squared(ring[0], ring[split])) {
+        split = i;
+      }
+    }
+
+    douglas_peucker(ring, 0, split, toleranceSq, keep);
+    douglas_peucker(ring, split, count, toleranceSq, keep);
+
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+      kept += keep[i] ? 1 : 0;
+    }
+
+    if (kept < 3) {
+      // Keep the polygon from collapsing into a line
+      const auto distance_of = [&](std::size_t i) noexcept {
+        return segment_distance_squared(ring[i], ring[0], ring[split]);
+      };
+
+      auto farthest = split == 1 ? std::size_t{2} : std::size_t{1};
+      for (std::size_t i = 1; i < count; ++i) {
+        if (i != split && distance_of(i) > distance_of(farthest)) {
+          farthest = i;
+        }
+      }
+      keep[farthest] = true;
+    }
+  } else {
+    douglas_peucker(points, 0, count - 1, toleranceSq, keep);
+  }
+
+  std::vector<point> result;
+  for (std::size_t i = 0; i < count; ++i) {
+    if (keep[i]) {
+      result.push_back(points[i]);
+    }
+  }
+  return result;
+}
+
+[[nodiscard]] inline auto simplify_visvalingam_whyatt(
+    const std::vector<point>& points,
+    bool closed,
+    double tolerance) -> std::vector<point>
+{
+  const auto threshold = tolerance * tolerance;
+  const auto count = points.size();
+
+  std::vector<std::size_t> prev(count);
+  std::vector<std::size_t> next(count);
+  std::vector<double> areas(count, 0);
+  std::vector<bool> removed(count, false);
+
+  for (std::size_t i = 0; i < count; ++i) {
+    prev[i] = (i + count - 1) % count;
+    next[i] = (i + 1) % count;
+  }
+
+  const auto is_endpoint = [&](std::size_t i) noexcept {
+    return !closed && (i == 0 || i == count - 1);
+  };
+
+  const auto area_of = [&](std::size_t i) noexcept {
+    return std::abs(cross(points[prev[i]], points[i], points[next[i]])) / 2.0;
+  };
+
+  // Entries are (area, index), outdated entries are skipped when popped
+  using entry = std::pair<double, std::size_t>;
+  std::priority_queue<entry, std::vector<entry>, std::greater<>> queue;
+
+  for (std::size_t i = 0; i < count; ++i) {
+    if (!is_endpoint(i)) {
+      areas[i] = area_of(i);
+      queue.emplace(areas[i], i);
+    }
+  }
+
+  auto remaining = count;
+  const std::size_t minimum = closed ? 3 : 2;
+
+  while (!queue.empty() && remaining > minimum) {
+    const auto [area, index] = queue.top();
+    if (area >= threshold) {
+      break;
+    }
+
+    queue.pop();
+    if (removed[index] || area != areas[index]) {
+      continue;
+    }
+
+    removed[index] = true;
+    --remaining;
+
+    const auto before = prev[index];
+    const auto after = next[index];
+    next[before] = after;
+    prev[after] = before;
+
+    // The effective area of a point never decreases as neighbours are removed
+    for (const auto neighbour : {before, after}) {
+      if (!is_endpoint(neighbour)) {
+        areas[neighbour] = std::max(area_of(neighbour), area);
+        queue.emplace(areas[neighbour], neighbour);
+      }
+    }
+  }
+
+  std::vector<point> result;
+  result.reserve(remaining);
+  for (std::size_t i = 0; i < count; ++i) {
+    if (!removed[i]) {
+      result.push_back(points[i]);
+    }
+  }
+  return result;
+}
+
+}  // namespace detail
+
+/**
+ * @brief Returns a simplified copy of a polyline or polygon.
+ *
+ * @details The end points of polylines are always kept, and polygons always
+ * keep at least three points.
+ *
+ * @param points the points of the line.
+ * @param closed `true` if the points form a polygon; `false` otherwise.
+ * @param tolerance the tolerance of the simplification, nothing is removed if
+ * it isn't positive.
+ * @param method the algorithm that will be used.
+ *
+ * @return the kept points, in their original order.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] inline auto simplify(
+    const std::vector<point>& points,
+    bool closed,
+    double tolerance,
+    simplification_method method = simplification_method::douglas_peucker)
+    -> std::vector<point>
+{
+  if (tolerance <= 0 || points.size() <= (closed ? 3u : 2u)) {
+    return points;
+  }
+
+  if (method == simplification_method::douglas_peucker) {
+    return detail::simplify_douglas_peucker(points, closed, tolerance);
+  } else {
+    return detail::simplify_visvalingam_whyatt(points, closed, tolerance);
+  }
+}
+
+namespace detail {
+
+[[nodiscard]] inline auto find_rule(
+    const std::vector<simplification_rule>& rules,
+    const std::string& group,
+    const std::string& type) noexcept -> const simplification_rule*
+{
+  for (const auto& rule : rules) {
+    if ((rule.group.empty() || rule.group == group) &&
+        (rule.type.empty() || rule.type == type)) {
+      return &rule;
+    }
+  }
+  return nullptr;
+}
+
+inline void simplify_points(json& json,
+                            bool closed,
+                            const simplification_rule& rule)
+{
+  std::vector<point> points;
+  points.reserve(json.size());
+  for (const auto& value : json) {
+    points.emplace_back(value);
+  }
+
+  auto simplified = json::array();
+  for (const auto& p : simplify(points, closed, rule.tolerance, rule.method)) {
+    simplified.push_back({{"x", p.x()}, {"y", p.y()}});
+  }
+  json = std::move(simplified);
+}
+
+/**
+ * @brief Simplifies the polygon and polyline objects in JSON layers, before
+ * they are parsed.
+ *
+ * @param layers the JSON array of layers, nested groups are visited as well.
+ * @param rules the rules that select the simplified objects.
+ *
+ * @since 0.3.0
+ */
+inline void simplify_layers(json& layers,
+                            const std::vector<simplification_rule>& rules)
+{
+  for (auto& layer : layers) {
+    const auto type = layer.at("type").get<std::string>();
+    if (type == "group") {
+      simplify_layers(layer.at("layers"), rules);
+    } else if (type == "objectgroup") {
+      const auto name = layer.at("name").get<std::string>();
+      for (auto& object : layer.at("objects")) {
+        const auto* rule =
+            find_rule(rules, name, object.at("type").get<std::string>());
+        if (!rule) {
+          continue;
+        }
+
+        if (const auto it = object.find("polygon"); it != object.end()) {
+          simplify_points(*it, true, *rule);
+        } else if (const auto it = object.find("polyline");
+                   it != object.end()) {
+          simplify_points(*it, false, *rule);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace detail
+}  // namespace step
+
+#endif  // STEP_SIMPLIFY_HEADER
@@ -0,0 +1,393 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_summed_area.hpp
+ *
+ * @brief Provides the `summed_area_table` class.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_SUMMED_AREA_HEADER
+#define STEP_SUMMED_AREA_HEADER
+
+#include <algorithm>  // min, max
+#include <cstddef>    // size_t
+#include <cstdint>    // uint32_t
+#include <utility>    // move
+#include <vector>     // vector
+
+#include "step_api.hpp"
+#include "step_tile_mask.hpp"
+#include "step_utils.hpp"
+
+namespace step {
+
+/**
+ * @class summed_area_table
+ *
+ * @brief Counts the set tiles of a mask in any rectangle in constant time.
+ *
+ * @details The table stores, for each tile, the amount of set tiles above
+ * and to the left of it, including the tile itself. The amount of set tiles
+ * in a rectangle is then obtained from the four corners of the rectangle.
+ * Masks are usually derived from a map, e.g. with `make_tile_mask()` for a
+ * single layer and a predicate such as "is solid" or "is water".
+ *
+ * Changing a tile affects every entry below and to the right of it, so
+ * changes are recorded and included in queries until there are enough of
+ * them to be worth applying, at which point the table is accumulated again
+ * from the top-most changed row. Queries are therefore constant time plus at
+ * most `max_pending` recorded changes.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_summed_area.hpp
+ */
+class summed_area_table final {
+ public:
+  /**
+   * @brief The maximum amount of changes that are recorded before they are
+   * applied to the table.
+   *
+   * @since 0.3.0
+   */
+  static constexpr std::size_t max_pending = 64;
+
+  /**
+   * @brief Creates a table from a mask.
+   *
+   * @param mask the mask that provides the tiles that will be counted.
+   * @param threads the maximum amount of threads used to build the table,
+   * zero means the amount of hardware threads.
+   *
+   * @since 0.3.0
+   */
+  explicit summed_area_table(tile_mask mask, int threads = 0)
+      : m_mask{std::move(mask)},
+        m_stride{static_cast<std::size_t>(m_mask.width()) + 1},
+        m_sums(m_stride * (static_cast<std::size_t>(m_mask.height()) + 1))
+  {
+    accumulate(0, threads);
+  }
+
+  /**
+   * @brief Changes whether or not a tile is set.
+   *
+   * @details This function has no effect if the position is out-of-bounds or
+   * if the tile already has the specified state.
+   *
+   * @param col the column of the tile.
+   * @param row the row of the tile.
+   * @param value `true` if the tile should be set; `false` otherwise.
+   *
+   * @since 0.3.0
+   */
+  void set(int col, int row, bool value = true)
+  {
+    if (!m_mask.contains(col, row) || m_mask.test(col, row) == value) {
+      return;
+    }
+
+    m_mask.set(col, row, value);
+    m_pending.push_back({col, row, value ? 1 : -1});
+
+    if (m_pending.size() > max_pending) {
+      flush();
+    }
+  }
+
+  /**
+   * @brief Applies all recorded changes to the table.
+   *
+   * @details This is done automatically when there are too many recorded
+   * changes, but may be called after a batch of changes to make the following
+   * queries as fast as possible.
+   *
+   * @param threads the maximum amount of threads, zero means the amount of
+   * hardware threads.
+   *
+   * @since 0.3.0
+   */
+  void flush(int threads = 1)
+  {
+    if (m_pending.empty()) {
+      return;
+    }
+
+    auto first = m_mask.height();
+    for (const auto& change : m_pending) {
+      first = std::min(first, change.row);
+    }
+
+    m_pending.clear();
+    accumulate(first, threads);
+  }
+
+  /**
+   * @brief Returns the amount of set tiles in a rectangle.
+   *
+   * @details The rectangle is clipped to the mask, so tiles outside of the
+   * mask are treated as unset.
+   *
+   * @param col the left-most column of the rectangle.
+   * @param row the top-most row of the rectangle.
+   * @param width the amount of columns in the rectangle.
+   * @param height the amount of rows in the rectangle.
+   *
+   * @return the amount of set tiles in the rectangle.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto count(int col, int row, int width, int height) const
+      noexcept -> int
+  {
+    const auto left = std::max(col, 0);
+    const auto top = std::max(row, 0);
+    const auto right = std::min(col + width, m_mask.width());
+    const auto bottom = std::min(row + height, m_mask.height());
+    if (left >= right || top >= bottom) {
+      return 0;
+    }
+
+    auto result = static_cast<int>(sum(right, bottom) - sum(left, bottom) -
+                                   sum(right, top) + sum(left, top));
+
+    for (const auto& change : m_pending) {
+      if (change.col >= left && change.col < right && change.row >= top &&
+          change.row < bottom) {
+        result += change.delta;
+      }
+    }
+
+    return result;
+  }
+
+  /**
+   * @brief Returns the amount of set tiles in the whole mask.
+   *
+   * @return the amount of set tiles.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto count() const noexcept -> int
+  {
+    return count(0, 0, m_mask.width(), m_mask.height());
+  }
+
+  /**
+   * @brief Indicates whether or not any tile in a rectangle is set.
+   *
+   * @param col the left-most column of the rectangle.
+   * @param row the top-most row of the rectangle.
+   * @param width the amount of columns in the rectangle.
+   * @param height the amount of rows in the rectangle.
+   *
+   * @return `true` if at least one tile in the rectangle is set; `false`
+   * otherwise.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto any(int col, int row, int width, int height) const
+      noexcept -> bool
+  {
+    return count(col, row, width, height) != 0;
+  }
+
+  /**
+   * @brief Indicates whether or not no tile in a rectangle is set.
+   *
+   * @details This is useful to check if an area is free, e.g. when placing
+   * buildings or spawning entities on a mask of blocked tiles.
+   *
+   * @param col the left-most column of the rectangle.
+   * @param row the top-most row of the rectangle.
+   * @param width the amount of columns in the rectangle.
+   * @param height the amount of rows in the rectangle.
+   *
+   * @return `true` if no tile in the rectangle is set; `false` otherwise.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto none(int col, int row, int width, int height) const
+      noexcept -> bool
+  {
+    return count(col, row, width, height) == 0;
+  }
+
+  /**
+   * @brief Indicates whether or not every tile in a rectangle is set.
+   *
+   * @details Rectangles that aren't completely inside of the mask are never
+   * fully set.
+   *
+   * @param col the left-most column of the rectangle.
+   * @param row the top-most row of the rectangle.
+   * @param width the amount of columns in the rectangle.
+   * @param height the amount of rows in the rectangle.
+   *
+   * @return `true` if every tile in the rectangle is set; `false` otherwise.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto all(int col, int row, int width, int height) const
+      noexcept -> bool
+  {
+    if (col < 0 || row < 0 || width <= 0 || height <= 0 ||
+        col + width > m_mask.width() || row + height > m_mask.height()) {
+      return false;
+    }
+    return count(col, row, width, height) == width * height;
+  }
+
+  /**
+   * @brief Indicates whether or not a tile is set.
+   *
+   * @param col the column of the tile.
+   * @param row the row of the tile.
+   *
+   * @return `true` if the tile is set; `false` otherwise.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto test(int col, int row) const noexcept -> bool
+  {
+    return m_mask.test(col, row);
+  }
+
+  /**
+   * @brief Returns the amount of recorded changes that haven't been applied.
+   *
+   * @return the amount of recorded changes.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto pending() const noexcept -> std::size_t
+  {
+    return m_pending.size();
+  }
+
+  /**
+   * @brief Returns the mask that the table counts the tiles of.
+   *
+   * @return the mask, including all changes.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto mask() const noexcept -> const tile_mask&
+  {
+    return m_mask;
+  }
+
+  /**
+   * @brief Returns the width of the table.
+   *
+   * @return the amount of columns.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto width() const noexcept -> int
+  {
+    return m_mask.width();
+  }
+
+  /**
+   * @brief Returns the height of the table.
+   *
+   * @return the amount of rows.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto height() const noexcept -> int
+  {
+    return m_mask.height();
+  }
+
+ private:
+  static constexpr int column_block = 256;
+
+  struct change final {
+    int col{};
+    int row{};
+    int delta{};
+  };
+
+  tile_mask m_mask;
+  std::size_t m_stride{};
+  std::vector<std::uint32_t> m_sums;
+  std::vector<change> m_pending;
+
+  /// Returns the amount of set tiles in the columns [0, col) and rows [0, row).
+  [[nodiscard]] auto sum(int col, int row) const noexcept -> std::uint32_t
+  {
+    return m_sums[static_cast<std::size_t>(row) * m_stride +
+                  static_cast<std::size_t>(col)];
+  }
+
+  /// Recomputes the sums of the rows starting at the specified row.
+  void accumulate(int first, int threads)
+  {
+    const auto width = m_mask.width();
+    const auto height = m_mask.height();
+    auto* sums = m_sums.data();
+
+    // Running sums within each row
+    detail::parallel_for(first, height, threads, [&](int row) {
+      auto* out = sums + (static_cast<std::size_t>(row) + 1) * m_stride;
+      const auto* words = m_mask.row_data(row);
+
+      std::uint32_t running = 0;
+      for (auto col = 0; col < width; ++col) {
+        const auto word = words[col / tile_mask::word_bits];
+        const auto bit = static_cast<unsigned>(col % tile_mask::word_bits);
+        running += static_cast<std::uint32_t>((word >> bit) & 1u);
+        out[col + 1] = running;
+      }
+    });
+
+    // Sums down each column, in blocks of columns to keep rows contiguous
+    const auto blocks = (width + column_block - 1) / column_block;
+    detail::parallel_for(0, blocks, threads, [&](int block) {
+      const auto begin = static_cast<std::size_t>(block) * column_block + 1;
+      const auto end = std::min(begin + column_block,
+                                static_cast<std::size_t>(width) + 1);
+      for (auto row = first + 1; row <= height; ++row) {
+        auto* out = sums + static_cast<std::size_t>(row) * m_stride;
+        const auto* above = out - m_stride;
+        for (auto i = begin; i < end; ++i) {
+          out[i] += above[i];
+        }
+      }
+    });
+  }
+};
+
+}  // namespace step
+
+#endif  // STEP_SUMMED_AREA_HEADER
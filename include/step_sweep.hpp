@@ -0,0 +1,998 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_sweep.hpp
+ *
+ * @brief Provides continuous collision detection of moving boxes and circles
+ * against the tiles of a map.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_SWEEP_HEADER
+#define STEP_SWEEP_HEADER
+
+#include <algorithm>    // min, max, sort
+#include <cmath>        // abs, sqrt, cos, sin
+#include <cstddef>      // size_t
+#include <cstdint>      // uint32_t
+#include <limits>       // numeric_limits
+#include <optional>     // optional, nullopt
+#include <string_view>  // string_view
+#include <utility>      // move, swap
+#include <vector>       // vector
+
+#include "step_api.hpp"
+#include "step_layer.hpp"
+#include "step_map.hpp"
+#include "step_object.hpp"
+#include "step_object_group.hpp"
+#include "step_point.hpp"
+#include "step_rect.hpp"
+#include "step_tile_mask.hpp"
+#include "step_tile_pos.hpp"
+#include "step_types.hpp"
+#include "step_utils.hpp"
+
+namespace step {
+
+/**
+ * @struct sweep_hit
+ *
+ * @brief A simple data container for the first contact of a moving shape
+ * with the tiles of a map.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_sweep.hpp
+ */
+struct sweep_hit final {
+  tile_pos tile;  ///< The position of the tile that was hit.
+  point normal;   ///< The unit normal of the contact, pointing away from the
+                  ///< tile.
+  double time{};  ///< The fraction of the motion before the contact, in
+                  ///< [0, 1].
+};
+
+/**
+ * @struct collider_properties
+ *
+ * @brief A simple data container for the names of the tile properties that
+ * describe the collision geometry of tiles.
+ *
+ * @details The slope properties are `int` or `float` properties that specify
+ * the height of the solid surface at the left and right edges of the tile, as
+ * a fraction of the tile height. A missing slope property defaults to 1, so a
+ * tile with `slope_left = 0` is a ramp that rises to the right.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_sweep.hpp
+ */
+struct collider_properties final {
+  std::string_view solid{"solid"};         ///< Boolean, the tile is solid.
+  std::string_view oneWay{"one_way"};      ///< Boolean, the tile can only be
+                                           ///< hit from above.
+  std::string_view slopeLeft{"slope_left"};    ///< Surface height at the left.
+  std::string_view slopeRight{"slope_right"};  ///< Surface height at the
+                                               ///< right.
+};
+
+namespace detail {
+
+/**
+ * @brief The largest penetration, in pixels, that is still treated as a
+ * contact instead of an overlap by the sweep functions.
+ *
+ * @details Shapes that are resolved to the time of impact end up touching
+ * the geometry they hit, and rounding errors may leave them slightly inside
+ * it. The tolerance makes sure that such shapes keep colliding.
+ *
+ * @since 0.3.0
+ */
+inline constexpr double sweep_skin = 1e-6;
+
+/**
+ * @struct sweep_contact
+ *
+ * @brief The time of impact and normal of a swept shape and a convex polygon.
+ *
+ * @since 0.3.0
+ */
+struct sweep_contact final {
+  double time{};
+  point normal;
+};
+
+/**
+ * @brief Computes the convex hull of a set of points.
+ *
+ * @param points the points, the order is irrelevant.
+ *
+ * @return the points of the hull in counter-clockwise order, in a y-down
+ * coordinate system; empty if the points don't span an area.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] inline auto convex_hull(std::vector<point> points)
+    -> std::vector<point>
+{
+  std::sort(points.begin(), points.end(), [](const point& a, const point& b) {
+    return a.x() < b.x() || (a.x() == b.x() && a.y() < b.y());
+  });
+
+  const auto cross = [](const point& o, const point& a, const point& b) {
+    return (a.x() - o.x()) * (b.y() - o.y()) -
+           (a.y() - o.y()) * (b.x() - o.x());
+  };
+
+  // Andrew's monotone chain
+  std::vector<point> hull(points.size() * 2);
+  std::size_t k = 0;
+  for (const auto& p : points) {
+    while (k >= 2 && cross(hull[k - 2], hull[k - 1], p) <= 0) {
+      --k;
+    }
+    hull[k++] = p;
+  }
+
+  const auto lower = k + 1;
+  for (auto i = points.size(); i-- > 1;) {
+    const auto& p = points[i - 1];
+    while (k >= lower && cross(hull[k - 2], hull[k - 1], p) <= 0) {
+      --k;
+    }
+    hull[k++] = p;
+  }
+
+  hull.resize(k > 0 ? k - 1 : 0);
+  if (hull.size() < 3) {
+    hull.clear();
+  }
+  return hull;
+}
+
+/**
+ * @brief Returns the outward unit normal of an edge of a convex polygon.
+ *
+ * @param a the first point of the edge.
+ * @param b the second point of the edge.
+ * @param inside a point inside the polygon.
+ *
+ * @return the outward normal; (0, 0) if the edge is degenerate.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] inline auto outward_normal(const point& a,
+                                         const point& b,
+                                         const point& inside) noexcept -> point
+{
+  const auto ex = b.x() - a.x();
+  const auto ey = b.y() - a.y();
+  const auto length = std::sqrt(ex * ex + ey * ey);
+  if (length == 0) {
+    return {};
+  }
+
+  auto nx = ey / length;
+  auto ny = -ex / length;
+  if (nx * (inside.x() - a.x()) + ny * (inside.y() - a.y()) > 0) {
+    nx = -nx;
+    ny = -ny;
+  }
+  return {nx, ny};
+}
+
+[[nodiscard]] inline auto centroid(const point* points,
+                                   std::size_t count) noexcept -> point
+{
+  double x = 0;
+  double y = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    x += points[i].x();
+    y += points[i].y();
+  }
+  return {x / static_cast<double>(count), y / static_cast<double>(count)};
+}
+
+/**
+ * @brief Sweeps an axis-aligned box against a convex polygon.
+ *
+ * @details This is the separating axis test extended to moving shapes, i.e.
+ * the time interval of overlap is computed for each candidate axis, and the
+ * shapes collide if the intervals have a common part. The axis with the
+ * latest entry time provides the contact normal.
+ *
+ * @param box the box at the start of the motion.
+ * @param motion the translation of the box.
+ * @param points the points of the convex polygon.
+ * @param count the amount of points in the polygon.
+ *
+ * @return the contact; an empty optional if the box doesn't hit the polygon,
+ * or if it overlaps the polygon at the start of the motion.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] inline auto sweep_box_convex(const rect& box,
+                                           const point& motion,
+                                           const point* points,
+                                           std::size_t count) noexcept
+    -> std::optional<sweep_contact>
+{
+  const auto halfWidth = box.width / 2.0;
+  const auto halfHeight = box.height / 2.0;
+  const auto cx = box.x + halfWidth;
+  const auto cy = box.y + halfHeight;
+
+  auto enter = -std::numeric_limits<double>::infinity();
+  auto exit = std::numeric_limits<double>::infinity();
+  double enterSpeed = 0;
+  point normal;
+
+  const auto overlaps = [&](double ax, double ay) noexcept {
+    auto min = std::numeric_limits<double>::infinity();
+    auto max = -min;
+    for (std::size_t i = 0; i < count; ++i) {
+      const auto p = points[i].x() * ax + points[i].y() * ay;
+      min = std::min(min, p);
+      max = std::max(max, p);
+    }
+
+    const auto center = cx * ax + cy * ay;
+    const auto extent = halfWidth * std::abs(ax) + halfHeight * std::abs(ay);
+    const auto boxMin = center - extent;
+    const auto boxMax = center + extent;
+
+    const auto speed = motion.x() * ax + motion.y() * ay;
+    if (std::abs(speed) < 1e-12) {
+      return boxMax > min + sweep_skin && boxMin < max - sweep_skin;
+    }
+
+    const auto entry = (speed > 0 ? min - boxMax : max - boxMin) / speed;
+    const auto leave = (speed > 0 ? max - boxMin : min - boxMax) / speed;
+    if (entry > enter) {
+      enter = entry;
+      enterSpeed = std::abs(speed);
+      normal = speed > 0 ? point{-ax, -ay} : point{ax, ay};
+    }
+    exit = std::min(exit, leave);
+    return enter < exit;
+  };
+
+  if (!overlaps(1, 0) || !overlaps(0, 1)) {
+    return std::nullopt;
+  }
+
+  const auto inside = centroid(points, count);
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto n =
+        outward_normal(points[i], points[(i + 1) % count], inside);
+    if ((n.x() != 0 || n.y() != 0) && !overlaps(n.x(), n.y())) {
+      return std::nullopt;
+    }
+  }
+
+  if (enter > 1) {
+    return std::nullopt;
+  }
+
+  if (enter < 0) {
+    // Only accept shapes that are resting against the polygon
+    if (enter * enterSpeed < -sweep_skin) {
+      return std::nullopt;
+    }
+    enter = 0;
+  }
+
+  return sweep_contact{enter, normal};
+}
+
+/**
+ * @brief Sweeps a circle against a convex polygon.
+ *
+ * @details The center of the circle is traced as a ray against the polygon
+ * expanded by the radius, i.e. against the edges pushed outwards by the
+ * radius and against circles at the corners.
+ *
+ * @param center the center of the circle at the start of the motion.
+ * @param radius the radius of the circle.
+ * @param motion the translation of the circle.
+ * @param points the points of the convex polygon.
+ * @param count the amount of points in the polygon.
+ *
+ * @return the contact; an empty optional if the circle doesn't hit the
+ * polygon, or if it overlaps the polygon at the start of the motion.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] inline auto sweep_circle_convex(const point& center,
+                                              double radius,
+                                              const point& motion,
+                                              const point* points,
+                                              std::size_t count) noexcept
+    -> std::optional<sweep_contact>
+{
+  const auto inside = centroid(points, count);
+
+  auto outside = false;
+  auto distance = std::numeric_limits<double>::infinity();
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto& a = points[i];
+    const auto& b = points[(i + 1) % count];
+    const auto n = outward_normal(a, b, inside);
+    if ((center.x() - a.x()) * n.x() + (center.y() - a.y()) * n.y() > 0) {
+      outside = true;
+    }
+
+    const auto ex = b.x() - a.x();
+    const auto ey = b.y() - a.y();
+    const auto lengthSq = ex * ex + ey * ey;
+    auto s = 0.0;
+    if (lengthSq > 0) {
+      s = ((center.x() - a.x()) * ex + (center.y() - a.y()) * ey) / lengthSq;
+      s = std::min(std::max(s, 0.0), 1.0);
+    }
+    distance = std::min(distance,
+                        std::hypot(center.x() - a.x() - s * ex,
+                                   center.y() - a.y() - s * ey));
+  }
+
+  if (!outside || distance < radius - sweep_skin) {
+    return std::nullopt;
+  }
+
+  std::optional<sweep_contact> best;
+  const auto consider = [&](double time, const point& normal) noexcept {
+    time = std::max(time, 0.0);
+    if (time <= 1 && (!best || time < best->time)) {
+      best = sweep_contact{time, normal};
+    }
+  };
+
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto& a = points[i];
+    const auto& b = points[(i + 1) % count];
+    const auto n = outward_normal(a, b, inside);
+
+    // The edge, pushed outwards by the radius
+    const auto speed = motion.x() * n.x() + motion.y() * n.y();
+    if (speed < 0) {
+      const auto gap =
+          (center.x() - a.x()) * n.x() + (center.y() - a.y()) * n.y();
+      const auto time = (radius - gap) / speed;
+
+      const auto qx = center.x() + time * motion.x() - a.x();
+      const auto qy = center.y() + time * motion.y() - a.y();
+      const auto ex = b.x() - a.x();
+      const auto ey = b.y() - a.y();
+      const auto s = (qx * ex + qy * ey) / (ex * ex + ey * ey);
+      if (s >= 0 && s <= 1) {
+        consider(time, n);
+      }
+    }
+
+    // The corner circle
+    const auto dx = center.x() - a.x();
+    const auto dy = center.y() - a.y();
+    const auto qa = motion.x() * motion.x() + motion.y() * motion.y();
+    const auto qb = 2 * (motion.x() * dx + motion.y() * dy);
+    const auto qc = dx * dx + dy * dy - radius * radius;
+    const auto discriminant = qb * qb - 4 * qa * qc;
+    if (qa > 0 && qb < 0 && discriminant >= 0) {
+      const auto time = (-qb - std::sqrt(discriminant)) / (2 * qa);
+      const auto hx = dx + std::max(time, 0.0) * motion.x();
+      const auto hy = dy + std::max(time, 0.0) * motion.y();
+      const auto length = std::hypot(hx, hy);
+      if (length > 0) {
+        consider(time, point{hx / length, hy / length});
+      }
+    }
+  }
+
+  return best;
+}
+
+}  // namespace detail
+
+/**
+ * @class tile_collider
+ *
+ * @brief Provides continuous collision detection of moving boxes and circles
+ * against the tiles of a map.
+ *
+ * @details The collision geometry of a tile is determined by its properties,
+ * see `collider_properties`. Tiles that are neither solid, one-way nor
+ * sloped are ignored. The geometry of a colliding tile is, in order of
+ * precedence,
+ * - a slope, if the tile has any of the slope properties.
+ * - the objects of the tile, i.e. the contents of `tile::object_group()`.
+ * Rectangles, ellipses and polygons are supported, where ellipses are
+ * approximated by polygons and polygons are replaced by their convex hulls.
+ * - the whole tile.
+ *
+ * One-way tiles, i.e. platforms, are only hit by shapes that approach them
+ * from above, so shapes can jump through them from below and walk through
+ * them sideways. The geometry of tiles is flipped along with the tiles.
+ *
+ * The geometry of the tiles is stored once per GID, and each cell only stores
+ * the GID of its tile. If several tile layers provide geometry for a cell,
+ * the geometry of the top-most layer is used, except that whole solid tiles
+ * take precedence.
+ *
+ * The sweep functions only visit the cells that are covered by the moving
+ * shape at some point during the motion, row by row. Shapes that overlap the
+ * geometry at the start of the motion don't collide with it, which lets
+ * shapes that got stuck move out again. Coordinates are in pixels, for
+ * orthogonal maps.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_sweep.hpp
+ */
+class tile_collider final {
+ public:
+  /**
+   * @brief Creates a collider from the tile layers of a map.
+   *
+   * @param map the map that provides the tile layers and tilesets.
+   * @param names the names of the tile properties that describe the tiles.
+   *
+   * @throws step_exception if any tile layer uses Base64 encoded data.
+   *
+   * @since 0.3.0
+   */
+  explicit tile_collider(const map& map, const collider_properties& names = {})
+      : m_width{map.width()},
+        m_height{map.height()},
+        m_tileWidth{static_cast<double>(map.tile_width())},
+        m_tileHeight{static_cast<double>(map.tile_height())},
+        m_cells(static_cast<std::size_t>(std::max(m_width, 0)) *
+                    static_cast<std::size_t>(std::max(m_height, 0)),
+                0u)
+  {
+    m_entries = detail::make_gid_table<entry>(
+        map, [&](const tileset& tileset, const tile& tile) {
+          return make_entry(tileset, tile, names);
+        });
+
+    for (const auto& layer : map.layers()) {
+      detail::each_tile_layer(
+          layer, [&](const step::layer&, const tile_layer& tiles) {
+            tiles.each([&](int col, int row, global_id gid) {
+              if (!contains(col, row) || !has_geometry(gid.get())) {
+                return;
+              }
+
+              auto& cell = m_cells[cell_index(col, row)];
+              if (!is_whole(cell)) {
+                cell = gid.get();
+              }
+            });
+          });
+    }
+  }
+
+  /**
+   * @brief Changes the tile of a cell.
+   *
+   * @details This function has no effect if the position is out-of-bounds.
+   *
+   * @param col the column of the cell.
+   * @param row the row of the cell.
+   * @param gid the GID of the tile, including any flip flags; zero clears the
+   * cell.
+   *
+   * @since 0.3.0
+   */
+  void set_tile(int col, int row, global_id gid) noexcept
+  {
+    if (contains(col, row)) {
+      m_cells[cell_index(col, row)] = has_geometry(gid.get()) ? gid.get() : 0u;
+    }
+  }
+
+  /**
+   * @brief Returns the GID of the tile that provides the geometry of a cell.
+   *
+   * @param col the column of the cell.
+   * @param row the row of the cell.
+   *
+   * @return the GID of the tile, including any flip flags; zero if the cell
+   * doesn't have any geometry or if the position is out-of-bounds.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto gid_at(int col, int row) const noexcept -> global_id
+  {
+    return global_id{contains(col, row) ? m_cells[cell_index(col, row)] : 0u};
+  }
+
+  /**
+   * @brief Sweeps an axis-aligned box through the map.
+   *
+   * @param box the box at the start of the motion, in pixels.
+   * @param motion the translation of the box, in pixels.
+   *
+   * @return the first contact; an empty optional if the box can move freely.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto sweep_box(const rect& box, const point& motion) const
+      -> std::optional<sweep_hit>
+  {
+    const auto bottom = box.y + box.height;
+    return sweep(box, motion, bottom, [&](const point* points, std::size_t n) {
+      return detail::sweep_box_convex(box, motion, points, n);
+    });
+  }
+
+  /**
+   * @brief Sweeps a circle through the map.
+   *
+   * @param center the center of the circle at the start of the motion, in
+   * pixels.
+   * @param radius the radius of the circle, in pixels.
+   * @param motion the translation of the circle, in pixels.
+   *
+   * @return the first contact; an empty optional if the circle can move
+   * freely.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto sweep_circle(const point& center,
+                                  double radius,
+                                  const point& motion) const
+      -> std::optional<sweep_hit>
+  {
+    const rect bounds{center.x() - radius,
+                      center.y() - radius,
+                      radius * 2,
+                      radius * 2};
+    const auto bottom = center.y() + radius;
+    return sweep(
+        bounds, motion, bottom, [&](const point* points, std::size_t n) {
+          return detail::sweep_circle_convex(
+              center, radius, motion, points, n);
+        });
+  }
+
+  /**
+   * @brief Indicates whether or not a position is within the map.
+   *
+   * @param col the column of the cell.
+   * @param row the row of the cell.
+   *
+   * @return `true` if the position is within the map; `false` otherwise.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto contains(int col, int row) const noexcept -> bool
+  {
+    return col >= 0 && row >= 0 && col < m_width && row < m_height;
+  }
+
+  /**
+   * @brief Returns the width of the map.
+   *
+   * @return the amount of columns.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto width() const noexcept -> int
+  {
+    return m_width;
+  }
+
+  /**
+   * @brief Returns the height of the map.
+   *
+   * @return the amount of rows.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto height() const noexcept -> int
+  {
+    return m_height;
+  }
+
+ private:
+  static constexpr int ellipse_segments = 16;
+  static constexpr double pi = 3.14159265358979323846;
+
+  /// The convex pieces of a tile, with coordinates in a local frame that is
+  /// flipped along with the tile and placed relative to the cell.
+  struct entry final {
+    std::uint32_t first{};
+    std::uint32_t count{};
+    double frameWidth{};
+    double frameHeight{};
+    point offset;
+    bool oneWay{};
+    bool whole{};
+  };
+
+  /// A range of points in the point pool.
+  struct piece final {
+    std::uint32_t first{};
+    std::uint32_t count{};
+  };
+
+  int m_width{};
+  int m_height{};
+  double m_tileWidth{};
+  double m_tileHeight{};
+  double m_margin{};
+  std::size_t m_maxPoints{};
+  std::vector<unsigned> m_cells;
+  std::vector<entry> m_entries;
+  std::vector<piece> m_pieces;
+  std::vector<point> m_points;
+
+  [[nodiscard]] auto cell_index(int col, int row) const noexcept
+      -> std::size_t
+  {
+    return static_cast<std::size_t>(row) * static_cast<std::size_t>(m_width) +
+           static_cast<std::size_t>(col);
+  }
+
+  [[nodiscard]] auto entry_of(unsigned gid) const noexcept -> const entry*
+  {
+    const auto index =
+        static_cast<std::size_t>(strip_flip_bits(global_id{gid}).get());
+    if (index < m_entries.size() && m_entries[index].count != 0) {
+      return &m_entries[index];
+    } else {
+      return nullptr;
+    }
+  }
+
+  [[nodiscard]] auto has_geometry(unsigned gid) const noexcept -> bool
+  {
+    return entry_of(gid) != nullptr;
+  }
+
+  [[nodiscard]] auto is_whole(unsigned gid) const noexcept -> bool
+  {
+    const auto* e = entry_of(gid);
+    return e && e->whole;
+  }
+
+  [[nodiscard]] static auto number(const tile& tile, std::string_view name)
+      -> std::optional<double>
+  {
+    const auto* props = tile.get_properties();
+    if (!props || !props->has(name)) {
+      return std::nullopt;
+    }
+
+    const auto& property = props->get(name);
+    if (property.is<int>()) {
+      return static_cast<double>(property.get<int>());
+    } else if (property.is<float>()) {
+      return static_cast<double>(property.get<float>());
+    } else {
+      return std::nullopt;
+    }
+  }
+
+  [[nodiscard]] static auto flag(const tile& tile, std::string_view name)
+      -> bool
+  {
+    const auto* props = tile.get_properties();
+    return props && props->is(name, true);
+  }
+
+  void add_piece(std::vector<point> points, entry& e)
+  {
+    // Drop repeated points, e.g. the collapsed corners of triangular slopes
+    points.erase(std::unique(points.begin(),
+                             points.end(),
+                             [](const point& a, const point& b) {
+                               return a.x() == b.x() && a.y() == b.y();
+                             }),
+                 points.end());
+    if (points.size() > 1 && points.front().x() == points.back().x() &&
+        points.front().y() == points.back().y()) {
+      points.pop_back();
+    }
+    if (points.size() < 3) {
+      return;
+    }
+
+    if (e.count == 0) {
+      e.first = static_cast<std::uint32_t>(m_pieces.size());
+    }
+    ++e.count;
+
+    m_pieces.push_back({static_cast<std::uint32_t>(m_points.size()),
+                        static_cast<std::uint32_t>(points.size())});
+    m_maxPoints = std::max(m_maxPoints, points.size());
+
+    // Geometry outside of the cell is found by widening the visited region,
+    // which must account for every way that the tile can be flipped
+    for (const auto& p : points) {
+      for (const auto q : {p.x(),
+                           p.y(),
+                           e.frameWidth - p.x(),
+                           e.frameHeight - p.y()}) {
+        const auto x = e.offset.x() + q;
+        const auto y = e.offset.y() + q;
+        m_margin = std::max(
+            {m_margin, -x, -y, x - m_tileWidth, y - m_tileHeight});
+      }
+      m_points.push_back(p);
+    }
+  }
+
+  void add_object(const object& object, entry& e)
+  {
+    if (object.is_point() || !object.visible()) {
+      return;
+    }
+
+    std::vector<point> points;
+    if (const auto* polygon = object.try_as<step::polygon>()) {
+      points = polygon->points;
+    } else if (object.is_ellipse()) {
+      const auto rx = object.width() / 2.0;
+      const auto ry = object.height() / 2.0;
+      for (auto i = 0; i < ellipse_segments; ++i) {
+        const auto angle = 2 * pi * i / ellipse_segments;
+        points.emplace_back(rx + rx * std::cos(angle),
+                            ry + ry * std::sin(angle));
+      }
+    } else if (!object.has<polyline>() && !object.has<text>() &&
+               !object.has<template_object>() && !object.has<global_id>()) {
+      points = {point{0, 0},
+                point{object.width(), 0},
+                point{object.width(), object.height()},
+                point{0, object.height()}};
+    } else {
+      return;
+    }
+
+    // Objects are rotated clockwise around their position
+    const auto radians = object.rotation() * pi / 180.0;
+    const auto cos = std::cos(radians);
+    const auto sin = std::sin(radians);
+    for (auto& p : points) {
+      p = point{object.x() + p.x() * cos - p.y() * sin,
+                object.y() + p.x() * sin + p.y() * cos};
+    }
+
+    add_piece(detail::convex_hull(std::move(points)), e);
+  }
+
+  [[nodiscard]] auto make_entry(const tileset& tileset,
+                                const tile& tile,
+                                const collider_properties& names) -> entry
+  {
+    entry e;
+    e.oneWay = flag(tile, names.oneWay);
+    if (!e.oneWay && !flag(tile, names.solid)) {
+      return e;
+    }
+
+    const auto left = number(tile, names.slopeLeft);
+    const auto right = number(tile, names.slopeRight);
+    if (left || right) {
+      e.frameWidth = m_tileWidth;
+      e.frameHeight = m_tileHeight;
+
+      const auto w = m_tileWidth;
+      const auto h = m_tileHeight;
+      const auto l = std::min(std::max(left.value_or(1), 0.0), 1.0);
+      const auto r = std::min(std::max(right.value_or(1), 0.0), 1.0);
+      add_piece({point{0, h * (1 - l)},
+                 point{w, h * (1 - r)},
+                 point{w, h},
+                 point{0, h}},
+                e);
+      return e;
+    }
+
+    if (const auto* layer = tile.object_group()) {
+      if (const auto* group = layer->try_as<object_group>()) {
+        // Tile images are aligned to the bottom-left corner of cells
+        e.frameWidth = tileset.tile_width();
+        e.frameHeight = tileset.tile_height();
+        e.offset = point{0, m_tileHeight - tileset.tile_height()};
+        if (const auto& tileOffset = tileset.get_tile_offset()) {
+          e.offset = point{e.offset.x() + tileOffset->x(),
+                           e.offset.y() + tileOffset->y()};
+        }
+
+        for (const auto& object : group->objects()) {
+          add_object(object, e);
+        }
+        if (e.count != 0) {
+          return e;
+        }
+        e.offset = point{};
+      }
+    }
+
+    e.frameWidth = m_tileWidth;
+    e.frameHeight = m_tileHeight;
+    e.whole = true;
+    add_piece({point{0, 0},
+               point{m_tileWidth, 0},
+               point{m_tileWidth, m_tileHeight},
+               point{0, m_tileHeight}},
+              e);
+    return e;
+  }
+
+  /// Places the pieces of the tile in a cell into world space.
+  template <typename Lambda>
+  void each_piece(int col,
+                  int row,
+                  unsigned gid,
+                  std::vector<point>& points,
+                  Lambda&& lambda) const
+  {
+    const auto* e = entry_of(gid);
+    if (!e) {
+      return;
+    }
+
+    const auto diagonal = (gid & detail::flipped_diagonally_bit) != 0;
+    const auto horizontal = (gid & detail::flipped_horizontally_bit) != 0;
+    const auto vertical = (gid & detail::flipped_vertically_bit) != 0;
+    const auto frameWidth = diagonal ? e->frameHeight : e->frameWidth;
+    const auto frameHeight = diagonal ? e->frameWidth : e->frameHeight;
+    const auto x = col * m_tileWidth + e->offset.x();
+    const auto y = row * m_tileHeight + e->offset.y();
+
+    for (auto i = e->first; i < e->first + e->count; ++i) {
+      const auto& p = m_pieces[i];
+
+      points.clear();
+      for (auto j = p.first; j < p.first + p.count; ++j) {
+        auto px = m_points[j].x();
+        auto py = m_points[j].y();
+        if (diagonal) {
+          std::swap(px, py);
+        }
+        if (horizontal) {
+          px = frameWidth - px;
+        }
+        if (vertical) {
+          py = frameHeight - py;
+        }
+        points.emplace_back(x + px, y + py);
+      }
+
+      lambda(points.data(), points.size(), e->oneWay);
+    }
+  }
+
+  template <typename Lambda>
+  [[nodiscard]] auto sweep(const rect& bounds,
+                           const point& motion,
+                           double bottom,
+                           Lambda&& test) const -> std::optional<sweep_hit>
+  {
+    std::optional<sweep_hit> best;
+    if (m_width <= 0 || m_height <= 0) {
+      return best;
+    }
+
+    std::vector<point> points;
+    points.reserve(m_maxPoints);
+
+    const auto minX = bounds.x - m_margin;
+    const auto minY = bounds.y - m_margin;
+    const auto maxX = bounds.x + bounds.width + m_margin;
+    const auto maxY = bounds.y + bounds.height + m_margin;
+    const auto dx = motion.x();
+    const auto dy = motion.y();
+
+    const auto firstRow = std::max(
+        detail::floor_to_int(std::min(minY, minY + dy) / m_tileHeight), 0);
+    const auto lastRow = std::min(
+        detail::floor_to_int(std::max(maxY, maxY + dy) / m_tileHeight),
+        m_height - 1);
+
+    for (auto row = firstRow; row <= lastRow; ++row) {
+      // The part of the motion where the shape overlaps the row
+      const auto top = row * m_tileHeight;
+      const auto under = top + m_tileHeight;
+      auto from = 0.0;
+      auto to = 1.0;
+      if (dy != 0) {
+        auto a = (top - maxY) / dy;
+        auto b = (under - minY) / dy;
+        if (a > b) {
+          std::swap(a, b);
+        }
+        from = std::max(from, a);
+        to = std::min(to, b);
+      } else if (maxY < top || minY > under) {
+        continue;
+      }
+
+      if (from > to) {
+        continue;
+      }
+
+      const auto left = minX + std::min(from * dx, to * dx);
+      const auto right = maxX + std::max(from * dx, to * dx);
+      const auto firstCol =
+          std::max(detail::floor_to_int(left / m_tileWidth), 0);
+      const auto lastCol =
+          std::min(detail::floor_to_int(right / m_tileWidth), m_width - 1);
+
+      for (auto col = firstCol; col <= lastCol; ++col) {
+        const auto gid = m_cells[cell_index(col, row)];
+        if (gid == 0) {
+          continue;
+        }
+
+        each_piece(col, row, gid, points, [&](const point* data,
+                                              std::size_t n,
+                                              bool oneWay) {
+          const auto contact = test(data, n);
+          if (!contact || (best && contact->time >= best->time)) {
+            return;
+          }
+
+          if (oneWay && !hits_from_above(*contact, bottom, data, n)) {
+            return;
+          }
+
+          best = sweep_hit{{col, row}, contact->normal, contact->time};
+        });
+      }
+    }
+
+    return best;
+  }
+
+  [[nodiscard]] static auto hits_from_above(
+      const detail::sweep_contact& contact,
+      double bottom,
+      const point* points,
+      std::size_t count) noexcept -> bool
+  {
+    if (contact.normal.y() >= 0) {
+      return false;
+    }
+
+    auto top = std::numeric_limits<double>::infinity();
+    for (std::size_t i = 0; i < count; ++i) {
+      top = std::min(top, points[i].y());
+    }
+    return bottom <= top + detail::sweep_skin;
+  }
+};
+
+}  // namespace step
+
+#endif  // STEP_SWEEP_HEADER
@@ -70,6 +70,7 @@ class tile_layer final {
   {
     detail::safe_bind(json, "compression", m_compression);
     detail::safe_bind(json, "encoding", m_encoding);
+    detail::safe_bind(json, "width", m_width);
 
     if (json.contains("chunks")) {
       m_chunks = detail::fill<std::vector<chunk>>(json, "chunks");
@@ -137,11 +138,51 @@ class tile_layer final {
     return m_chunks;
   }
 
+  /**
+   * @brief Iterates over all of the tiles stored in the tile layer.
+   *
+   * @details Both the tile data of finite maps and the chunks of infinite maps
+   * are visited. The supplied GIDs are the raw values, i.e. they may have
+   * flip flags set.
+   *
+   * @tparam Lambda the type of the lambda object.
+   *
+   * @param lambda the lambda that takes three arguments, `int col`, `int row`
+   * and `global_id gid`.
+   *
+   * @throws step_exception if the tile data is Base64 encoded.
+   *
+   * @since 0.3.0
+   */
+  template <typename Lambda>
+  void each(Lambda&& lambda) const
+  {
+    if (m_data && m_width > 0) {
+      const auto& gids = m_data->as_gid();
+      const auto size = static_cast<int>(gids.size());
+      for (int index = 0; index < size; ++index) {
+        lambda(index % m_width, index / m_width, gids[index]);
+      }
+    }
+
+    for (const auto& chunk : m_chunks) {
+      const auto& gids = chunk.data().as_gid();
+      const auto size = static_cast<int>(gids.size());
+      const auto width = chunk.width();
+      for (int index = 0; index < size && width > 0; ++index) {
+        const auto col = chunk.x() + index % width;
+        const auto row = chunk.y() + index / width;
+        lambda(col, row, gids[index]);
+      }
+    }
+  }
+
  private:
   encoding m_encoding{encoding::csv};
   compression m_compression{compression::none};
   std::unique_ptr<detail::data> m_data;
   std::vector<chunk> m_chunks;
+  int m_width{0};
 };
 
 NLOHMANN_JSON_SERIALIZE_ENUM(tile_layer::compression,
@@ -0,0 +1,487 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_tile_mask.hpp
+ *
+ * @brief Provides the `tile_mask` class, a packed bit grid derived from the
+ * tile layers of a map.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_TILE_MASK_HEADER
+#define STEP_TILE_MASK_HEADER
+
+#include <algorithm>    // min
+#include <bitset>       // bitset
+#include <cstddef>      // size_t
+#include <cstdint>      // uint64_t
+#include <string>       // string
+#include <string_view>  // string_view
+#include <type_traits>  // enable_if_t, is_invocable_r_v
+#include <vector>       // vector
+
+#include "step_api.hpp"
+#include "step_layer.hpp"
+#include "step_map.hpp"
+#include "step_tile.hpp"
+#include "step_tile_pos.hpp"
+#include "step_tileset.hpp"
+#include "step_types.hpp"
+
+namespace step {
+namespace detail {
+
+/**
+ * @brief Returns the amount of GIDs used by the tilesets of a map, i.e. one
+ * more than the largest GID.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] inline auto gid_count(const map& map) -> std::size_t
+{
+  std::size_t count = 1;
+  for (const auto& tileset : map.tilesets()) {
+    const auto end = static_cast<std::size_t>(tileset->first_gid().get()) +
+                     static_cast<std::size_t>(tileset->tile_count());
+    if (end > count) {
+      count = end;
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief Creates a table that is indexed by GIDs, with values obtained from
+ * the tiles of the tilesets of a map.
+ *
+ * @details GIDs that don't have an associated `tile` instance, i.e. tiles
+ * without any custom data, are mapped to the fallback value.
+ *
+ * @tparam T the type of the values in the table.
+ * @tparam Lambda the type of the lambda object.
+ *
+ * @param map the map that provides the tilesets.
+ * @param lambda the lambda that takes two arguments, `const tileset&` and
+ * `const tile&`, and returns the value associated with the tile.
+ * @param fallback the value used for tiles without custom data.
+ *
+ * @return a table indexed by GIDs, without flip flags.
+ *
+ * @since 0.3.0
+ */
+template <typename T, typename Lambda>
+[[nodiscard]] auto make_gid_table(const map& map,
+                                  Lambda&& lambda,
+                                  const T& fallback = {}) -> std::vector<T>
+{
+  std::vector<T> table(gid_count(map), fallback);
+  for (const auto& tileset : map.tilesets()) {
+    const auto first = tileset->first_gid().get();
+    for (const auto& tile : tileset->tiles()) {
+      const auto gid = static_cast<std::size_t>(first + tile.id().get());
+      if (gid < table.size()) {
+        table[gid] = lambda(*tileset, tile);
+      }
+    }
+  }
+  return table;
+}
+
+}  // namespace detail
+
+/**
+ * @class tile_mask
+ *
+ * @brief A packed grid of bits, with one bit per tile in a map.
+ *
+ * @details Tile masks are used to represent derived information about the
+ * tiles of a map, e.g. whether or not each tile is solid. The bits of each row
+ * are stored in 64-bit words, so that algorithms can process a whole word of
+ * tiles at a time. Use `make_tile_mask()` to create a mask from the tile
+ * layers of a map.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_tile_mask.hpp
+ */
+class tile_mask final {
+ public:
+  using word_type = std::uint64_t;
+
+  /**
+   * @brief The amount of bits in each word.
+   *
+   * @since 0.3.0
+   */
+  static constexpr int word_bits = 64;
+
+  tile_mask() noexcept = default;
+
+  /**
+   * @brief Creates a mask with all bits cleared.
+   *
+   * @param width the amount of columns in the mask.
+   * @param height the amount of rows in the mask.
+   *
+   * @since 0.3.0
+   */
+  tile_mask(int width, int height)
+      : m_width{width > 0 ? width : 0},
+        m_height{height > 0 ? height : 0},
+        m_wordsPerRow{(m_width + word_bits - 1) / word_bits},
+        m_words(static_cast<std::size_t>(m_wordsPerRow) *
+                static_cast<std::size_t>(m_height))
+  {}
+
+  /**
+   * @brief Sets the bit associated with a tile.
+   *
+   * @details This function has no effect if the position is out-of-bounds.
+   *
+   * @param col the column of the tile.
+   * @param row the row of the tile.
+   * @param value the new value of the bit.
+   *
+   * @since 0.3.0
+   */
+  void set(int col, int row, bool value = true) noexcept
+  {
+    if (contains(col, row)) {
+      auto& word = m_words[word_index(col, row)];
+      const auto bit = word_type{1} << static_cast<unsigned>(col % word_bits);
+      if (value) {
+        word |= bit;
+      } else {
+        word &= ~bit;
+      }
+    }
+  }
+
+  /**
+   * @brief Sets the bits that are set in another mask.
+   *
+   * @details This is useful for combining masks created from different
+   * layers. Bits of the other mask that are outside of this mask are ignored.
+   *
+   * @param other the mask that provides the bits that will be set.
+   *
+   * @return the mask itself.
+   *
+   * @since 0.3.0
+   */
+  auto operator|=(const tile_mask& other) noexcept -> tile_mask&
+  {
+    const auto rows = std::min(m_height, other.m_height);
+    const auto words = std::min(m_wordsPerRow, other.m_wordsPerRow);
+    for (auto row = 0; row < rows; ++row) {
+      auto* dst = m_words.data() + word_index(0, row);
+      const auto* src = other.row_data(row);
+      for (auto i = 0; i < words; ++i) {
+        dst[i] |= src[i];
+      }
+
+      // Clear the bits that are beyond the last column of this mask
+      if (words == m_wordsPerRow && m_width % word_bits != 0) {
+        const auto used = static_cast<unsigned>(m_width % word_bits);
+        dst[words - 1] &= (word_type{1} << used) - 1;
+      }
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Clears all of the bits in the mask.
+   *
+   * @since 0.3.0
+   */
+  void clear() noexcept
+  {
+    for (auto& word : m_words) {
+      word = 0;
+    }
+  }
+
+  /**
+   * @brief Returns the bit associated with a tile.
+   *
+   * @param col the column of the tile.
+   * @param row the row of the tile.
+   *
+   * @return the bit associated with the tile; `false` if the position is
+   * out-of-bounds.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto test(int col, int row) const noexcept -> bool
+  {
+    if (contains(col, row)) {
+      const auto word = m_words[word_index(col, row)];
+      return (word >> static_cast<unsigned>(col % word_bits)) & 1u;
+    } else {
+      return false;
+    }
+  }
+
+  /**
+   * @copydoc test(int, int)
+   *
+   * @param pos the position of the tile.
+   */
+  [[nodiscard]] auto test(tile_pos pos) const noexcept -> bool
+  {
+    return test(pos.col, pos.row);
+  }
+
+  /**
+   * @brief Indicates whether or not a position is within the mask.
+   *
+   * @param col the column of the position.
+   * @param row the row of the position.
+   *
+   * @return `true` if the position is within the mask; `false` otherwise.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto contains(int col, int row) const noexcept -> bool
+  {
+    return col >= 0 && row >= 0 && col < m_width && row < m_height;
+  }
+
+  /**
+   * @brief Returns the amount of set bits in the mask.
+   *
+   * @return the amount of set bits in the mask.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto count() const noexcept -> int
+  {
+    std::size_t result = 0;
+    for (const auto word : m_words) {
+      result += std::bitset<word_bits>{word}.count();
+    }
+    return static_cast<int>(result);
+  }
+
+  /**
+   * @brief Returns a pointer to the words that store a row of the mask.
+   *
+   * @details The bit associated with column `c` is bit `c % 64` in the word at
+   * index `c / 64`. Unused bits in the last word of a row are always cleared.
+   *
+   * @param row the index of the row, must be in the range [0, height).
+   *
+   * @return a pointer to the first word of the row.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto row_data(int row) const noexcept -> const word_type*
+  {
+    return m_words.data() + static_cast<std::size_t>(row) * m_wordsPerRow;
+  }
+
+  /**
+   * @brief Returns the amount of words that are used to store each row.
+   *
+   * @return the amount of words per row.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto words_per_row() const noexcept -> int
+  {
+    return m_wordsPerRow;
+  }
+
+  /**
+   * @brief Returns the amount of columns in the mask.
+   *
+   * @return the amount of columns in the mask.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto width() const noexcept -> int
+  {
+    return m_width;
+  }
+
+  /**
+   * @brief Returns the amount of rows in the mask.
+   *
+   * @return the amount of rows in the mask.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto height() const noexcept -> int
+  {
+    return m_height;
+  }
+
+ private:
+  int m_width{0};
+  int m_height{0};
+  int m_wordsPerRow{0};
+  std::vector<word_type> m_words;
+
+  [[nodiscard]] auto word_index(int col, int row) const noexcept
+      -> std::size_t
+  {
+    return static_cast<std::size_t>(row) * m_wordsPerRow +
+           static_cast<std::size_t>(col / word_bits);
+  }
+};
+
+namespace detail {
+
+template <typename Predicate>
+inline constexpr bool is_tile_predicate =
+    std::is_invocable_r_v<bool, Predicate, const tile&>;
+
+template <typename Predicate>
+[[nodiscard]] auto make_tile_predicate_table(const map& map,
+                                             Predicate&& predicate)
+    -> std::vector<unsigned char>
+{
+  return make_gid_table<unsigned char>(
+      map, [&](const tileset&, const tile& tile) -> unsigned char {
+        return predicate(tile) ? 1 : 0;
+      });
+}
+
+inline void fill_tile_mask(tile_mask& mask,
+                           const layer& layer,
+                           const std::vector<unsigned char>& table)
+{
+  each_tile_layer(layer, [&](const step::layer&, const tile_layer& tiles) {
+    tiles.each([&](int col, int row, global_id gid) {
+      const auto index = static_cast<std::size_t>(strip_flip_bits(gid).get());
+      if (index < table.size() && table[index]) {
+        mask.set(col, row);
+      }
+    });
+  });
+}
+
+}  // namespace detail
+
+/**
+ * @brief Creates a mask of the tiles in the tile layers of a map that satisfy
+ * a predicate.
+ *
+ * @details A bit is set if the tile at that position in any of the tile
+ * layers, including layers nested in groups, satisfies the predicate. The
+ * predicate is evaluated once for each tile with custom data in the tilesets
+ * of the map, tiles without custom data never satisfy the predicate. The mask
+ * covers the bounds of the map, tiles outside of the map are ignored.
+ *
+ * @tparam Predicate the type of the predicate.
+ *
+ * @param map the map that provides the tile layers and tilesets.
+ * @param predicate the predicate that takes a single `const tile&` argument.
+ *
+ * @return a mask of the tiles that satisfy the predicate.
+ *
+ * @throws step_exception if any tile layer uses Base64 encoded data.
+ *
+ * @since 0.3.0
+ */
+template <typename Predicate,
+          typename = std::enable_if_t<detail::is_tile_predicate<Predicate>>>
+[[nodiscard]] auto make_tile_mask(const map& map, Predicate&& predicate)
+    -> tile_mask
+{
+  const auto table = detail::make_tile_predicate_table(map, predicate);
+
+  tile_mask mask{map.width(), map.height()};
+  for (const auto& layer : map.layers()) {
+    detail::fill_tile_mask(mask, layer, table);
+  }
+
+  return mask;
+}
+
+/**
+ * @brief Creates a mask of the tiles in a single layer that satisfy a
+ * predicate.
+ *
+ * @details If the layer is a group, all of the tile layers in the group are
+ * included.
+ *
+ * @tparam Predicate the type of the predicate.
+ *
+ * @param map the map that provides the tilesets.
+ * @param layer the layer that provides the tiles.
+ * @param predicate the predicate that takes a single `const tile&` argument.
+ *
+ * @return a mask of the tiles that satisfy the predicate.
+ *
+ * @throws step_exception if the layer uses Base64 encoded data.
+ *
+ * @since 0.3.0
+ */
+template <typename Predicate,
+          typename = std::enable_if_t<detail::is_tile_predicate<Predicate>>>
+[[nodiscard]] auto make_tile_mask(const map& map,
+                                  const layer& layer,
+                                  Predicate&& predicate) -> tile_mask
+{
+  const auto table = detail::make_tile_predicate_table(map, predicate);
+
+  tile_mask mask{map.width(), map.height()};
+  detail::fill_tile_mask(mask, layer, table);
+
+  return mask;
+}
+
+/**
+ * @brief Creates a mask of the tiles in the tile layers of a map that have a
+ * boolean property with the value `true`.
+ *
+ * @param map the map that provides the tile layers and tilesets.
+ * @param property the name of the boolean tile property, e.g. `"solid"`.
+ *
+ * @return a mask of the tiles that have the property set to `true`.
+ *
+ * @throws step_exception if any tile layer uses Base64 encoded data.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] inline auto make_tile_mask(const map& map,
+                                         std::string_view property)
+    -> tile_mask
+{
+  return make_tile_mask(map, [property](const tile& tile) {
+    const auto* props = tile.get_properties();
+    return props && props->is(property, true);
+  });
+}
+
+}  // namespace step
+
+#endif  // STEP_TILE_MASK_HEADER
@@ -0,0 +1,92 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_tile_pos.hpp
+ *
+ * @brief Provides the `tile_pos` struct.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_TILE_POS_HEADER
+#define STEP_TILE_POS_HEADER
+
+#include "step_api.hpp"
+
+namespace step {
+
+/**
+ * @struct tile_pos
+ *
+ * @brief A simple data container for the column and row of a tile in a map.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_tile_pos.hpp
+ */
+struct tile_pos final {
+  int col{};
+  int row{};
+};
+
+/**
+ * @brief Indicates whether or not two tile positions are equal.
+ *
+ * @param lhs the left-hand side tile position.
+ * @param rhs the right-hand side tile position.
+ *
+ * @return `true` if the tile positions are equal; `false` otherwise.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] constexpr auto operator==(const tile_pos& lhs,
+                                        const tile_pos& rhs) noexcept -> bool
+{
+  return lhs.col == rhs.col && lhs.row == rhs.row;
+}
+
+/**
+ * @brief Indicates whether or not two tile positions aren't equal.
+ *
+ * @param lhs the left-hand side tile position.
+ * @param rhs the right-hand side tile position.
+ *
+ * @return `true` if the tile positions aren't equal; `false` otherwise.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] constexpr auto operator!=(const tile_pos& lhs,
+                                        const tile_pos& rhs) noexcept -> bool
+{
+  return !(lhs == rhs);
+}
+
+}  // namespace step
+
+#endif  // STEP_TILE_POS_HEADER
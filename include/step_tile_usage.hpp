@@ -0,0 +1,337 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_tile_usage.hpp
+ *
+ * @brief Provides a map-wide histogram of tile usage.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_TILE_USAGE_HEADER
+#define STEP_TILE_USAGE_HEADER
+
+#include <algorithm>  // max, min, stable_sort
+#include <cstddef>    // size_t
+#include <cstdint>    // uint64_t
+#include <stdexcept>  // out_of_range
+#include <thread>     // thread
+#include <utility>    // pair
+#include <vector>     // vector
+
+#include "step_api.hpp"
+#include "step_data.hpp"
+#include "step_exception.hpp"
+#include "step_layer.hpp"
+#include "step_map.hpp"
+#include "step_object.hpp"
+#include "step_tile_layer.hpp"
+#include "step_tile_mask.hpp"
+#include "step_types.hpp"
+#include "step_utils.hpp"
+
+namespace step {
+
+/**
+ * @class tile_histogram
+ *
+ * @brief Counts how many times each tile of a map is used.
+ *
+ * @details The tile data and chunks of all tile layers, including nested
+ * layers, and all tile objects are counted. Flip flags are ignored. Tiles that
+ * are only shown as frames of the animation of a used tile aren't counted, but
+ * are still considered to be used.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_tile_usage.hpp
+ */
+class tile_histogram final {
+ public:
+  /**
+   * @brief Counts the tiles of a map.
+   *
+   * @details The tile data is split into slices that are counted in
+   * parallel, with one histogram per thread that are summed afterwards.
+   *
+   * @param map the map that will be analyzed.
+   * @param threads the maximum amount of threads, zero means the amount of
+   * hardware threads.
+   *
+   * @throws step_exception if a tile layer has Base64 encoded data.
+   *
+   * @since 0.3.0
+   */
+  explicit tile_histogram(const map& map, int threads = 0)
+      : m_counts(detail::gid_count(map), 0)
+  {
+    std::vector<const global_id*> slices;
+    std::vector<std::size_t> sizes;
+    const auto add = [&](const detail::data& data) {
+      const auto& gids = data.as_gid();
+      for (std::size_t i = 0; i < gids.size(); i += slice_size) {
+        slices.push_back(gids.data() + i);
+        sizes.push_back(std::min(slice_size, gids.size() - i));
+      }
+    };
+
+    for (const auto& layer : map.layers()) {
+      detail::each_tile_layer(layer, [&](const step::layer&,
+                                         const tile_layer& tiles) {
+        if (const auto* data = tiles.data()) {
+          add(*data);
+        }
+        for (const auto& chunk : tiles.chunks()) {
+          add(chunk.data());
+        }
+      });
+
+      detail::each_object_group(layer, [&](const step::layer&,
+                                           const object_group& group) {
+        for (const auto& object : group.objects()) {
+          if (const auto* gid = object.try_as<global_id>()) {
+            increment(m_counts, *gid);
+          }
+        }
+      });
+    }
+
+    if (threads <= 0) {
+      threads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    const auto partitions = std::max(
+        std::min(threads, static_cast<int>(slices.size())), 1);
+
+    std::vector<std::vector<std::uint64_t>> partial(
+        static_cast<std::size_t>(partitions));
+    detail::parallel_for(0, partitions, partitions, [&](int partition) {
+      auto& counts = partial[static_cast<std::size_t>(partition)];
+      counts.assign(m_counts.size(), 0);
+      for (auto i = static_cast<std::size_t>(partition); i < slices.size();
+           i += static_cast<std::size_t>(partitions)) {
+        for (std::size_t j = 0; j < sizes[i]; ++j) {
+          increment(counts, slices[i][j]);
+        }
+      }
+    });
+
+    for (const auto& counts : partial) {
+      for (std::size_t gid = 0; gid < counts.size(); ++gid) {
+        m_counts[gid] += counts[gid];
+      }
+    }
+
+    m_counts[0] = 0;
+    mark_used(map);
+  }
+
+  /**
+   * @brief Returns the amount of times that a tile is used.
+   *
+   * @param gid the GID of the tile, flip flags are ignored.
+   *
+   * @return the amount of cells and tile objects that use the tile.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto count(global_id gid) const noexcept -> std::uint64_t
+  {
+    const auto index = static_cast<std::size_t>(strip_flip_bits(gid).get());
+    return index < m_counts.size() ? m_counts[index] : 0;
+  }
+
+  /**
+   * @brief Indicates whether or not a tile is used.
+   *
+   * @param gid the GID of the tile, flip flags are ignored.
+   *
+   * @return `true` if the tile is used directly, or as a frame of the
+   * animation of a used tile; `false` otherwise.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto used(global_id gid) const noexcept -> bool
+  {
+    const auto index = static_cast<std::size_t>(strip_flip_bits(gid).get());
+    return index < m_used.size() && m_used[index];
+  }
+
+  /**
+   * @brief Returns the total amount of tile uses.
+   *
+   * @return the sum of the counts of all tiles.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto total() const noexcept -> std::uint64_t
+  {
+    std::uint64_t sum = 0;
+    for (const auto count : m_counts) {
+      sum += count;
+    }
+    return sum;
+  }
+
+  /**
+   * @brief Returns the local IDs of the used tiles of a tileset.
+   *
+   * @param tileset the index of the tileset in the map.
+   *
+   * @return the local IDs of the used tiles, in ascending order.
+   *
+   * @throws std::out_of_range if the tileset index is invalid.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto used_tiles(std::size_t tileset) const -> std::vector<int>
+  {
+    return filter(tileset, true);
+  }
+
+  /**
+   * @brief Returns the local IDs of the unused tiles of a tileset.
+   *
+   * @param tileset the index of the tileset in the map.
+   *
+   * @return the local IDs of the unused tiles, in ascending order.
+   *
+   * @throws std::out_of_range if the tileset index is invalid.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto unused_tiles(std::size_t tileset) const
+      -> std::vector<int>
+  {
+    return filter(tileset, false);
+  }
+
+  /**
+   * @brief Returns the local IDs of the used tiles of a tileset, ordered by
+   * how often they are used.
+   *
+   * @details Ties are ordered by local ID. Tiles that are only used as
+   * animation frames come last.
+   *
+   * @param tileset the index of the tileset in the map.
+   *
+   * @return the local IDs of the used tiles, most frequently used first.
+   *
+   * @throws std::out_of_range if the tileset index is invalid.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto by_frequency(std::size_t tileset) const
+      -> std::vector<int>
+  {
+    auto result = used_tiles(tileset);
+    const auto first = m_ranges.at(tileset).first;
+    std::stable_sort(result.begin(), result.end(), [&](int a, int b) {
+      return m_counts[first + static_cast<std::size_t>(a)] >
+             m_counts[first + static_cast<std::size_t>(b)];
+    });
+    return result;
+  }
+
+  /**
+   * @brief Returns the counts of all tiles.
+   *
+   * @return the counts, indexed by GID.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto counts() const noexcept
+      -> const std::vector<std::uint64_t>&
+  {
+    return m_counts;
+  }
+
+ private:
+  static constexpr std::size_t slice_size = 16'384;
+
+  std::vector<std::uint64_t> m_counts;
+  std::vector<unsigned char> m_used;
+  std::vector<std::pair<std::size_t, std::size_t>> m_ranges;  // GID ranges
+
+  static void increment(std::vector<std::uint64_t>& counts,
+                        global_id gid) noexcept
+  {
+    const auto index = static_cast<std::size_t>(strip_flip_bits(gid).get());
+    if (index < counts.size()) {
+      ++counts[index];
+    }
+  }
+
+  void mark_used(const map& map)
+  {
+    m_used.assign(m_counts.size(), 0);
+    for (std::size_t gid = 0; gid < m_counts.size(); ++gid) {
+      m_used[gid] = m_counts[gid] > 0;
+    }
+
+    for (const auto& tileset : map.tilesets()) {
+      const auto first = static_cast<std::size_t>(tileset->first_gid().get());
+      const auto last = first + static_cast<std::size_t>(tileset->tile_count());
+      m_ranges.emplace_back(first, std::min(last, m_counts.size()));
+
+      for (const auto& tile : tileset->tiles()) {
+        const auto gid = first + static_cast<std::size_t>(tile.id().get());
+        const auto& animation = tile.get_animation();
+        if (!animation || gid >= m_counts.size() || !m_counts[gid]) {
+          continue;
+        }
+
+        for (const auto& frame : animation->frames()) {
+          const auto index =
+              first + static_cast<std::size_t>(frame.tile_id().get());
+          if (index < m_used.size()) {
+            m_used[index] = 1;
+          }
+        }
+      }
+    }
+  }
+
+  [[nodiscard]] auto filter(std::size_t tileset, bool used) const
+      -> std::vector<int>
+  {
+    const auto [first, last] = m_ranges.at(tileset);
+
+    std::vector<int> result;
+    for (auto gid = first; gid < last; ++gid) {
+      if (static_cast<bool>(m_used[gid]) == used) {
+        result.push_back(static_cast<int>(gid - first));
+      }
+    }
+    return result;
+  }
+};
+
+}  // namespace step
+
+#endif  // STEP_TILE_USAGE_HEADER
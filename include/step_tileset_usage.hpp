@@ -0,0 +1,407 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_tileset_usage.hpp
+ *
+ * @brief Provides per-chunk tileset and image usage masks.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_TILESET_USAGE_HEADER
+#define STEP_TILESET_USAGE_HEADER
+
+#include <algorithm>    // find, max, min
+#include <cstddef>      // size_t
+#include <cstdint>      // uint32_t, uint64_t
+#include <limits>       // numeric_limits
+#include <string>       // string
+#include <string_view>  // string_view
+#include <utility>      // pair
+#include <vector>       // vector
+
+#include "step_api.hpp"
+#include "step_layer.hpp"
+#include "step_map.hpp"
+#include "step_object.hpp"
+#include "step_rect.hpp"
+#include "step_tile_pos.hpp"
+#include "step_tile_mask.hpp"
+#include "step_types.hpp"
+#include "step_utils.hpp"
+
+namespace step {
+
+/**
+ * @class tileset_usage
+ *
+ * @brief Records which tilesets, and which images, each chunk of a map uses.
+ *
+ * @details The map is split into chunks of 16x16 tiles, and every chunk stores
+ * one bit per tileset and one bit per image. Images are the images of regular
+ * tilesets, and the individual tile images of image collection tilesets.
+ * Finding the textures that a viewport needs is then an OR over the masks of
+ * the chunks that it overlaps.
+ *
+ * Tile layers, including nested ones, and tile objects are taken into
+ * account. Tile objects are assigned to the chunks that their bounds overlap.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_tileset_usage.hpp
+ */
+class tileset_usage final {
+ public:
+  /**
+   * @brief The width and height of the chunks, in tiles.
+   *
+   * @since 0.3.0
+   */
+  static constexpr int chunk_size = 16;
+
+  /**
+   * @brief Computes the usage masks of a map.
+   *
+   * @param map the map that will be analyzed.
+   *
+   * @since 0.3.0
+   */
+  explicit tileset_usage(const map& map)
+      : m_tileWidth{std::max(map.tile_width(), 1)},
+        m_tileHeight{std::max(map.tile_height(), 1)},
+        m_chunkCols{(map.width() + chunk_size - 1) / chunk_size},
+        m_chunkRows{(map.height() + chunk_size - 1) / chunk_size}
+  {
+    build_tables(map);
+
+    m_tilesetWords = (map.tilesets().size() + word_bits - 1) / word_bits;
+    m_imageWords = (m_images.size() + word_bits - 1) / word_bits;
+
+    const auto chunks = static_cast<std::size_t>(m_chunkCols * m_chunkRows);
+    m_tilesetBits.assign(chunks * m_tilesetWords, 0);
+    m_imageBits.assign(chunks * m_imageWords, 0);
+
+    for (const auto& layer : map.layers()) {
+      detail::each_tile_layer(layer, [&](const step::layer&,
+                                         const tile_layer& tiles) {
+        tiles.each([&](int col, int row, global_id gid) {
+          if (col >= 0 && row >= 0) {
+            mark(col / chunk_size, row / chunk_size, gid);
+          }
+        });
+      });
+
+      detail::each_object_group(layer, [&](const step::layer&,
+                                           const object_group& group) {
+        for (const auto& object : group.objects()) {
+          if (const auto* gid = object.try_as<global_id>()) {
+            mark_object(object, *gid);
+          }
+        }
+      });
+    }
+  }
+
+  /**
+   * @brief Returns the tilesets that are used in an area.
+   *
+   * @param area the area, in pixels.
+   * @param margin the amount of pixels that the area is expanded by, on each
+   * side.
+   *
+   * @return the indices of the used tilesets, in the order of the tilesets of
+   * the map.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto tilesets(const rect& area, double margin = 0) const
+      -> std::vector<std::size_t>
+  {
+    return indices_of(tileset_mask(area, margin));
+  }
+
+  /**
+   * @brief Returns the images that are used in an area.
+   *
+   * @param area the area, in pixels.
+   * @param margin the amount of pixels that the area is expanded by, on each
+   * side.
+   *
+   * @return the paths of the used images, as stated in the tilesets.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto images(const rect& area, double margin = 0) const
+      -> std::vector<std::string_view>
+  {
+    std::vector<std::string_view> result;
+    for (const auto index : indices_of(image_mask(area, margin))) {
+      result.emplace_back(m_images[index]);
+    }
+    return result;
+  }
+
+  /**
+   * @brief Returns the mask of the tilesets that are used in an area.
+   *
+   * @details Bit `i` of the mask, i.e. bit `i % 64` of word `i / 64`, is set
+   * if the tileset with index `i` is used. Masks for different areas can be
+   * compared to find the tilesets that should be loaded or evicted.
+   *
+   * @param area the area, in pixels.
+   * @param margin the amount of pixels that the area is expanded by, on each
+   * side.
+   *
+   * @return the mask of the used tilesets.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto tileset_mask(const rect& area, double margin = 0) const
+      -> std::vector<std::uint64_t>
+  {
+    return combine(m_tilesetBits, m_tilesetWords, area, margin);
+  }
+
+  /**
+   * @brief Returns the mask of the images that are used in an area.
+   *
+   * @details Bit `i` of the mask is set if the image with index `i` in
+   * `image_names()` is used.
+   *
+   * @param area the area, in pixels.
+   * @param margin the amount of pixels that the area is expanded by, on each
+   * side.
+   *
+   * @return the mask of the used images.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto image_mask(const rect& area, double margin = 0) const
+      -> std::vector<std::uint64_t>
+  {
+    return combine(m_imageBits, m_imageWords, area, margin);
+  }
+
+  /**
+   * @brief Returns the paths of all images of the tilesets.
+   *
+   * @return the paths of all images, indexed by the bits of the image masks.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto image_names() const noexcept
+      -> const std::vector<std::string>&
+  {
+    return m_images;
+  }
+
+  /**
+   * @brief Returns the amount of chunk columns.
+   *
+   * @return the amount of chunk columns.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto chunk_cols() const noexcept -> int
+  {
+    return m_chunkCols;
+  }
+
+  /**
+   * @brief Returns the amount of chunk rows.
+   *
+   * @return the amount of chunk rows.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto chunk_rows() const noexcept -> int
+  {
+    return m_chunkRows;
+  }
+
+ private:
+  static constexpr std::size_t word_bits = 64;
+  static constexpr auto none = std::numeric_limits<std::uint32_t>::max();
+
+  int m_tileWidth{};
+  int m_tileHeight{};
+  int m_chunkCols{};
+  int m_chunkRows{};
+  std::size_t m_tilesetWords{};
+  std::size_t m_imageWords{};
+  std::vector<std::uint32_t> m_tilesetOf;  // Indexed by GID
+  std::vector<std::uint32_t> m_imageOf;    // Indexed by GID
+  std::vector<std::string> m_images;
+  std::vector<std::uint64_t> m_tilesetBits;
+  std::vector<std::uint64_t> m_imageBits;
+
+  [[nodiscard]] auto image_index(const std::string& image) -> std::uint32_t
+  {
+    const auto it = std::find(m_images.begin(), m_images.end(), image);
+    if (it != m_images.end()) {
+      return static_cast<std::uint32_t>(it - m_images.begin());
+    }
+    m_images.push_back(image);
+    return static_cast<std::uint32_t>(m_images.size() - 1);
+  }
+
+  void build_tables(const map& map)
+  {
+    auto count = detail::gid_count(map);
+    for (const auto& tileset : map.tilesets()) {
+      for (const auto& tile : tileset->tiles()) {
+        const auto gid = static_cast<std::size_t>(tileset->first_gid().get()) +
+                         static_cast<std::size_t>(tile.id().get());
+        count = std::max(count, gid + 1);
+      }
+    }
+
+    m_tilesetOf.assign(count, none);
+    m_imageOf.assign(count, none);
+
+    const auto& tilesets = map.tilesets();
+    for (std::size_t index = 0; index < tilesets.size(); ++index) {
+      const auto& tileset = *tilesets[index];
+      const auto first = static_cast<std::size_t>(tileset.first_gid().get());
+      const auto last = first + static_cast<std::size_t>(tileset.tile_count());
+
+      const auto image = tileset.image().empty()
+                             ? none
+                             : image_index(std::string{tileset.image()});
+      for (auto gid = first; gid < last; ++gid) {
+        m_tilesetOf[gid] = static_cast<std::uint32_t>(index);
+        m_imageOf[gid] = image;
+      }
+
+      for (const auto& tile : tileset.tiles()) {
+        const auto gid = first + static_cast<std::size_t>(tile.id().get());
+        m_tilesetOf[gid] = static_cast<std::uint32_t>(index);
+        if (const auto& tileImage = tile.image(); tileImage) {
+          m_imageOf[gid] = image_index(*tileImage);
+        }
+      }
+    }
+  }
+
+  void mark(int chunkCol, int chunkRow, global_id gid)
+  {
+    const auto index = static_cast<std::size_t>(strip_flip_bits(gid).get());
+    if (index == 0 || index >= m_tilesetOf.size() ||
+        chunkCol >= m_chunkCols || chunkRow >= m_chunkRows) {
+      return;
+    }
+
+    const auto chunk = static_cast<std::size_t>(chunkRow * m_chunkCols +
+                                                chunkCol);
+    if (const auto tileset = m_tilesetOf[index]; tileset != none) {
+      m_tilesetBits[chunk * m_tilesetWords + tileset / word_bits] |=
+          std::uint64_t{1} << (tileset % word_bits);
+    }
+    if (const auto image = m_imageOf[index]; image != none) {
+      m_imageBits[chunk * m_imageWords + image / word_bits] |=
+          std::uint64_t{1} << (image % word_bits);
+    }
+  }
+
+  void mark_object(const object& object, global_id gid)
+  {
+    // Tile objects are anchored at their bottom-left corner
+    const auto [first, last] = chunk_range({object.x(),
+                                            object.y() - object.height(),
+                                            object.width(),
+                                            object.height()},
+                                           0);
+    for (auto row = first.row; row <= last.row; ++row) {
+      for (auto col = first.col; col <= last.col; ++col) {
+        mark(col, row, gid);
+      }
+    }
+  }
+
+  [[nodiscard]] auto chunk_range(const rect& area, double margin) const
+      -> std::pair<tile_pos, tile_pos>
+  {
+    const auto chunkWidth = static_cast<double>(m_tileWidth * chunk_size);
+    const auto chunkHeight = static_cast<double>(m_tileHeight * chunk_size);
+
+    const auto x = area.x - margin;
+    const auto y = area.y - margin;
+    const auto width = std::max(area.width + 2 * margin, 0.0);
+    const auto height = std::max(area.height + 2 * margin, 0.0);
+
+    // Areas are half-open, so the last chunk is found slightly inside the edge
+    const auto epsilon = width > 0 && height > 0 ? 1e-9 : 0.0;
+    const tile_pos first{
+        std::max(detail::floor_to_int(x / chunkWidth), 0),
+        std::max(detail::floor_to_int(y / chunkHeight), 0)};
+    const tile_pos last{
+        std::min(detail::floor_to_int((x + width - epsilon) / chunkWidth),
+                 m_chunkCols - 1),
+        std::min(detail::floor_to_int((y + height - epsilon) / chunkHeight),
+                 m_chunkRows - 1)};
+    return {first, last};
+  }
+
+  [[nodiscard]] auto combine(const std::vector<std::uint64_t>& bits,
+                             std::size_t words,
+                             const rect& area,
+                             double margin) const -> std::vector<std::uint64_t>
+  {
+    std::vector<std::uint64_t> result(words, 0);
+    const auto [first, last] = chunk_range(area, margin);
+    for (auto row = first.row; row <= last.row; ++row) {
+      for (auto col = first.col; col <= last.col; ++col) {
+        const auto chunk =
+            static_cast<std::size_t>(row * m_chunkCols + col) * words;
+        for (std::size_t word = 0; word < words; ++word) {
+          result[word] |= bits[chunk + word];
+        }
+      }
+    }
+    return result;
+  }
+
+  [[nodiscard]] static auto indices_of(const std::vector<std::uint64_t>& mask)
+      -> std::vector<std::size_t>
+  {
+    std::vector<std::size_t> result;
+    for (std::size_t word = 0; word < mask.size(); ++word) {
+      for (std::size_t bit = 0; bit < word_bits; ++bit) {
+        if ((mask[word] >> bit) & 1u) {
+          result.push_back(word * word_bits + bit);
+        }
+      }
+    }
+    return result;
+  }
+};
+
+}  // namespace step
+
+#endif  // STEP_TILESET_USAGE_HEADER
@@ -86,6 +86,33 @@ using object_ref = fluent::NamedType<int,
                                      fluent::Subtractable,
                                      fluent::Printable>;
 
+namespace detail {
+
+inline constexpr unsigned flipped_horizontally_bit = 0x80000000u;
+inline constexpr unsigned flipped_vertically_bit = 0x40000000u;
+inline constexpr unsigned flipped_diagonally_bit = 0x20000000u;
+inline constexpr unsigned rotated_hexagonal_bit = 0x10000000u;
+inline constexpr unsigned gid_flags_mask = 0xF0000000u;
+
+}  // namespace detail
+
+/**
+ * @brief Returns a global ID without the flip flags stored in its high bits.
+ *
+ * @details GIDs in tile layer data and tile objects may have the flip
+ * flags set, which must be cleared before the GID is used to look up a tile.
+ *
+ * @param gid the global ID that may have flip flags set.
+ *
+ * @return the global ID without any flip flags.
+ *
+ * @since 0.3.0
+ */
+[[nodiscard]] inline auto strip_flip_bits(global_id gid) noexcept -> global_id
+{
+  return global_id{gid.get() & ~detail::gid_flags_mask};
+}
+
 /**
  * Constructs a global ID from an integer literal.
  *
@@ -26,11 +26,13 @@
 #define STEP_UTILS_HEADER
 
 #include <charconv>
+#include <cmath>
 #include <fstream>
 #include <memory>
 #include <named_type.hpp>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <type_traits>
 #include <vector>
 
@@ -171,6 +173,78 @@ template <typename T>
   }
 }
 
+/**
+ * Returns the largest integer that isn't greater than the supplied value.
+ *
+ * @param value the value that will be rounded down.
+ * @return the rounded down value.
+ * @since 0.3.0
+ */
+[[nodiscard]] inline auto floor_to_int(double value) noexcept -> int
+{
+  return static_cast<int>(std::floor(value));
+}
+
+/**
+ * Invokes a callable for each index in a range, using several threads.
+ *
+ * The range is split into one contiguous block per thread, and the calling
+ * thread processes the last block. The callable must be safe to invoke
+ * concurrently for different indices.
+ *
+ * @tparam Lambda the type of the callable.
+ * @param begin the first index of the range.
+ * @param end the index one past the last index of the range.
+ * @param threads the maximum amount of threads, zero means the amount of
+ * hardware threads.
+ * @param lambda the callable that takes a single `int` argument.
+ * @since 0.3.0
+ */
+template <typename Lambda>
+void parallel_for(int begin, int end, int threads, Lambda&& lambda)
+{
+  if (threads <= 0) {
+    threads = static_cast<int>(std::thread::hardware_concurrency());
+  }
+
+  const auto count = end - begin;
+  if (threads > count) {
+    threads = count;
+  }
+
+  if (threads <= 1) {
+    for (auto i = begin; i < end; ++i) {
+      lambda(i);
+    }
+    return;
+  }
+
+  const auto run = [&lambda](int first, int last) {
+    for (auto i = first; i < last; ++i) {
+      lambda(i);
+    }
+  };
+
+  std::vector<std::thread> workers;
+  workers.reserve(static_cast<std::size_t>(threads - 1));
+
+  const auto blockSize = count / threads;
+  const auto remainder = count % threads;
+
+  auto first = begin;
+  for (auto i = 0; i < threads - 1; ++i) {
+    const auto last = first + blockSize + (i < remainder ? 1 : 0);
+    workers.emplace_back(run, first, last);
+    first = last;
+  }
+
+  run(first, end);
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
 }  // namespace step::detail
 
 #endif  // STEP_UTILS_HEADER
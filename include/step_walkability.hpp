@@ -0,0 +1,563 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2020 Albin Johansson
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/**
+ * @file step_walkability.hpp
+ *
+ * @brief Provides the `walkability_grid` class, a movement cost grid derived
+ * from the tile layers of a map.
+ *
+ * @author Albin Johansson
+ *
+ * @date 2020
+ *
+ * @copyright MIT License
+ */
+
+#ifndef STEP_WALKABILITY_HEADER
+#define STEP_WALKABILITY_HEADER
+
+#include <algorithm>    // max, min
+#include <array>        // array
+#include <cmath>        // abs, ceil, sqrt
+#include <cstddef>      // size_t
+#include <cstdint>      // uint8_t
+#include <string_view>  // string_view
+#include <type_traits>  // enable_if_t, is_invocable_r_v
+#include <vector>       // vector
+
+#include "step_api.hpp"
+#include "step_layer.hpp"
+#include "step_map.hpp"
+#include "step_projection.hpp"
+#include "step_tile.hpp"
+#include "step_tile_mask.hpp"
+#include "step_tile_pos.hpp"
+#include "step_types.hpp"
+
+namespace step {
+
+/**
+ * @class walkability_grid
+ *
+ * @brief A grid of movement costs, with one cost per tile in a map.
+ *
+ * @details The cost of a tile is the cost of entering it, where a cost of
+ * zero means that the tile is blocked. The costs are stored as a flat array of
+ * bytes. The grid also knows the neighbourhood of the tiles, which depends on
+ * the orientation of the map. Orthogonal and isometric tiles have four edge
+ * neighbours and four diagonal neighbours, staggered tiles have four edge
+ * neighbours and four corner neighbours and hexagonal tiles have six
+ * neighbours. Diagonal (and corner) moves cost `sqrt(2)` times as much as edge
+ * moves, and aren't allowed to cut corners, i.e. both of the tiles that share
+ * an edge with the tiles of the move must be walkable.
+ *
+ * @since 0.3.0
+ *
+ * @headerfile step_walkability.hpp
+ */
+class walkability_grid final {
+ public:
+  using cost_type = std::uint8_t;
+
+  /**
+   * @brief The cost that represents a blocked tile.
+   *
+   * @since 0.3.0
+   */
+  static constexpr cost_type blocked = 0;
+
+  /**
+   * @brief The maximum amount of neighbours of a tile.
+   *
+   * @since 0.3.0
+   */
+  static constexpr std::size_t max_neighbours = 8;
+
+  /**
+   * @enum diagonals
+   *
+   * @brief Indicates whether or not diagonal (or corner) moves are allowed.
+   *
+   * @details Hexagonal maps don't have any diagonal neighbours, so this option
+   * has no effect for hexagonal maps.
+   *
+   * @since 0.3.0
+   */
+  enum class diagonals { allowed, forbidden };
+
+  walkability_grid() noexcept = default;
+
+  /**
+   * @brief Creates a grid with the size and orientation of a map, where all
+   * tiles have the cost 1.
+   *
+   * @param map the map that provides the size and orientation.
+   * @param moves indicates whether or not diagonal moves are allowed.
+   *
+   * @since 0.3.0
+   */
+  explicit walkability_grid(const map& map,
+                            diagonals moves = diagonals::allowed)
+      : m_width{map.width()},
+        m_height{map.height()},
+        m_orientation{map.get_orientation()},
+        m_staggerX{map.get_stagger_axis() == map::stagger_axis::x},
+        m_staggerEven{map.get_stagger_index() == map::stagger_index::even},
+        m_costs(static_cast<std::size_t>(std::max(m_width, 0)) *
+                    static_cast<std::size_t>(std::max(m_height, 0)),
+                cost_type{1})
+  {
+    init_neighbourhood(map, moves == diagonals::allowed);
+  }
+
+  /**
+   * @brief Creates a grid from the tile layers of a map.
+   *
+   * @details The cost function is evaluated once for each tile with custom
+   * data in the tilesets of the map, other tiles have the cost 1. The cost of
+   * a position is the largest cost of the tiles at that position in all tile
+   * layers, including layers nested in groups, unless any of the tiles is
+   * blocked, in which case the position is blocked. Positions without any
+   * tiles have the cost 1. Costs are clamped to the range [0, 255].
+   *
+   * @tparam Lambda the type of the cost function.
+   *
+   * @param map the map that provides the tile layers and tilesets.
+   * @param costOf the cost function that takes a single `const tile&` argument
+   * and returns the cost of the tile, as an `int`.
+   * @param moves indicates whether or not diagonal moves are allowed.
+   *
+   * @throws step_exception if any tile layer uses Base64 encoded data.
+   *
+   * @since 0.3.0
+   */
+  template <typename Lambda,
+            typename = std::enable_if_t<
+                std::is_invocable_r_v<int, Lambda, const tile&>>>
+  walkability_grid(const map& map,
+                   Lambda&& costOf,
+                   diagonals moves = diagonals::allowed)
+      : walkability_grid{map, moves}
+  {
+    const auto table = detail::make_gid_table<cost_type>(
+        map, [&](const tileset&, const tile& tile) {
+          return clamp_cost(costOf(tile));
+        });
+
+    for (const auto& layer : map.layers()) {
+      detail::each_tile_layer(layer, [&](const step::layer&,
+                                         const tile_layer& tiles) {
+        tiles.each([&](int col, int row, global_id gid) {
+          const auto index = strip_flip_bits(gid).get();
+          if (index == 0 || !contains(col, row)) {
+            return;
+          }
+
+          const auto cost = static_cast<std::size_t>(index) < table.size()
+                                ? table[static_cast<std::size_t>(index)]
+                                : cost_type{1};
+
+          auto& current = m_costs[cell_index(col, row)];
+          if (current != blocked) {
+            current = (cost == blocked) ? blocked : std::max(current, cost);
+          }
+        });
+      });
+    }
+  }
+
+  /**
+   * @brief Creates a grid from the tile layers of a map, where the costs of
+   * the tiles are provided by a tile property.
+   *
+   * @details The property should be either an `int` or a `float` property,
+   * where `float` values are rounded up. Tiles without the property have the
+   * cost 1, and tiles with a cost of zero or less are blocked.
+   *
+   * @param map the map that provides the tile layers and tilesets.
+   * @param property the name of the tile property, e.g. `"cost"`.
+   * @param moves indicates whether or not diagonal moves are allowed.
+   *
+   * @throws step_exception if any tile layer uses Base64 encoded data.
+   *
+   * @since 0.3.0
+   */
+  walkability_grid(const map& map,
+                   std::string_view property,
+                   diagonals moves = diagonals::allowed)
+      : walkability_grid{map,
+                         [property](const tile& tile) {
+                           return property_cost(tile, property);
+                         },
+                         moves}
+  {}
+
+  /**
+   * @brief Sets the cost of entering a tile.
+   *
+   * @details This function has no effect if the position is out-of-bounds.
+   *
+   * @param col the column of the tile.
+   * @param row the row of the tile.
+   * @param cost the new cost of the tile, `blocked` blocks the tile.
+   *
+   * @since 0.3.0
+   */
+  void set_cost(int col, int row, cost_type cost) noexcept
+  {
+    if (contains(col, row)) {
+      m_costs[cell_index(col, row)] = cost;
+    }
+  }
+
+  /**
+   * @brief Returns the cost of entering a tile.
+   *
+   * @param col the column of the tile.
+   * @param row the row of the tile.
+   *
+   * @return the cost of the tile; `blocked` if the position is out-of-bounds.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto cost(int col, int row) const noexcept -> cost_type
+  {
+    return contains(col, row) ? m_costs[cell_index(col, row)] : blocked;
+  }
+
+  /**
+   * @copydoc cost(int, int)
+   *
+   * @param pos the position of the tile.
+   */
+  [[nodiscard]] auto cost(tile_pos pos) const noexcept -> cost_type
+  {
+    return cost(pos.col, pos.row);
+  }
+
+  /**
+   * @brief Indicates whether or not a tile can be entered.
+   *
+   * @param pos the position of the tile.
+   *
+   * @return `true` if the tile is within the grid and isn't blocked; `false`
+   * otherwise.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto is_walkable(tile_pos pos) const noexcept -> bool
+  {
+    return cost(pos) != blocked;
+  }
+
+  /**
+   * @brief Indicates whether or not a position is within the grid.
+   *
+   * @param col the column of the position.
+   * @param row the row of the position.
+   *
+   * @return `true` if the position is within the grid; `false` otherwise.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto contains(int col, int row) const noexcept -> bool
+  {
+    return col >= 0 && row >= 0 && col < m_width && row < m_height;
+  }
+
+  /**
+   * @brief Invokes a callable for each neighbour that can be entered from a
+   * tile.
+   *
+   * @details Neighbours that are out-of-bounds or blocked are skipped, as are
+   * diagonal moves that would cut a corner. The callable is invoked with the
+   * position of the neighbour and the distance to it, where edge moves have
+   * the distance 1. The cost of the move is the distance multiplied by the
+   * cost of the neighbour.
+   *
+   * @tparam Lambda the type of the callable.
+   *
+   * @param pos the position of the tile.
+   * @param lambda the callable that takes two arguments, `tile_pos` and
+   * `double`.
+   *
+   * @since 0.3.0
+   */
+  template <typename Lambda>
+  void each_neighbour(tile_pos pos, Lambda&& lambda) const
+  {
+    const auto& offsets = m_offsets[parity(pos)];
+
+    std::array<tile_pos, max_neighbours> positions{};
+    std::array<bool, max_neighbours> open{};
+    for (std::size_t i = 0; i < m_neighbourCount; ++i) {
+      positions[i] = {pos.col + offsets[i].col, pos.row + offsets[i].row};
+      open[i] = is_walkable(positions[i]);
+    }
+
+    for (std::size_t i = 0; i < m_neighbourCount; ++i) {
+      if (!open[i]) {
+        continue;
+      }
+
+      if (m_guarded && i >= 4) {
+        const auto& guard = m_guards[i - 4];
+        if (!open[guard[0]] || !open[guard[1]]) {
+          continue;
+        }
+      }
+
+      lambda(positions[i], m_distances[i]);
+    }
+  }
+
+  /**
+   * @brief Returns a lower bound of the cost of moving between two tiles.
+   *
+   * @details The estimate is the length of the shortest path between the
+   * tiles, ignoring blocked tiles, assuming that all tiles have the cost 1.
+   * This makes the estimate suitable as an A* heuristic.
+   *
+   * @param from the start position.
+   * @param to the target position.
+   *
+   * @return a lower bound of the cost of moving between the tiles.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto estimate(tile_pos from, tile_pos to) const noexcept
+      -> double
+  {
+    if (m_orientation == map::orientation::orthogonal ||
+        m_orientation == map::orientation::isometric) {
+      return square_distance(std::abs(to.col - from.col),
+                             std::abs(to.row - from.row));
+    }
+
+    // Doubled coordinates, where shifted tiles are offset by one unit
+    const auto a = doubled(from);
+    const auto b = doubled(to);
+    const auto dx = std::abs(b.col - a.col);
+    const auto dy = std::abs(b.row - a.row);
+
+    if (m_orientation == map::orientation::hexagonal) {
+      if (m_staggerX) {
+        return dx + std::max(0, (dy - dx) / 2);
+      } else {
+        return dy + std::max(0, (dx - dy) / 2);
+      }
+    } else {
+      // Staggered diamonds are rotated squares, (u, v) are the edge axes
+      const auto du = std::abs((b.col - a.col) + (b.row - a.row)) / 2;
+      const auto dv = std::abs((b.row - a.row) - (b.col - a.col)) / 2;
+      return square_distance(du, dv);
+    }
+  }
+
+  /**
+   * @brief Returns the total cost of a path.
+   *
+   * @param path the positions of the path, where each position must be a
+   * neighbour of the previous position.
+   *
+   * @return the total cost of the path, which doesn't include the cost of the
+   * first position.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto path_cost(const std::vector<tile_pos>& path) const
+      -> double
+  {
+    double result = 0;
+    for (std::size_t i = 1; i < path.size(); ++i) {
+      const auto& offsets = m_offsets[parity(path[i - 1])];
+      for (std::size_t j = 0; j < m_neighbourCount; ++j) {
+        if (path[i - 1].col + offsets[j].col == path[i].col &&
+            path[i - 1].row + offsets[j].row == path[i].row) {
+          result += m_distances[j] * cost(path[i]);
+          break;
+        }
+      }
+    }
+    return result;
+  }
+
+  /**
+   * @brief Returns the amount of neighbours of each tile.
+   *
+   * @return the amount of neighbours of each tile, e.g. 6 for hexagonal maps.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto neighbour_count() const noexcept -> std::size_t
+  {
+    return m_neighbourCount;
+  }
+
+  /**
+   * @brief Returns the amount of columns in the grid.
+   *
+   * @return the amount of columns in the grid.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto width() const noexcept -> int
+  {
+    return m_width;
+  }
+
+  /**
+   * @brief Returns the amount of rows in the grid.
+   *
+   * @return the amount of rows in the grid.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto height() const noexcept -> int
+  {
+    return m_height;
+  }
+
+  /**
+   * @brief Returns the orientation of the map that the grid is based on.
+   *
+   * @return the orientation of the map.
+   *
+   * @since 0.3.0
+   */
+  [[nodiscard]] auto get_orientation() const noexcept -> map::orientation
+  {
+    return m_orientation;
+  }
+
+ private:
+  using offset_table = std::array<tile_pos, max_neighbours>;
+
+  int m_width{0};
+  int m_height{0};
+  map::orientation m_orientation{map::orientation::orthogonal};
+  bool m_staggerX{false};
+  bool m_staggerEven{false};
+  bool m_guarded{false};
+  std::size_t m_neighbourCount{0};
+  std::array<offset_table, 4> m_offsets{};  // Indexed by column/row parity
+  std::array<double, max_neighbours> m_distances{};
+  std::array<std::array<std::size_t, 2>, 4> m_guards{};
+  std::vector<cost_type> m_costs;
+
+  [[nodiscard]] static auto clamp_cost(int cost) noexcept -> cost_type
+  {
+    return static_cast<cost_type>(std::min(std::max(cost, 0), 255));
+  }
+
+  [[nodiscard]] static auto property_cost(const tile& tile,
+                                          std::string_view name) -> int
+  {
+    const auto* props = tile.get_properties();
+    if (!props || !props->has(name)) {
+      return 1;
+    }
+
+    const auto& property = props->get(name);
+    if (property.is<int>()) {
+      return property.get<int>();
+    } else if (property.is<float>()) {
+      return static_cast<int>(std::ceil(property.get<float>()));
+    } else {
+      return 1;
+    }
+  }
+
+  [[nodiscard]] auto square_distance(int dx, int dy) const noexcept -> double
+  {
+    if (m_neighbourCount == 4) {
+      return dx + dy;
+    }
+
+    // Octile distance
+    const auto lo = std::min(dx, dy);
+    const auto hi = std::max(dx, dy);
+    return (hi - lo) + m_distances[4] * lo;
+  }
+
+  [[nodiscard]] static auto parity(tile_pos pos) noexcept -> std::size_t
+  {
+    return static_cast<std::size_t>((pos.col & 1) | ((pos.row & 1) << 1));
+  }
+
+  [[nodiscard]] auto cell_index(int col, int row) const noexcept
+      -> std::size_t
+  {
+    return static_cast<std::size_t>(row) * static_cast<std::size_t>(m_width) +
+           static_cast<std::size_t>(col);
+  }
+
+  [[nodiscard]] auto doubled(tile_pos pos) const noexcept -> tile_pos
+  {
+    const auto index = m_staggerX ? pos.col : pos.row;
+    const auto shifted = ((index & 1) != 0) != m_staggerEven ? 1 : 0;
+    if (m_staggerX) {
+      return {pos.col, 2 * pos.row + shifted};
+    } else {
+      return {2 * pos.col + shifted, pos.row};
+    }
+  }
+
+  void init_neighbourhood(const map& map, bool allowDiagonals)
+  {
+    visit_projection(map, [&](const auto& projection) {
+      for (std::size_t i = 0; i < m_offsets.size(); ++i) {
+        const tile_pos pos{static_cast<int>(i & 1u),
+                           static_cast<int>(i >> 1u)};
+        const auto& offsets = projection.neighbour_offsets(pos);
+        for (std::size_t j = 0; j < offsets.size(); ++j) {
+          m_offsets[i][j] = offsets[j];
+        }
+      }
+    });
+
+    if (m_orientation == map::orientation::hexagonal) {
+      m_neighbourCount = 6;
+      m_distances.fill(1);
+      return;
+    }
+
+    m_neighbourCount = allowDiagonals ? 8 : 4;
+    m_guarded = allowDiagonals;
+    m_distances = {1, 1, 1, 1, 1.4142135623730951, 1.4142135623730951,
+                   1.4142135623730951, 1.4142135623730951};
+
+    // The edge neighbours on either side of each diagonal neighbour
+    if (m_orientation == map::orientation::staggered) {
+      m_guards = {{{3, 0}, {0, 1}, {1, 2}, {2, 3}}};
+    } else {
+      m_guards = {{{0, 1}, {1, 2}, {2, 3}, {3, 0}}};
+    }
+  }
+};
+
+}  // namespace step
+
+#endif  // STEP_WALKABILITY_HEADER
@@ -0,0 +1,157 @@
+#include "step_alias_table.hpp"
+
+#include <doctest.h>
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "step_exception.hpp"
+#include "step_map.hpp"
+
+using namespace step;
+
+namespace {
+
+// Evaluates the exact distribution by sampling the unit interval evenly
+auto frequencies(const alias_table& table, int samples = 100'000)
+    -> std::vector<double>
+{
+  std::vector<double> result(table.size(), 0);
+  for (auto i = 0; i < samples; ++i) {
+    result.at(table.pick((i + 0.5) / samples)) += 1.0 / samples;
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST_SUITE("alias_table")
+{
+  TEST_CASE("Distributions")
+  {
+    const std::vector<double> weights{1, 0, 2, 5, 0.5, 1.5};
+    const alias_table table{weights};
+    REQUIRE(table.size() == weights.size());
+
+    const auto result = frequencies(table);
+    for (std::size_t i = 0; i < weights.size(); ++i) {
+      CHECK(result[i] == doctest::Approx(weights[i] / 10).epsilon(1e-3));
+    }
+
+    const alias_table single{{3}};
+    CHECK(single.pick(0.0) == 0);
+    CHECK(single.pick(0.999) == 0);
+  }
+
+  TEST_CASE("Invalid weights")
+  {
+    const std::vector<double> empty;
+    const std::vector<double> zeros{0, 0};
+    const std::vector<double> negative{1, -1};
+    CHECK_THROWS_AS(alias_table{empty}, step_exception);
+    CHECK_THROWS_AS(alias_table{zeros}, step_exception);
+    CHECK_THROWS_AS(alias_table{negative}, step_exception);
+  }
+
+  TEST_CASE("Random number generators")
+  {
+    const alias_table table{{1, 3}};
+    detail::split_mix rng{7};
+
+    auto ones = 0;
+    for (auto i = 0; i < 100'000; ++i) {
+      ones += table.pick(rng) == 1 ? 1 : 0;
+    }
+    CHECK(ones / 100'000.0 == doctest::Approx(0.75).epsilon(0.01));
+  }
+}
+
+TEST_SUITE("weighted_tiles")
+{
+  TEST_CASE("Tileset probabilities")
+  {
+    const map map{"resource/alias/map.json"};
+    const weighted_tiles tiles{*map.tilesets().at(0)};
+
+    CHECK(tiles.gids() == std::vector<unsigned>{1, 2, 3, 4});
+
+    std::map<unsigned, int> counts;
+    for (auto i = 0; i < 8'000; ++i) {
+      ++counts[tiles.pick((i + 0.5) / 8'000).get()];
+    }
+    CHECK(counts[1] == doctest::Approx(1'000).epsilon(0.01));
+    CHECK(counts[2] == doctest::Approx(3'000).epsilon(0.01));
+    CHECK(counts[3] == 0);
+    CHECK(counts[4] == doctest::Approx(4'000).epsilon(0.01));
+  }
+
+  TEST_CASE("Wang set probabilities")
+  {
+    const map map{"resource/alias/map.json"};
+    const auto& tileset = *map.tilesets().at(0);
+    const weighted_tiles tiles{tileset, tileset.wang_sets().at(0)};
+
+    const auto flipped = 2u | detail::flipped_horizontally_bit;
+    CHECK(tiles.gids() == std::vector<unsigned>{1, flipped, 4});
+
+    std::map<unsigned, int> counts;
+    for (auto i = 0; i < 53'000; ++i) {
+      ++counts[tiles.pick((i + 0.5) / 53'000).get()];
+    }
+    CHECK(counts[1] == doctest::Approx(1'000).epsilon(0.01));
+    CHECK(counts[flipped] == doctest::Approx(48'000).epsilon(0.01));
+    CHECK(counts[4] == doctest::Approx(4'000).epsilon(0.01));
+  }
+
+  TEST_CASE("Batched fills")
+  {
+    const map map{"resource/alias/map.json"};
+    const weighted_tiles tiles{*map.tilesets().at(0)};
+
+    std::vector<unsigned> serial(100'000);
+    std::vector<unsigned> parallel(serial.size());
+    tiles.fill(serial.data(), serial.size(), 1234, 1);
+    tiles.fill(parallel.data(), parallel.size(), 1234, 4);
+    CHECK(serial == parallel);
+
+    std::map<unsigned, int> counts;
+    for (const auto gid : serial) {
+      ++counts[gid];
+    }
+    CHECK(counts[1] / 100'000.0 == doctest::Approx(0.125).epsilon(0.05));
+    CHECK(counts[2] / 100'000.0 == doctest::Approx(0.375).epsilon(0.05));
+    CHECK(counts[3] == 0);
+    CHECK(counts[4] / 100'000.0 == doctest::Approx(0.5).epsilon(0.05));
+
+    std::vector<unsigned> other(serial.size());
+    tiles.fill(other.data(), other.size(), 4321, 4);
+    CHECK(other != serial);
+  }
+
+  TEST_CASE("Region fills")
+  {
+    const map map{"resource/alias/map.json"};
+    const weighted_tiles tiles{*map.tilesets().at(0)};
+
+    constexpr int width = 64;
+    constexpr int height = 32;
+    std::vector<unsigned> grid(width * height, 0);
+    tiles.fill(grid, width, 10, 5, 20, 12, 99, 3);
+
+    for (auto row = 0; row < height; ++row) {
+      for (auto col = 0; col < width; ++col) {
+        const auto inside = col >= 10 && col < 30 && row >= 5 && row < 17;
+        const auto gid = grid[row * width + col];
+        CHECK((gid != 0) == inside);
+      }
+    }
+
+    auto copy = grid;
+    tiles.fill(copy, width, 10, 5, 20, 12, 99, 1);
+    CHECK(copy == grid);
+
+    CHECK_THROWS_AS(tiles.fill(grid, width, 50, 0, 20, 1, 1), step_exception);
+    CHECK_THROWS_AS(tiles.fill(grid, width, 0, 30, 1, 3, 1), step_exception);
+  }
+}
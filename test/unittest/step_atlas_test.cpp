@@ -0,0 +1,108 @@
+#include "step_atlas.hpp"
+
+#include <doctest.h>
+
+#include <string>
+#include <vector>
+
+#include "step_exception.hpp"
+
+using namespace step;
+
+namespace {
+
+void check_layout(const texture_atlas& atlas, int padding)
+{
+  const auto& images = atlas.images();
+  for (std::size_t i = 0; i < images.size(); ++i) {
+    const auto& bounds = images[i].bounds;
+    CHECK(images[i].page >= 0);
+    CHECK(images[i].page < atlas.page_count());
+    CHECK(bounds.x >= 0);
+    CHECK(bounds.y >= 0);
+    CHECK(bounds.x + bounds.width <= atlas.page_width());
+    CHECK(bounds.y + bounds.height <= atlas.page_height());
+
+    const rect padded{
+        bounds.x, bounds.y, bounds.width + padding, bounds.height + padding};
+    for (std::size_t j = i + 1; j < images.size(); ++j) {
+      if (images[i].page == images[j].page) {
+        CHECK(!intersects(padded, images[j].bounds));
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST_SUITE("texture_atlas")
+{
+  TEST_CASE("Packs tilesets and image collection tiles")
+  {
+    const map map{"resource/atlas/map.json"};
+    const texture_atlas atlas{map, 128, 128, 2};
+
+    CHECK(atlas.page_count() == 1);
+    REQUIRE(atlas.images().size() == 5);
+    check_layout(atlas, 2);
+
+    const auto& terrain = atlas.images().at(0);
+    CHECK(terrain.image == "terrain.png");
+    CHECK(terrain.bounds.width == 72);
+    CHECK(terrain.bounds.height == 36);
+
+    const auto& second = atlas.region(2_gid);
+    CHECK(second.page == 0);
+    CHECK(second.bounds == rect{terrain.bounds.x + 19,
+                                terrain.bounds.y + 1,
+                                16,
+                                16});
+
+    const auto& sixth = atlas.region(global_id{6u | 0x80000000u});
+    CHECK(sixth.bounds == rect{terrain.bounds.x + 19,
+                               terrain.bounds.y + 19,
+                               16,
+                               16});
+
+    // Both tiles use the same image
+    CHECK(atlas.region(9_gid).bounds == atlas.region(12_gid).bounds);
+    CHECK(atlas.region(9_gid).bounds.width == 32);
+    CHECK(atlas.region(10_gid).bounds.height == 48);
+
+    CHECK(atlas.region(0_gid).page == -1);
+    CHECK(atlas.region(100_gid).page == -1);
+  }
+
+  TEST_CASE("Selected tilesets")
+  {
+    const map map{"resource/atlas/map.json"};
+    const std::vector<std::string> tilesets{"props"};
+    const texture_atlas atlas{map, 64, 64, 0, tilesets};
+
+    CHECK(atlas.images().size() == 3);
+    CHECK(atlas.region(1_gid).page == -1);
+    CHECK(atlas.region(13_gid).page == -1);
+    CHECK(atlas.region(11_gid).page == 0);
+    check_layout(atlas, 0);
+  }
+
+  TEST_CASE("Several pages")
+  {
+    const map map{"resource/atlas/map.json"};
+    const texture_atlas atlas{map, 80, 48, 1};
+
+    CHECK(atlas.page_count() > 1);
+    check_layout(atlas, 1);
+
+    for (unsigned gid = 1; gid <= 13; ++gid) {
+      CHECK(atlas.region(global_id{gid}).page != -1);
+    }
+  }
+
+  TEST_CASE("Invalid page sizes")
+  {
+    const map map{"resource/atlas/map.json"};
+    CHECK_THROWS_AS(texture_atlas(map, 40, 40), step_exception);
+    CHECK_THROWS_AS(texture_atlas(map, 0, 128), step_exception);
+  }
+}
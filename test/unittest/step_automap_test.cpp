@@ -0,0 +1,139 @@
+#include "step_automap.hpp"
+
+#include <doctest.h>
+
+#include <vector>
+
+#include "step_exception.hpp"
+#include "step_map.hpp"
+
+using namespace step;
+
+namespace {
+
+constexpr unsigned grass = 1;
+constexpr unsigned water = 2;
+constexpr unsigned edge = 3;
+constexpr unsigned shore = 7;
+
+// Applies the two rules in the test rule map directly
+void expected_pass(int width,
+                   int height,
+                   std::vector<unsigned>& ground,
+                   std::vector<unsigned>& decor)
+{
+  const auto before = ground;
+  const auto at = [&](int col, int row) {
+    return before[static_cast<std::size_t>(row * width + col)];
+  };
+
+  for (auto row = 0; row < height; ++row) {
+    for (auto col = 0; col < width; ++col) {
+      const auto index = static_cast<std::size_t>(row * width + col);
+      if (row > 0 && at(col, row) == water && at(col, row - 1) != water) {
+        decor[index] = shore;
+      }
+      if (col > 0 && at(col, row) == grass && at(col - 1, row) == grass) {
+        ground[index] = edge;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST_SUITE("automap")
+{
+  TEST_CASE("Parsing rules")
+  {
+    const map rules{"resource/automap/rules.json"};
+    const automap_rules automap{rules};
+
+    REQUIRE(automap.rules().size() == 2);
+    CHECK(automap.layer_names() == std::vector<std::string>{"ground", "decor"});
+    CHECK(automap.unanchored().empty());
+    CHECK(automap.max_width() == 2);
+    CHECK(automap.max_height() == 2);
+
+    const auto& shoreRule = automap.rules().at(0);
+    CHECK(shoreRule.width == 1);
+    CHECK(shoreRule.height == 2);
+    CHECK(shoreRule.conditions.size() == 2);
+    CHECK(shoreRule.outputs.size() == 1);
+
+    CHECK(automap.anchors(0, water));
+    CHECK(automap.anchors(0, grass));
+    CHECK(!automap.anchors(0, edge));
+    CHECK(!automap.has_anchors(1));
+
+    const map plain{"resource/automap/map.json"};
+    CHECK_THROWS_AS(automap_rules{plain}, step_exception);
+  }
+
+  TEST_CASE("Applying rules")
+  {
+    const map rules{"resource/automap/rules.json"};
+    const map map{"resource/automap/map.json"};
+    const automap_rules automap{rules};
+
+    automapper serial{map, automap};
+    automapper parallel{map, automap};
+
+    auto ground = serial.layer("ground");
+    std::vector<unsigned> decor(ground.size(), 0);
+    CHECK(serial.layer("decor") == decor);
+
+    expected_pass(map.width(), map.height(), ground, decor);
+
+    std::size_t expectedChanges = 0;
+    for (std::size_t i = 0; i < ground.size(); ++i) {
+      expectedChanges += ground[i] == edge ? 1 : 0;
+      expectedChanges += decor[i] == shore ? 1 : 0;
+    }
+
+    CHECK(serial.apply(1) == expectedChanges);
+    CHECK(parallel.apply(4) == expectedChanges);
+
+    CHECK(serial.layer("ground") == ground);
+    CHECK(serial.layer("decor") == decor);
+    CHECK(parallel.layer("ground") == ground);
+    CHECK(parallel.layer("decor") == decor);
+
+    // Applying the rules again doesn't change anything
+    CHECK(serial.apply() == 0);
+
+    CHECK(serial.gid_at("ground", -1, 0).get() == 0);
+    CHECK_THROWS_AS(serial.gid_at("other", 0, 0), step_exception);
+    CHECK_THROWS_AS(serial.set("ground", 40, 0, global_id{1}),
+                    step_exception);
+  }
+
+  TEST_CASE("Incremental updates")
+  {
+    const map rules{"resource/automap/rules.json"};
+    const map map{"resource/automap/map.json"};
+    const automap_rules automap{rules};
+
+    automapper incremental{map, automap};
+    automapper full{map, automap};
+    incremental.apply();
+    full.apply();
+
+    const int cells[][2] = {{0, 0}, {5, 5}, {6, 5}, {39, 29}, {20, 0}, {21, 1}};
+    for (const auto& [col, row] : cells) {
+      incremental.set("ground", col, row, global_id{grass});
+      full.set("ground", col, row, global_id{grass});
+    }
+    incremental.set("ground", 10, 10, global_id{water});
+    full.set("ground", 10, 10, global_id{water});
+    CHECK(incremental.pending() == 7);
+
+    const auto changed = incremental.update(2);
+    CHECK(incremental.pending() == 0);
+    CHECK(full.apply() == changed);
+
+    CHECK(incremental.layer("ground") == full.layer("ground"));
+    CHECK(incremental.layer("decor") == full.layer("decor"));
+    CHECK(incremental.update() == 0);
+  }
+}
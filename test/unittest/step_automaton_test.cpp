@@ -0,0 +1,184 @@
+#include "step_automaton.hpp"
+
+#include <doctest.h>
+
+#include <vector>
+
+#include "step_exception.hpp"
+#include "step_map.hpp"
+
+using namespace step;
+
+namespace {
+
+constexpr unsigned dead = 1;
+constexpr unsigned alive = 2;
+
+constexpr unsigned dirt = 1;
+constexpr unsigned crop = 2;
+
+auto life(const automaton_neighbourhood& cells) -> global_id
+{
+  const auto neighbours = cells.count(global_id{alive});
+  if (cells.center() == alive) {
+    return global_id{neighbours == 2 || neighbours == 3 ? alive : dead};
+  } else {
+    return global_id{neighbours == 3 ? alive : dead};
+  }
+}
+
+void add_life_rules(cellular_automaton& automaton)
+{
+  automaton.set_rule(global_id{dead}, life);
+  automaton.set_rule(global_id{alive}, life);
+}
+
+auto naive_life(const std::vector<unsigned>& cells, int width, int height)
+    -> std::vector<unsigned>
+{
+  auto next = cells;
+  for (auto row = 0; row < height; ++row) {
+    for (auto col = 0; col < width; ++col) {
+      auto neighbours = 0;
+      for (auto dy = -1; dy <= 1; ++dy) {
+        for (auto dx = -1; dx <= 1; ++dx) {
+          const auto c = col + dx;
+          const auto r = row + dy;
+          if ((dx || dy) && c >= 0 && r >= 0 && c < width && r < height &&
+              cells[static_cast<std::size_t>(r * width + c)] == alive) {
+            ++neighbours;
+          }
+        }
+      }
+
+      const auto index = static_cast<std::size_t>(row * width + col);
+      if (cells[index] == alive) {
+        next[index] = neighbours == 2 || neighbours == 3 ? alive : dead;
+      } else if (cells[index] == dead) {
+        next[index] = neighbours == 3 ? alive : dead;
+      }
+    }
+  }
+  return next;
+}
+
+auto filled(int width, int height) -> cellular_automaton
+{
+  cellular_automaton automaton{width, height};
+  for (auto row = 0; row < height; ++row) {
+    for (auto col = 0; col < width; ++col) {
+      automaton.set(col, row, global_id{dead});
+    }
+  }
+  return automaton;
+}
+
+}  // namespace
+
+TEST_SUITE("cellular_automaton")
+{
+  TEST_CASE("Matches a naive implementation")
+  {
+    const map map{"resource/automaton/life.json"};
+    cellular_automaton serial{map, "cells"};
+    cellular_automaton parallel{map, "cells"};
+    add_life_rules(serial);
+    add_life_rules(parallel);
+
+    auto expected = serial.gids();
+    for (auto generation = 0; generation < 30; ++generation) {
+      const auto previous = expected;
+      expected = naive_life(expected, map.width(), map.height());
+
+      const auto& changes = serial.step(1);
+      parallel.step(4);
+      REQUIRE(serial.gids() == expected);
+      REQUIRE(parallel.gids() == expected);
+
+      std::size_t differences = 0;
+      for (std::size_t i = 0; i < expected.size(); ++i) {
+        differences += expected[i] != previous[i] ? 1 : 0;
+      }
+      CHECK(changes.size() == differences);
+
+      for (const auto& change : changes) {
+        const auto index = static_cast<std::size_t>(
+            change.pos.row * map.width() + change.pos.col);
+        CHECK(change.previous == previous[index]);
+        CHECK(change.current == expected[index]);
+      }
+    }
+
+    CHECK(serial.generation() == 30);
+    CHECK_THROWS_AS(cellular_automaton(map, "missing"), step_exception);
+  }
+
+  TEST_CASE("Stable areas are skipped")
+  {
+    auto automaton = filled(256, 256);
+    add_life_rules(automaton);
+
+    // A blinker in the middle of a block
+    automaton.set(100, 100, global_id{alive});
+    automaton.set(101, 100, global_id{alive});
+    automaton.set(102, 100, global_id{alive});
+
+    automaton.step();
+    CHECK(automaton.stepped_blocks() == 64);
+
+    for (auto i = 0; i < 4; ++i) {
+      CHECK(automaton.step().size() == 4);
+      CHECK(automaton.stepped_blocks() == 9);
+    }
+
+    // The blinker is vertical after an odd amount of steps
+    CHECK(automaton.gid_at(100, 100).get() == dead);
+    CHECK(automaton.gid_at(101, 99).get() == alive);
+    CHECK(automaton.gid_at(101, 101).get() == alive);
+
+    // Freezing the blinker empties the active region
+    automaton.set(101, 99, global_id{5});
+    automaton.set(101, 100, global_id{5});
+    automaton.set(101, 101, global_id{5});
+    automaton.step();
+    automaton.step();
+    CHECK(automaton.changes().empty());
+    CHECK(automaton.stepped_blocks() == 0);
+
+    CHECK_THROWS_AS(automaton.set(256, 0, global_id{1}), step_exception);
+    CHECK(automaton.gid_at(-1, 0).get() == 0);
+  }
+
+  TEST_CASE("Spontaneous rules")
+  {
+    const auto run = [&](int threads, std::uint64_t seed) {
+      auto automaton = filled(100, 100);
+      automaton.set_seed(seed);
+      automaton.set_rule(
+          global_id{dirt},
+          [](const automaton_neighbourhood& cell) {
+            return global_id{cell.random() < 0.05 ? crop : dirt};
+          },
+          true);
+
+      for (auto i = 0; i < 10; ++i) {
+        automaton.step(threads);
+        CHECK(automaton.stepped_blocks() == 16);
+      }
+      return automaton.gids();
+    };
+
+    const auto first = run(1, 7);
+    CHECK(run(4, 7) == first);
+    CHECK(run(4, 8) != first);
+
+    std::size_t crops = 0;
+    for (const auto gid : first) {
+      crops += gid == crop ? 1 : 0;
+    }
+
+    // About 40% of the cells should have grown crops after ten steps
+    CHECK(crops > 3'500);
+    CHECK(crops < 4'500);
+  }
+}
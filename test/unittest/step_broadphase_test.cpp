@@ -0,0 +1,142 @@
+#include "step_broadphase.hpp"
+
+#include <doctest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "step_map.hpp"
+
+using namespace step;
+
+namespace {
+
+auto sorted(std::vector<object_pair> pairs) -> std::vector<object_pair>
+{
+  std::sort(pairs.begin(),
+            pairs.end(),
+            [](const object_pair& a, const object_pair& b) {
+              return a.first < b.first ||
+                     (a.first == b.first && a.second < b.second);
+            });
+  return pairs;
+}
+
+auto brute_force_pairs(const object_broadphase& broadphase)
+    -> std::vector<object_pair>
+{
+  std::vector<object_pair> pairs;
+  for (std::size_t a = 0; a < broadphase.size(); ++a) {
+    for (auto b = a + 1; b < broadphase.size(); ++b) {
+      if (broadphase.overlaps(a, b)) {
+        pairs.push_back({a, b});
+      }
+    }
+  }
+  return pairs;
+}
+
+auto groups_of(const map& map) -> std::vector<const object_group*>
+{
+  std::vector<const object_group*> groups;
+  for (const auto& layer : map.layers()) {
+    groups.push_back(&layer.as<object_group>());
+  }
+  return groups;
+}
+
+}  // namespace
+
+TEST_SUITE("object_broadphase")
+{
+  TEST_CASE("Overlapping shapes")
+  {
+    const map map{"resource/broadphase/zones.json"};
+    const object_broadphase broadphase{groups_of(map)};
+
+    REQUIRE(broadphase.size() == 12);
+    CHECK(broadphase.object_at(0).name() == "room");
+    CHECK(broadphase.group_of(4) == 0);
+    CHECK(broadphase.group_of(5) == 1);
+
+    const std::vector<object_pair> expected{
+        {0, 4}, {0, 5}, {1, 11}, {2, 8}, {3, 10}};
+    CHECK(sorted(broadphase.pairs()) == expected);
+
+    // The bounding box of the rotated square
+    const auto bounds = broadphase.bounds(3);
+    CHECK(bounds.x == doctest::Approx(600 - 25 * std::sqrt(2.0)));
+    CHECK(bounds.y == doctest::Approx(0));
+    CHECK(bounds.width == doctest::Approx(50 * std::sqrt(2.0)));
+    CHECK(bounds.height == doctest::Approx(50 * std::sqrt(2.0)));
+
+    // Overlapping bounding boxes, but separate shapes
+    CHECK(!broadphase.overlaps(1, 6));
+    CHECK(!broadphase.overlaps(2, 7));
+    CHECK(!broadphase.overlaps(3, 9));
+  }
+
+  TEST_CASE("Pairs across groups")
+  {
+    const map map{"resource/broadphase/zones.json"};
+    const object_broadphase broadphase{
+        groups_of(map), object_broadphase::pairs_of::across_groups};
+
+    const std::vector<object_pair> expected{
+        {0, 5}, {1, 11}, {2, 8}, {3, 10}};
+    CHECK(sorted(broadphase.pairs()) == expected);
+  }
+
+  TEST_CASE("Moving objects")
+  {
+    const map map{"resource/broadphase/zones.json"};
+    object_broadphase broadphase{groups_of(map)};
+
+    broadphase.set_position(6, {250, 10});
+    broadphase.set_position(9, {645, 45});
+    broadphase.update();
+
+    std::vector<object_pair> expected{
+        {0, 4}, {0, 5}, {1, 6}, {1, 11}, {2, 8}, {3, 10}, {6, 11}};
+    CHECK(sorted(broadphase.pairs()) == expected);
+
+    broadphase.set_rotation(3, 0);
+    broadphase.update();
+
+    expected.insert(expected.begin() + 5, object_pair{3, 9});
+    CHECK(sorted(broadphase.pairs()) == expected);
+  }
+
+  TEST_CASE("Incremental updates match a brute force search")
+  {
+    const map map{"resource/broadphase/random.json"};
+    object_broadphase broadphase{groups_of(map)};
+    REQUIRE(broadphase.size() == 300);
+
+    CHECK(sorted(broadphase.pairs()) == brute_force_pairs(broadphase));
+    CHECK(!broadphase.pairs().empty());
+
+    std::mt19937 rng{11};
+    std::uniform_int_distribution<std::size_t> index{0, 299};
+    std::uniform_real_distribution<double> step{-60, 60};
+    std::uniform_int_distribution<int> moves{1, 120};
+
+    for (int round = 0; round < 40; ++round) {
+      const auto count = moves(rng);
+      for (int i = 0; i < count; ++i) {
+        const auto which = index(rng);
+        const auto& object = broadphase.object_at(which);
+        if (i % 5 == 0) {
+          broadphase.set_rotation(which, step(rng) * 3);
+        } else {
+          broadphase.set_position(
+              which, {object.x() + step(rng), object.y() + step(rng)});
+        }
+      }
+
+      broadphase.update();
+      CHECK(sorted(broadphase.pairs()) == brute_force_pairs(broadphase));
+    }
+  }
+}
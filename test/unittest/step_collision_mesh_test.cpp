@@ -0,0 +1,114 @@
+#include "step_collision_mesh.hpp"
+
+#include <doctest.h>
+
+#include <vector>
+
+#include "step_map.hpp"
+
+using namespace step;
+
+namespace {
+
+auto covered_area(const std::vector<rect>& rects) -> double
+{
+  double area = 0;
+  for (const auto& rect : rects) {
+    area += rect.width * rect.height;
+  }
+  return area;
+}
+
+}  // namespace
+
+TEST_SUITE("collision_mesh")
+{
+  TEST_CASE("Merge solid tiles")
+  {
+    const map map{"resource/collision/map.json"};
+    const collision_mesh mesh{map, "solid", 4};
+
+    CHECK(mesh.chunk_size() == 4);
+    CHECK(mesh.chunk_cols() == 2);
+    CHECK(mesh.chunk_rows() == 2);
+    CHECK(mesh.rect_count() == 3);
+
+    REQUIRE(mesh.chunk_rects(0, 0).size() == 1);
+    CHECK(mesh.chunk_rects(0, 0).front() == rect{0, 0, 48, 32});
+    CHECK(mesh.chunk_rects(1, 1).front() == rect{96, 64, 32, 32});
+    CHECK(mesh.chunk_rects(0, 1).front() == rect{0, 80, 16, 16});
+    CHECK(mesh.chunk_rects(1, 0).empty());
+
+    CHECK_THROWS_AS(mesh.chunk_rects(2, 0), step_exception);
+  }
+
+  TEST_CASE("Tile collision objects")
+  {
+    const map map{"resource/collision/map.json"};
+    const collision_mesh mesh{map, "solid", 4};
+
+    const auto& shapes = mesh.chunk_shapes(1, 0);
+    REQUIRE(shapes.size() == 1);
+    CHECK(shapes.front().offset.x() == 64);
+    CHECK(shapes.front().offset.y() == 32);
+    CHECK(shapes.front().gid == 3_gid);
+    CHECK(shapes.front().shape->width() == 12);
+
+    int count = 0;
+    mesh.query_shapes({60, 30, 10, 10}, [&](const collision_shape&) {
+      ++count;
+    });
+    CHECK(count == 1);
+  }
+
+  TEST_CASE("Predicate and incremental rebuilds")
+  {
+    const map map{"resource/collision/map.json"};
+    collision_mesh mesh{map,
+                        [](const tile& tile) {
+                          const auto* props = tile.get_properties();
+                          return tile.type() == "wall" ||
+                                 (props && props->is("solid", true));
+                        },
+                        4};
+
+    CHECK(mesh.chunk_rects(0, 0).size() == 2);
+    CHECK(covered_area(mesh.rects()) == mesh.solid().count() * 16 * 16);
+
+    mesh.set_solid(3, 1, true);
+    mesh.set_solid(3, 1, true);
+    CHECK(mesh.rebuild() == 1);
+    CHECK(mesh.rebuild() == 0);
+    CHECK(mesh.chunk_rects(0, 0).size() == 1);
+    CHECK(mesh.chunk_rects(0, 0).front() == rect{0, 0, 64, 32});
+
+    std::vector<rect> found;
+    mesh.query({0, 0, 20, 20}, [&](const rect& rect) {
+      found.push_back(rect);
+    });
+    CHECK(found.size() == 1);
+  }
+
+  TEST_CASE("Greedy meshing of a large mask")
+  {
+    tile_mask mask{40, 40};
+    for (int row = 0; row < 40; ++row) {
+      for (int col = 0; col < 40; ++col) {
+        if ((col / 5 + row / 7) % 3 != 0) {
+          mask.set(col, row);
+        }
+      }
+    }
+
+    const collision_mesh mesh{mask, 8, 8, 16};
+    const auto rects = mesh.rects();
+    CHECK(covered_area(rects) == mask.count() * 8 * 8);
+    CHECK(rects.size() < static_cast<std::size_t>(mask.count() / 4));
+
+    for (std::size_t i = 0; i < rects.size(); ++i) {
+      for (std::size_t j = i + 1; j < rects.size(); ++j) {
+        CHECK(!intersects(rects[i], rects[j]));
+      }
+    }
+  }
+}
@@ -0,0 +1,128 @@
+#include "step_field_of_view.hpp"
+
+#include <doctest.h>
+
+#include <vector>
+
+#include "step_map.hpp"
+
+using namespace step;
+
+namespace {
+
+auto make_pattern(int width, int height) -> tile_mask
+{
+  tile_mask mask{width, height};
+  for (int row = 0; row < height; ++row) {
+    for (int col = 0; col < width; ++col) {
+      if ((col * 7 + row * 13) % 17 == 0 || (col % 9 == 4 && row % 5 != 2)) {
+        mask.set(col, row);
+      }
+    }
+  }
+  return mask;
+}
+
+}  // namespace
+
+TEST_SUITE("field_of_view")
+{
+  TEST_CASE("Open area")
+  {
+    const tile_mask opaque{9, 9};
+    const field_of_view fov{opaque, {4, 4}, 3};
+
+    CHECK(fov.origin() == tile_pos{4, 4});
+    CHECK(fov.radius() == 3);
+    CHECK(fov.count() == 29);
+    CHECK(fov.is_visible({4, 4}));
+    CHECK(fov.is_visible({4, 1}));
+    CHECK(fov.is_visible({6, 6}));
+    CHECK(!fov.is_visible({7, 7}));
+    CHECK(!fov.is_visible({4, 0}));
+  }
+
+  TEST_CASE("Opaque tiles from several layers")
+  {
+    const map map{"resource/fov/dungeon.json"};
+    const auto is_opaque = [](const tile& tile) {
+      const auto* props = tile.get_properties();
+      return props && props->is("opaque", true);
+    };
+
+    auto opaque = make_tile_mask(map, map.layers().at(0), is_opaque);
+    CHECK(opaque.count() == 1);
+    opaque |= make_tile_mask(map, map.layers().at(1), is_opaque);
+    CHECK(opaque.count() == 2);
+
+    const field_of_view fov{opaque, {1, 4}, 8};
+    CHECK(fov.is_visible({2, 4}));
+    CHECK(fov.is_visible({3, 4}));  // Walls are visible
+    CHECK(!fov.is_visible({4, 4}));
+    CHECK(!fov.is_visible({8, 4}));
+    CHECK(fov.is_visible({4, 3}));
+    CHECK(fov.is_visible({6, 2}));
+    CHECK(!fov.is_visible({-1, 4}));
+  }
+
+  TEST_CASE("Visibility is symmetric")
+  {
+    const auto opaque = make_pattern(30, 24);
+    constexpr int radius = 8;
+
+    std::vector<fov_viewer> viewers;
+    for (int row = 0; row < opaque.height(); ++row) {
+      for (int col = 0; col < opaque.width(); ++col) {
+        viewers.push_back({{col, row}, radius});
+      }
+    }
+
+    const auto fovs = compute_fields_of_view(opaque, viewers);
+    REQUIRE(fovs.size() == viewers.size());
+
+    const auto fov_of = [&](tile_pos pos) -> const field_of_view& {
+      return fovs[static_cast<std::size_t>(pos.row * opaque.width() +
+                                           pos.col)];
+    };
+
+    for (const auto& viewer : viewers) {
+      const auto a = viewer.origin;
+      if (opaque.test(a)) {
+        continue;
+      }
+
+      for (int dy = -radius; dy <= radius; ++dy) {
+        for (int dx = -radius; dx <= radius; ++dx) {
+          const tile_pos b{a.col + dx, a.row + dy};
+          if (opaque.contains(b.col, b.row) && !opaque.test(b) &&
+              dx * dx + dy * dy <= radius * radius) {
+            CHECK(fov_of(a).is_visible(b) == fov_of(b).is_visible(a));
+          }
+        }
+      }
+    }
+  }
+
+  TEST_CASE("Batched computations match single computations")
+  {
+    const auto opaque = make_pattern(64, 48);
+    const std::vector<fov_viewer> viewers{
+        {{5, 5}, 10}, {{30, 20}, 6}, {{63, 47}, 12}, {{0, 0}, 0}};
+
+    std::vector<field_of_view> results;
+    for (const auto threads : {1, 4}) {
+      compute_fields_of_view(opaque, viewers, results, threads);
+      REQUIRE(results.size() == viewers.size());
+
+      for (std::size_t i = 0; i < viewers.size(); ++i) {
+        const field_of_view expected{
+            opaque, viewers[i].origin, viewers[i].radius};
+        CHECK(results[i].count() == expected.count());
+        CHECK(results[i].visible().row_data(0)[0] ==
+              expected.visible().row_data(0)[0]);
+      }
+    }
+
+    CHECK(results.back().count() == 1);
+  }
+}
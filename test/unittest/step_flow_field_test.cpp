@@ -0,0 +1,145 @@
+#include "step_flow_field.hpp"
+
+#include <doctest.h>
+
+#include <vector>
+
+#include "step_map.hpp"
+
+using namespace step;
+
+namespace {
+
+void add_obstacles(walkability_grid& grid)
+{
+  for (int row = 0; row < grid.height(); ++row) {
+    for (int col = 0; col < grid.width(); ++col) {
+      if ((col * 7 + row * 13) % 11 == 0 || (col % 6 == 3 && row % 9 != 4)) {
+        grid.set_cost(col, row, walkability_grid::blocked);
+      } else if ((col + row) % 5 == 0) {
+        grid.set_cost(col, row, 3);
+      }
+    }
+  }
+}
+
+// Follows the field from a tile, returns the cost of the walk
+auto walk(const walkability_grid& grid, const flow_field& field, tile_pos pos)
+    -> double
+{
+  double cost = 0;
+  while (!field.is_goal(pos)) {
+    const auto next = field.next(pos);
+    REQUIRE(next != pos);
+    cost += grid.path_cost({pos, next});
+    pos = next;
+  }
+  return cost;
+}
+
+void check_equal(const walkability_grid& grid,
+                 const flow_field& lhs,
+                 const flow_field& rhs)
+{
+  for (int row = 0; row < grid.height(); ++row) {
+    for (int col = 0; col < grid.width(); ++col) {
+      const tile_pos pos{col, row};
+      CHECK(lhs.distance(pos) == rhs.distance(pos));
+      CHECK(lhs.next(pos) == rhs.next(pos));
+    }
+  }
+}
+
+}  // namespace
+
+TEST_SUITE("flow_field")
+{
+  TEST_CASE("Weighted distances")
+  {
+    const map map{"resource/pathfinding/costs.json"};
+    const walkability_grid grid{map, "cost"};
+
+    flow_field field{grid};
+    field.set_goals({{6, 0}, {3, 0}});
+
+    CHECK(field.goals().size() == 1);  // The blocked goal is ignored
+    CHECK(field.distance({6, 0}) == 0.0);
+    CHECK(field.distance({7, 0}) == 1.0);
+    CHECK(field.distance({5, 1}) == doctest::Approx(1.4));
+    CHECK(!field.distance({3, 0}));
+    CHECK(!field.distance({-1, 0}));
+    CHECK(field.next({7, 1}) == tile_pos{6, 0});
+    CHECK(field.next({6, 0}) == tile_pos{6, 0});
+
+    // Following the field accumulates the reported distance
+    for (int row = 0; row < grid.height(); ++row) {
+      for (int col = 0; col < grid.width(); ++col) {
+        const tile_pos pos{col, row};
+        if (const auto distance = field.distance(pos)) {
+          const auto expected = doctest::Approx(*distance).epsilon(0.05);
+          CHECK(walk(grid, field, pos) == expected);
+          CHECK(field.nearest_goal(pos) == tile_pos{6, 0});
+        }
+      }
+    }
+  }
+
+  TEST_CASE("Chamfer distances")
+  {
+    const map map{"resource/pathfinding/costs.json"};
+    const walkability_grid grid{map, "cost"};
+
+    flow_field field{grid, flow_field::metric::chamfer};
+    field.set_goals({{0, 0}});
+
+    CHECK(field.distance({0, 3}) == 3.0);
+    CHECK(field.distance({2, 2}) == doctest::Approx(2.8));
+    CHECK(field.distance({2, 4}) == doctest::Approx(2 * 1.4 + 2));
+    CHECK(field.distance({4, 0}) == doctest::Approx(2 * 1.4 + 8));
+  }
+
+  TEST_CASE("Nearest goal")
+  {
+    const map map{"resource/pathfinding/open.json"};
+    const walkability_grid grid{map};
+
+    flow_field field{grid, flow_field::metric::chamfer};
+    field.set_goals({{0, 0}, {47, 47}});
+
+    CHECK(field.nearest_goal({10, 10}) == tile_pos{0, 0});
+    CHECK(field.nearest_goal({40, 30}) == tile_pos{47, 47});
+    CHECK(field.distance({3, 4}) == doctest::Approx(1 + 3 * 1.4));
+  }
+
+  TEST_CASE("Incremental goal updates match full rebuilds")
+  {
+    const map map{"resource/pathfinding/open.json"};
+    walkability_grid grid{map};
+    add_obstacles(grid);
+
+    flow_field incremental{grid};
+    flow_field reference{grid, flow_field::metric::weighted, 1};
+
+    const std::vector<tile_pos> goals{
+        {1, 1}, {40, 5}, {20, 20}, {7, 44}, {30, 40}, {0, 2}};
+    for (const auto goal : goals) {
+      incremental.add_goal(goal);
+      reference.set_goals(incremental.goals());
+      check_equal(grid, incremental, reference);
+    }
+
+    incremental.remove_goal({20, 20});
+    incremental.move_goal({40, 5}, {41, 6});
+    incremental.remove_goal({1, 1});
+    reference.set_goals(incremental.goals());
+    check_equal(grid, incremental, reference);
+
+    const auto remaining = incremental.goals();
+    for (const auto goal : remaining) {
+      incremental.remove_goal(goal);
+    }
+    CHECK(incremental.goals().empty());
+    CHECK(!incremental.distance({10, 10}));
+    CHECK(incremental.next({10, 10}) == tile_pos{10, 10});
+  }
+}
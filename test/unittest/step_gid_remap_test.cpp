@@ -0,0 +1,86 @@
+#include "step_gid_remap.hpp"
+
+#include <doctest.h>
+
+#include <string>
+#include <vector>
+
+using namespace step;
+
+namespace {
+
+inline constexpr unsigned flipped = 0x80000000u;
+
+}  // namespace
+
+TEST_SUITE("gid_remap")
+{
+  TEST_CASE("Shared tilesets get a single range")
+  {
+    const map first{"resource/gid_remap/first.json"};
+    const map second{"resource/gid_remap/second.json"};
+    const gid_remap remap{{&first, &second}};
+
+    const std::vector<std::string> tilesets{"a", "b", "c"};
+    CHECK(remap.tilesets() == tilesets);
+    CHECK(remap.first_gid(0) == 1_gid);
+    CHECK(remap.first_gid(1) == 5_gid);
+    CHECK(remap.first_gid(2) == 7_gid);
+    CHECK(remap.gid_count() == 10);
+
+    CHECK(remap.remap(0, 4_gid) == 4_gid);
+    CHECK(remap.remap(0, 6_gid) == 6_gid);
+    CHECK(remap.remap(1, 1_gid) == 5_gid);
+    CHECK(remap.remap(1, 5_gid) == 9_gid);
+    CHECK(remap.remap(1, 0_gid) == 0_gid);
+    CHECK(remap.remap(1, 1'000_gid) == 0_gid);
+  }
+
+  TEST_CASE("Compaction removes unused tiles")
+  {
+    const map first{"resource/gid_remap/first.json"};
+    const map second{"resource/gid_remap/second.json"};
+    const gid_remap remap{{&first, &second}, true, 2};
+
+    CHECK(remap.local_tiles(0) == std::vector<int>{0, 1, 3});
+    CHECK(remap.local_tiles(1) == std::vector<int>{0});
+    CHECK(remap.local_tiles(2) == std::vector<int>{0, 2});
+    CHECK(remap.gid_count() == 7);
+
+    const auto& ground = first.layers().at(0).as<tile_layer>();
+    const std::vector<global_id> firstExpected{
+        1_gid, global_id{2u | flipped}, 4_gid, 0_gid};
+    CHECK(remap.remap(0, ground.data()->as_gid()) == firstExpected);
+    CHECK(remap.remap(0, 4_gid) == 3_gid);
+    CHECK(remap.remap(0, 3_gid) == 0_gid);
+
+    const auto& other = second.layers().at(0).as<tile_layer>();
+    const std::vector<global_id> secondExpected{
+        4_gid, 5_gid, global_id{6u | flipped}, 0_gid};
+    CHECK(remap.remap(1, other.data()->as_gid()) == secondExpected);
+  }
+
+  TEST_CASE("Bulk remapping matches single lookups")
+  {
+    const map map{"resource/gid_remap/second.json"};
+    const gid_remap remap{map};
+
+    std::vector<global_id> gids;
+    for (unsigned i = 0; i < 20'000; ++i) {
+      const auto flags = (i % 3 == 0) ? flipped : 0u;
+      gids.push_back(global_id{(i % 8) | flags});
+    }
+
+    const auto result = remap.remap(0, gids, 4);
+    REQUIRE(result.size() == gids.size());
+    for (std::size_t i = 0; i < gids.size(); ++i) {
+      CHECK(result[i] == remap.remap(0, gids[i]));
+    }
+
+    auto inPlace = gids;
+    remap.remap(0, inPlace.data(), inPlace.data(), inPlace.size(), 0);
+    CHECK(inPlace == result);
+
+    CHECK_THROWS_AS(remap.table(1), std::out_of_range);
+  }
+}
@@ -0,0 +1,108 @@
+#include "step_gid_table.hpp"
+
+#include <doctest.h>
+
+#include "step_map.hpp"
+
+using namespace step;
+
+namespace {
+
+constexpr unsigned flipped = detail::flipped_horizontally_bit |
+                             detail::flipped_vertically_bit |
+                             detail::flipped_diagonally_bit;
+
+}  // namespace
+
+TEST_SUITE("gid_table")
+{
+  TEST_CASE("Bitsets")
+  {
+    const map map{"resource/gid_table/map.json"};
+    gid_bitset solid{map, "solid"};
+
+    CHECK(solid.size() == 9);
+    CHECK(solid.test(global_id{1}));
+    CHECK(!solid.test(global_id{2}));
+    CHECK(!solid.test(global_id{3}));
+    CHECK(solid[global_id{6}]);
+    CHECK(!solid[global_id{8}]);
+    CHECK(!solid[global_id{0}]);
+    CHECK(!solid[global_id{100}]);
+
+    // Flip flags are ignored
+    CHECK(solid[global_id{flipped | 1u}]);
+    CHECK(solid[global_id{detail::flipped_vertically_bit | 6u}]);
+
+    solid.set(global_id{flipped | 2u});
+    CHECK(solid[global_id{2}]);
+    solid.set(global_id{2}, false);
+    CHECK(!solid[global_id{2}]);
+    solid.set(global_id{100});
+    CHECK(!solid[global_id{100}]);
+
+    const gid_bitset lava{map, [](const tile& tile) {
+                            return tile.type() == "lava";
+                          }};
+    CHECK(lava[global_id{8}]);
+    CHECK(!lava[global_id{1}]);
+  }
+
+  TEST_CASE("Arrays")
+  {
+    const map map{"resource/gid_table/map.json"};
+
+    const gid_array<double> friction{map, "friction", 1.0};
+    CHECK(friction.size() == 9);
+    CHECK(friction.fallback() == 1.0);
+    CHECK(friction[global_id{1}] == 1.0);
+    CHECK(friction[global_id{3}] == 0.5);
+    CHECK(friction[global_id{flipped | 6u}] == 2.0);
+    CHECK(friction[global_id{1000}] == 1.0);
+
+    const gid_array<int> cost{map, "cost"};
+    CHECK(cost[global_id{1}] == 3);
+    CHECK(cost[global_id{6}] == -1);
+    CHECK(cost[global_id{2}] == 0);
+
+    gid_array<int> tileset{map,
+                           [](const step::tileset& ts, const tile&) {
+                             return ts.first_gid().get();
+                           },
+                           -1};
+    CHECK(tileset[global_id{1}] == 1);
+    CHECK(tileset[global_id{2}] == -1);  // No custom data
+    CHECK(tileset[global_id{8}] == 5);
+
+    tileset.set(global_id{flipped | 2u}, 42);
+    CHECK(tileset[global_id{2}] == 42);
+  }
+
+  TEST_CASE("Compiled tile properties")
+  {
+    const map map{"resource/gid_table/map.json"};
+    const tile_property_tables tables{map};
+
+    const auto* solid = tables.flags("solid");
+    REQUIRE(solid);
+    CHECK(solid->test(global_id{1}));
+    CHECK(!solid->test(global_id{3}));
+    CHECK(solid->test(global_id{6}));
+
+    const auto* cost = tables.integers("cost");
+    REQUIRE(cost);
+    CHECK(cost->get(global_id{1}) == 3);
+    CHECK(cost->get(global_id{flipped | 6u}) == -1);
+    CHECK(cost->get(global_id{4}) == 0);
+
+    const auto* friction = tables.floats("friction");
+    REQUIRE(friction);
+    CHECK(friction->get(global_id{3}) == 0.5f);
+    CHECK(friction->get(global_id{6}) == 2.0f);
+
+    CHECK(!tables.flags("cost"));
+    CHECK(!tables.integers("friction"));
+    CHECK(!tables.floats("kind"));
+    CHECK(!tables.flags("missing"));
+  }
+}
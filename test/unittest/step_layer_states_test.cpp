@@ -0,0 +1,72 @@
+#include "step_layer_states.hpp"
+
+#include <doctest.h>
+
+#include "step_exception.hpp"
+
+using namespace step;
+
+TEST_SUITE("layer_states")
+{
+  TEST_CASE("Accumulates group state")
+  {
+    const map map{"resource/layer_states/map.json"};
+    const layer_states states{map};
+
+    REQUIRE(states.size() == 6);
+    CHECK(states.index_of(1) == 0);
+    CHECK(states.index_of(10) == 1);
+    CHECK(states.index_of(2) == 2);
+    CHECK(states.index_of(11) == 3);
+    CHECK(states.index_of(20) == 4);
+    CHECK(states.index_of(3) == 5);
+
+    const auto& outer = states.get(10);
+    CHECK(outer.parent == -1);
+    CHECK(outer.end == 5);
+    CHECK(outer.source->name() == "outer");
+
+    const auto& walls = states.get(2);
+    CHECK(walls.parent == 1);
+    CHECK(walls.offset_x == 8);
+    CHECK(walls.offset_y == 4);
+    CHECK(walls.opacity == doctest::Approx(0.25));
+    CHECK(walls.visible);
+
+    const auto& objects = states.get(20);
+    CHECK(objects.parent == 3);
+    CHECK(objects.offset_x == 11);
+    CHECK(objects.offset_y == 2);
+    CHECK(objects.opacity == doctest::Approx(0.5));
+
+    CHECK(!states.get(3).visible);
+    CHECK_THROWS_AS(states.get(42), step_exception);
+  }
+
+  TEST_CASE("Overrides update descendants")
+  {
+    const map map{"resource/layer_states/map.json"};
+    layer_states states{map};
+
+    states.set_visible(10, false);
+    CHECK(!states.get(10).visible);
+    CHECK(!states.get(2).visible);
+    CHECK(!states.get(20).visible);
+    CHECK(states.get(1).visible);
+
+    states.set_visible(10, true);
+    CHECK(states.get(20).visible);
+
+    states.set_opacity(11, 0.5);
+    CHECK(states.get(20).opacity == doctest::Approx(0.25));
+    CHECK(states.get(2).opacity == doctest::Approx(0.25));
+
+    states.set_offset(10, 0, 10);
+    CHECK(states.get(20).offset_x == 3);
+    CHECK(states.get(20).offset_y == 12);
+    CHECK(states.get(2).offset_y == 14);
+    CHECK(states.get(3).offset_y == 0);
+
+    CHECK_THROWS_AS(states.set_visible(42, false), step_exception);
+  }
+}
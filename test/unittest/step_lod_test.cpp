@@ -0,0 +1,175 @@
+#include "step_lod.hpp"
+
+#include <doctest.h>
+
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "step_exception.hpp"
+#include "step_map.hpp"
+
+using namespace step;
+
+namespace {
+
+using weight_function = std::function<double(unsigned)>;
+
+auto naive_summary(const std::vector<unsigned>& cells,
+                   int width,
+                   int height,
+                   const weight_function& weight) -> std::vector<unsigned>
+{
+  const auto nextWidth = (width + 1) / 2;
+  const auto nextHeight = (height + 1) / 2;
+
+  std::vector<unsigned> result;
+  for (auto row = 0; row < nextHeight; ++row) {
+    for (auto col = 0; col < nextWidth; ++col) {
+      std::vector<unsigned> block;
+      for (const auto [dx, dy] : {std::pair{0, 0}, {1, 0}, {0, 1}, {1, 1}}) {
+        const auto c = col * 2 + dx;
+        const auto r = row * 2 + dy;
+        if (c < width && r < height && cells[r * width + c] != 0) {
+          block.push_back(cells[r * width + c]);
+        }
+      }
+
+      auto best = block.empty() ? 0u : block.front();
+      auto bestScore = 0.0;
+      for (const auto gid : block) {
+        auto score = 0.0;
+        for (const auto other : block) {
+          score += other == gid ? weight(other) : 0.0;
+        }
+        if (score > bestScore) {
+          best = gid;
+          bestScore = score;
+        }
+      }
+      result.push_back(best);
+    }
+  }
+  return result;
+}
+
+void check_pyramid(const lod_pyramid& pyramid, const weight_function& weight)
+{
+  auto cells = pyramid.level(0);
+  auto width = pyramid.width(0);
+  auto height = pyramid.height(0);
+
+  for (std::size_t level = 1; level < pyramid.levels(); ++level) {
+    cells = naive_summary(cells, width, height, weight);
+    width = (width + 1) / 2;
+    height = (height + 1) / 2;
+
+    REQUIRE(pyramid.width(level) == width);
+    REQUIRE(pyramid.height(level) == height);
+    CHECK(pyramid.level(level) == cells);
+  }
+
+  for (std::size_t level = 0; level < pyramid.levels(); ++level) {
+    for (auto cr = 0; cr < pyramid.chunk_rows(level); ++cr) {
+      for (auto cc = 0; cc < pyramid.chunk_cols(level); ++cc) {
+        auto expected = 0;
+        for (auto r = 0; r < lod_pyramid::chunk_size; ++r) {
+          for (auto c = 0; c < lod_pyramid::chunk_size; ++c) {
+            const auto col = cc * lod_pyramid::chunk_size + c;
+            const auto row = cr * lod_pyramid::chunk_size + r;
+            expected += pyramid.gid_at(level, col, row).get() != 0 ? 1 : 0;
+          }
+        }
+        CHECK(pyramid.chunk_count(level, cc, cr) == expected);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST_SUITE("lod_pyramid")
+{
+  TEST_CASE("Most common tiles")
+  {
+    const map map{"resource/lod/map.json"};
+    const lod_pyramid serial{map, "ground", 1};
+    const lod_pyramid parallel{map, "ground", 4};
+
+    REQUIRE(serial.levels() == 7);
+    CHECK(serial.width(6) == 1);
+    CHECK(serial.height(6) == 1);
+
+    check_pyramid(serial, [](unsigned) { return 1.0; });
+    for (std::size_t level = 0; level < serial.levels(); ++level) {
+      CHECK(serial.level(level) == parallel.level(level));
+    }
+
+    CHECK(serial.gid_at(1, -1, 0).get() == 0);
+    CHECK(serial.chunk_count(0, 5, 5) == 0);
+    CHECK_THROWS_AS((void) serial.level(7), std::out_of_range);
+    CHECK_THROWS_AS(lod_pyramid(map, "missing"), step_exception);
+  }
+
+  TEST_CASE("Weighted tiles")
+  {
+    const map map{"resource/lod/map.json"};
+    const lod_pyramid pyramid{
+        map, "ground", gid_array<double>{map, "weight", 1.0}};
+
+    check_pyramid(pyramid, [](unsigned gid) {
+      return gid == 3 ? 5.0 : gid == 2 ? 0.0 : 1.0;
+    });
+
+    // Heavy tiles win every block that they appear in
+    const auto& base = pyramid.level(0);
+    for (auto row = 0; row < pyramid.height(1); ++row) {
+      for (auto col = 0; col < pyramid.width(1); ++col) {
+        const auto c = col * 2;
+        const auto r = row * 2;
+        const auto width = pyramid.width(0);
+        const auto height = pyramid.height(0);
+
+        auto heavy = false;
+        for (auto i = 0; i < 4; ++i) {
+          const auto x = c + i % 2;
+          const auto y = r + i / 2;
+          heavy |= x < width && y < height && base[y * width + x] == 3;
+        }
+        CHECK((pyramid.gid_at(1, col, row).get() == 3) == heavy);
+      }
+    }
+  }
+
+  TEST_CASE("Incremental updates")
+  {
+    const map map{"resource/lod/map.json"};
+    lod_pyramid pyramid{map, "ground"};
+
+    std::mt19937 rng{3};
+    std::uniform_int_distribution<int> cols{0, 36};
+    std::uniform_int_distribution<int> rows{0, 22};
+    std::uniform_int_distribution<unsigned> gids{0, 3};
+    for (auto i = 0; i < 300; ++i) {
+      pyramid.set(cols(rng), rows(rng), global_id{gids(rng)});
+    }
+
+    check_pyramid(pyramid, [](unsigned) { return 1.0; });
+    CHECK_THROWS_AS(pyramid.set(37, 0, global_id{1}), step_exception);
+  }
+
+  TEST_CASE("Levels for zoom factors")
+  {
+    const map map{"resource/lod/map.json"};
+    const lod_pyramid pyramid{map, "ground"};
+
+    CHECK(pyramid.level_for_scale(2) == 0);
+    CHECK(pyramid.level_for_scale(1) == 0);
+    CHECK(pyramid.level_for_scale(0.75) == 0);
+    CHECK(pyramid.level_for_scale(0.5) == 1);
+    CHECK(pyramid.level_for_scale(0.3) == 1);
+    CHECK(pyramid.level_for_scale(0.25) == 2);
+    CHECK(pyramid.level_for_scale(0.001) == 6);
+    CHECK(pyramid.level_for_scale(0) == 6);
+  }
+}
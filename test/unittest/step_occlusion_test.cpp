@@ -0,0 +1,100 @@
+#include "step_occlusion.hpp"
+
+#include <doctest.h>
+
+#include "step_exception.hpp"
+#include "step_map.hpp"
+
+using namespace step;
+
+namespace {
+
+constexpr int floor_id = 1;
+constexpr int walls_id = 2;
+constexpr int roof_id = 3;
+constexpr int overlay_id = 4;
+constexpr int shadows_id = 5;
+constexpr int top_id = 6;
+
+auto count_occluded(const occlusion_mask& mask, int layer) -> int
+{
+  auto count = 0;
+  for (auto row = 0; row < 20; ++row) {
+    for (auto col = 0; col < 40; ++col) {
+      count += mask.occluded(layer, col, row) ? 1 : 0;
+    }
+  }
+  return count;
+}
+
+}  // namespace
+
+TEST_SUITE("occlusion_mask")
+{
+  TEST_CASE("Occluded cells")
+  {
+    const map map{"resource/occlusion/map.json"};
+    const occlusion_mask mask{map, "opaque"};
+
+    for (auto row = 0; row < 20; ++row) {
+      for (auto col = 0; col < 40; ++col) {
+        const auto byTop = row >= 10 && col >= 20;
+        CHECK(mask.occluded(floor_id, col, row) == (col < 20 || byTop));
+        CHECK(mask.occluded(overlay_id, col, row) == byTop);
+        CHECK(mask.occluded(shadows_id, col, row) == (byTop && col >= 30));
+      }
+    }
+
+    // Walls are only covered by translucent, hidden or offset layers
+    CHECK(count_occluded(mask, walls_id) == 0);
+    CHECK(count_occluded(mask, roof_id) == 0);
+    CHECK(count_occluded(mask, top_id) == 0);
+    CHECK(mask.occluded_count() == 600 + 200 + 100);
+
+    CHECK(!mask.occluded(floor_id, -1, 0));
+    CHECK(!mask.occluded(floor_id, 0, 20));
+    CHECK_THROWS_AS((void) mask.occluded(7, 0, 0), step_exception);
+  }
+
+  TEST_CASE("Chunks")
+  {
+    const map map{"resource/occlusion/map.json"};
+    const occlusion_mask mask{map, "opaque", 1};
+
+    REQUIRE(mask.chunk_cols() == 3);
+    REQUIRE(mask.chunk_rows() == 2);
+
+    CHECK(mask.chunk_hidden(floor_id, 0, 0));
+    CHECK(mask.chunk_hidden(floor_id, 0, 1));
+    CHECK(!mask.chunk_hidden(floor_id, 1, 0));
+    CHECK(mask.chunk_hidden(floor_id, 2, 1));
+    CHECK(!mask.chunk_hidden(walls_id, 0, 0));
+
+    // The walls layer has no tiles in the last chunk column
+    CHECK(mask.chunk_hidden(walls_id, 2, 0));
+
+    const auto& bits = mask.chunk_mask(floor_id, 1, 0);
+    CHECK(bits.count() == 4 * 16 + 12 * 6);
+    CHECK(bits.test(0));
+    CHECK(!bits.test(4));
+    CHECK(bits.test(10 * 16 + 4));
+
+    CHECK_THROWS_AS((void) mask.chunk_mask(floor_id, 3, 0), step_exception);
+  }
+
+  TEST_CASE("Caller supplied opaque tiles")
+  {
+    const map map{"resource/occlusion/map.json"};
+
+    gid_bitset opaque{detail::gid_count(map)};
+    opaque.set(global_id{2});
+    const occlusion_mask mask{map, opaque, 4};
+
+    // Only the bottom layer has the opaque tile, so nothing is covered
+    CHECK(mask.occluded_count() == 0);
+
+    const occlusion_mask serial{map, "opaque", 1};
+    const occlusion_mask parallel{map, "opaque", 4};
+    CHECK(serial.occluded_count() == parallel.occluded_count());
+  }
+}
@@ -0,0 +1,217 @@
+#include "step_pathfinding.hpp"
+
+#include <doctest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "step_map.hpp"
+
+using namespace step;
+
+namespace {
+
+inline constexpr double infinity = std::numeric_limits<double>::infinity();
+
+// Bellman-Ford style relaxation, slow but obviously correct
+auto reference_costs(const walkability_grid& grid, tile_pos start)
+    -> std::vector<double>
+{
+  const auto width = grid.width();
+  std::vector<double> costs(
+      static_cast<std::size_t>(grid.width() * grid.height()), infinity);
+  costs[static_cast<std::size_t>(start.row * width + start.col)] = 0;
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int row = 0; row < grid.height(); ++row) {
+      for (int col = 0; col < width; ++col) {
+        const auto cost = costs[static_cast<std::size_t>(row * width + col)];
+        if (cost == infinity) {
+          continue;
+        }
+
+        grid.each_neighbour({col, row}, [&](tile_pos next, double dist) {
+          auto& other =
+              costs[static_cast<std::size_t>(next.row * width + next.col)];
+          const auto candidate = cost + dist * grid.cost(next);
+          if (candidate < other - 1e-9) {
+            other = candidate;
+            changed = true;
+          }
+        });
+      }
+    }
+  }
+
+  return costs;
+}
+
+auto is_valid_path(const walkability_grid& grid,
+                   const std::vector<tile_pos>& path,
+                   tile_pos start,
+                   tile_pos goal) -> bool
+{
+  if (path.empty() || path.front() != start || path.back() != goal) {
+    return false;
+  }
+
+  for (std::size_t i = 1; i < path.size(); ++i) {
+    bool adjacent = false;
+    grid.each_neighbour(path[i - 1], [&](tile_pos next, double) {
+      adjacent = adjacent || next == path[i];
+    });
+    if (!adjacent) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void add_obstacles(walkability_grid& grid)
+{
+  for (int row = 0; row < grid.height(); ++row) {
+    for (int col = 0; col < grid.width(); ++col) {
+      if ((col * 7 + row * 13) % 11 == 0 || (col % 6 == 3 && row % 9 != 4)) {
+        grid.set_cost(col, row, walkability_grid::blocked);
+      } else if ((col + row) % 5 == 0) {
+        grid.set_cost(col, row, 3);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST_SUITE("path_finder")
+{
+  TEST_CASE("Shortest path around walls")
+  {
+    const map map{"resource/pathfinding/costs.json"};
+    const walkability_grid grid{map, "cost"};
+    path_finder finder{grid};
+
+    const auto path = finder.find_path({0, 0}, {6, 0});
+    REQUIRE(is_valid_path(grid, path, {0, 0}, {6, 0}));
+
+    const auto expected = reference_costs(grid, {0, 0});
+    CHECK(grid.path_cost(path) == doctest::Approx(expected[6]));
+
+    CHECK(finder.find_path({0, 0}, {3, 0}).empty());  // Blocked goal
+    CHECK(finder.find_path({0, 0}, {0, 0}).size() == 1);
+  }
+
+  TEST_CASE("Shortest paths in all orientations")
+  {
+    for (const auto* file : {"resource/projection/orthogonal.json",
+                             "resource/projection/isometric.json",
+                             "resource/projection/staggered_x.json",
+                             "resource/projection/staggered_y.json",
+                             "resource/projection/hexagonal_x.json",
+                             "resource/projection/hexagonal_y.json"}) {
+      CAPTURE(std::string{file});
+      const map map{file};
+      walkability_grid grid{map};
+      add_obstacles(grid);
+
+      path_finder finder{grid};
+      const tile_pos start{0, 1};
+      const auto expected = reference_costs(grid, start);
+
+      for (int row = 0; row < grid.height(); ++row) {
+        for (int col = 0; col < grid.width(); ++col) {
+          const tile_pos goal{col, row};
+          const auto cost =
+              expected[static_cast<std::size_t>(row * grid.width() + col)];
+          const auto path = finder.find_path(start, goal);
+
+          if (cost == infinity || !grid.is_walkable(goal)) {
+            CHECK(path.empty());
+          } else {
+            REQUIRE(is_valid_path(grid, path, start, goal));
+            CHECK(grid.path_cost(path) == doctest::Approx(cost));
+            CHECK(grid.estimate(start, goal) <= cost + 1e-9);
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST_SUITE("hierarchical_path_finder")
+{
+  TEST_CASE("Paths match the flat search")
+  {
+    for (const auto* file : {"resource/pathfinding/open.json",
+                             "resource/projection/staggered_y.json",
+                             "resource/projection/hexagonal_x.json",
+                             "resource/projection/hexagonal_y.json"}) {
+      CAPTURE(std::string{file});
+      const map map{file};
+      walkability_grid grid{map};
+      add_obstacles(grid);
+
+      hierarchical_path_finder hierarchical{grid, 4};
+      CHECK(hierarchical.node_count() > 0);
+
+      for (const auto start : {tile_pos{0, 1}, tile_pos{5, 6}}) {
+        const auto expected = reference_costs(grid, start);
+        for (int row = 0; row < grid.height(); row += 3) {
+          for (int col = 0; col < grid.width(); col += 2) {
+            const tile_pos goal{col, row};
+            const auto cost =
+                expected[static_cast<std::size_t>(row * grid.width() + col)];
+            const auto path = hierarchical.find_path(start, goal);
+
+            if (cost == infinity || !grid.is_walkable(start) ||
+                !grid.is_walkable(goal)) {
+              CHECK(path.empty());
+            } else {
+              REQUIRE(is_valid_path(grid, path, start, goal));
+              CHECK(grid.path_cost(path) >= cost - 1e-9);
+              CHECK(grid.path_cost(path) <= cost * 1.5 + 4);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  TEST_CASE("Incremental repair")
+  {
+    const map map{"resource/pathfinding/open.json"};
+    hierarchical_path_finder finder{walkability_grid{map}, 8};
+
+    CHECK(finder.cluster_cols() == 6);
+    CHECK(finder.cluster_rows() == 6);
+    CHECK(finder.repair() == 0);
+
+    // Wall off the left side of the map, with a gap at row 30
+    for (int row = 0; row < 48; ++row) {
+      if (row != 30) {
+        finder.set_cost(20, row, walkability_grid::blocked);
+      }
+    }
+    CHECK(finder.repair() == 18);
+
+    auto path = finder.find_path({2, 2}, {40, 2});
+    REQUIRE(is_valid_path(finder.grid(), path, {2, 2}, {40, 2}));
+    CHECK(std::find(path.begin(), path.end(), tile_pos{20, 30}) != path.end());
+
+    finder.set_cost(20, 30, walkability_grid::blocked);
+    CHECK(finder.find_path({2, 2}, {40, 2}).empty());
+    CHECK(finder.repair() == 0);
+
+    finder.set_cost(20, 10, 1);
+    CHECK(finder.repair() == 9);
+
+    path = finder.find_path({2, 2}, {40, 2});
+    REQUIRE(is_valid_path(finder.grid(), path, {2, 2}, {40, 2}));
+    CHECK(std::find(path.begin(), path.end(), tile_pos{20, 10}) != path.end());
+  }
+}
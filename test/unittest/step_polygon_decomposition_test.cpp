@@ -0,0 +1,201 @@
+#include "step_polygon_decomposition.hpp"
+
+#include <doctest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "step_exception.hpp"
+#include "step_map.hpp"
+
+using namespace step;
+
+namespace {
+
+auto area(const std::vector<point>& points) -> double
+{
+  double sum = 0;
+  for (std::size_t i = 0, j = points.size() - 1; i < points.size(); j = i++) {
+    sum += points[j].x() * points[i].y() - points[i].x() * points[j].y();
+  }
+  return sum / 2.0;
+}
+
+auto is_convex(const std::vector<point>& points) -> bool
+{
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    const auto& a = points[i];
+    const auto& b = points[(i + 1) % points.size()];
+    const auto& c = points[(i + 2) % points.size()];
+    if (detail::cross(a, b, c) < -1e-9) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void check_decomposition(const polygon_decomposition& decomposition,
+                         double expectedArea)
+{
+  const auto& points = decomposition.points();
+  REQUIRE(points.size() >= 3);
+  CHECK(area(points) == doctest::Approx(expectedArea));
+  CHECK(decomposition.triangle_count() == points.size() - 2);
+
+  double triangles = 0;
+  const auto& indices = decomposition.triangles();
+  for (std::size_t i = 0; i < indices.size(); i += 3) {
+    const std::vector<point> triangle{points.at(indices[i]),
+                                      points.at(indices[i + 1]),
+                                      points.at(indices[i + 2])};
+    CHECK(area(triangle) > 0);
+    triangles += area(triangle);
+  }
+  CHECK(triangles == doctest::Approx(expectedArea));
+
+  double pieces = 0;
+  CHECK(decomposition.piece_count() <= decomposition.triangle_count());
+  for (std::size_t i = 0; i < decomposition.piece_count(); ++i) {
+    const auto piece = decomposition.piece_points(i);
+    CHECK(is_convex(piece));
+    pieces += area(piece);
+  }
+  CHECK(pieces == doctest::Approx(expectedArea));
+}
+
+auto corridor_points() -> std::vector<point>
+{
+  return {{0, 0}, {100, 0}, {100, 20}, {20, 20}, {20, 100}, {0, 100}};
+}
+
+}  // namespace
+
+TEST_SUITE("polygon_decomposition")
+{
+  TEST_CASE("Convex polygons are a single piece")
+  {
+    const polygon_decomposition square{
+        std::vector<point>{{0, 0}, {10, 0}, {10, 10}, {0, 10}}};
+    check_decomposition(square, 100);
+    CHECK(square.triangle_count() == 2);
+    CHECK(square.piece_count() == 1);
+    CHECK(square.piece(0).size() == 4);
+  }
+
+  TEST_CASE("Cleaning and winding order")
+  {
+    // Clockwise, with repeated and collinear points
+    const std::vector<point> points{{0, 0},
+                                    {0, 0},
+                                    {0, 5},
+                                    {0, 10},
+                                    {10, 10},
+                                    {10, 0},
+                                    {5, 0},
+                                    {0, 0}};
+    const polygon_decomposition square{points};
+    CHECK(square.points().size() == 4);
+    check_decomposition(square, 100);
+    CHECK(square.piece_count() == 1);
+
+    const polygon_decomposition line{
+        std::vector<point>{{0, 0}, {5, 5}, {10, 10}}};
+    CHECK(line.points().empty());
+    CHECK(line.triangle_count() == 0);
+    CHECK(line.piece_count() == 0);
+  }
+
+  TEST_CASE("Concave polygons")
+  {
+    const polygon_decomposition corridor{corridor_points()};
+    check_decomposition(corridor, 100 * 20 + 80 * 20);
+    CHECK(corridor.triangle_count() == 4);
+    CHECK(corridor.piece_count() == 2);
+  }
+
+  TEST_CASE("Random star-shaped polygons")
+  {
+    std::mt19937 rng{17};
+    std::uniform_real_distribution<double> radius{5, 100};
+    std::uniform_int_distribution<int> sizes{3, 200};
+
+    for (int i = 0; i < 50; ++i) {
+      const auto count = sizes(rng);
+      std::vector<point> points;
+      for (auto k = 0; k < count; ++k) {
+        const auto angle = 2 * detail::pi * k / count;
+        const auto r = radius(rng);
+        points.emplace_back(r * std::cos(angle), r * std::sin(angle));
+      }
+
+      const polygon_decomposition decomposition{points};
+      CHECK(decomposition.source_hash() == detail::hash_points(points));
+      check_decomposition(decomposition, std::abs(area(points)));
+    }
+  }
+
+  TEST_CASE("JSON round trip")
+  {
+    const polygon_decomposition original{corridor_points()};
+
+    const json json = original;
+    const polygon_decomposition parsed{json};
+
+    CHECK(parsed.source_hash() == original.source_hash());
+    CHECK(parsed.points().size() == original.points().size());
+    CHECK(parsed.triangles() == original.triangles());
+    REQUIRE(parsed.piece_count() == original.piece_count());
+    for (std::size_t i = 0; i < parsed.piece_count(); ++i) {
+      CHECK(parsed.piece(i) == original.piece(i));
+    }
+  }
+}
+
+TEST_SUITE("polygon_cache")
+{
+  TEST_CASE("Lazy decompositions")
+  {
+    const map map{"resource/shapes/shapes.json"};
+    const auto& objects = map.layers().at(0).as<object_group>().objects();
+
+    polygon_cache cache;
+    CHECK(cache.size() == 0);
+
+    const auto& star = cache.get(objects.at(0));
+    CHECK(cache.size() == 1);
+    CHECK(&cache.get(objects.at(0)) == &star);
+    CHECK(star.triangle_count() == 8);
+    CHECK(cache.find(objects.at(0).id()) == &star);
+    CHECK(!cache.find(objects.at(3).id()));
+
+    CHECK_THROWS_AS(cache.get(objects.at(1)), step_exception);
+    CHECK_THROWS_AS(cache.get(objects.at(2)), step_exception);
+  }
+
+  TEST_CASE("Build and store caches")
+  {
+    const map map{"resource/shapes/shapes.json"};
+    const auto& objects = map.layers().at(0).as<object_group>().objects();
+
+    polygon_cache cache;
+    cache.build(map, 2);
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.find(1));
+    REQUIRE(cache.find(4));
+    CHECK(cache.find(4)->piece_count() == 1);
+
+    const json json = cache;
+    const polygon_cache loaded{json};
+    REQUIRE(loaded.size() == 2);
+    CHECK(loaded.find(1)->triangles() == cache.find(1)->triangles());
+
+    // Outdated entries are computed again
+    auto stale = json;
+    stale["polygons"][0]["decomposition"]["hash"] = 0;
+    polygon_cache outdated{stale};
+    CHECK(outdated.find(1)->source_hash() == 0);
+    CHECK(outdated.get(objects.at(0)).source_hash() ==
+          cache.find(1)->source_hash());
+  }
+}
@@ -0,0 +1,147 @@
+#include "step_polygon_shape.hpp"
+
+#include <doctest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "step_exception.hpp"
+#include "step_map.hpp"
+
+using namespace step;
+
+namespace {
+
+auto objects(const map& map) -> const std::vector<object>&
+{
+  return map.layers().at(0).as<object_group>().objects();
+}
+
+auto brute_force_distance(const std::vector<point>& points,
+                          bool closed,
+                          const point& p) -> double
+{
+  auto best = std::numeric_limits<double>::infinity();
+  const auto count = closed ? points.size() : points.size() - 1;
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto closest = detail::closest_on_segment(
+        p, points[i], points[(i + 1) % points.size()]);
+    best = std::min(best, std::sqrt(detail::distance_squared(p, closest)));
+  }
+  return best;
+}
+
+}  // namespace
+
+TEST_SUITE("polygon_shape")
+{
+  TEST_CASE("Squares")
+  {
+    const map map{"resource/shapes/shapes.json"};
+    const polygon_shape square{objects(map).at(3)};
+
+    CHECK(square.closed());
+    CHECK(square.edge_count() == 4);
+    CHECK(square.bounds() == rect{300, 50, 40, 40});
+
+    CHECK(square.contains({320, 70}));
+    CHECK(!square.contains({299, 70}));
+    CHECK(!square.contains({320, 91}));
+
+    CHECK(square.intersects({280, 70}, {310, 70}));
+    CHECK(square.intersects({280, 50}, {400, 50}));  // Along an edge
+    CHECK(!square.intersects({310, 60}, {330, 80}));  // Inside
+    CHECK(!square.intersects({0, 0}, {10, 10}));
+
+    const auto outside = square.nearest({350, 70});
+    CHECK(outside.position.x() == doctest::Approx(340));
+    CHECK(outside.position.y() == doctest::Approx(70));
+    CHECK(outside.distance == doctest::Approx(10));
+    CHECK(outside.edge == 1);
+
+    const auto inside = square.nearest({305, 70});
+    CHECK(inside.distance == doctest::Approx(5));
+    CHECK(square.distance({305, 70}) == 0);
+    CHECK(square.distance({350, 70}) == doctest::Approx(10));
+  }
+
+  TEST_CASE("Polylines")
+  {
+    const map map{"resource/shapes/shapes.json"};
+    const polygon_shape path{objects(map).at(1)};
+
+    CHECK(!path.closed());
+    CHECK(path.edge_count() == 3);
+    CHECK(!path.contains({50, 10}));
+    CHECK(path.edge_start(2).x() == 100);
+    CHECK(path.edge_start(2).y() == 100);
+
+    const auto nearest = path.nearest({150, 90});
+    CHECK(nearest.position.y() == doctest::Approx(100));
+    CHECK(nearest.distance == doctest::Approx(10));
+    CHECK(nearest.edge == 2);
+
+    // The open end of the polyline
+    CHECK(path.intersects({10, 50}, {200, 50}));
+    CHECK(!path.intersects({-10, 10}, {-10, 200}));
+  }
+
+  TEST_CASE("Only polygons and polylines are supported")
+  {
+    const map map{"resource/shapes/shapes.json"};
+    CHECK_THROWS_AS(polygon_shape{objects(map).at(2)}, step_exception);
+  }
+
+  TEST_CASE("Rotated concave polygon matches brute force")
+  {
+    const map map{"resource/shapes/shapes.json"};
+    const auto& object = objects(map).at(0);
+    const polygon_shape star{object};
+
+    // The first point of the star is rotated 30 degrees around the position
+    const auto& first = star.points().front();
+    CHECK(first.x() == doctest::Approx(100 + 50 * std::cos(detail::pi / 6)));
+    CHECK(first.y() == doctest::Approx(100 + 50 * std::sin(detail::pi / 6)));
+
+    std::mt19937 rng{5};
+    std::uniform_real_distribution<double> coordinate{30, 170};
+    std::vector<point> points;
+    for (int i = 0; i < 3000; ++i) {
+      points.emplace_back(coordinate(rng), coordinate(rng));
+    }
+
+    const auto& outline = star.points();
+    for (const auto& p : points) {
+      CHECK(star.contains(p) ==
+            detail::polygon_contains(outline.data(), outline.size(), p));
+      CHECK(star.nearest(p).distance ==
+            doctest::Approx(brute_force_distance(outline, true, p)));
+    }
+
+    for (std::size_t i = 0; i + 1 < points.size(); i += 2) {
+      auto expected = false;
+      for (std::size_t e = 0; e < star.edge_count(); ++e) {
+        expected = expected || detail::segments_intersect(points[i],
+                                                          points[i + 1],
+                                                          star.edge_start(e),
+                                                          star.edge_end(e));
+      }
+      CHECK(star.intersects(points[i], points[i + 1]) == expected);
+    }
+
+    std::vector<unsigned char> inside;
+    star.contains(points, inside, 4);
+    std::vector<nearest_point> nearest;
+    star.nearest(points, nearest, 4);
+
+    REQUIRE(inside.size() == points.size());
+    REQUIRE(nearest.size() == points.size());
+    for (std::size_t i = 0; i < points.size(); ++i) {
+      CHECK((inside[i] != 0) == star.contains(points[i]));
+      CHECK(nearest[i].edge == star.nearest(points[i]).edge);
+    }
+  }
+}
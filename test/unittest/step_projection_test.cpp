@@ -0,0 +1,203 @@
+#include "step_projection.hpp"
+
+#include <doctest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "step_map.hpp"
+
+using namespace step;
+
+namespace {
+
+template <typename Projection>
+auto brute_force_visible(const Projection& projection,
+                         const map& map,
+                         double x,
+                         double y,
+                         double width,
+                         double height) -> std::vector<tile_pos>
+{
+  std::vector<tile_pos> result;
+  if (width <= 0 || height <= 0) {
+    return result;
+  }
+
+  for (int row = 0; row < map.height(); ++row) {
+    for (int col = 0; col < map.width(); ++col) {
+      const auto pixel = projection.tile_to_pixel({col, row});
+      if (pixel.x() < x + width && pixel.x() + projection.tile_width() > x &&
+          pixel.y() < y + height && pixel.y() + projection.tile_height() > y) {
+        result.push_back({col, row});
+      }
+    }
+  }
+  return result;
+}
+
+auto contains(const std::vector<tile_pos>& tiles, tile_pos pos) -> bool
+{
+  return std::find(tiles.begin(), tiles.end(), pos) != tiles.end();
+}
+
+}  // namespace
+
+TEST_SUITE("projection")
+{
+  TEST_CASE("Orthogonal conversions")
+  {
+    const map map{"resource/projection/orthogonal.json"};
+    const projection<map::orientation::orthogonal> projection{map};
+
+    const auto pixel = projection.tile_to_pixel({3, 2});
+    CHECK(pixel.x() == 96);
+    CHECK(pixel.y() == 48);
+
+    CHECK(projection.pixel_to_tile(96, 48) == tile_pos{3, 2});
+    CHECK(projection.pixel_to_tile(127.9, 71.9) == tile_pos{3, 2});
+    CHECK(projection.pixel_to_tile(-1, -1) == tile_pos{-1, -1});
+
+    const auto neighbours = projection.neighbours_of({3, 2});
+    CHECK(neighbours.at(0) == tile_pos{3, 1});
+    CHECK(neighbours.at(1) == tile_pos{4, 2});
+    CHECK(neighbours.at(7) == tile_pos{2, 1});
+  }
+
+  TEST_CASE("Batched conversions")
+  {
+    const map map{"resource/projection/isometric.json"};
+    const projection<map::orientation::isometric> projection{map};
+
+    const std::vector<int> cols{0, 1, 2, 8};
+    const std::vector<int> rows{0, 5, 3, 6};
+    std::vector<double> xs(cols.size());
+    std::vector<double> ys(cols.size());
+    projection.tile_to_pixel(
+        cols.data(), rows.data(), cols.size(), xs.data(), ys.data());
+
+    for (auto& x : xs) {
+      x += projection.tile_width() / 2.0;
+    }
+    for (auto& y : ys) {
+      y += projection.tile_height() / 2.0;
+    }
+
+    std::vector<int> outCols(cols.size());
+    std::vector<int> outRows(cols.size());
+    projection.pixel_to_tile(
+        xs.data(), ys.data(), xs.size(), outCols.data(), outRows.data());
+
+    CHECK(outCols == cols);
+    CHECK(outRows == rows);
+  }
+
+  TEST_CASE("Orthogonal render order")
+  {
+    const map map{"resource/projection/orthogonal_left_up.json"};
+    const projection<map::orientation::orthogonal> projection{map};
+
+    std::vector<tile_pos> tiles;
+    for (const auto pos : projection.visible_tiles(40, 30, 40, 20)) {
+      tiles.push_back(pos);
+    }
+
+    const std::vector<tile_pos> expected{
+        {2, 2}, {1, 2}, {2, 1}, {1, 1}};
+    CHECK(tiles == expected);
+  }
+
+  TEST_CASE("Staggered pixel to tile matches diamond containment")
+  {
+    for (const auto* file : {"resource/projection/staggered_x.json",
+                             "resource/projection/staggered_y.json"}) {
+      const map map{file};
+      const projection<map::orientation::staggered> projection{map};
+
+      for (double y = 1.5; y < 150; y += 3.25) {
+        for (double x = 1.5; x < 300; x += 3.75) {
+          const auto pos = projection.pixel_to_tile(x, y);
+          const auto center = projection.tile_center(pos);
+          const auto dx = std::abs(x - center.x()) / (map.tile_width() / 2.0);
+          const auto dy = std::abs(y - center.y()) / (map.tile_height() / 2.0);
+          CHECK(dx + dy <= 1.0);
+        }
+      }
+    }
+  }
+
+  TEST_CASE("Round trips, neighbours and visible tiles")
+  {
+    for (const auto* file : {"resource/projection/orthogonal.json",
+                             "resource/projection/isometric.json",
+                             "resource/projection/staggered_x.json",
+                             "resource/projection/staggered_y.json",
+                             "resource/projection/hexagonal_x.json",
+                             "resource/projection/hexagonal_y.json"}) {
+      CAPTURE(std::string{file});
+      const map map{file};
+
+      visit_projection(map, [&](const auto& projection) {
+        for (int row = 0; row < map.height(); ++row) {
+          for (int col = 0; col < map.width(); ++col) {
+            const tile_pos pos{col, row};
+            CHECK(projection.pixel_to_tile(projection.tile_center(pos)) == pos);
+
+            for (const auto neighbour : projection.neighbours_of(pos)) {
+              const auto back = projection.neighbours_of(neighbour);
+              CHECK(std::find(back.begin(), back.end(), pos) != back.end());
+            }
+          }
+        }
+
+        const double rects[][4] = {{0, 0, 1000, 1000},
+                                   {37, 21, 90, 55},
+                                   {-50, -50, 60, 60},
+                                   {150, 40, 1, 1},
+                                   {64, 32, 0, 10}};
+        for (const auto& rect : rects) {
+          const auto expected = brute_force_visible(
+              projection, map, rect[0], rect[1], rect[2], rect[3]);
+
+          std::vector<tile_pos> actual;
+          for (const auto pos :
+               projection.visible_tiles(rect[0], rect[1], rect[2], rect[3])) {
+            actual.push_back(pos);
+          }
+
+          REQUIRE(actual.size() == expected.size());
+          for (const auto pos : actual) {
+            CHECK(contains(expected, pos));
+          }
+
+          // Tiles must never be drawn before tiles that are above them
+          for (std::size_t i = 1; i < actual.size(); ++i) {
+            const auto prev = projection.tile_to_pixel(actual[i - 1]);
+            const auto curr = projection.tile_to_pixel(actual[i]);
+            if (map.get_orientation() != map::orientation::orthogonal) {
+              CHECK(prev.y() <= curr.y() + projection.tile_height() / 2.0);
+            }
+          }
+        }
+      });
+    }
+  }
+
+  TEST_CASE("Hexagonal neighbours are equidistant")
+  {
+    const map map{"resource/projection/hexagonal_y.json"};
+    const projection<map::orientation::hexagonal> projection{map};
+
+    for (const auto pos : {tile_pos{3, 3}, tile_pos{4, 4}}) {
+      const auto center = projection.tile_center(pos);
+      for (const auto neighbour : projection.neighbours_of(pos)) {
+        const auto other = projection.tile_center(neighbour);
+        const auto distance = std::hypot(other.x() - center.x(),
+                                         other.y() - center.y());
+        CHECK(distance == doctest::Approx(24).epsilon(0.05));
+      }
+    }
+  }
+}
@@ -0,0 +1,149 @@
+#include "step_raycast.hpp"
+
+#include <doctest.h>
+
+#include <cmath>
+#include <optional>
+#include <vector>
+
+#include "step_map.hpp"
+
+using namespace step;
+
+namespace {
+
+auto make_pattern(int width, int height) -> tile_mask
+{
+  tile_mask mask{width, height};
+  for (int row = 0; row < height; ++row) {
+    for (int col = 0; col < width; ++col) {
+      if ((col * 7 + row * 13) % 23 == 0) {
+        mask.set(col, row);
+      }
+    }
+  }
+  return mask;
+}
+
+// Finds the first solid tile by sampling the ray densely
+auto sample(const tile_mask& solid, const ray& r) -> std::optional<tile_pos>
+{
+  constexpr int samples = 200'000;
+  for (int i = 0; i <= samples; ++i) {
+    const auto t = static_cast<double>(i) / samples;
+    const tile_pos pos{
+        static_cast<int>(std::floor(r.from.x() + (r.to.x() - r.from.x()) * t)),
+        static_cast<int>(std::floor(r.from.y() + (r.to.y() - r.from.y()) * t))};
+    if (solid.test(pos)) {
+      return pos;
+    }
+  }
+  return std::nullopt;
+}
+
+auto make_rays() -> std::vector<ray>
+{
+  std::vector<ray> rays;
+  for (int i = 0; i < 300; ++i) {
+    const point from{(i * 37 % 397) / 10.0 + 0.013, (i * 53 % 293) / 10.0};
+    const point to{(i * 71 % 401) / 10.0, (i * 29 % 307) / 10.0 + 0.027};
+    rays.push_back({from, to});
+  }
+  return rays;
+}
+
+}  // namespace
+
+TEST_SUITE("raycaster")
+{
+  TEST_CASE("Hits against map tiles")
+  {
+    const map map{"resource/collision/map.json"};
+    const auto solid = make_tile_mask(map, "solid");
+    const raycaster raycaster{solid, map};
+
+    SUBCASE("Horizontal ray")
+    {
+      const auto hit = raycaster.cast({{100, 8}, {0, 8}});
+      REQUIRE(hit);
+      CHECK(hit->tile == tile_pos{2, 0});
+      CHECK(hit->position.x() == doctest::Approx(48));
+      CHECK(hit->position.y() == doctest::Approx(8));
+      CHECK(hit->normal.x() == 1);
+      CHECK(hit->normal.y() == 0);
+      CHECK(hit->fraction == doctest::Approx(0.52));
+    }
+
+    SUBCASE("Vertical ray")
+    {
+      const auto hit = raycaster.cast({{104, 10}, {104, 90}});
+      REQUIRE(hit);
+      CHECK(hit->tile == tile_pos{6, 4});
+      CHECK(hit->position.y() == doctest::Approx(64));
+      CHECK(hit->normal.x() == 0);
+      CHECK(hit->normal.y() == -1);
+    }
+
+    SUBCASE("Ray that starts inside a solid tile")
+    {
+      const auto hit = raycaster.cast({{8, 8}, {200, 8}});
+      REQUIRE(hit);
+      CHECK(hit->tile == tile_pos{0, 0});
+      CHECK(hit->fraction == 0);
+      CHECK(hit->normal.x() == 0);
+      CHECK(hit->normal.y() == 0);
+    }
+
+    SUBCASE("Line of sight")
+    {
+      CHECK(!raycaster.cast({{60, 40}, {90, 40}}));
+      CHECK(raycaster.line_of_sight({60, 40}, {90, 40}));
+      CHECK(raycaster.line_of_sight({60, 40}, {60, 40}));
+      CHECK(!raycaster.line_of_sight({60, 40}, {8, 88}));
+    }
+  }
+
+  TEST_CASE("Traversal matches dense sampling")
+  {
+    const auto solid = make_pattern(40, 30);
+    const raycaster raycaster{solid};
+
+    for (const auto& r : make_rays()) {
+      const auto hit = raycaster.cast(r);
+      const auto expected = sample(solid, r);
+
+      REQUIRE(hit.has_value() == expected.has_value());
+      if (hit) {
+        CHECK(hit->tile == *expected);
+        CHECK(hit->position.x() == doctest::Approx(
+                                       r.from.x() + (r.to.x() - r.from.x()) *
+                                                        hit->fraction));
+      }
+    }
+  }
+
+  TEST_CASE("Batched rays")
+  {
+    const auto solid = make_pattern(40, 30);
+    const raycaster raycaster{solid};
+    const auto rays = make_rays();
+
+    std::vector<std::optional<ray_hit>> hits;
+    std::vector<unsigned char> visible;
+    for (const auto threads : {1, 4}) {
+      raycaster.cast(rays, hits, threads);
+      raycaster.line_of_sight(rays, visible, threads);
+      REQUIRE(hits.size() == rays.size());
+      REQUIRE(visible.size() == rays.size());
+
+      for (std::size_t i = 0; i < rays.size(); ++i) {
+        const auto expected = raycaster.cast(rays[i]);
+        REQUIRE(hits[i].has_value() == expected.has_value());
+        if (expected) {
+          CHECK(hits[i]->tile == expected->tile);
+        }
+        CHECK((visible[i] == 1) == !expected);
+      }
+    }
+  }
+}
@@ -0,0 +1,164 @@
+#include "step_regions.hpp"
+
+#include <doctest.h>
+
+#include <string>
+#include <vector>
+
+#include "step_map.hpp"
+
+using namespace step;
+
+namespace {
+
+// Labels the regions by flood filling, slow but obviously correct
+auto reference_labels(const tile_mask& mask, const connectivity& connections)
+    -> std::vector<int>
+{
+  const auto width = mask.width();
+  std::vector<int> labels(
+      static_cast<std::size_t>(mask.width() * mask.height()), region_map::none);
+
+  int next = 0;
+  for (int row = 0; row < mask.height(); ++row) {
+    for (int col = 0; col < width; ++col) {
+      const auto index = static_cast<std::size_t>(row * width + col);
+      if (!mask.test(col, row) || labels[index] != region_map::none) {
+        continue;
+      }
+
+      std::vector<tile_pos> stack{{col, row}};
+      labels[index] = next;
+      while (!stack.empty()) {
+        const auto pos = stack.back();
+        stack.pop_back();
+        connections.each(pos, [&](tile_pos other) {
+          if (!mask.test(other)) {
+            return;
+          }
+          auto& label =
+              labels[static_cast<std::size_t>(other.row * width + other.col)];
+          if (label == region_map::none) {
+            label = next;
+            stack.push_back(other);
+          }
+        });
+      }
+      ++next;
+    }
+  }
+
+  return labels;
+}
+
+auto make_pattern(int width, int height) -> tile_mask
+{
+  tile_mask mask{width, height};
+  for (int row = 0; row < height; ++row) {
+    for (int col = 0; col < width; ++col) {
+      if ((col * 7 + row * 3) % 5 != 0 && (col / 4 + row / 3) % 4 != 0) {
+        mask.set(col, row);
+      }
+    }
+  }
+  return mask;
+}
+
+}  // namespace
+
+TEST_SUITE("region_map")
+{
+  TEST_CASE("Rooms and doors")
+  {
+    const map map{"resource/regions/rooms.json"};
+    const auto floor = make_tile_mask(map, "floor");
+    const auto doors = make_tile_mask(map, "door");
+
+    const region_map regions{floor, doors, connectivity::of(map)};
+    REQUIRE(regions.regions().size() == 5);
+
+    CHECK(regions.label({1, 1}) == 0);
+    CHECK(regions.label({5, 1}) == 1);
+    CHECK(regions.label({9, 1}) == 2);
+    CHECK(regions.label({1, 5}) == 3);
+    CHECK(regions.label({6, 5}) == 4);
+    CHECK(regions.label({0, 0}) == region_map::none);
+    CHECK(regions.label({4, 2}) == region_map::none);
+    CHECK(regions.label({-1, 2}) == region_map::none);
+
+    CHECK(regions.connected({1, 1}, {3, 3}));
+    CHECK(!regions.connected({1, 1}, {5, 1}));
+
+    const auto& room = regions.regions().at(4);
+    CHECK(room.area == 10);
+    CHECK(room.min == tile_pos{6, 5});
+    CHECK(room.max == tile_pos{10, 6});
+
+    const auto& links = regions.links();
+    REQUIRE(links.size() == 3);
+    CHECK(links.at(0).from == 0);
+    CHECK(links.at(0).to == 1);
+    CHECK(links.at(0).door == tile_pos{4, 2});
+    CHECK(links.at(1).from == 0);
+    CHECK(links.at(1).to == 3);
+    CHECK(links.at(1).door == tile_pos{2, 4});
+    CHECK(links.at(2).from == 1);
+    CHECK(links.at(2).to == 2);
+
+    CHECK(regions.neighbours(0) == std::vector<int>{1, 3});
+    CHECK(regions.neighbours(4).empty());
+  }
+
+  TEST_CASE("Mismatching door mask")
+  {
+    const tile_mask mask{4, 4};
+    const tile_mask doors{4, 5};
+    CHECK_THROWS_AS(region_map(mask, doors, connectivity::four()),
+                    step_exception);
+  }
+
+  TEST_CASE("Four and eight connectivity")
+  {
+    tile_mask mask{5, 5};
+    for (int i = 0; i < 5; ++i) {
+      mask.set(i, i);
+    }
+
+    CHECK(region_map{mask, connectivity::four()}.regions().size() == 5);
+    CHECK(region_map{mask, connectivity::eight()}.regions().size() == 1);
+  }
+
+  TEST_CASE("Labels match flood fill in all orientations")
+  {
+    for (const auto* file : {"resource/projection/orthogonal.json",
+                             "resource/projection/staggered_x.json",
+                             "resource/projection/staggered_y.json",
+                             "resource/projection/hexagonal_x.json",
+                             "resource/projection/hexagonal_y.json"}) {
+      CAPTURE(std::string{file});
+      const map map{file};
+      const auto mask = make_pattern(map.width(), map.height());
+      const auto connections = connectivity::of(map);
+
+      const region_map regions{mask, connections};
+      CHECK(regions.labels() == reference_labels(mask, connections));
+    }
+  }
+
+  TEST_CASE("Labels don't depend on the amount of threads")
+  {
+    const auto mask = make_pattern(301, 257);
+    const auto expected = reference_labels(mask, connectivity::eight());
+
+    for (const auto threads : {1, 3, 8}) {
+      const region_map regions{mask, connectivity::eight(), threads};
+      CHECK(regions.labels() == expected);
+
+      int area = 0;
+      for (const auto& region : regions.regions()) {
+        area += region.area;
+      }
+      CHECK(area == mask.count());
+    }
+  }
+}
@@ -0,0 +1,124 @@
+#include "step_render_list.hpp"
+
+#include <doctest.h>
+
+#include <string>
+#include <vector>
+
+#include "step_exception.hpp"
+
+using namespace step;
+
+namespace {
+
+using kind = render_item::kind;
+
+auto describe(const render_list& list) -> std::vector<std::string>
+{
+  std::vector<std::string> result;
+  list.each([&](const render_item& item) {
+    const auto prefix = item.type == kind::object ? "o" : "t";
+    result.push_back(prefix + std::to_string(item.layer) + ":" +
+                     std::to_string(item.index));
+  });
+  return result;
+}
+
+void check_sorted(const render_list& list)
+{
+  for (std::size_t i = 1; i < list.size(); ++i) {
+    CHECK(list.at(i - 1).depth <= list.at(i).depth);
+  }
+}
+
+}  // namespace
+
+TEST_SUITE("render_list")
+{
+  TEST_CASE("Orthogonal maps are sorted by y")
+  {
+    const map map{"resource/render_list/orthogonal.json"};
+    render_list list{map};
+
+    // Objects in groups with the index draw order aren't depth sorted
+    const std::vector<std::string> expected{"t1:0",
+                                            "o3:1",
+                                            "t1:1",
+                                            "t2:1",
+                                            "o3:2",
+                                            "t1:2",
+                                            "t1:3",
+                                            "t2:3",
+                                            "o3:3"};
+    CHECK(describe(list) == expected);
+    CHECK(list.at(1).depth == 20);
+    CHECK(list.at(3).depth == 32);
+
+    CHECK_THROWS_AS(list.move(4, 0, 0), step_exception);
+    CHECK_THROWS_AS(list.move(5, 0, 0), step_exception);
+  }
+
+  TEST_CASE("Moving objects")
+  {
+    const map map{"resource/render_list/orthogonal.json"};
+    render_list list{map};
+
+    list.move(1, 0, 50);
+    CHECK(list.pending() == 1);
+    CHECK(list.at(1).index == 1);
+
+    list.update();
+    CHECK(list.pending() == 0);
+    const std::vector<std::string> moved{"t1:0",
+                                         "t1:1",
+                                         "t2:1",
+                                         "o3:2",
+                                         "t1:2",
+                                         "o3:1",
+                                         "t1:3",
+                                         "t2:3",
+                                         "o3:3"};
+    CHECK(describe(list) == moved);
+
+    // Moving most of the objects triggers a full sort
+    list.move(2, 0, 0);
+    list.move(3, 0, 10);
+    list.move(1, 0, 10);
+    list.update();
+    check_sorted(list);
+    const std::vector<std::string> sorted{"o3:2",
+                                          "o3:1",
+                                          "o3:3",
+                                          "t1:0",
+                                          "t1:1",
+                                          "t2:1",
+                                          "t1:2",
+                                          "t1:3",
+                                          "t2:3"};
+    CHECK(describe(list) == sorted);
+
+    for (int frame = 0; frame < 50; ++frame) {
+      list.move(1 + frame % 3, 0, (frame * 37) % 80);
+      list.update();
+      check_sorted(list);
+    }
+  }
+
+  TEST_CASE("Isometric maps are sorted by depth")
+  {
+    const map map{"resource/render_list/isometric.json"};
+    const render_list list{map};
+
+    const std::vector<std::string> expected{
+        "o2:1", "t1:0", "t1:1", "o2:2", "t1:2", "t1:3", "t1:4"};
+    CHECK(describe(list) == expected);
+    CHECK(list.at(1).depth == 32);
+    CHECK(list.at(6).depth == 96);
+  }
+
+  TEST_CASE("Unsupported orientations")
+  {
+    const map map{"resource/render_list/staggered.json"};
+    CHECK_THROWS_AS(render_list{map}, step_exception);
+  }
+}
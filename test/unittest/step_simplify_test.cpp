@@ -0,0 +1,156 @@
+#include "step_simplify.hpp"
+
+#include <doctest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "step_map.hpp"
+
+using namespace step;
+
+namespace {
+
+auto distance_to(const std::vector<point>& line, bool closed, const point& p)
+    -> double
+{
+  auto best = std::numeric_limits<double>::infinity();
+  const auto count = closed ? line.size() : line.size() - 1;
+  for (std::size_t i = 0; i < count; ++i) {
+    const auto& a = line[i];
+    const auto& b = line[(i + 1) % line.size()];
+    best = std::min(best, detail::segment_distance_squared(p, a, b));
+  }
+  return std::sqrt(best);
+}
+
+auto noisy_circle(int count, double radius, double noise)
+    -> std::vector<point>
+{
+  std::mt19937 rng{42};
+  std::uniform_real_distribution<double> offset{-noise, noise};
+
+  std::vector<point> points;
+  for (auto i = 0; i < count; ++i) {
+    const auto angle = 2 * detail::pi * i / count;
+    points.emplace_back(radius * std::cos(angle) + offset(rng),
+                        radius * std::sin(angle) + offset(rng));
+  }
+  return points;
+}
+
+auto polylines_by_id(const map& map)
+    -> std::unordered_map<int, std::vector<point>>
+{
+  std::unordered_map<int, std::vector<point>> result;
+  for (const auto& layer : map.layers()) {
+    detail::each_object_group(layer, [&](const auto&, const auto& group) {
+      for (const auto& object : group.objects()) {
+        if (const auto* poly = object.template try_as<polygon>()) {
+          result[object.id()] = poly->points;
+        } else if (const auto* line = object.template try_as<polyline>()) {
+          result[object.id()] = line->points;
+        }
+      }
+    });
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST_SUITE("simplify")
+{
+  TEST_CASE("Douglas-Peucker polylines")
+  {
+    std::vector<point> wave;
+    for (auto i = 0; i < 1'000; ++i) {
+      wave.emplace_back(i * 0.5, 20 * std::sin(i * 0.01));
+    }
+
+    const auto simplified = simplify(wave, false, 0.25);
+    CHECK(simplified.size() < wave.size() / 10);
+    CHECK(simplified.front().x() == wave.front().x());
+    CHECK(simplified.back().x() == wave.back().x());
+
+    for (const auto& p : wave) {
+      CHECK(distance_to(simplified, false, p) <= 0.25 + 1e-9);
+    }
+
+    const auto line = simplify(wave, false, 1'000);
+    CHECK(line.size() == 2);
+  }
+
+  TEST_CASE("Douglas-Peucker polygons")
+  {
+    const auto circle = noisy_circle(2'000, 100, 0.1);
+
+    const auto simplified = simplify(circle, true, 0.5);
+    CHECK(simplified.size() < circle.size() / 10);
+    for (const auto& p : circle) {
+      CHECK(distance_to(simplified, true, p) <= 0.5 + 1e-9);
+    }
+
+    const auto triangle = simplify(circle, true, 1'000);
+    CHECK(triangle.size() == 3);
+  }
+
+  TEST_CASE("Visvalingam-Whyatt")
+  {
+    const std::vector<point> staircase{
+        {0, 0}, {1, 0}, {2, 0}, {2, 0.01}, {3, 0.01}, {4, 0}, {10, 0}};
+
+    const auto flat = simplify(
+        staircase, false, 0.2, simplification_method::visvalingam_whyatt);
+    REQUIRE(flat.size() == 2);
+    CHECK(flat.front().x() == 0);
+    CHECK(flat.back().x() == 10);
+
+    const auto circle = noisy_circle(500, 100, 0.1);
+    const auto simplified = simplify(
+        circle, true, 2, simplification_method::visvalingam_whyatt);
+    CHECK(simplified.size() < circle.size() / 2);
+    CHECK(simplified.size() > 3);
+
+    const auto triangle = simplify(
+        circle, true, 1'000, simplification_method::visvalingam_whyatt);
+    CHECK(triangle.size() == 3);
+  }
+
+  TEST_CASE("Non-positive tolerances keep every point")
+  {
+    const auto circle = noisy_circle(100, 10, 1);
+    CHECK(simplify(circle, true, 0).size() == circle.size());
+    CHECK(simplify(circle,
+                   false,
+                   -1,
+                   simplification_method::visvalingam_whyatt)
+              .size() == circle.size());
+  }
+
+  TEST_CASE("Simplification at load time")
+  {
+    const map original{"resource/simplify/map.json"};
+    const auto before = polylines_by_id(original);
+
+    const std::vector<simplification_rule> rules{
+        {"coast", "", 0.5, simplification_method::douglas_peucker},
+        {"", "road", 0.5, simplification_method::visvalingam_whyatt}};
+
+    const map simplified{"resource/simplify/map.json", rules};
+    auto after = polylines_by_id(simplified);
+
+    REQUIRE(after.size() == 3);
+    CHECK(after.at(1).size() < before.at(1).size() / 4);
+    CHECK(after.at(2).size() < before.at(2).size() / 4);
+    CHECK(after.at(3).size() == before.at(3).size());
+
+    for (const auto& p : before.at(1)) {
+      CHECK(distance_to(after.at(1), true, p) <= 0.5 + 1e-9);
+    }
+  }
+}
@@ -0,0 +1,101 @@
+#include "step_summed_area.hpp"
+
+#include <doctest.h>
+
+#include <random>
+
+#include "step_map.hpp"
+#include "step_tile_mask.hpp"
+
+using namespace step;
+
+namespace {
+
+auto brute_force_count(const tile_mask& mask,
+                       int col,
+                       int row,
+                       int width,
+                       int height) -> int
+{
+  int count = 0;
+  for (auto r = row; r < row + height; ++r) {
+    for (auto c = col; c < col + width; ++c) {
+      if (mask.test(c, r)) {
+        ++count;
+      }
+    }
+  }
+  return count;
+}
+
+}  // namespace
+
+TEST_SUITE("summed_area_table")
+{
+  TEST_CASE("Count solid tiles of a map")
+  {
+    const map map{"resource/collision/map.json"};
+    const summed_area_table table{make_tile_mask(map, "solid")};
+
+    CHECK(table.width() == 8);
+    CHECK(table.height() == 6);
+    CHECK(table.count() == 11);
+
+    CHECK(table.count(0, 0, 3, 2) == 6);
+    CHECK(table.all(0, 0, 3, 2));
+    CHECK(!table.all(0, 0, 4, 2));
+    CHECK(table.none(3, 0, 3, 4));
+    CHECK(table.any(5, 3, 2, 2));
+
+    // Rectangles are clipped to the mask
+    CHECK(table.count(-5, -5, 8, 7) == 6);
+    CHECK(table.count(6, 4, 10, 10) == 4);
+    CHECK(table.count(8, 0, 2, 2) == 0);
+    CHECK(!table.all(6, 4, 3, 2));
+    CHECK(!table.all(0, 0, 0, 0));
+  }
+
+  TEST_CASE("Random masks and changes")
+  {
+    std::mt19937 rng{7};
+    std::uniform_int_distribution<int> coin{0, 3};
+
+    tile_mask mask{150, 70};
+    for (int row = 0; row < mask.height(); ++row) {
+      for (int col = 0; col < mask.width(); ++col) {
+        mask.set(col, row, coin(rng) == 0);
+      }
+    }
+
+    summed_area_table table{mask, 4};
+    std::uniform_int_distribution<int> cols{-10, 160};
+    std::uniform_int_distribution<int> rows{-10, 80};
+    std::uniform_int_distribution<int> sizes{0, 60};
+
+    for (int i = 0; i < 2000; ++i) {
+      const auto col = cols(rng);
+      const auto row = rows(rng);
+      const auto value = coin(rng) != 0;
+      mask.set(col, row, value);
+      table.set(col, row, value);
+      CHECK(table.pending() <= summed_area_table::max_pending);
+
+      const auto x = cols(rng);
+      const auto y = rows(rng);
+      const auto w = sizes(rng);
+      const auto h = sizes(rng);
+      CHECK(table.count(x, y, w, h) == brute_force_count(mask, x, y, w, h));
+    }
+
+    table.flush();
+    CHECK(table.pending() == 0);
+    CHECK(table.count() == brute_force_count(mask, 0, 0, 150, 70));
+
+    const summed_area_table rebuilt{table.mask(), 1};
+    for (int row = 0; row < 70; row += 3) {
+      for (int col = 0; col < 150; col += 7) {
+        CHECK(table.count(col, row, 11, 5) == rebuilt.count(col, row, 11, 5));
+      }
+    }
+  }
+}
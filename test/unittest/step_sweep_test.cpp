@@ -0,0 +1,219 @@
+#include "step_sweep.hpp"
+
+#include <doctest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <random>
+
+#include "step_map.hpp"
+#include "step_tile_mask.hpp"
+
+using namespace step;
+
+namespace {
+
+// Sweeps the top-left corner of the box against each solid tile expanded by
+// the size of the box
+auto brute_force_sweep(const tile_mask& solid,
+                       double tileSize,
+                       const rect& box,
+                       const point& motion) -> std::optional<double>
+{
+  std::optional<double> best;
+  for (int row = 0; row < solid.height(); ++row) {
+    for (int col = 0; col < solid.width(); ++col) {
+      if (!solid.test(col, row)) {
+        continue;
+      }
+
+      const double lo[] = {col * tileSize - box.width,
+                           row * tileSize - box.height};
+      const double hi[] = {(col + 1) * tileSize, (row + 1) * tileSize};
+      const double origin[] = {box.x, box.y};
+      const double delta[] = {motion.x(), motion.y()};
+
+      auto enter = -std::numeric_limits<double>::infinity();
+      auto exit = std::numeric_limits<double>::infinity();
+      for (int axis = 0; axis < 2; ++axis) {
+        if (delta[axis] == 0) {
+          if (origin[axis] <= lo[axis] || origin[axis] >= hi[axis]) {
+            enter = exit;
+          }
+          continue;
+        }
+        auto a = (lo[axis] - origin[axis]) / delta[axis];
+        auto b = (hi[axis] - origin[axis]) / delta[axis];
+        if (a > b) {
+          std::swap(a, b);
+        }
+        enter = std::max(enter, a);
+        exit = std::min(exit, b);
+      }
+
+      if (enter < exit && enter >= 0 && enter <= 1 &&
+          (!best || enter < *best)) {
+        best = enter;
+      }
+    }
+  }
+  return best;
+}
+
+}  // namespace
+
+TEST_SUITE("tile_collider")
+{
+  TEST_CASE("Cells")
+  {
+    const map map{"resource/sweep/map.json"};
+    tile_collider collider{map};
+
+    CHECK(collider.width() == 10);
+    CHECK(collider.height() == 8);
+
+    CHECK(collider.gid_at(0, 7) == global_id{1});
+    CHECK(collider.gid_at(2, 6) == global_id{3});
+    CHECK(collider.gid_at(8, 6) ==
+          global_id{3u | detail::flipped_horizontally_bit});
+    CHECK(collider.gid_at(0, 0) == global_id{1});
+    CHECK(collider.gid_at(5, 6) == global_id{4});  // Decoration above
+    CHECK(collider.gid_at(1, 0) == global_id{0});  // Not solid
+    CHECK(collider.gid_at(-1, 0) == global_id{0});
+
+    collider.set_tile(1, 0, global_id{2});
+    CHECK(collider.gid_at(1, 0) == global_id{2});
+
+    collider.set_tile(1, 0, global_id{6});
+    CHECK(collider.gid_at(1, 0) == global_id{0});
+  }
+
+  TEST_CASE("Boxes")
+  {
+    const map map{"resource/sweep/map.json"};
+    const tile_collider collider{map};
+
+    SUBCASE("Landing on the floor")
+    {
+      const auto hit = collider.sweep_box({2, 96, 12, 12}, {0, 20});
+      REQUIRE(hit);
+      CHECK(hit->time == doctest::Approx(0.2));
+      CHECK(hit->tile == tile_pos{0, 7});
+      CHECK(hit->normal.x() == doctest::Approx(0));
+      CHECK(hit->normal.y() == doctest::Approx(-1));
+    }
+
+    SUBCASE("Sliding along the floor into a ramp")
+    {
+      const auto hit = collider.sweep_box({2, 100, 12, 12}, {20, 0});
+      REQUIRE(hit);
+      CHECK(hit->time == doctest::Approx(0.9));
+      CHECK(hit->tile == tile_pos{2, 6});
+    }
+
+    SUBCASE("Landing on slopes")
+    {
+      const auto ramp = collider.sweep_box({36, 80, 4, 4}, {0, 40});
+      REQUIRE(ramp);
+      CHECK(ramp->time == doctest::Approx(0.5));
+      CHECK(ramp->tile == tile_pos{2, 6});
+      CHECK(ramp->normal.x() == doctest::Approx(-std::sqrt(0.5)));
+      CHECK(ramp->normal.y() == doctest::Approx(-std::sqrt(0.5)));
+
+      const auto flipped = collider.sweep_box({140, 80, 4, 4}, {0, 40});
+      REQUIRE(flipped);
+      CHECK(flipped->time == doctest::Approx(0.6));
+      CHECK(flipped->tile == tile_pos{8, 6});
+      CHECK(flipped->normal.x() == doctest::Approx(std::sqrt(0.5)));
+      CHECK(flipped->normal.y() == doctest::Approx(-std::sqrt(0.5)));
+    }
+
+    SUBCASE("One-way platforms")
+    {
+      const auto hit = collider.sweep_box({52, 40, 8, 8}, {0, 30});
+      REQUIRE(hit);
+      CHECK(hit->time == doctest::Approx(16.0 / 30.0));
+      CHECK(hit->tile == tile_pos{3, 4});
+      CHECK(hit->normal.y() == doctest::Approx(-1));
+
+      CHECK(!collider.sweep_box({52, 90, 8, 8}, {0, -40}));
+      CHECK(!collider.sweep_box({30, 66, 8, 8}, {40, 0}));
+    }
+
+    SUBCASE("Tile objects")
+    {
+      const auto hit = collider.sweep_box({70, 104, 6, 6}, {20, 0});
+      REQUIRE(hit);
+      CHECK(hit->time == doctest::Approx(0.4));
+      CHECK(hit->tile == tile_pos{5, 6});
+      CHECK(hit->normal.x() == doctest::Approx(-1));
+
+      CHECK(!collider.sweep_box({70, 97, 6, 6}, {30, 0}));
+    }
+
+    SUBCASE("Overlapping boxes can move out")
+    {
+      CHECK(!collider.sweep_box({2, 114, 4, 4}, {5, -30}));
+    }
+  }
+
+  TEST_CASE("Circles")
+  {
+    const map map{"resource/sweep/map.json"};
+    const tile_collider collider{map};
+
+    const auto floor = collider.sweep_circle({20, 90}, 6, {0, 32});
+    REQUIRE(floor);
+    CHECK(floor->time == doctest::Approx(0.5));
+    CHECK(floor->normal.y() == doctest::Approx(-1));
+
+    const auto resting = collider.sweep_circle({8, 104 + 1e-9}, 8, {0, 10});
+    REQUIRE(resting);
+    CHECK(resting->time == 0);
+
+    const auto ellipse = collider.sweep_circle({100, 40}, 4, {40, 0});
+    REQUIRE(ellipse);
+    CHECK(ellipse->time == doctest::Approx(0.6));
+    CHECK(ellipse->tile == tile_pos{8, 2});
+    CHECK(ellipse->normal.x() < -0.9);
+
+    // Hitting the bottom-right corner of a tile diagonally
+    const auto corner = collider.sweep_circle({24, 24}, 2, {-12, -12});
+    REQUIRE(corner);
+    CHECK(corner->time ==
+          doctest::Approx((8 * std::sqrt(2.0) - 2) / (12 * std::sqrt(2.0))));
+    CHECK(corner->tile == tile_pos{0, 0});
+    CHECK(corner->normal.x() == doctest::Approx(std::sqrt(0.5)));
+    CHECK(corner->normal.y() == doctest::Approx(std::sqrt(0.5)));
+
+    CHECK(!collider.sweep_circle({60, 96}, 4, {0, -40}));
+  }
+
+  TEST_CASE("Boxes match a brute force sweep")
+  {
+    const map map{"resource/sweep/grid.json"};
+    const auto solid = make_tile_mask(map, "solid");
+    const tile_collider collider{map};
+
+    std::mt19937 rng{42};
+    std::uniform_real_distribution<double> position{-20, 400};
+    std::uniform_real_distribution<double> size{1, 30};
+    std::uniform_real_distribution<double> delta{-120, 120};
+
+    for (int i = 0; i < 2000; ++i) {
+      const rect box{position(rng), position(rng) * 0.6, size(rng), size(rng)};
+      const point motion{delta(rng), delta(rng)};
+
+      const auto expected = brute_force_sweep(solid, 16, box, motion);
+      const auto actual = collider.sweep_box(box, motion);
+
+      REQUIRE(expected.has_value() == actual.has_value());
+      if (actual) {
+        CHECK(actual->time == doctest::Approx(*expected));
+        CHECK(solid.test(actual->tile.col, actual->tile.row));
+      }
+    }
+  }
+}
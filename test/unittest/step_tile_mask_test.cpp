@@ -0,0 +1,100 @@
+#include "step_tile_mask.hpp"
+
+#include <doctest.h>
+
+#include "step_map.hpp"
+
+using namespace step;
+
+TEST_SUITE("tile_mask")
+{
+  TEST_CASE("Set and test bits")
+  {
+    tile_mask mask{70, 3};
+    CHECK(mask.width() == 70);
+    CHECK(mask.height() == 3);
+    CHECK(mask.words_per_row() == 2);
+    CHECK(mask.count() == 0);
+
+    mask.set(0, 0);
+    mask.set(69, 2);
+    mask.set(64, 1);
+    mask.set(-1, 0);
+    mask.set(70, 0);
+
+    CHECK(mask.test(0, 0));
+    CHECK(mask.test(69, 2));
+    CHECK(mask.test(tile_pos{64, 1}));
+    CHECK(!mask.test(1, 0));
+    CHECK(!mask.test(-1, 0));
+    CHECK(mask.count() == 3);
+    CHECK(mask.row_data(1)[1] == 1u);
+
+    mask.set(0, 0, false);
+    CHECK(!mask.test(0, 0));
+    CHECK(mask.count() == 2);
+
+    mask.clear();
+    CHECK(mask.count() == 0);
+  }
+
+  TEST_CASE("Combine masks")
+  {
+    tile_mask mask{70, 2};
+    mask.set(3, 0);
+
+    tile_mask other{80, 3};
+    other.set(69, 1);
+    other.set(75, 1);
+    other.set(5, 2);
+
+    mask |= other;
+    CHECK(mask.count() == 2);
+    CHECK(mask.test(3, 0));
+    CHECK(mask.test(69, 1));
+    CHECK(!mask.test(75, 1));
+  }
+
+  TEST_CASE("Strip flip bits")
+  {
+    CHECK(strip_flip_bits(global_id{0x80000005u}) == 5_gid);
+    CHECK(strip_flip_bits(global_id{0xF0000001u}) == 1_gid);
+    CHECK(strip_flip_bits(7_gid) == 7_gid);
+  }
+
+  TEST_CASE("Create mask from map")
+  {
+    const map map{"resource/collision/map.json"};
+
+    SUBCASE("Boolean property")
+    {
+      const auto mask = make_tile_mask(map, "solid");
+      CHECK(mask.width() == 8);
+      CHECK(mask.height() == 6);
+      CHECK(mask.count() == 11);
+      CHECK(mask.test(0, 0));
+      CHECK(mask.test(0, 5));  // Flipped tile in a nested layer
+      CHECK(!mask.test(3, 0));
+    }
+
+    SUBCASE("Predicate")
+    {
+      const auto mask = make_tile_mask(map, [](const tile& tile) {
+        return tile.type() == "wall";
+      });
+      CHECK(mask.count() == 1);
+      CHECK(mask.test(3, 0));
+    }
+
+    SUBCASE("Single layer")
+    {
+      const auto mask =
+          make_tile_mask(map, map.layers().at(1), [](const tile& tile) {
+            const auto* props = tile.get_properties();
+            return props && props->is("solid", true);
+          });
+      CHECK(mask.count() == 1);
+      CHECK(mask.test(0, 5));
+    }
+  }
+}
@@ -0,0 +1,57 @@
+#include "step_tile_usage.hpp"
+
+#include <doctest.h>
+
+#include <vector>
+
+#include "step_exception.hpp"
+
+using namespace step;
+
+TEST_SUITE("tile_histogram")
+{
+  TEST_CASE("Counts tile layers, chunks and tile objects")
+  {
+    const map map{"resource/tile_usage/map.json"};
+
+    for (const auto threads : {1, 3, 0}) {
+      const tile_histogram histogram{map, threads};
+
+      CHECK(histogram.count(global_id{1}) == 5);
+      CHECK(histogram.count(global_id{2}) == 2);
+      CHECK(histogram.count(global_id{3}) == 3);
+      CHECK(histogram.count(global_id{10}) == 2);
+      CHECK(histogram.count(global_id{11}) == 1);
+      CHECK(histogram.count(global_id{12}) == 1);
+      CHECK(histogram.count(global_id{12u | 0x80000000u}) == 1);
+      CHECK(histogram.count(global_id{0}) == 0);
+      CHECK(histogram.count(global_id{1'000}) == 0);
+      CHECK(histogram.total() == 14);
+    }
+  }
+
+  TEST_CASE("Used and unused tiles")
+  {
+    const map map{"resource/tile_usage/map.json"};
+    const tile_histogram histogram{map};
+
+    // Tile 5 is a frame of the animated tile 0, tile 6 is only a frame of the
+    // animation of the unused tile 4
+    CHECK(histogram.used(global_id{6}));
+    CHECK(!histogram.used(global_id{7}));
+    CHECK(histogram.used_tiles(0) == std::vector<int>{0, 1, 2, 5});
+    CHECK(histogram.unused_tiles(0) == std::vector<int>{3, 4, 6, 7});
+    CHECK(histogram.unused_tiles(1) == std::vector<int>{0});
+
+    CHECK(histogram.by_frequency(0) == std::vector<int>{0, 2, 1, 5});
+    CHECK(histogram.by_frequency(1) == std::vector<int>{1, 2, 3});
+
+    CHECK_THROWS_AS(histogram.used_tiles(2), std::out_of_range);
+  }
+
+  TEST_CASE("Base64 data")
+  {
+    const map map{"resource/tile_usage/base64.json"};
+    CHECK_THROWS_AS(tile_histogram{map}, step_exception);
+  }
+}
@@ -0,0 +1,76 @@
+#include "step_tileset_usage.hpp"
+
+#include <doctest.h>
+
+#include <string_view>
+#include <vector>
+
+#include "step_map.hpp"
+
+using namespace step;
+
+namespace {
+
+using indices = std::vector<std::size_t>;
+using names = std::vector<std::string_view>;
+
+}  // namespace
+
+TEST_SUITE("tileset_usage")
+{
+  TEST_CASE("Chunks")
+  {
+    const map map{"resource/tileset_usage/map.json"};
+    const tileset_usage usage{map};
+
+    CHECK(usage.chunk_cols() == 3);
+    CHECK(usage.chunk_rows() == 3);
+    CHECK(usage.image_names().size() == 4);
+  }
+
+  TEST_CASE("Tilesets and images in areas")
+  {
+    const map map{"resource/tileset_usage/map.json"};
+    const tileset_usage usage{map};
+
+    CHECK(usage.tilesets({0, 0, 100, 100}) == indices{0});
+    CHECK(usage.images({0, 0, 100, 100}) == names{"terrain.png"});
+
+    // The flipped prop is in the second chunk of the first row
+    CHECK(usage.tilesets({300, 0, 50, 50}) == indices{0, 1});
+    CHECK(usage.images({300, 0, 50, 50}) ==
+          names{"terrain.png", "props.png"});
+
+    // The tile object only reaches into the last chunk
+    CHECK(usage.tilesets({500, 500, 10, 10}) == indices{0});
+    CHECK(usage.tilesets({500, 500, 10, 10}, 60) == indices{0, 2});
+    CHECK(usage.images({500, 500, 10, 10}, 60) ==
+          names{"terrain.png", "b.png"});
+
+    CHECK(usage.tilesets({0, 0, 640, 640}) == indices{0, 1, 2});
+    CHECK(usage.images({0, 0, 640, 640}) ==
+          names{"terrain.png", "props.png", "b.png"});
+
+    // Areas end before the first pixel of the next chunk
+    CHECK(usage.tilesets({0, 0, 256, 256}) == indices{0});
+
+    // Areas outside of the map use nothing, unless the margin reaches in
+    CHECK(usage.tilesets({-1000, -1000, 10, 10}).empty());
+    CHECK(usage.tilesets({-1000, -1000, 10, 10}, 200).empty());
+    CHECK(usage.tilesets({-1000, -1000, 10, 10}, 1000) == indices{0});
+  }
+
+  TEST_CASE("Masks")
+  {
+    const map map{"resource/tileset_usage/map.json"};
+    const tileset_usage usage{map};
+
+    const auto everything = usage.tileset_mask({0, 0, 640, 640});
+    REQUIRE(everything.size() == 1);
+    CHECK(everything.front() == 0b111u);
+
+    const auto corner = usage.image_mask({0, 0, 16, 16});
+    REQUIRE(corner.size() == 1);
+    CHECK(corner.front() == 0b1u);
+  }
+}
@@ -0,0 +1,126 @@
+#include "step_walkability.hpp"
+
+#include <doctest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "step_map.hpp"
+
+using namespace step;
+
+namespace {
+
+auto neighbours_of(const walkability_grid& grid, tile_pos pos)
+    -> std::vector<tile_pos>
+{
+  std::vector<tile_pos> result;
+  grid.each_neighbour(pos, [&](tile_pos next, double) {
+    result.push_back(next);
+  });
+  return result;
+}
+
+auto contains(const std::vector<tile_pos>& tiles, tile_pos pos) -> bool
+{
+  return std::find(tiles.begin(), tiles.end(), pos) != tiles.end();
+}
+
+}  // namespace
+
+TEST_SUITE("walkability_grid")
+{
+  TEST_CASE("Costs from tile properties")
+  {
+    const map map{"resource/pathfinding/costs.json"};
+    const walkability_grid grid{map, "cost"};
+
+    CHECK(grid.width() == 8);
+    CHECK(grid.height() == 6);
+
+    CHECK(grid.cost(0, 0) == 1);
+    CHECK(grid.cost(7, 0) == 4);
+    CHECK(grid.cost(2, 1) == 3);  // Float costs are rounded up
+    CHECK(grid.cost(4, 4) == 3);  // Largest cost of all layers
+    CHECK(grid.cost(7, 5) == 1);  // No tiles
+
+    CHECK(grid.cost(3, 0) == walkability_grid::blocked);
+    CHECK(grid.cost(3, 3) == walkability_grid::blocked);  // Flipped tile
+    CHECK(!grid.is_walkable({3, 2}));
+    CHECK(!grid.is_walkable({-1, 0}));
+    CHECK(!grid.is_walkable({8, 0}));
+  }
+
+  TEST_CASE("Costs from a cost function")
+  {
+    const map map{"resource/pathfinding/costs.json"};
+    const walkability_grid grid{map, [](const tile& tile) {
+                                  return tile.type() == "road" ? 0 : 1;
+                                }};
+
+    CHECK(grid.cost(0, 0) == walkability_grid::blocked);
+    CHECK(grid.cost(3, 0) == walkability_grid::blocked);
+    CHECK(grid.cost(2, 1) == 1);
+    CHECK(grid.cost(7, 5) == 1);
+  }
+
+  TEST_CASE("Orthogonal neighbours")
+  {
+    const map map{"resource/pathfinding/costs.json"};
+    walkability_grid grid{map};
+
+    CHECK(grid.neighbour_count() == 8);
+    CHECK(neighbours_of(grid, {0, 0}).size() == 3);
+    CHECK(neighbours_of(grid, {4, 4}).size() == 8);
+
+    // Diagonal moves can't cut corners
+    grid.set_cost(1, 0, walkability_grid::blocked);
+    const auto corner = neighbours_of(grid, {0, 0});
+    CHECK(corner.size() == 1);
+    CHECK(contains(corner, {0, 1}));
+
+    const walkability_grid cardinal{map,
+                                    walkability_grid::diagonals::forbidden};
+    CHECK(cardinal.neighbour_count() == 4);
+    CHECK(cardinal.estimate({0, 0}, {3, 4}) == 7);
+    CHECK(grid.estimate({0, 0}, {3, 4}) == doctest::Approx(1 + 3 * 1.41421));
+  }
+
+  TEST_CASE("Neighbourhoods are symmetric")
+  {
+    for (const auto* file : {"resource/projection/isometric.json",
+                             "resource/projection/staggered_x.json",
+                             "resource/projection/staggered_y.json",
+                             "resource/projection/hexagonal_x.json",
+                             "resource/projection/hexagonal_y.json"}) {
+      CAPTURE(std::string{file});
+      const map map{file};
+      const walkability_grid grid{map};
+
+      const auto expected =
+          map.get_orientation() == map::orientation::hexagonal ? 6u : 8u;
+      CHECK(grid.neighbour_count() == expected);
+
+      for (int row = 0; row < grid.height(); ++row) {
+        for (int col = 0; col < grid.width(); ++col) {
+          const tile_pos pos{col, row};
+          for (const auto next : neighbours_of(grid, pos)) {
+            CHECK(contains(neighbours_of(grid, next), pos));
+            CHECK(grid.estimate(pos, next) <= 1.5);
+          }
+        }
+      }
+    }
+  }
+
+  TEST_CASE("Path cost")
+  {
+    const map map{"resource/pathfinding/costs.json"};
+    const walkability_grid grid{map, "cost"};
+
+    CHECK(grid.path_cost({}) == 0);
+    CHECK(grid.path_cost({{1, 0}, {2, 1}, {2, 2}}) ==
+          doctest::Approx(1.41421 * 3 + 3));
+  }
+}